@@ -0,0 +1,131 @@
+#include "AssetLoader.h"
+
+#include <cstdio>
+#include <thread>
+
+AssetLoader::AssetLoader(unsigned int threadCount) :
+	workers(threadCount > 0 ? threadCount : (std::thread::hardware_concurrency() > 3 ? std::thread::hardware_concurrency() / 2 : 1)),
+	requestedCount(0), loadedCount(0), failedCount(0), allLoadedMilliseconds(0.0)
+{
+
+}
+AssetLoader::~AssetLoader()
+{
+
+}
+
+template<typename T>
+std::shared_future<std::shared_ptr<T>> AssetLoader::Queue(const std::wstring& name, std::function<bool(T&)> load, std::function<void(T&)> onLoaded)
+{
+	// Time each batch of loads from its first request
+	if(pendingLoads.empty())
+	{
+		firstRequestTime = std::chrono::high_resolution_clock::now();
+		allLoadedMilliseconds = 0.0;
+	}
+	requestedCount++;
+
+	// Promises are move-only, so share ownership to fit in a std::function
+	auto promise = std::make_shared<std::promise<std::shared_ptr<T>>>();
+	std::shared_future<std::shared_ptr<T>> result = promise->get_future().share();
+	workers.Submit([promise, load]()
+	{
+		auto data = std::make_shared<T>();
+		promise->set_value(load(*data) ? data : nullptr);
+	});
+
+	pendingLoads.push_back({
+		name,
+		[result]() { return result.wait_for(std::chrono::seconds(0)) == std::future_status::ready; },
+		[result]() { result.wait(); },
+		[result, onLoaded]()
+		{
+			std::shared_ptr<T> data = result.get();
+			if(!data)
+				return false;
+			if(onLoaded)
+				onLoaded(*data);
+			return true;
+		} });
+
+	return result;
+}
+
+AssetLoader::TextureFuture AssetLoader::LoadTexture(const std::wstring& filePath, const TextureCookOptions& cookOptions, std::function<void(TextureData&)> onLoaded)
+{
+	std::filesystem::path cacheDirectory = textureCacheDirectory;
+	return Queue<TextureData>(filePath, [filePath, cacheDirectory, cookOptions](TextureData& data)
+	{
+		return LoadTextureData(filePath.c_str(), cacheDirectory, cookOptions, data);
+	}, onLoaded);
+}
+
+AssetLoader::TextureFuture AssetLoader::LoadOrmTexture(const std::wstring& occlusionPath, const std::wstring& roughnessPath, const std::wstring& metalnessPath,
+	const TextureCookOptions& cookOptions, std::function<void(TextureData&)> onLoaded)
+{
+	std::filesystem::path cacheDirectory = textureCacheDirectory;
+	return Queue<TextureData>(roughnessPath.empty() ? metalnessPath : roughnessPath,
+		[occlusionPath, roughnessPath, metalnessPath, cacheDirectory, cookOptions](TextureData& data)
+	{
+		return LoadOrmTextureData(
+			occlusionPath.empty() ? nullptr : occlusionPath.c_str(),
+			roughnessPath.empty() ? nullptr : roughnessPath.c_str(),
+			metalnessPath.empty() ? nullptr : metalnessPath.c_str(),
+			cacheDirectory, cookOptions, data);
+	}, onLoaded);
+}
+
+AssetLoader::TextureFuture AssetLoader::LoadCubemap(const std::vector<std::wstring>& facePaths, std::function<void(TextureData&)> onLoaded)
+{
+	std::filesystem::path cacheDirectory = textureCacheDirectory;
+	return Queue<TextureData>(facePaths.empty() ? L"" : facePaths[0], [facePaths, cacheDirectory](TextureData& data)
+	{
+		return LoadCubemapData(facePaths, cacheDirectory, data);
+	}, onLoaded);
+}
+
+AssetLoader::MeshFuture AssetLoader::LoadMesh(const std::wstring& filePath, std::function<void(MeshData&)> onLoaded)
+{
+	return Queue<MeshData>(filePath, [filePath](MeshData& data) { return LoadMeshData(filePath.c_str(), data); }, onLoaded);
+}
+
+void AssetLoader::Update(unsigned int maxFinishedLoads)
+{
+	unsigned int finishedCount = 0;
+	for(size_t i = 0; i < pendingLoads.size() && finishedCount < maxFinishedLoads;)
+	{
+		if(!pendingLoads[i].isReady())
+		{
+			i++;
+			continue;
+		}
+
+		// Take it off the list first, in case its callback queues more loads
+		PendingLoad load = std::move(pendingLoads[i]);
+		pendingLoads.erase(pendingLoads.begin() + i);
+
+		if(load.finish())
+			loadedCount++;
+		else
+		{
+			failedCount++;
+			printf("Failed to load %ls\n", load.name.c_str());
+		}
+		finishedCount++;
+	}
+
+	if(finishedCount > 0 && pendingLoads.empty())
+	{
+		allLoadedMilliseconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - firstRequestTime).count() * 1000.0;
+		printf("Background loading finished: %u assets (%u failed) in %.1f ms\n", loadedCount, failedCount, allLoadedMilliseconds);
+	}
+}
+
+void AssetLoader::WaitForAll()
+{
+	while(!pendingLoads.empty())
+	{
+		pendingLoads.front().wait();
+		Update();
+	}
+}
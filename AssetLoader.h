@@ -0,0 +1,92 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "TextureData.h"
+#include "MeshData.h"
+#include "ThreadPool.h"
+
+// --------------------------------------------------------
+// Loads assets in the background so the game can start
+// drawing before they've all arrived
+// - Decoding and parsing run on the loader's own worker
+//   threads (and never touch the graphics API)
+// - Each load's onLoaded callback runs on the main thread,
+//   from Update(), once its data is ready; that's where it
+//   gets uploaded and swapped in for its placeholder
+// - Textures go through the texture cache (see TextureData),
+//   so only their first load decodes them and makes mips
+// - The returned futures give the decoded data directly, to
+//   anything that would rather wait on it (they hold null if
+//   the load failed, in which case onLoaded isn't called)
+// --------------------------------------------------------
+class AssetLoader
+{
+public:
+	using TextureFuture = std::shared_future<std::shared_ptr<TextureData>>;
+	using MeshFuture = std::shared_future<std::shared_ptr<MeshData>>;
+
+private:
+	// A load whose data is being prepared on a worker
+	struct PendingLoad
+	{
+		std::wstring name;
+		std::function<bool()> isReady;
+		std::function<void()> wait;
+		std::function<bool()> finish; // Returns whether the load succeeded
+	};
+
+	ThreadPool workers;
+	std::vector<PendingLoad> pendingLoads;
+	std::filesystem::path textureCacheDirectory;
+
+	unsigned int requestedCount;
+	unsigned int loadedCount;
+	unsigned int failedCount;
+	std::chrono::high_resolution_clock::time_point firstRequestTime;
+	double allLoadedMilliseconds;
+
+	// Runs load(data) on a worker and queues onLoaded(data) for the main thread
+	template<typename T>
+	std::shared_future<std::shared_ptr<T>> Queue(const std::wstring& name, std::function<bool(T&)> load, std::function<void(T&)> onLoaded);
+
+public:
+	// Defaults to half of the hardware threads, leaving the rest to the global pool and the main thread
+	AssetLoader(unsigned int threadCount = 0);
+	~AssetLoader();
+	AssetLoader(const AssetLoader&) = delete; // Remove copy constructor
+	AssetLoader& operator=(const AssetLoader&) = delete; // Remove copy-assignment operator
+
+	TextureFuture LoadTexture(const std::wstring& filePath, const TextureCookOptions& cookOptions, std::function<void(TextureData&)> onLoaded);
+	// Packs occlusion, roughness and metalness maps into one texture (an empty path uses that value's default)
+	TextureFuture LoadOrmTexture(const std::wstring& occlusionPath, const std::wstring& roughnessPath, const std::wstring& metalnessPath,
+		const TextureCookOptions& cookOptions, std::function<void(TextureData&)> onLoaded);
+	// Faces in cube map order: +X, -X, +Y, -Y, +Z, -Z (all square, the same size and channel count), cooked into
+	// a prefiltered cube map with irradiance SH (see LoadCubemapData)
+	TextureFuture LoadCubemap(const std::vector<std::wstring>& facePaths, std::function<void(TextureData&)> onLoaded);
+	MeshFuture LoadMesh(const std::wstring& filePath, std::function<void(MeshData&)> onLoaded);
+
+	// Runs the callbacks of up to maxFinishedLoads loads that are ready (call once per frame on the main thread)
+	// - Limiting it spreads the cost of uploading over several frames
+	void Update(unsigned int maxFinishedLoads = UINT32_MAX);
+	// Blocks until every requested load has finished
+	void WaitForAll();
+
+	// Where cooked textures are kept (no caching while this is empty); set it before loading any textures
+	void SetTextureCacheDirectory(const std::filesystem::path& value) { textureCacheDirectory = value; };
+
+	bool IsIdle() { return pendingLoads.empty(); };
+	unsigned int GetRequestedCount() { return requestedCount; };
+	unsigned int GetLoadedCount() { return loadedCount; };
+	unsigned int GetFailedCount() { return failedCount; };
+	unsigned int GetPendingCount() { return (unsigned int) pendingLoads.size(); };
+	// Time from the first request until the last pending load finished (0 while any are pending)
+	double GetAllLoadedMilliseconds() { return allLoadedMilliseconds; };
+};
@@ -0,0 +1,724 @@
+#include "BlockCompression.h"
+#include "ThreadPool.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+	// Texel c of pixel p, with grayscale expanded to (gray, gray, gray, 255)
+	uint8_t GetChannel(const Image& image, size_t p, unsigned int c)
+	{
+		if(image.channels == 1)
+			return c < 3 ? image.pixels[p] : 255;
+		return image.pixels[p * image.channels + c];
+	}
+
+	float Clamp(float value, float low, float high)
+	{
+		return value < low ? low : (value > high ? high : value);
+	}
+
+	// Finds the direction the values vary the most along (principal axis of their covariance),
+	// with power iteration since only the largest eigenvector matters
+	template<int Channels>
+	bool FindPrincipalAxis(const float texels[16][4], float mean[Channels], float axis[Channels])
+	{
+		for(int c = 0; c < Channels; c++)
+		{
+			mean[c] = 0.0f;
+			for(int i = 0; i < 16; i++)
+				mean[c] += texels[i][c];
+			mean[c] /= 16.0f;
+		}
+
+		float covariance[Channels][Channels] = {};
+		for(int i = 0; i < 16; i++)
+		{
+			for(int a = 0; a < Channels; a++)
+			{
+				for(int b = 0; b < Channels; b++)
+					covariance[a][b] += (texels[i][a] - mean[a]) * (texels[i][b] - mean[b]);
+			}
+		}
+
+		for(int c = 0; c < Channels; c++)
+			axis[c] = 1.0f;
+		for(int iteration = 0; iteration < 8; iteration++)
+		{
+			float next[Channels] = {};
+			float length = 0.0f;
+			for(int a = 0; a < Channels; a++)
+			{
+				for(int b = 0; b < Channels; b++)
+					next[a] += covariance[a][b] * axis[b];
+				length += next[a] * next[a];
+			}
+
+			// Every texel is the same (or close enough not to matter)
+			if(length < 1e-8f)
+				return false;
+
+			length = std::sqrt(length);
+			for(int c = 0; c < Channels; c++)
+				axis[c] = next[c] / length;
+		}
+		return true;
+	}
+
+	// Endpoints at the extremes of the texels' projections onto their principal axis
+	template<int Channels>
+	void FindEndpoints(const float texels[16][4], float endpoint0[4], float endpoint1[4])
+	{
+		float mean[Channels];
+		float axis[Channels];
+		if(!FindPrincipalAxis<Channels>(texels, mean, axis))
+		{
+			for(int c = 0; c < Channels; c++)
+				endpoint0[c] = endpoint1[c] = mean[c];
+			return;
+		}
+
+		float lowest = std::numeric_limits<float>::max();
+		float highest = -std::numeric_limits<float>::max();
+		for(int i = 0; i < 16; i++)
+		{
+			float t = 0.0f;
+			for(int c = 0; c < Channels; c++)
+				t += (texels[i][c] - mean[c]) * axis[c];
+			lowest = std::fmin(lowest, t);
+			highest = std::fmax(highest, t);
+		}
+
+		for(int c = 0; c < Channels; c++)
+		{
+			endpoint0[c] = Clamp(mean[c] + axis[c] * highest, 0.0f, 255.0f);
+			endpoint1[c] = Clamp(mean[c] + axis[c] * lowest, 0.0f, 255.0f);
+		}
+	}
+
+	// Least squares fit of two endpoints, given how far along the line (0 to 1) each texel was placed
+	// - Returns false when every texel used the same weight, since the fit is then undefined
+	template<int Channels>
+	bool RefitEndpoints(const float texels[16][4], const float weights[16], float endpoint0[4], float endpoint1[4])
+	{
+		float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+		float ax[Channels] = {};
+		float bx[Channels] = {};
+		for(int i = 0; i < 16; i++)
+		{
+			float b = weights[i];
+			float a = 1.0f - b;
+			aa += a * a;
+			bb += b * b;
+			ab += a * b;
+			for(int c = 0; c < Channels; c++)
+			{
+				ax[c] += a * texels[i][c];
+				bx[c] += b * texels[i][c];
+			}
+		}
+
+		float determinant = aa * bb - ab * ab;
+		if(std::fabs(determinant) < 1e-6f)
+			return false;
+
+		for(int c = 0; c < Channels; c++)
+		{
+			endpoint0[c] = Clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.0f, 255.0f);
+			endpoint1[c] = Clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.0f, 255.0f);
+		}
+		return true;
+	}
+
+	/* BC1 */
+
+	uint16_t PackColor565(const float color[4])
+	{
+		unsigned int r = (unsigned int) (Clamp(color[0], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+		unsigned int g = (unsigned int) (Clamp(color[1], 0.0f, 255.0f) * 63.0f / 255.0f + 0.5f);
+		unsigned int b = (unsigned int) (Clamp(color[2], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+		return (uint16_t) ((r << 11) | (g << 5) | b);
+	}
+
+	void UnpackColor565(uint16_t packed, int color[3])
+	{
+		int r = (packed >> 11) & 31;
+		int g = (packed >> 5) & 63;
+		int b = packed & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	// Four color palette (never the three color + transparent mode, so it also suits BC3)
+	void GetColorPalette(uint16_t color0, uint16_t color1, int palette[4][3])
+	{
+		UnpackColor565(color0, palette[0]);
+		UnpackColor565(color1, palette[1]);
+		for(int c = 0; c < 3; c++)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+		}
+	}
+
+	void EncodeColorBlock(const float texels[16][4], uint8_t* block)
+	{
+		// Weight of the second endpoint for each index
+		const float IndexWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+		float endpoint0[4], endpoint1[4];
+		FindEndpoints<3>(texels, endpoint0, endpoint1);
+
+		float bestError = std::numeric_limits<float>::max();
+		for(int iteration = 0; iteration < 3; iteration++)
+		{
+			uint16_t color0 = PackColor565(endpoint0);
+			uint16_t color1 = PackColor565(endpoint1);
+
+			// The larger color has to come first for the four color palette
+			bool isSwapped = color0 < color1;
+			if(isSwapped)
+			{
+				uint16_t swap = color0;
+				color0 = color1;
+				color1 = swap;
+			}
+
+			int palette[4][3];
+			GetColorPalette(color0, color1, palette);
+
+			uint32_t indices = 0;
+			float error = 0.0f;
+			float weights[16];
+			for(int i = 0; i < 16; i++)
+			{
+				int bestIndex = 0;
+				float bestDistance = std::numeric_limits<float>::max();
+				for(int p = 0; p < (color0 == color1 ? 1 : 4); p++)
+				{
+					float distance = 0.0f;
+					for(int c = 0; c < 3; c++)
+						distance += (texels[i][c] - palette[p][c]) * (texels[i][c] - palette[p][c]);
+					if(distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = p;
+					}
+				}
+				indices |= (uint32_t) bestIndex << (i * 2);
+				error += bestDistance;
+
+				// Weights are relative to the unswapped endpoints, for refitting them
+				weights[i] = isSwapped ? 1.0f - IndexWeights[bestIndex] : IndexWeights[bestIndex];
+			}
+
+			if(error < bestError)
+			{
+				bestError = error;
+				memcpy(block, &color0, 2);
+				memcpy(block + 2, &color1, 2);
+				memcpy(block + 4, &indices, 4);
+			}
+
+			if(error == 0.0f || !RefitEndpoints<3>(texels, weights, endpoint0, endpoint1))
+				break;
+		}
+	}
+
+	void DecodeColorBlock(const uint8_t* block, uint8_t texels[16][4])
+	{
+		uint16_t color0, color1;
+		uint32_t indices;
+		memcpy(&color0, block, 2);
+		memcpy(&color1, block + 2, 2);
+		memcpy(&indices, block + 4, 4);
+
+		int palette[4][3];
+		GetColorPalette(color0, color1, palette);
+		for(int i = 0; i < 16; i++)
+		{
+			int index = (indices >> (i * 2)) & 3;
+			for(int c = 0; c < 3; c++)
+				texels[i][c] = (uint8_t) palette[index][c];
+			texels[i][3] = 255;
+		}
+	}
+
+	/* BC4 */
+
+	// Eight value palette when value0 > value1, otherwise six values plus 0 and 255
+	void GetSingleChannelPalette(int value0, int value1, int palette[8])
+	{
+		palette[0] = value0;
+		palette[1] = value1;
+		if(value0 > value1)
+		{
+			for(int i = 1; i < 7; i++)
+				palette[i + 1] = ((7 - i) * value0 + i * value1 + 3) / 7;
+		}
+		else
+		{
+			for(int i = 1; i < 5; i++)
+				palette[i + 1] = ((5 - i) * value0 + i * value1 + 2) / 5;
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	void EncodeSingleChannelBlock(const float texels[16][4], int channel, uint8_t* block)
+	{
+		// Weight of the second endpoint for each index (eight value mode)
+		const float IndexWeights[8] = { 0.0f, 1.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f };
+
+		float lowest = 255.0f;
+		float highest = 0.0f;
+		float values[16][4];
+		for(int i = 0; i < 16; i++)
+		{
+			values[i][0] = texels[i][channel];
+			lowest = std::fmin(lowest, values[i][0]);
+			highest = std::fmax(highest, values[i][0]);
+		}
+
+		float endpoint0[4] = { highest };
+		float endpoint1[4] = { lowest };
+		float bestError = std::numeric_limits<float>::max();
+		for(int iteration = 0; iteration < 3; iteration++)
+		{
+			int value0 = (int) (endpoint0[0] + 0.5f);
+			int value1 = (int) (endpoint1[0] + 0.5f);
+
+			// Stay in eight value mode, which needs the first value to be larger
+			bool isSwapped = value0 < value1;
+			if(isSwapped)
+			{
+				int swap = value0;
+				value0 = value1;
+				value1 = swap;
+			}
+
+			int palette[8];
+			GetSingleChannelPalette(value0, value1, palette);
+
+			uint64_t indices = 0;
+			float error = 0.0f;
+			float weights[16];
+			for(int i = 0; i < 16; i++)
+			{
+				int bestIndex = 0;
+				float bestDistance = std::numeric_limits<float>::max();
+				for(int p = 0; p < 8; p++)
+				{
+					float distance = (values[i][0] - palette[p]) * (values[i][0] - palette[p]);
+					if(distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = p;
+					}
+				}
+				indices |= (uint64_t) bestIndex << (i * 3);
+				error += bestDistance;
+				weights[i] = isSwapped ? 1.0f - IndexWeights[bestIndex] : IndexWeights[bestIndex];
+			}
+
+			if(error < bestError)
+			{
+				bestError = error;
+				block[0] = (uint8_t) value0;
+				block[1] = (uint8_t) value1;
+				for(int b = 0; b < 6; b++)
+					block[2 + b] = (uint8_t) (indices >> (b * 8));
+			}
+
+			// Equal values fall into six value mode, where index 0 still means value0
+			if(error == 0.0f || value0 == value1 || !RefitEndpoints<1>(values, weights, endpoint0, endpoint1))
+				break;
+		}
+	}
+
+	void DecodeSingleChannelBlock(const uint8_t* block, uint8_t values[16])
+	{
+		int palette[8];
+		GetSingleChannelPalette(block[0], block[1], palette);
+
+		uint64_t indices = 0;
+		for(int b = 0; b < 6; b++)
+			indices |= (uint64_t) block[2 + b] << (b * 8);
+		for(int i = 0; i < 16; i++)
+			values[i] = (uint8_t) palette[(indices >> (i * 3)) & 7];
+	}
+
+	/* BC7 (mode 6) */
+
+	const int BC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	// Writes bits least significant first across the 128-bit block
+	class BitWriter
+	{
+		uint8_t* block;
+		unsigned int position;
+
+	public:
+		BitWriter(uint8_t* block) : block(block), position(0) { memset(block, 0, 16); };
+
+		void Write(uint32_t value, unsigned int count)
+		{
+			for(unsigned int i = 0; i < count; i++, position++)
+				block[position / 8] |= (uint8_t) (((value >> i) & 1) << (position % 8));
+		}
+	};
+
+	uint32_t ReadBits(const uint8_t* block, unsigned int& position, unsigned int count)
+	{
+		uint32_t value = 0;
+		for(unsigned int i = 0; i < count; i++, position++)
+			value |= (uint32_t) ((block[position / 8] >> (position % 8)) & 1) << i;
+		return value;
+	}
+
+	// Picks the 7-bit channels and shared p-bit that best represent an 8-bit endpoint
+	void QuantizeEndpoint(const float endpoint[4], int quantized[4], int& pBit)
+	{
+		float bestError = std::numeric_limits<float>::max();
+		for(int p = 0; p < 2; p++)
+		{
+			int candidate[4];
+			float error = 0.0f;
+			for(int c = 0; c < 4; c++)
+			{
+				int value = (int) std::floor((endpoint[c] - p) / 2.0f + 0.5f);
+				candidate[c] = value < 0 ? 0 : (value > 127 ? 127 : value);
+				float difference = endpoint[c] - (float) ((candidate[c] << 1) | p);
+				error += difference * difference;
+			}
+			if(error < bestError)
+			{
+				bestError = error;
+				pBit = p;
+				memcpy(quantized, candidate, sizeof(candidate));
+			}
+		}
+	}
+
+	void GetMode6Palette(const int quantized0[4], int pBit0, const int quantized1[4], int pBit1, int palette[16][4])
+	{
+		for(int c = 0; c < 4; c++)
+		{
+			int value0 = (quantized0[c] << 1) | pBit0;
+			int value1 = (quantized1[c] << 1) | pBit1;
+			for(int i = 0; i < 16; i++)
+				palette[i][c] = ((64 - BC7Weights[i]) * value0 + BC7Weights[i] * value1 + 32) >> 6;
+		}
+	}
+
+	void EncodeMode6Block(const float texels[16][4], uint8_t* block)
+	{
+		float endpoint0[4], endpoint1[4];
+		FindEndpoints<4>(texels, endpoint0, endpoint1);
+
+		float bestError = std::numeric_limits<float>::max();
+		int bestQuantized[2][4] = {};
+		int bestPBits[2] = {};
+		int bestIndices[16] = {};
+		for(int iteration = 0; iteration < 3; iteration++)
+		{
+			int quantized[2][4];
+			int pBits[2];
+			QuantizeEndpoint(endpoint0, quantized[0], pBits[0]);
+			QuantizeEndpoint(endpoint1, quantized[1], pBits[1]);
+
+			int palette[16][4];
+			GetMode6Palette(quantized[0], pBits[0], quantized[1], pBits[1], palette);
+
+			int indices[16];
+			float error = 0.0f;
+			float weights[16];
+			for(int i = 0; i < 16; i++)
+			{
+				int bestIndex = 0;
+				float bestDistance = std::numeric_limits<float>::max();
+				for(int p = 0; p < 16; p++)
+				{
+					float distance = 0.0f;
+					for(int c = 0; c < 4; c++)
+						distance += (texels[i][c] - palette[p][c]) * (texels[i][c] - palette[p][c]);
+					if(distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = p;
+					}
+				}
+				indices[i] = bestIndex;
+				error += bestDistance;
+				weights[i] = BC7Weights[bestIndex] / 64.0f;
+			}
+
+			if(error < bestError)
+			{
+				bestError = error;
+				memcpy(bestQuantized, quantized, sizeof(quantized));
+				memcpy(bestPBits, pBits, sizeof(pBits));
+				memcpy(bestIndices, indices, sizeof(indices));
+			}
+
+			if(error == 0.0f || !RefitEndpoints<4>(texels, weights, endpoint0, endpoint1))
+				break;
+		}
+
+		// The first texel's index is stored without its top bit, so it has to be in the first half
+		if(bestIndices[0] & 8)
+		{
+			for(int c = 0; c < 4; c++)
+			{
+				int swap = bestQuantized[0][c];
+				bestQuantized[0][c] = bestQuantized[1][c];
+				bestQuantized[1][c] = swap;
+			}
+			int swap = bestPBits[0];
+			bestPBits[0] = bestPBits[1];
+			bestPBits[1] = swap;
+			for(int i = 0; i < 16; i++)
+				bestIndices[i] = 15 - bestIndices[i];
+		}
+
+		BitWriter writer(block);
+		writer.Write(1 << 6, 7); // Mode 6
+		for(int c = 0; c < 4; c++)
+		{
+			writer.Write(bestQuantized[0][c], 7);
+			writer.Write(bestQuantized[1][c], 7);
+		}
+		writer.Write(bestPBits[0], 1);
+		writer.Write(bestPBits[1], 1);
+		writer.Write(bestIndices[0], 3);
+		for(int i = 1; i < 16; i++)
+			writer.Write(bestIndices[i], 4);
+	}
+
+	void DecodeMode6Block(const uint8_t* block, uint8_t texels[16][4])
+	{
+		unsigned int position = 0;
+		if(ReadBits(block, position, 7) != (1 << 6))
+		{
+			// Some other mode, which nothing here writes
+			memset(texels, 0, 16 * 4);
+			return;
+		}
+
+		int quantized[2][4];
+		for(int c = 0; c < 4; c++)
+		{
+			quantized[0][c] = ReadBits(block, position, 7);
+			quantized[1][c] = ReadBits(block, position, 7);
+		}
+		int pBit0 = ReadBits(block, position, 1);
+		int pBit1 = ReadBits(block, position, 1);
+
+		int palette[16][4];
+		GetMode6Palette(quantized[0], pBit0, quantized[1], pBit1, palette);
+		for(int i = 0; i < 16; i++)
+		{
+			int index = ReadBits(block, position, i == 0 ? 3 : 4);
+			for(int c = 0; c < 4; c++)
+				texels[i][c] = (uint8_t) palette[index][c];
+		}
+	}
+}
+
+const char* GetBlockFormatName(BlockFormat format)
+{
+	switch(format)
+	{
+	case BlockFormat::BC1: return "BC1";
+	case BlockFormat::BC3: return "BC3";
+	case BlockFormat::BC4: return "BC4";
+	case BlockFormat::BC5: return "BC5";
+	case BlockFormat::BC7: return "BC7";
+	default: return "Uncompressed";
+	}
+}
+
+unsigned int GetBlockBytes(BlockFormat format)
+{
+	switch(format)
+	{
+	case BlockFormat::BC1:
+	case BlockFormat::BC4:
+		return 8;
+	case BlockFormat::BC3:
+	case BlockFormat::BC5:
+	case BlockFormat::BC7:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+unsigned int GetBlockFormatChannels(BlockFormat format)
+{
+	switch(format)
+	{
+	case BlockFormat::BC1: return 3;
+	case BlockFormat::BC4: return 1;
+	case BlockFormat::BC5: return 2;
+	default: return 4;
+	}
+}
+
+unsigned int GetRowPitch(BlockFormat format, unsigned int channels, unsigned int width)
+{
+	if(format == BlockFormat::None)
+		return width * channels;
+	return ((width + 3) / 4) * GetBlockBytes(format);
+}
+
+size_t GetSurfaceSize(BlockFormat format, unsigned int channels, unsigned int width, unsigned int height)
+{
+	if(format == BlockFormat::None)
+		return (size_t) width * height * channels;
+	return (size_t) GetRowPitch(format, channels, width) * ((height + 3) / 4);
+}
+
+bool CanBlockCompress(unsigned int width, unsigned int height)
+{
+	return width % 4 == 0 && height % 4 == 0;
+}
+
+void CompressImage(const Image& image, BlockFormat format, std::vector<uint8_t>& blocks)
+{
+	unsigned int blocksWide = (image.width + 3) / 4;
+	unsigned int blocksHigh = (image.height + 3) / 4;
+	unsigned int blockBytes = GetBlockBytes(format);
+	blocks.resize((size_t) blocksWide * blocksHigh * blockBytes);
+
+	ThreadPool::Global().ParallelFor(blocksHigh, 4, [&](size_t begin, size_t end)
+	{
+		for(size_t blockY = begin; blockY < end; blockY++)
+		{
+			for(unsigned int blockX = 0; blockX < blocksWide; blockX++)
+			{
+				// Gather the block, repeating the edge for blocks that hang off the image
+				float texels[16][4];
+				for(unsigned int i = 0; i < 16; i++)
+				{
+					unsigned int x = blockX * 4 + i % 4;
+					unsigned int y = (unsigned int) blockY * 4 + i / 4;
+					size_t p = (size_t) (y < image.height ? y : image.height - 1) * image.width + (x < image.width ? x : image.width - 1);
+					for(unsigned int c = 0; c < 4; c++)
+						texels[i][c] = GetChannel(image, p, c);
+				}
+
+				uint8_t* block = &blocks[((size_t) blockY * blocksWide + blockX) * blockBytes];
+				switch(format)
+				{
+				case BlockFormat::BC1:
+					EncodeColorBlock(texels, block);
+					break;
+				case BlockFormat::BC3:
+					EncodeSingleChannelBlock(texels, 3, block);
+					EncodeColorBlock(texels, block + 8);
+					break;
+				case BlockFormat::BC4:
+					EncodeSingleChannelBlock(texels, 0, block);
+					break;
+				case BlockFormat::BC5:
+					EncodeSingleChannelBlock(texels, 0, block);
+					EncodeSingleChannelBlock(texels, 1, block + 8);
+					break;
+				case BlockFormat::BC7:
+					EncodeMode6Block(texels, block);
+					break;
+				default:
+					break;
+				}
+			}
+		}
+	});
+}
+
+Image DecompressImage(const uint8_t* blocks, unsigned int width, unsigned int height, BlockFormat format)
+{
+	unsigned int channels = format == BlockFormat::BC4 ? 1 : 4;
+	Image image = { width, height, channels, false, {} };
+	image.pixels.resize((size_t) width * height * channels);
+
+	unsigned int blocksWide = (width + 3) / 4;
+	unsigned int blocksHigh = (height + 3) / 4;
+	unsigned int blockBytes = GetBlockBytes(format);
+	for(unsigned int blockY = 0; blockY < blocksHigh; blockY++)
+	{
+		for(unsigned int blockX = 0; blockX < blocksWide; blockX++)
+		{
+			const uint8_t* block = &blocks[((size_t) blockY * blocksWide + blockX) * blockBytes];
+
+			uint8_t texels[16][4] = {};
+			uint8_t values[16];
+			switch(format)
+			{
+			case BlockFormat::BC1:
+				DecodeColorBlock(block, texels);
+				break;
+			case BlockFormat::BC3:
+				DecodeColorBlock(block + 8, texels);
+				DecodeSingleChannelBlock(block, values);
+				for(int i = 0; i < 16; i++)
+					texels[i][3] = values[i];
+				break;
+			case BlockFormat::BC4:
+				DecodeSingleChannelBlock(block, values);
+				for(int i = 0; i < 16; i++)
+					texels[i][0] = values[i];
+				break;
+			case BlockFormat::BC5:
+				DecodeSingleChannelBlock(block, values);
+				for(int i = 0; i < 16; i++)
+					texels[i][0] = values[i];
+				DecodeSingleChannelBlock(block + 8, values);
+				for(int i = 0; i < 16; i++)
+				{
+					texels[i][1] = values[i];
+					texels[i][3] = 255;
+				}
+				break;
+			case BlockFormat::BC7:
+				DecodeMode6Block(block, texels);
+				break;
+			default:
+				break;
+			}
+
+			// Only copy out the texels that are actually in the image
+			for(unsigned int i = 0; i < 16; i++)
+			{
+				unsigned int x = blockX * 4 + i % 4;
+				unsigned int y = blockY * 4 + i / 4;
+				if(x >= width || y >= height)
+					continue;
+				memcpy(&image.pixels[((size_t) y * width + x) * channels], texels[i], channels);
+			}
+		}
+	}
+	return image;
+}
+
+double ComputePsnr(const Image& original, const Image& decoded, unsigned int channelCount)
+{
+	double squaredError = 0.0;
+	size_t pixelCount = (size_t) original.width * original.height;
+	for(size_t p = 0; p < pixelCount; p++)
+	{
+		for(unsigned int c = 0; c < channelCount; c++)
+		{
+			double difference = (double) GetChannel(original, p, c) - GetChannel(decoded, p, c);
+			squaredError += difference * difference;
+		}
+	}
+
+	double meanSquaredError = squaredError / ((double) pixelCount * channelCount);
+	if(meanSquaredError == 0.0)
+		return std::numeric_limits<double>::infinity();
+	return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Image.h"
+
+// --------------------------------------------------------
+// Block compressed (BCn) texture formats, encoded on the CPU
+// - Every format stores 4x4 texel blocks, left to right and
+//   top to bottom; edge blocks repeat the last row/column
+// - BC1: RGB in 8 bytes (two 565 colors, 2 bits per texel)
+// - BC3: a BC4 alpha block followed by a BC1 color block
+// - BC4: one channel (red) in 8 bytes (3 bits per texel)
+// - BC5: two channels (red, green) as two BC4 blocks
+// - BC7: RGBA in 16 bytes; only mode 6 (one pair of 7-bit
+//   endpoints with p-bits, 4 bits per texel) is produced
+// --------------------------------------------------------
+enum class BlockFormat : uint32_t
+{
+	None,	// Uncompressed, 1 or 4 bytes per texel
+	BC1,
+	BC3,
+	BC4,
+	BC5,
+	BC7
+};
+
+const char* GetBlockFormatName(BlockFormat format);
+
+// Bytes per 4x4 block (0 when uncompressed)
+unsigned int GetBlockBytes(BlockFormat format);
+
+// How many of a texel's channels (RGBA order) the format keeps
+unsigned int GetBlockFormatChannels(BlockFormat format);
+
+// Bytes per row of texels, or per row of blocks when compressed
+unsigned int GetRowPitch(BlockFormat format, unsigned int channels, unsigned int width);
+
+// Bytes for a whole surface (one mip)
+size_t GetSurfaceSize(BlockFormat format, unsigned int channels, unsigned int width, unsigned int height);
+
+// D3D11 only allows block compressed textures whose top mip is a whole number of blocks
+bool CanBlockCompress(unsigned int width, unsigned int height);
+
+// Encodes a 1 or 4 channel image, splitting rows of blocks across the global thread pool
+// - Grayscale images are treated as (gray, gray, gray, 255)
+void CompressImage(const Image& image, BlockFormat format, std::vector<uint8_t>& blocks);
+
+// Decodes blocks back into an image (BC4 gives 1 channel, everything else RGBA)
+// - Meant for checking quality, so BC7 only understands the mode it's encoded with
+Image DecompressImage(const uint8_t* blocks, unsigned int width, unsigned int height, BlockFormat format);
+
+// Peak signal to noise ratio (in dB) over the first channelCount channels (higher is better;
+// infinite when identical)
+double ComputePsnr(const Image& original, const Image& decoded, unsigned int channelCount);
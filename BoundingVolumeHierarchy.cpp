@@ -0,0 +1,444 @@
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+using namespace DirectX;
+
+namespace
+{
+	const uint32_t InsideBit = 0x80000000u; // Marks stack entries already known to be inside the frustum
+
+	float SurfaceArea(const XMFLOAT3& min, const XMFLOAT3& max)
+	{
+		float x = max.x - min.x;
+		float y = max.y - min.y;
+		float z = max.z - min.z;
+		return 2.0f * (x * y + y * z + z * x);
+	}
+
+	void Grow(XMFLOAT3& min, XMFLOAT3& max, const XMFLOAT3& otherMin, const XMFLOAT3& otherMax)
+	{
+		min = XMFLOAT3(std::fmin(min.x, otherMin.x), std::fmin(min.y, otherMin.y), std::fmin(min.z, otherMin.z));
+		max = XMFLOAT3(std::fmax(max.x, otherMax.x), std::fmax(max.y, otherMax.y), std::fmax(max.z, otherMax.z));
+	}
+
+	XMFLOAT3 BoundsMin(const MeshBounds& bounds)
+	{
+		return XMFLOAT3(bounds.center.x - bounds.extents.x, bounds.center.y - bounds.extents.y, bounds.center.z - bounds.extents.z);
+	}
+	XMFLOAT3 BoundsMax(const MeshBounds& bounds)
+	{
+		return XMFLOAT3(bounds.center.x + bounds.extents.x, bounds.center.y + bounds.extents.y, bounds.center.z + bounds.extents.z);
+	}
+
+	float Component(const XMFLOAT3& vector, int axis)
+	{
+		return axis == 0 ? vector.x : (axis == 1 ? vector.y : vector.z);
+	}
+
+	// --------------------------------------------------------
+	// Slab test: where (if anywhere between 0 and maxDistance)
+	// the ray enters the box
+	// - Zero direction components give infinite reciprocals;
+	//   fmin/fmax skip the NaNs those can make
+	// --------------------------------------------------------
+	bool RayHitsBox(const XMFLOAT3& min, const XMFLOAT3& max, const XMFLOAT3& origin, const XMFLOAT3& inverseDirection, float maxDistance, float& entry)
+	{
+		float nearX = (min.x - origin.x) * inverseDirection.x, farX = (max.x - origin.x) * inverseDirection.x;
+		float nearY = (min.y - origin.y) * inverseDirection.y, farY = (max.y - origin.y) * inverseDirection.y;
+		float nearZ = (min.z - origin.z) * inverseDirection.z, farZ = (max.z - origin.z) * inverseDirection.z;
+
+		float enter = std::fmax(std::fmax(std::fmin(nearX, farX), std::fmin(nearY, farY)), std::fmax(std::fmin(nearZ, farZ), 0.0f));
+		float exit = std::fmin(std::fmin(std::fmax(nearX, farX), std::fmax(nearY, farY)), std::fmin(std::fmax(nearZ, farZ), maxDistance));
+		entry = enter;
+		return enter <= exit;
+	}
+
+	bool BoxesOverlap(const XMFLOAT3& minA, const XMFLOAT3& maxA, const XMFLOAT3& minB, const XMFLOAT3& maxB)
+	{
+		return minA.x <= maxB.x && maxA.x >= minB.x && minA.y <= maxB.y && maxA.y >= minB.y && minA.z <= maxB.z && maxA.z >= minB.z;
+	}
+}
+
+void BoundingVolumeHierarchy::FitLeaf(Node& node)
+{
+	const MeshBounds& firstBounds = objectBounds[objectIndices[node.first]];
+	node.min = BoundsMin(firstBounds);
+	node.max = BoundsMax(firstBounds);
+	for(uint32_t i = 1; i < node.objectCount; i++)
+	{
+		const MeshBounds& bounds = objectBounds[objectIndices[node.first + i]];
+		Grow(node.min, node.max, BoundsMin(bounds), BoundsMax(bounds));
+	}
+}
+
+float BoundingVolumeHierarchy::CalculateCost()
+{
+	if(nodes.empty())
+		return 0.0f;
+
+	// Every node is tested when its parent is visited, which happens about as often as its area (relative to
+	// the root's) - plus, for leaves, each of their objects
+	float rootArea = SurfaceArea(nodes[0].min, nodes[0].max);
+	if(rootArea <= 0.0f)
+		return 1.0f;
+
+	double total = 0.0;
+	for(const Node& node : nodes)
+		total += SurfaceArea(node.min, node.max) * (node.objectCount > 0 ? node.objectCount : 1);
+	return (float) (total / rootArea);
+}
+
+// --------------------------------------------------------
+// Splits ranges of objectIndices until every leaf holds at
+// most MaxLeafObjects objects
+// - Each split bins the objects' centers along the node's
+//   longest axis (of centers) and picks the bin boundary
+//   with the least surface area * object count on both
+//   sides; if everything lands on one side (or every center
+//   is the same), it splits the range down the middle
+// --------------------------------------------------------
+void BoundingVolumeHierarchy::Build(const MeshBounds* bounds, size_t count)
+{
+	objectBounds.assign(bounds, bounds + count);
+	objectIndices.resize(count);
+	std::iota(objectIndices.begin(), objectIndices.end(), 0);
+	nodes.clear();
+	if(count == 0)
+	{
+		cost = builtCost = 0.0f;
+		return;
+	}
+	nodes.reserve(count / 2 + 1);
+
+	struct Range { uint32_t node, start, end; };
+	std::vector<Range> pending;
+	nodes.push_back({});
+	pending.push_back({ 0, 0, (uint32_t) count });
+	while(!pending.empty())
+	{
+		Range range = pending.back();
+		pending.pop_back();
+		uint32_t objectCount = range.end - range.start;
+
+		// Bounds of the objects and of their centers
+		XMFLOAT3 min = BoundsMin(objectBounds[objectIndices[range.start]]);
+		XMFLOAT3 max = BoundsMax(objectBounds[objectIndices[range.start]]);
+		XMFLOAT3 centerMin = objectBounds[objectIndices[range.start]].center;
+		XMFLOAT3 centerMax = centerMin;
+		for(uint32_t i = range.start + 1; i < range.end; i++)
+		{
+			const MeshBounds& object = objectBounds[objectIndices[i]];
+			Grow(min, max, BoundsMin(object), BoundsMax(object));
+			Grow(centerMin, centerMax, object.center, object.center);
+		}
+		nodes[range.node].min = min;
+		nodes[range.node].max = max;
+
+		if(objectCount <= MaxLeafObjects)
+		{
+			nodes[range.node].first = range.start;
+			nodes[range.node].objectCount = objectCount;
+			continue;
+		}
+
+		XMFLOAT3 centerSize(centerMax.x - centerMin.x, centerMax.y - centerMin.y, centerMax.z - centerMin.z);
+		int axis = centerSize.x > centerSize.y ? (centerSize.x > centerSize.z ? 0 : 2) : (centerSize.y > centerSize.z ? 1 : 2);
+		float axisMin = Component(centerMin, axis);
+		float axisSize = Component(centerSize, axis);
+
+		uint32_t middle = range.start;
+		if(axisSize > 0.0f)
+		{
+			float binScale = SplitBinCount / axisSize;
+			auto binOf = [&](uint32_t object)
+			{
+				int bin = (int) ((Component(objectBounds[object].center, axis) - axisMin) * binScale);
+				return bin < (int) SplitBinCount ? bin : (int) SplitBinCount - 1;
+			};
+
+			uint32_t binCounts[SplitBinCount] = {};
+			XMFLOAT3 binMins[SplitBinCount], binMaxes[SplitBinCount];
+			for(uint32_t i = range.start; i < range.end; i++)
+			{
+				int bin = binOf(objectIndices[i]);
+				const MeshBounds& object = objectBounds[objectIndices[i]];
+				if(binCounts[bin]++ == 0)
+				{
+					binMins[bin] = BoundsMin(object);
+					binMaxes[bin] = BoundsMax(object);
+				}
+				else
+					Grow(binMins[bin], binMaxes[bin], BoundsMin(object), BoundsMax(object));
+			}
+
+			// Sweep from the right to know each boundary's right side cost, then from the left to find the best
+			float rightCosts[SplitBinCount] = {};
+			XMFLOAT3 sideMin(0, 0, 0), sideMax(0, 0, 0); // Only read once sideCount > 0 has set them
+			uint32_t sideCount = 0;
+			for(int bin = SplitBinCount - 1; bin > 0; bin--)
+			{
+				if(binCounts[bin] > 0)
+				{
+					if(sideCount == 0)
+					{
+						sideMin = binMins[bin];
+						sideMax = binMaxes[bin];
+					}
+					else
+						Grow(sideMin, sideMax, binMins[bin], binMaxes[bin]);
+					sideCount += binCounts[bin];
+				}
+				rightCosts[bin] = sideCount > 0 ? SurfaceArea(sideMin, sideMax) * sideCount : 0.0f;
+			}
+
+			float bestCost = INFINITY;
+			int bestBin = -1; // Last bin on the left
+			sideCount = 0;
+			for(int bin = 0; bin < (int) SplitBinCount - 1; bin++)
+			{
+				if(binCounts[bin] > 0)
+				{
+					if(sideCount == 0)
+					{
+						sideMin = binMins[bin];
+						sideMax = binMaxes[bin];
+					}
+					else
+						Grow(sideMin, sideMax, binMins[bin], binMaxes[bin]);
+					sideCount += binCounts[bin];
+				}
+				if(sideCount == 0 || sideCount == objectCount)
+					continue;
+
+				float splitCost = SurfaceArea(sideMin, sideMax) * sideCount + rightCosts[bin + 1];
+				if(splitCost < bestCost)
+				{
+					bestCost = splitCost;
+					bestBin = bin;
+				}
+			}
+
+			if(bestBin >= 0)
+			{
+				middle = (uint32_t) (std::partition(objectIndices.begin() + range.start, objectIndices.begin() + range.end,
+					[&](uint32_t object) { return binOf(object) <= bestBin; }) - objectIndices.begin());
+			}
+		}
+		if(middle == range.start || middle == range.end)
+			middle = range.start + objectCount / 2;
+
+		// Both children at once, so they sit side by side
+		uint32_t left = (uint32_t) nodes.size();
+		nodes.push_back({});
+		nodes.push_back({});
+		nodes[range.node].first = left;
+		nodes[range.node].objectCount = 0;
+		pending.push_back({ left + 1, middle, range.end });
+		pending.push_back({ left, range.start, middle });
+	}
+
+	cost = builtCost = CalculateCost();
+}
+
+void BoundingVolumeHierarchy::Refit(const MeshBounds* bounds)
+{
+	objectBounds.assign(bounds, bounds + objectBounds.size());
+
+	// Children always come after their parents, so back to front sees them first
+	for(size_t i = nodes.size(); i-- > 0;)
+	{
+		Node& node = nodes[i];
+		if(node.objectCount > 0)
+			FitLeaf(node);
+		else
+		{
+			node.min = nodes[node.first].min;
+			node.max = nodes[node.first].max;
+			Grow(node.min, node.max, nodes[node.first + 1].min, nodes[node.first + 1].max);
+		}
+	}
+
+	cost = CalculateCost();
+}
+
+// --------------------------------------------------------
+// Nodes entirely inside every plane take all of their
+// objects without testing anything below them; nodes only
+// partly inside have their children (or objects) tested
+// --------------------------------------------------------
+size_t BoundingVolumeHierarchy::QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& objects)
+{
+	if(nodes.empty())
+		return 0;
+
+	size_t found = 0;
+	stack.clear();
+	stack.push_back(0);
+	while(!stack.empty())
+	{
+		uint32_t entry = stack.back();
+		stack.pop_back();
+		const Node& node = nodes[entry & ~InsideBit];
+
+		bool isInside = (entry & InsideBit) != 0;
+		if(!isInside)
+		{
+			XMFLOAT3 center((node.min.x + node.max.x) * 0.5f, (node.min.y + node.max.y) * 0.5f, (node.min.z + node.max.z) * 0.5f);
+			XMFLOAT3 extents((node.max.x - node.min.x) * 0.5f, (node.max.y - node.min.y) * 0.5f, (node.max.z - node.min.z) * 0.5f);
+			bool isOutside = false;
+			isInside = true;
+			for(const XMFLOAT4& plane : frustum.planes)
+			{
+				float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+				float reach = std::fabs(plane.x) * extents.x + std::fabs(plane.y) * extents.y + std::fabs(plane.z) * extents.z;
+				if(distance < -reach)
+				{
+					isOutside = true;
+					break;
+				}
+				if(distance < reach)
+					isInside = false;
+			}
+			if(isOutside)
+				continue;
+		}
+
+		if(node.objectCount > 0)
+		{
+			for(uint32_t i = node.first; i < node.first + node.objectCount; i++)
+			{
+				const MeshBounds& object = objectBounds[objectIndices[i]];
+				if(isInside || (frustum.IntersectsBox(object.center, object.extents) && frustum.IntersectsSphere(object.center, object.radius)))
+				{
+					objects.push_back(objectIndices[i]);
+					found++;
+				}
+			}
+		}
+		else
+		{
+			stack.push_back(node.first | (isInside ? InsideBit : 0));
+			stack.push_back((node.first + 1) | (isInside ? InsideBit : 0));
+		}
+	}
+	return found;
+}
+
+size_t BoundingVolumeHierarchy::QueryOverlap(const XMFLOAT3& center, const XMFLOAT3& extents, std::vector<uint32_t>& objects)
+{
+	if(nodes.empty())
+		return 0;
+
+	XMFLOAT3 min(center.x - extents.x, center.y - extents.y, center.z - extents.z);
+	XMFLOAT3 max(center.x + extents.x, center.y + extents.y, center.z + extents.z);
+
+	size_t found = 0;
+	stack.clear();
+	stack.push_back(0);
+	while(!stack.empty())
+	{
+		const Node& node = nodes[stack.back()];
+		stack.pop_back();
+		if(!BoxesOverlap(node.min, node.max, min, max))
+			continue;
+
+		if(node.objectCount > 0)
+		{
+			for(uint32_t i = node.first; i < node.first + node.objectCount; i++)
+			{
+				const MeshBounds& object = objectBounds[objectIndices[i]];
+				if(BoxesOverlap(BoundsMin(object), BoundsMax(object), min, max))
+				{
+					objects.push_back(objectIndices[i]);
+					found++;
+				}
+			}
+		}
+		else
+		{
+			stack.push_back(node.first);
+			stack.push_back(node.first + 1);
+		}
+	}
+	return found;
+}
+
+// --------------------------------------------------------
+// Visits the nearer child first, and skips any node the
+// ray enters further away than the nearest hit so far
+// --------------------------------------------------------
+bool BoundingVolumeHierarchy::Raycast(const XMFLOAT3& origin, const XMFLOAT3& direction, float maxDistance, uint32_t& object, float& distance)
+{
+	if(nodes.empty())
+		return false;
+
+	XMFLOAT3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+	float nearest = maxDistance;
+	bool isHit = false;
+
+	float entry;
+	if(!RayHitsBox(nodes[0].min, nodes[0].max, origin, inverseDirection, nearest, entry))
+		return false;
+	stack.clear();
+	stackDistances.clear();
+	stack.push_back(0);
+	stackDistances.push_back(entry);
+	while(!stack.empty())
+	{
+		const Node& node = nodes[stack.back()];
+		float nodeEntry = stackDistances.back();
+		stack.pop_back();
+		stackDistances.pop_back();
+		if(nodeEntry > nearest)
+			continue;
+
+		if(node.objectCount > 0)
+		{
+			for(uint32_t i = node.first; i < node.first + node.objectCount; i++)
+			{
+				const MeshBounds& bounds = objectBounds[objectIndices[i]];
+				if(RayHitsBox(BoundsMin(bounds), BoundsMax(bounds), origin, inverseDirection, nearest, entry) && (!isHit || entry < nearest))
+				{
+					nearest = entry;
+					object = objectIndices[i];
+					isHit = true;
+				}
+			}
+			continue;
+		}
+
+		float leftEntry, rightEntry;
+		bool isLeftHit = RayHitsBox(nodes[node.first].min, nodes[node.first].max, origin, inverseDirection, nearest, leftEntry);
+		bool isRightHit = RayHitsBox(nodes[node.first + 1].min, nodes[node.first + 1].max, origin, inverseDirection, nearest, rightEntry);
+		uint32_t left = node.first;
+
+		// Farther child goes on the stack first, so the nearer is visited next
+		if(isLeftHit && isRightHit && leftEntry < rightEntry)
+		{
+			stack.push_back(left + 1);
+			stackDistances.push_back(rightEntry);
+			stack.push_back(left);
+			stackDistances.push_back(leftEntry);
+		}
+		else
+		{
+			if(isLeftHit)
+			{
+				stack.push_back(left);
+				stackDistances.push_back(leftEntry);
+			}
+			if(isRightHit)
+			{
+				stack.push_back(left + 1);
+				stackDistances.push_back(rightEntry);
+			}
+		}
+	}
+
+	if(isHit)
+		distance = nearest;
+	return isHit;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <DirectXMath.h>
+
+#include "Bounds.h"
+#include "Frustum.h"
+
+// --------------------------------------------------------
+// A tree of boxes over many objects' world bounds, so
+// culling, picking and overlap tests only visit the parts of
+// the scene near what they're looking for
+// - Objects are referred to by their index in the bounds
+//   Build() was given
+// - Built top-down, splitting each node where the surface
+//   area heuristic (binned along its longest axis) says
+//   queries will visit the fewest objects
+// - As objects move, Refit() grows and shrinks the existing
+//   boxes bottom-up instead of building a new tree; that
+//   slowly loosens the tree, so NeedsRebuild() says when its
+//   cost has grown enough to be worth building again
+// - Nodes are stored depth-first with siblings side by
+//   side, so every child comes after its parent
+// --------------------------------------------------------
+class BoundingVolumeHierarchy
+{
+public:
+	static const unsigned int MaxLeafObjects = 4;
+	static const unsigned int SplitBinCount = 16;
+
+	// How much the tree's cost may grow through refitting before NeedsRebuild() says to rebuild it
+	static inline float rebuildCostRatio = 1.5f;
+
+private:
+	struct Node
+	{
+		DirectX::XMFLOAT3 min;
+		uint32_t first;			// Leaves: first of objectIndices; otherwise: left child (right is first + 1)
+		DirectX::XMFLOAT3 max;
+		uint32_t objectCount;	// 0 for nodes that aren't leaves
+	};
+
+	std::vector<Node> nodes;
+	std::vector<uint32_t> objectIndices;	// Every leaf's objects, one contiguous run per leaf
+	std::vector<MeshBounds> objectBounds;	// Per object
+	std::vector<uint32_t> stack;			// Scratch space for queries
+	std::vector<float> stackDistances;		// Where Raycast() enters each node on the stack
+
+	float builtCost = 0.0f;
+	float cost = 0.0f;
+
+	void FitLeaf(Node& node);
+	float CalculateCost();
+
+public:
+	void Build(const MeshBounds* bounds, size_t count);
+	// Updates every object's bounds (the same objects it was built with) and refits the tree around them
+	void Refit(const MeshBounds* bounds);
+
+	// Appends every object whose box and sphere could be inside the frustum; returns how many were found
+	size_t QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& objects);
+	// Appends every object whose box overlaps the given one; returns how many were found
+	size_t QueryOverlap(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents, std::vector<uint32_t>& objects);
+	// Finds the nearest object whose box the ray (direction needn't be normalized; distance is in its
+	// lengths) enters within maxDistance, if any
+	bool Raycast(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction, float maxDistance, uint32_t& object, float& distance);
+
+	size_t GetObjectCount() { return objectBounds.size(); };
+	size_t GetNodeCount() { return nodes.size(); };
+	// Expected boxes visited per query (the surface area heuristic, relative to the root's area)
+	float GetCost() { return cost; };
+	bool NeedsRebuild() { return cost > builtCost * rebuildCostRatio; };
+};
@@ -0,0 +1,145 @@
+#include "Bounds.h"
+
+#include <cmath>
+
+using namespace DirectX;
+
+MeshBounds CalculateMeshBounds(const Vertex* vertices, size_t vertexCount)
+{
+	MeshBounds bounds = {};
+	if(vertexCount == 0)
+		return bounds;
+
+	XMVECTOR minimum = XMLoadFloat3(&vertices[0].position);
+	XMVECTOR maximum = minimum;
+	for(size_t i = 1; i < vertexCount; i++)
+	{
+		XMVECTOR position = XMLoadFloat3(&vertices[i].position);
+		minimum = XMVectorMin(minimum, position);
+		maximum = XMVectorMax(maximum, position);
+	}
+	XMVECTOR center = (minimum + maximum) * 0.5f;
+	XMStoreFloat3(&bounds.center, center);
+	XMStoreFloat3(&bounds.extents, (maximum - minimum) * 0.5f);
+
+	// Second pass for the sphere, now that its center is known
+	float radiusSquared = 0.0f;
+	for(size_t i = 0; i < vertexCount; i++)
+	{
+		float distanceSquared = XMVectorGetX(XMVector3LengthSq(XMLoadFloat3(&vertices[i].position) - center));
+		radiusSquared = distanceSquared > radiusSquared ? distanceSquared : radiusSquared;
+	}
+	bounds.radius = std::sqrt(radiusSquared);
+	return bounds;
+}
+
+MeshBounds TransformMeshBounds(const MeshBounds& localBounds, const XMFLOAT4X4& world)
+{
+	// Row vectors, so each world axis gets every local axis's contribution down one column
+	const auto& m = world.m;
+	XMFLOAT3 center(
+		localBounds.center.x * m[0][0] + localBounds.center.y * m[1][0] + localBounds.center.z * m[2][0] + m[3][0],
+		localBounds.center.x * m[0][1] + localBounds.center.y * m[1][1] + localBounds.center.z * m[2][1] + m[3][1],
+		localBounds.center.x * m[0][2] + localBounds.center.y * m[1][2] + localBounds.center.z * m[2][2] + m[3][2]);
+	const XMFLOAT3& e = localBounds.extents;
+	XMFLOAT3 extents(
+		e.x * std::fabs(m[0][0]) + e.y * std::fabs(m[1][0]) + e.z * std::fabs(m[2][0]),
+		e.x * std::fabs(m[0][1]) + e.y * std::fabs(m[1][1]) + e.z * std::fabs(m[2][1]),
+		e.x * std::fabs(m[0][2]) + e.y * std::fabs(m[1][2]) + e.z * std::fabs(m[2][2]));
+
+	float maxScaleSquared = 0.0f;
+	for(int row = 0; row < 3; row++)
+	{
+		float scaleSquared = m[row][0] * m[row][0] + m[row][1] * m[row][1] + m[row][2] * m[row][2];
+		maxScaleSquared = scaleSquared > maxScaleSquared ? scaleSquared : maxScaleSquared;
+	}
+	return { center, extents, localBounds.radius * std::sqrt(maxScaleSquared) };
+}
+
+void BoundsBatch::Clear()
+{
+	count = 0;
+}
+
+void BoundsBatch::Add(const MeshBounds& localBounds, const XMFLOAT4X4& world)
+{
+	Add(TransformMeshBounds(localBounds, world));
+}
+
+void BoundsBatch::Add(const MeshBounds& worldBounds)
+{
+	// Grow a whole group of four at a time, so Cull() never reads past the end
+	if(count == centerX.size())
+	{
+		size_t newSize = count + 4;
+		for(std::vector<float>* component : { &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ, &radii })
+			component->resize(newSize, 0.0f);
+	}
+
+	centerX[count] = worldBounds.center.x;
+	centerY[count] = worldBounds.center.y;
+	centerZ[count] = worldBounds.center.z;
+	extentX[count] = worldBounds.extents.x;
+	extentY[count] = worldBounds.extents.y;
+	extentZ[count] = worldBounds.extents.z;
+	radii[count] = worldBounds.radius;
+	count++;
+}
+
+// --------------------------------------------------------
+// Tests four objects per plane at a time, one SIMD lane per
+// object: each is outside a plane when its center is
+// further behind it than both how far its box reaches
+// towards the plane and its sphere's radius
+// - Lanes past the end (in the last group) are tested too,
+//   but never written out
+// --------------------------------------------------------
+size_t BoundsBatch::Cull(const Frustum& frustum, std::vector<uint8_t>& visible) const
+{
+	visible.resize(count);
+
+	// Each plane's components splatted across all four lanes, and their absolute values for the boxes' reach
+	XMVECTOR planeX[6], planeY[6], planeZ[6], planeW[6];
+	XMVECTOR absPlaneX[6], absPlaneY[6], absPlaneZ[6];
+	for(int p = 0; p < 6; p++)
+	{
+		const XMFLOAT4& plane = frustum.planes[p];
+		planeX[p] = XMVectorReplicate(plane.x);
+		planeY[p] = XMVectorReplicate(plane.y);
+		planeZ[p] = XMVectorReplicate(plane.z);
+		planeW[p] = XMVectorReplicate(plane.w);
+		absPlaneX[p] = XMVectorReplicate(std::fabs(plane.x));
+		absPlaneY[p] = XMVectorReplicate(std::fabs(plane.y));
+		absPlaneZ[p] = XMVectorReplicate(std::fabs(plane.z));
+	}
+
+	size_t visibleCount = 0;
+	for(size_t first = 0; first < count; first += 4)
+	{
+		XMVECTOR cx = XMLoadFloat4((const XMFLOAT4*) &centerX[first]);
+		XMVECTOR cy = XMLoadFloat4((const XMFLOAT4*) &centerY[first]);
+		XMVECTOR cz = XMLoadFloat4((const XMFLOAT4*) &centerZ[first]);
+		XMVECTOR ex = XMLoadFloat4((const XMFLOAT4*) &extentX[first]);
+		XMVECTOR ey = XMLoadFloat4((const XMFLOAT4*) &extentY[first]);
+		XMVECTOR ez = XMLoadFloat4((const XMFLOAT4*) &extentZ[first]);
+		XMVECTOR radius = XMLoadFloat4((const XMFLOAT4*) &radii[first]);
+
+		XMVECTOR outside = XMVectorFalseInt();
+		for(int p = 0; p < 6; p++)
+		{
+			XMVECTOR distance = planeX[p] * cx + planeY[p] * cy + planeZ[p] * cz + planeW[p];
+			XMVECTOR reach = XMVectorMin(absPlaneX[p] * ex + absPlaneY[p] * ey + absPlaneZ[p] * ez, radius);
+			outside = XMVectorOrInt(outside, XMVectorLess(distance, -reach));
+		}
+
+		XMFLOAT4 visibleLanes;
+		XMStoreFloat4(&visibleLanes, XMVectorSelect(XMVectorSplatOne(), XMVectorZero(), outside));
+		const float* lanes = &visibleLanes.x;
+		for(size_t lane = 0; lane < 4 && first + lane < count; lane++)
+		{
+			visible[first + lane] = lanes[lane] != 0.0f ? 1 : 0;
+			visibleCount += visible[first + lane];
+		}
+	}
+	return visibleCount;
+}
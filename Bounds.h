@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <DirectXMath.h>
+
+#include "Vertex.h"
+#include "Frustum.h"
+
+// --------------------------------------------------------
+// An axis-aligned box (center and half-size) and a sphere
+// around the same center, in a mesh's local space
+// - The sphere is the smallest one around the box's center
+//   that holds every vertex, so it's often much tighter than
+//   the box's own corners once the box is rotated
+// --------------------------------------------------------
+struct MeshBounds
+{
+	DirectX::XMFLOAT3 center;
+	DirectX::XMFLOAT3 extents;
+	float radius;
+};
+
+MeshBounds CalculateMeshBounds(const Vertex* vertices, size_t vertexCount);
+
+// Local bounds moved into the world: the box around the transformed box, and the sphere scaled by
+// the world matrix's longest axis
+MeshBounds TransformMeshBounds(const MeshBounds& localBounds, const DirectX::XMFLOAT4X4& world);
+
+// --------------------------------------------------------
+// World space bounds of many objects, kept one float array
+// per component (padded to a multiple of four) so a frustum
+// can test four of them at once with SIMD
+// --------------------------------------------------------
+class BoundsBatch
+{
+private:
+	std::vector<float> centerX, centerY, centerZ;
+	std::vector<float> extentX, extentY, extentZ;
+	std::vector<float> radii;
+	size_t count = 0;
+
+public:
+	void Clear();
+	void Add(const MeshBounds& localBounds, const DirectX::XMFLOAT4X4& world);
+	// Adds bounds that are already in world space
+	void Add(const MeshBounds& worldBounds);
+
+	size_t GetCount() const { return count; };
+
+	// Sets visible[i] to 1 for every object that might be inside the frustum (outside neither its box
+	// nor its sphere, plane by plane) and 0 otherwise; returns how many are visible
+	size_t Cull(const Frustum& frustum, std::vector<uint8_t>& visible) const;
+};
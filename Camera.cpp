@@ -12,32 +12,53 @@ Camera::Camera(DirectX::XMFLOAT3 location, DirectX::XMFLOAT3 rotation, float asp
 void Camera::Update(float deltaTime)
 {
 	// Minecraft controls
+	float distance = deltaTime * movementSpeed;
+	XMFLOAT3 relativeOffset = XMFLOAT3(0, 0, 0);
+	float verticalOffset = 0;
 	if(Input::KeyDown('W'))
-		transform.MoveRelative(0, 0, deltaTime * movementSpeed);
+		relativeOffset.z += distance;
 	if(Input::KeyDown('S'))
-		transform.MoveRelative(0, 0, -deltaTime * movementSpeed);
+		relativeOffset.z -= distance;
 	if(Input::KeyDown('D'))
-		transform.MoveRelative(deltaTime * movementSpeed, 0, 0);
+		relativeOffset.x += distance;
 	if(Input::KeyDown('A'))
-		transform.MoveRelative(-deltaTime * movementSpeed, 0, 0);
+		relativeOffset.x -= distance;
 	if(Input::KeyDown(VK_SPACE))
-		transform.MoveAbsolute(0, deltaTime * movementSpeed, 0);
+		verticalOffset += distance;
 	if(Input::KeyDown(VK_LSHIFT))
-		transform.MoveAbsolute(0, -deltaTime * movementSpeed, 0);
+		verticalOffset -= distance;
 
 	// Camera looking (while LMB is held)
+	float pitchDelta = 0;
+	float yawDelta = 0;
 	if(Input::MouseLeftDown())
 	{
-		float deltaX = Input::GetMouseXDelta() * lookSpeed;
-		float deltaY = Input::GetMouseYDelta() * lookSpeed;
+		yawDelta = Input::GetMouseXDelta() * lookSpeed;
+		pitchDelta = Input::GetMouseYDelta() * lookSpeed;
+	}
 
-		transform.Rotate(deltaY, deltaX, 0);
+	Move(relativeOffset, verticalOffset, pitchDelta, yawDelta);
+}
 
-		// Clamp camera pitch between -1/2 PI and +1/2 PI
-		if(transform.GetPitchYawRoll().x < -XM_PIDIV2)
-			transform.SetRotation(-XM_PIDIV2, transform.GetPitchYawRoll().y, transform.GetPitchYawRoll().z);
-		if(transform.GetPitchYawRoll().x > XM_PIDIV2)
-			transform.SetRotation(XM_PIDIV2, transform.GetPitchYawRoll().y, transform.GetPitchYawRoll().z);
+void Camera::Move(XMFLOAT3 relativeOffset, float verticalOffset, float pitchDelta, float yawDelta)
+{
+	if(relativeOffset.x != 0 || relativeOffset.y != 0 || relativeOffset.z != 0)
+		transform.MoveRelative(relativeOffset);
+	if(verticalOffset != 0)
+		transform.MoveAbsolute(0, verticalOffset, 0);
+
+	// Turn once, with the pitch already clamped between -1/2 PI and +1/2 PI, so the rotation (and
+	// the basis vectors the view matrix is built from) is only worked out once
+	if(pitchDelta != 0 || yawDelta != 0)
+	{
+		XMFLOAT3 rotation = transform.GetPitchYawRoll();
+		rotation.x += pitchDelta;
+		rotation.y += yawDelta;
+		if(rotation.x < -XM_PIDIV2)
+			rotation.x = -XM_PIDIV2;
+		if(rotation.x > XM_PIDIV2)
+			rotation.x = XM_PIDIV2;
+		transform.SetRotation(rotation);
 	}
 
 	// Make sure the view matrix reflects any changes
@@ -69,4 +90,17 @@ XMFLOAT4X4 Camera::GetViewMatrix()
 XMFLOAT4X4 Camera::GetProjectionMatrix()
 {
 	return projMatrix;
-}
\ No newline at end of file
+}
+
+void Camera::ScreenPointToRay(float x, float y, float screenWidth, float screenHeight, XMFLOAT3& origin, XMFLOAT3& direction)
+{
+	// Back from clip space (y points up there, but down on screen) at both ends of the depth range
+	XMMATRIX inverseViewProjection = XMMatrixInverse(nullptr, XMLoadFloat4x4(&viewMatrix) * XMLoadFloat4x4(&projMatrix));
+	float clipX = x / screenWidth * 2.0f - 1.0f;
+	float clipY = 1.0f - y / screenHeight * 2.0f;
+	XMVECTOR nearPoint = XMVector3TransformCoord(XMVectorSet(clipX, clipY, 0.0f, 1.0f), inverseViewProjection);
+	XMVECTOR farPoint = XMVector3TransformCoord(XMVectorSet(clipX, clipY, 1.0f, 1.0f), inverseViewProjection);
+
+	XMStoreFloat3(&origin, nearPoint);
+	XMStoreFloat3(&direction, farPoint - nearPoint);
+}
@@ -23,6 +23,9 @@ public:
 	Camera(DirectX::XMFLOAT3 location, DirectX::XMFLOAT3 rotation, float aspectRatio, float fov);
 
 	void Update(float deltaTime);
+	// What Update() does with the input: offset along the camera's axes, offset straight up, and
+	// turning (pitch clamped to straight up or down)
+	void Move(DirectX::XMFLOAT3 relativeOffset, float verticalOffset, float pitchDelta, float yawDelta);
 
 	DirectX::XMFLOAT4X4 UpdateViewMatrix();
 	DirectX::XMFLOAT4X4 UpdateProjectionMatrix(float aspectRatio);
@@ -30,6 +33,11 @@ public:
 	DirectX::XMFLOAT4X4 GetViewMatrix();
 	DirectX::XMFLOAT4X4 GetProjectionMatrix();
 
-	Transform GetTransform() { return transform; }
+	// World space ray through a point on screen (in pixels from the top left), starting on the near
+	// plane with a direction that reaches the far plane at a distance of 1
+	void ScreenPointToRay(float x, float y, float screenWidth, float screenHeight, DirectX::XMFLOAT3& origin, DirectX::XMFLOAT3& direction);
+
+	Transform& GetTransform() { return transform; }
 	float GetFOV() { return fov; }
-};
\ No newline at end of file
+	float GetFarDistance() { return farDistance; }
+};
@@ -0,0 +1,29 @@
+#include "ConstantBufferData.h"
+
+#include <cstring>
+
+void SetConstantData(unsigned char* localData, bool& isDirty, unsigned int byteOffset, const void* data, unsigned int size)
+{
+	// Comparing first is far cheaper than a copy to the GPU, which is what an unneeded dirty costs
+	unsigned char* destination = localData + byteOffset;
+	if(memcmp(destination, data, size) == 0)
+		return;
+
+	memcpy(destination, data, size);
+	isDirty = true;
+}
+
+bool ShouldCopyConstantBuffer(bool& isDirty, unsigned int bufferSize, bool skipClean, SimpleBufferCopyStats& stats)
+{
+	if(skipClean && !isDirty)
+	{
+		stats.SkipCount++;
+		stats.BytesSkipped += bufferSize;
+		return false;
+	}
+
+	isDirty = false;
+	stats.CopyCount++;
+	stats.BytesCopied += bufferSize;
+	return true;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+
+// --------------------------------------------------------
+// Constant buffer copies made (or skipped, because
+// nothing in the buffer changed) since the last reset
+// --------------------------------------------------------
+struct SimpleBufferCopyStats
+{
+	size_t CopyCount = 0;
+	size_t SkipCount = 0;
+	size_t BytesCopied = 0;
+	size_t BytesSkipped = 0;
+};
+
+// --------------------------------------------------------
+// The CPU side of keeping a constant buffer's local data
+// in step with its GPU copy, kept apart from SimpleShader
+// so it can run without a device
+// - SetConstantData() only dirties the buffer when a byte
+//   actually changes, so setting the same value every
+//   frame doesn't cost a copy
+// - ShouldCopyConstantBuffer() decides (and counts) whether
+//   the buffer has to go to the GPU; the caller then makes
+//   the copy itself
+// --------------------------------------------------------
+
+// Writes size bytes of data to the local data at byteOffset, marking it dirty if they differ
+void SetConstantData(unsigned char* localData, bool& isDirty, unsigned int byteOffset, const void* data, unsigned int size);
+
+// Whether a buffer of bufferSize bytes needs copying: always if skipClean is off, otherwise only
+// if it's dirty; a copy clears isDirty, and either way it's counted in stats
+bool ShouldCopyConstantBuffer(bool& isDirty, unsigned int bufferSize, bool skipClean, SimpleBufferCopyStats& stats);
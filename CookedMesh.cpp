@@ -0,0 +1,125 @@
+#include "CookedMesh.h"
+
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+namespace
+{
+	// Reads the size and last write time of a source file, returning false if it doesn't exist
+	bool GetSourceStamp(const wchar_t* sourcePath, uint64_t& size, int64_t& writeTime)
+	{
+		std::error_code error;
+		size = std::filesystem::file_size(sourcePath, error);
+		if(error)
+			return false;
+
+		writeTime = std::filesystem::last_write_time(sourcePath, error).time_since_epoch().count();
+		return !error;
+	}
+}
+
+CookedMesh::CookedMesh(const wchar_t* sourcePath) :
+	file(GetCookedPath(sourcePath).c_str()), header(nullptr)
+{
+	if(!file.IsOpen() || file.GetSize() < sizeof(CookedMeshHeader))
+		return;
+
+	const CookedMeshHeader* candidate = (const CookedMeshHeader*) file.GetData();
+
+	// Reject files from other versions or other vertex layouts
+	if(memcmp(candidate->magic, "MESH", 4) != 0 ||
+		candidate->version != Version ||
+		candidate->vertexStride != sizeof(Vertex))
+		return;
+
+	// Reject truncated files
+	uint64_t expectedSize = sizeof(CookedMeshHeader) +
+		(uint64_t) candidate->vertexCount * sizeof(Vertex) +
+		(uint64_t) candidate->indexCount * sizeof(unsigned int) +
+		(uint64_t) candidate->meshletCount * sizeof(Meshlet) +
+		(uint64_t) candidate->lodCount * sizeof(MeshLod);
+	if(file.GetSize() != expectedSize)
+		return;
+
+	// Reject stale files (the source has been modified since cooking)
+	uint64_t sourceSize;
+	int64_t sourceWriteTime;
+	if(GetSourceStamp(sourcePath, sourceSize, sourceWriteTime) &&
+		(sourceSize != candidate->sourceSize || sourceWriteTime != candidate->sourceWriteTime))
+		return;
+
+	header = candidate;
+}
+
+bool CookedMesh::Write(const wchar_t* sourcePath, const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const std::vector<Meshlet>& meshlets, const std::vector<MeshLod>& lods, unsigned int sourceVertexCount)
+{
+	CookedMeshHeader newHeader = {};
+	memcpy(newHeader.magic, "MESH", 4);
+	newHeader.version = Version;
+	newHeader.vertexStride = sizeof(Vertex);
+	newHeader.vertexCount = (uint32_t) vertices.size();
+	newHeader.indexCount = (uint32_t) indices.size();
+	newHeader.meshletCount = (uint32_t) meshlets.size();
+	newHeader.lodCount = (uint32_t) lods.size();
+	newHeader.sourceVertexCount = sourceVertexCount;
+	if(!GetSourceStamp(sourcePath, newHeader.sourceSize, newHeader.sourceWriteTime))
+		return false;
+
+	// Written under a unique name and renamed over the old file, so a reader never maps half a
+	// file, and two threads cooking the same mesh don't write into each other's
+	std::error_code error;
+	std::filesystem::path cookedPath = GetCookedPath(sourcePath);
+	std::filesystem::path temporaryPath = cookedPath;
+	temporaryPath += '.' + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	{
+		std::ofstream cooked(temporaryPath, std::ios::binary | std::ios::trunc);
+		if(!cooked.is_open())
+			return false;
+
+		cooked.write((const char*) &newHeader, sizeof(CookedMeshHeader));
+		cooked.write((const char*) vertices.data(), vertices.size() * sizeof(Vertex));
+		cooked.write((const char*) indices.data(), indices.size() * sizeof(unsigned int));
+		cooked.write((const char*) meshlets.data(), meshlets.size() * sizeof(Meshlet));
+		cooked.write((const char*) lods.data(), lods.size() * sizeof(MeshLod));
+		if(!cooked.good())
+		{
+			cooked.close();
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+	}
+
+	std::filesystem::rename(temporaryPath, cookedPath, error);
+	if(error)
+	{
+		std::filesystem::remove(temporaryPath, error);
+		return false;
+	}
+	return true;
+}
+
+std::filesystem::path CookedMesh::GetCookedPath(const wchar_t* sourcePath)
+{
+	std::filesystem::path cookedPath = sourcePath;
+	cookedPath += ".mesh";
+	return cookedPath;
+}
+
+const Vertex* CookedMesh::GetVertices() const
+{
+	return header ? (const Vertex*) (file.GetData() + sizeof(CookedMeshHeader)) : nullptr;
+}
+const unsigned int* CookedMesh::GetIndices() const
+{
+	return header ? (const unsigned int*) (GetVertices() + header->vertexCount) : nullptr;
+}
+const Meshlet* CookedMesh::GetMeshlets() const
+{
+	return header ? (const Meshlet*) (GetIndices() + header->indexCount) : nullptr;
+}
+const MeshLod* CookedMesh::GetLods() const
+{
+	return header ? (const MeshLod*) (GetMeshlets() + header->meshletCount) : nullptr;
+}
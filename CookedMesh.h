@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "MappedFile.h"
+#include "Vertex.h"
+#include "Meshlets.h"
+#include "MeshSimplifier.h"
+
+// --------------------------------------------------------
+// Binary "cooked" mesh format, written next to the source
+// file (i.e. cube.obj -> cube.obj.mesh) the first time the
+// source is loaded:
+//  [CookedMeshHeader][Vertex x vertexCount][uint32 x indexCount]
+//  [Meshlet x meshletCount][MeshLod x lodCount]
+// - Vertices are fully processed (welded, optimized and with
+//   tangents) and indices hold every level of detail, grouped
+//   into meshlets, so a cooked mesh can go straight to the GPU
+// - The header records the source file's size and last write
+//   time; the cooked file is ignored once either changes
+// --------------------------------------------------------
+struct CookedMeshHeader
+{
+	char magic[4];				// Always "MESH"
+	uint32_t version;			// Bumped whenever the layout or mesh processing changes
+	uint64_t sourceSize;		// Size of the source file in bytes
+	int64_t sourceWriteTime;	// Last write time of the source file (file clock ticks)
+	uint32_t vertexStride;		// sizeof(Vertex) when the file was cooked
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	uint32_t meshletCount;
+	uint32_t lodCount;
+	uint32_t sourceVertexCount;	// Face corners in the source file (its vertices before welding)
+};
+
+class CookedMesh
+{
+public:
+	static const uint32_t Version = 5;
+
+private:
+	MappedFile file;
+	const CookedMeshHeader* header;
+
+public:
+	// Memory maps the cooked version of the given source file, if there is an up-to-date one
+	CookedMesh(const wchar_t* sourcePath);
+
+	// Writes the cooked version of a source file; returns false if it couldn't be written
+	static bool Write(const wchar_t* sourcePath, const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const std::vector<Meshlet>& meshlets, const std::vector<MeshLod>& lods, unsigned int sourceVertexCount);
+	static std::filesystem::path GetCookedPath(const wchar_t* sourcePath);
+
+	bool IsValid() const { return header != nullptr; };
+	size_t GetFileSize() const { return file.GetSize(); };
+
+	// All point straight into the mapped file, so they're only valid while this object lives
+	const Vertex* GetVertices() const;
+	const unsigned int* GetIndices() const;
+	const Meshlet* GetMeshlets() const;
+	const MeshLod* GetLods() const;
+	unsigned int GetVertexCount() const { return header ? header->vertexCount : 0; };
+	unsigned int GetIndexCount() const { return header ? header->indexCount : 0; };
+	unsigned int GetMeshletCount() const { return header ? header->meshletCount : 0; };
+	unsigned int GetLodCount() const { return header ? header->lodCount : 0; };
+	unsigned int GetSourceVertexCount() const { return header ? header->sourceVertexCount : 0; };
+};
@@ -0,0 +1,151 @@
+#include "CookedTexture.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+namespace
+{
+	const uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+	const uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+	const uint64_t Prime3 = 0x165667B19E3779F9ull;
+
+	uint64_t RotateLeft(uint64_t value, int bits)
+	{
+		return (value << bits) | (value >> (64 - bits));
+	}
+}
+
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed)
+{
+	const uint8_t* bytes = (const uint8_t*) data;
+	uint64_t hash = seed + Prime3 + size * Prime1;
+
+	// Mix in 8 bytes at a time, then whatever's left one byte at a time
+	size_t i = 0;
+	for(; i + 8 <= size; i += 8)
+	{
+		uint64_t word;
+		memcpy(&word, bytes + i, 8);
+		hash ^= RotateLeft(word * Prime2, 31) * Prime1;
+		hash = RotateLeft(hash, 27) * Prime1 + Prime3;
+	}
+	for(; i < size; i++)
+	{
+		hash ^= bytes[i] * Prime3;
+		hash = RotateLeft(hash, 11) * Prime1;
+	}
+
+	// Avalanche, so every input bit affects every output bit
+	hash ^= hash >> 33;
+	hash *= Prime2;
+	hash ^= hash >> 29;
+	hash *= Prime3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+CookedTexture::CookedTexture(const std::filesystem::path& cacheDirectory, uint64_t contentHash) :
+	file(GetCookedPath(cacheDirectory, contentHash)), header(nullptr)
+{
+	if(!file.IsOpen() || file.GetSize() < sizeof(CookedTextureHeader))
+		return;
+
+	const CookedTextureHeader* candidate = (const CookedTextureHeader*) file.GetData();
+
+	// Reject files from other versions (or that somehow don't match their name)
+	if(memcmp(candidate->magic, "TEXC", 4) != 0 ||
+		candidate->version != Version ||
+		candidate->contentHash != contentHash ||
+		candidate->channels == 0 || candidate->channels > 4 || candidate->mipCount == 0 || candidate->mipCount > 32 ||
+		(candidate->faceCount != 1 && candidate->faceCount != 6) ||
+		candidate->format > (uint32_t) BlockFormat::BC7)
+		return;
+
+	// Reject truncated files
+	BlockFormat format = (BlockFormat) candidate->format;
+	if(file.GetSize() != sizeof(CookedTextureHeader) + candidate->faceCount * GetMipChainSize(format, candidate->width, candidate->height, candidate->channels, candidate->mipCount))
+		return;
+
+	header = candidate;
+}
+
+bool CookedTexture::Write(const std::filesystem::path& cacheDirectory, CookedTextureHeader header, const std::vector<const uint8_t*>& mipPixels)
+{
+	if(header.faceCount == 0)
+		header.faceCount = 1;
+	if(mipPixels.empty() || mipPixels.size() != (size_t) header.faceCount * header.mipCount)
+		return false;
+
+	memcpy(header.magic, "TEXC", 4);
+	header.version = Version;
+
+	std::error_code error;
+	std::filesystem::create_directories(cacheDirectory, error);
+
+	// Another thread (or program) may be writing the same texture, so write under a unique name first
+	std::filesystem::path cookedPath = GetCookedPath(cacheDirectory, header.contentHash);
+	std::filesystem::path temporaryPath = cookedPath;
+	temporaryPath += '.' + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	{
+		std::ofstream cooked(temporaryPath, std::ios::binary | std::ios::trunc);
+		if(!cooked.is_open())
+			return false;
+
+		cooked.write((const char*) &header, sizeof(CookedTextureHeader));
+		for(size_t i = 0; i < mipPixels.size(); i++)
+		{
+			uint32_t mip = (uint32_t) (i % header.mipCount);
+			uint32_t mipWidth = header.width >> mip;
+			uint32_t mipHeight = header.height >> mip;
+			size_t size = GetSurfaceSize((BlockFormat) header.format, header.channels, mipWidth > 0 ? mipWidth : 1, mipHeight > 0 ? mipHeight : 1);
+			cooked.write((const char*) mipPixels[i], size);
+		}
+		if(!cooked.good())
+		{
+			cooked.close();
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+	}
+
+	// If the rename fails, someone else already put (identical) data in place
+	std::filesystem::rename(temporaryPath, cookedPath, error);
+	if(error)
+		std::filesystem::remove(temporaryPath, error);
+	return true;
+}
+
+std::filesystem::path CookedTexture::GetCookedPath(const std::filesystem::path& cacheDirectory, uint64_t contentHash)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.tex", (unsigned long long) contentHash);
+	return cacheDirectory / name;
+}
+
+uint64_t CookedTexture::GetMipChainSize(BlockFormat format, uint32_t width, uint32_t height, uint32_t channels, uint32_t mipCount)
+{
+	uint64_t size = 0;
+	for(uint32_t mip = 0; mip < mipCount; mip++)
+	{
+		size += GetSurfaceSize(format, channels, width, height);
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+	return size;
+}
+
+const uint8_t* CookedTexture::GetMipPixels(unsigned int mip, unsigned int face) const
+{
+	if(!header || mip >= header->mipCount || face >= header->faceCount)
+		return nullptr;
+
+	// Skip past every earlier face, then every larger mip
+	BlockFormat format = (BlockFormat) header->format;
+	uint64_t offset = sizeof(CookedTextureHeader) +
+		face * GetMipChainSize(format, header->width, header->height, header->channels, header->mipCount) +
+		GetMipChainSize(format, header->width, header->height, header->channels, mip);
+	return (const uint8_t*) file.GetData() + offset;
+}
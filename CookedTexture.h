@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "MappedFile.h"
+#include "BlockCompression.h"
+
+// --------------------------------------------------------
+// Binary "cooked" texture format: a decoded image and its
+// whole mip chain, ready to upload (as plain texels or as
+// compressed blocks)
+//  [CookedTextureHeader][mip 0 pixels][mip 1 pixels]...
+// - Cube maps store each face's whole chain in turn
+//   (face 0 mips 0..n, face 1 mips 0..n, ...)
+// - Files live in a cache directory, named after the hash of
+//   the source file's contents (and the options it was
+//   cooked with), so renaming or touching a source doesn't
+//   invalidate it and identical sources share one file
+// - Mip i is max(1, width >> i) x max(1, height >> i), with
+//   rows (of texels or blocks) packed tightly
+// --------------------------------------------------------
+struct CookedTextureHeader
+{
+	char magic[4];			// Always "TEXC"
+	uint32_t version;		// Bumped whenever the layout or mip generation changes
+	uint64_t contentHash;	// Hash the file is named after
+	uint32_t width;
+	uint32_t height;
+	uint32_t channels;		// Of the source image, even when compressed
+	uint32_t mipCount;
+	uint32_t isSRGB;
+	uint32_t format;		// A BlockFormat
+	float psnr;				// Of the top mip after compression (in dB)
+	uint32_t faceCount;		// 1, or 6 for a cube map
+	float irradianceSH[27];	// Cube maps only: diffuse irradiance (9 RGB coefficients, see CubemapCooker)
+	uint32_t reserved;		// Keeps the header a multiple of 8 bytes
+};
+
+class CookedTexture
+{
+public:
+	static const uint32_t Version = 3;
+
+private:
+	MappedFile file;
+	const CookedTextureHeader* header;
+
+public:
+	// Memory maps the cached texture with the given hash, if there is one
+	CookedTexture(const std::filesystem::path& cacheDirectory, uint64_t contentHash);
+
+	// Writes a texture described by header (whose magic and version are filled in here) to the cache,
+	// one pointer per mip (per face, face-major); returns false if it couldn't be written
+	// - Writes to a temporary file first, so a half-written file is never picked up
+	static bool Write(const std::filesystem::path& cacheDirectory, CookedTextureHeader header, const std::vector<const uint8_t*>& mipPixels);
+	static std::filesystem::path GetCookedPath(const std::filesystem::path& cacheDirectory, uint64_t contentHash);
+
+	// Size in bytes of every mip from the given size down to 1x1
+	static uint64_t GetMipChainSize(BlockFormat format, uint32_t width, uint32_t height, uint32_t channels, uint32_t mipCount);
+
+	bool IsValid() const { return header != nullptr; };
+	const CookedTextureHeader* GetHeader() const { return header; };
+
+	// Points straight into the mapped file, so it's only valid while this object lives
+	const uint8_t* GetMipPixels(unsigned int mip, unsigned int face = 0) const;
+};
+
+// Hashes a block of bytes (64-bit, in the style of xxHash); good enough to name cache files by
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 0);
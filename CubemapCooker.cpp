@@ -0,0 +1,437 @@
+#include "CubemapCooker.h"
+#include "MipGenerator.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <cmath>
+
+namespace
+{
+	const float Gamma = 2.2f;	// Matches MipGenerator
+	const float Pi = 3.14159265f;
+
+	// One level of a cube map in linear RGB (three floats per texel, one vector per face)
+	struct CubeLevel
+	{
+		unsigned int size;
+		std::vector<float> faces[6];
+	};
+
+	// Direction through the center of texel (x, y) of a face (not normalized)
+	void GetTexelDirection(int face, float x, float y, unsigned int size, float direction[3])
+	{
+		float u = 2.0f * (x + 0.5f) / size - 1.0f;
+		float v = 2.0f * (y + 0.5f) / size - 1.0f;
+		switch(face)
+		{
+		case 0: direction[0] = 1.0f; direction[1] = -v; direction[2] = -u; break;
+		case 1: direction[0] = -1.0f; direction[1] = -v; direction[2] = u; break;
+		case 2: direction[0] = u; direction[1] = 1.0f; direction[2] = v; break;
+		case 3: direction[0] = u; direction[1] = -1.0f; direction[2] = -v; break;
+		case 4: direction[0] = u; direction[1] = -v; direction[2] = 1.0f; break;
+		default: direction[0] = -u; direction[1] = -v; direction[2] = -1.0f; break;
+		}
+	}
+
+	// The face a direction points into, and where on it (0-1 across, 0-1 down)
+	int GetFaceCoordinates(const float direction[3], float& s, float& t)
+	{
+		float absX = std::fabs(direction[0]);
+		float absY = std::fabs(direction[1]);
+		float absZ = std::fabs(direction[2]);
+
+		int face;
+		float u, v, major;
+		if(absX >= absY && absX >= absZ)
+		{
+			face = direction[0] > 0 ? 0 : 1;
+			major = absX;
+			u = direction[0] > 0 ? -direction[2] : direction[2];
+			v = -direction[1];
+		}
+		else if(absY >= absZ)
+		{
+			face = direction[1] > 0 ? 2 : 3;
+			major = absY;
+			u = direction[0];
+			v = direction[1] > 0 ? direction[2] : -direction[2];
+		}
+		else
+		{
+			face = direction[2] > 0 ? 4 : 5;
+			major = absZ;
+			u = direction[2] > 0 ? direction[0] : -direction[0];
+			v = -direction[1];
+		}
+
+		s = (u / major + 1.0f) * 0.5f;
+		t = (v / major + 1.0f) * 0.5f;
+		return face;
+	}
+
+	// Bilinear lookup within one face (clamped at its edges, rather than blending across them)
+	void SampleLevel(const CubeLevel& level, const float direction[3], float color[3])
+	{
+		float s, t;
+		int face = GetFaceCoordinates(direction, s, t);
+		const std::vector<float>& pixels = level.faces[face];
+
+		float x = s * level.size - 0.5f;
+		float y = t * level.size - 0.5f;
+		int x0 = (int) std::floor(x);
+		int y0 = (int) std::floor(y);
+		float fractionX = x - x0;
+		float fractionY = y - y0;
+
+		int last = (int) level.size - 1;
+		int xs[2] = { x0 < 0 ? 0 : (x0 > last ? last : x0), x0 + 1 < 0 ? 0 : (x0 + 1 > last ? last : x0 + 1) };
+		int ys[2] = { y0 < 0 ? 0 : (y0 > last ? last : y0), y0 + 1 < 0 ? 0 : (y0 + 1 > last ? last : y0 + 1) };
+		float weights[4] = { (1 - fractionX) * (1 - fractionY), fractionX * (1 - fractionY), (1 - fractionX) * fractionY, fractionX * fractionY };
+
+		color[0] = color[1] = color[2] = 0.0f;
+		for(int i = 0; i < 4; i++)
+		{
+			const float* texel = &pixels[((size_t) ys[i / 2] * level.size + xs[i % 2]) * 3];
+			for(int c = 0; c < 3; c++)
+				color[c] += texel[c] * weights[i];
+		}
+	}
+
+	// Trilinear lookup between the two levels around lod
+	void SampleCube(const std::vector<CubeLevel>& levels, const float direction[3], float lod, float color[3])
+	{
+		float maxLod = (float) (levels.size() - 1);
+		lod = lod < 0.0f ? 0.0f : (lod > maxLod ? maxLod : lod);
+		unsigned int lower = (unsigned int) lod;
+		unsigned int upper = lower + 1 < levels.size() ? lower + 1 : lower;
+		float blend = lod - lower;
+
+		float lowerColor[3], upperColor[3];
+		SampleLevel(levels[lower], direction, lowerColor);
+		SampleLevel(levels[upper], direction, upperColor);
+		for(int c = 0; c < 3; c++)
+			color[c] = lowerColor[c] + (upperColor[c] - lowerColor[c]) * blend;
+	}
+
+	// Linear copies of the faces, each level a 2x2 box filter of the last, stopping at 1x1
+	// - The first level is the faces' own size halved as many times as needed to fit maxSize
+	std::vector<CubeLevel> BuildLevels(const std::vector<Image>& faces, bool isGammaEncoded, unsigned int maxSize)
+	{
+		float linear[256];
+		for(int i = 0; i < 256; i++)
+			linear[i] = isGammaEncoded ? std::pow(i / 255.0f, Gamma) : i / 255.0f;
+
+		unsigned int sourceSize = faces[0].width;
+		unsigned int step = 1;
+		while(sourceSize / step > maxSize && sourceSize / step > 1)
+			step *= 2;
+
+		std::vector<CubeLevel> levels(1);
+		levels[0].size = sourceSize / step;
+		ThreadPool::Global().ParallelFor(6, 1, [&](size_t begin, size_t end)
+		{
+			for(size_t face = begin; face < end; face++)
+			{
+				const Image& image = faces[face];
+				unsigned int size = levels[0].size;
+				std::vector<float>& pixels = levels[0].faces[face];
+				pixels.assign((size_t) size * size * 3, 0.0f);
+
+				// Average each step x step square of source texels
+				float scale = 1.0f / (step * step);
+				for(unsigned int y = 0; y < size; y++)
+				{
+					for(unsigned int x = 0; x < size; x++)
+					{
+						float* texel = &pixels[((size_t) y * size + x) * 3];
+						for(unsigned int sy = 0; sy < step; sy++)
+						{
+							for(unsigned int sx = 0; sx < step; sx++)
+							{
+								size_t p = (size_t) (y * step + sy) * image.width + (x * step + sx);
+								for(int c = 0; c < 3; c++)
+									texel[c] += linear[image.pixels[p * image.channels + (image.channels == 1 ? 0 : c)]] * scale;
+							}
+						}
+					}
+				}
+			}
+		});
+
+		while(levels.back().size > 1)
+		{
+			const CubeLevel& previous = levels.back();
+			CubeLevel next;
+			next.size = previous.size / 2;
+			for(int face = 0; face < 6; face++)
+			{
+				next.faces[face].resize((size_t) next.size * next.size * 3);
+				for(unsigned int y = 0; y < next.size; y++)
+				{
+					for(unsigned int x = 0; x < next.size; x++)
+					{
+						for(int c = 0; c < 3; c++)
+						{
+							const std::vector<float>& source = previous.faces[face];
+							size_t row0 = (size_t) (y * 2) * previous.size;
+							size_t row1 = (size_t) (y * 2 + 1) * previous.size;
+							next.faces[face][((size_t) y * next.size + x) * 3 + c] = 0.25f * (
+								source[(row0 + x * 2) * 3 + c] + source[(row0 + x * 2 + 1) * 3 + c] +
+								source[(row1 + x * 2) * 3 + c] + source[(row1 + x * 2 + 1) * 3 + c]);
+						}
+					}
+				}
+			}
+			levels.push_back(std::move(next));
+		}
+		return levels;
+	}
+
+	// Points 0 to N - 1 spread evenly over the unit square
+	void Hammersley(unsigned int i, unsigned int count, float& u, float& v)
+	{
+		unsigned int bits = i;
+		bits = (bits << 16) | (bits >> 16);
+		bits = ((bits & 0x55555555u) << 1) | ((bits & 0xAAAAAAAAu) >> 1);
+		bits = ((bits & 0x33333333u) << 2) | ((bits & 0xCCCCCCCCu) >> 2);
+		bits = ((bits & 0x0F0F0F0Fu) << 4) | ((bits & 0xF0F0F0F0u) >> 4);
+		bits = ((bits & 0x00FF00FFu) << 8) | ((bits & 0xFF00FF00u) >> 8);
+		u = (float) i / count;
+		v = bits * 2.3283064365386963e-10f;
+	}
+
+	float Normalize(float vector[3])
+	{
+		float length = std::sqrt(vector[0] * vector[0] + vector[1] * vector[1] + vector[2] * vector[2]);
+		for(int c = 0; c < 3; c++)
+			vector[c] /= length;
+		return length;
+	}
+
+	// Solid angle of the part of a face between the center and (x, y), in [-1, 1] face coordinates
+	float AreaElement(float x, float y)
+	{
+		return std::atan2(x * y, std::sqrt(x * x + y * y + 1.0f));
+	}
+
+	float GetTexelSolidAngle(unsigned int x, unsigned int y, unsigned int size)
+	{
+		float x0 = 2.0f * x / size - 1.0f;
+		float y0 = 2.0f * y / size - 1.0f;
+		float x1 = 2.0f * (x + 1) / size - 1.0f;
+		float y1 = 2.0f * (y + 1) / size - 1.0f;
+		return AreaElement(x0, y0) - AreaElement(x0, y1) - AreaElement(x1, y0) + AreaElement(x1, y1);
+	}
+
+	void EvaluateBasis(const float direction[3], float basis[9])
+	{
+		float x = direction[0], y = direction[1], z = direction[2];
+		basis[0] = 0.282095f;
+		basis[1] = 0.488603f * y;
+		basis[2] = 0.488603f * z;
+		basis[3] = 0.488603f * x;
+		basis[4] = 1.092548f * x * y;
+		basis[5] = 1.092548f * y * z;
+		basis[6] = 0.315392f * (3.0f * z * z - 1.0f);
+		basis[7] = 1.092548f * x * z;
+		basis[8] = 0.546274f * (x * x - y * y);
+	}
+
+	uint8_t Encode(float value, bool isGammaEncoded)
+	{
+		value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+		if(isGammaEncoded)
+			value = std::pow(value, 1.0f / Gamma);
+		return (uint8_t) (value * 255.0f + 0.5f);
+	}
+}
+
+size_t PrefilterCubemap(const std::vector<Image>& faces, bool isGammaEncoded, std::vector<Image>& mips)
+{
+	unsigned int size = faces[0].width;
+	unsigned int mipCount = GetMipCount(size, size);
+
+	// Half size is plenty to sample from, since even the first prefiltered mip is half size
+	std::vector<CubeLevel> levels = BuildLevels(faces, isGammaEncoded, size > 1 ? size / 2 : 1);
+
+	// Solid angle of a texel of the first level, to pick which level each sample reads from
+	float levelTexelSolidAngle = 4.0f * Pi / (6.0f * levels[0].size * levels[0].size);
+
+	mips.assign((size_t) 6 * mipCount, Image());
+	std::atomic<size_t> sampleCount = 0;
+	for(int face = 0; face < 6; face++)
+	{
+		// The top mip is the face itself, as RGBA
+		Image& top = mips[(size_t) face * mipCount];
+		top = { size, size, 4, faces[face].isSRGB, {} };
+		top.pixels.resize((size_t) size * size * 4);
+		for(size_t p = 0; p < (size_t) size * size; p++)
+		{
+			for(unsigned int c = 0; c < 4; c++)
+			{
+				top.pixels[p * 4 + c] = faces[face].channels == 1 ?
+					(c < 3 ? faces[face].pixels[p] : 255) : faces[face].pixels[p * 4 + c];
+			}
+		}
+	}
+
+	for(unsigned int mip = 1; mip < mipCount; mip++)
+	{
+		unsigned int mipSize = size >> mip > 0 ? size >> mip : 1;
+		float roughness = (float) mip / (mipCount - 1);
+		float alpha = roughness * roughness;
+
+		// Every texel uses the same samples relative to its normal, so work them out once
+		// - Each is a light direction in tangent space (z along the normal), its cosine weight
+		//   and (for filtered importance sampling) the level to read it from, which is as blurry
+		//   as the samples are sparse
+		struct PrefilterSample
+		{
+			float light[3];
+			float nDotL;
+			float lod;
+		};
+		std::vector<PrefilterSample> samples;
+		for(unsigned int i = 0; i < PrefilterSampleCount; i++)
+		{
+			// Importance sample a half vector from the GGX distribution
+			float u, v;
+			Hammersley(i, PrefilterSampleCount, u, v);
+			float phi = 2.0f * Pi * u;
+			float cosTheta = std::sqrt((1.0f - v) / (1.0f + (alpha * alpha - 1.0f) * v));
+			float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+			float half[3] = { sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta };
+
+			// Reflect the view (which is the normal) about it
+			PrefilterSample sample;
+			sample.light[0] = 2.0f * cosTheta * half[0];
+			sample.light[1] = 2.0f * cosTheta * half[1];
+			sample.light[2] = 2.0f * cosTheta * half[2] - 1.0f;
+			sample.nDotL = sample.light[2];
+			if(sample.nDotL <= 0.0f)
+				continue;
+
+			float denominator = cosTheta * cosTheta * (alpha * alpha - 1.0f) + 1.0f;
+			float distribution = alpha * alpha / (Pi * denominator * denominator);
+			float pdf = distribution * 0.25f; // D * NdotH / (4 * VdotH), with V = N
+			float sampleSolidAngle = 1.0f / (PrefilterSampleCount * pdf + 1e-6f);
+			sample.lod = 0.5f * std::log2(sampleSolidAngle / levelTexelSolidAngle) + 1.0f;
+			samples.push_back(sample);
+		}
+
+		for(int face = 0; face < 6; face++)
+		{
+			Image& image = mips[(size_t) face * mipCount + mip];
+			image = { mipSize, mipSize, 4, faces[face].isSRGB, {} };
+			image.pixels.resize((size_t) mipSize * mipSize * 4);
+		}
+
+		// Every row of every face is independent
+		ThreadPool::Global().ParallelFor((size_t) 6 * mipSize, 4, [&](size_t begin, size_t end)
+		{
+			size_t samplesTaken = 0;
+			for(size_t row = begin; row < end; row++)
+			{
+				int face = (int) (row / mipSize);
+				unsigned int y = (unsigned int) (row % mipSize);
+				Image& image = mips[(size_t) face * mipCount + mip];
+
+				for(unsigned int x = 0; x < mipSize; x++)
+				{
+					float normal[3];
+					GetTexelDirection(face, (float) x, (float) y, mipSize, normal);
+					Normalize(normal);
+
+					// Tangent frame around the normal, for placing samples
+					float up[3] = { 0.0f, 0.0f, 1.0f };
+					if(std::fabs(normal[2]) > 0.999f)
+					{
+						up[0] = 1.0f;
+						up[2] = 0.0f;
+					}
+					float tangentX[3] = { up[1] * normal[2] - up[2] * normal[1], up[2] * normal[0] - up[0] * normal[2], up[0] * normal[1] - up[1] * normal[0] };
+					Normalize(tangentX);
+					float tangentY[3] = { normal[1] * tangentX[2] - normal[2] * tangentX[1], normal[2] * tangentX[0] - normal[0] * tangentX[2], normal[0] * tangentX[1] - normal[1] * tangentX[0] };
+
+					float total[3] = {};
+					float totalWeight = 0.0f;
+					for(const PrefilterSample& sample : samples)
+					{
+						float light[3];
+						for(int c = 0; c < 3; c++)
+							light[c] = tangentX[c] * sample.light[0] + tangentY[c] * sample.light[1] + normal[c] * sample.light[2];
+
+						float color[3];
+						SampleCube(levels, light, sample.lod, color);
+						for(int c = 0; c < 3; c++)
+							total[c] += color[c] * sample.nDotL;
+						totalWeight += sample.nDotL;
+					}
+					samplesTaken += samples.size();
+
+					uint8_t* texel = &image.pixels[((size_t) y * mipSize + x) * 4];
+					for(int c = 0; c < 3; c++)
+						texel[c] = Encode(totalWeight > 0.0f ? total[c] / totalWeight : 0.0f, isGammaEncoded);
+					texel[3] = 255;
+				}
+			}
+			sampleCount += samplesTaken;
+		});
+	}
+	return sampleCount;
+}
+
+void ProjectIrradianceSH(const std::vector<Image>& faces, bool isGammaEncoded, float coefficients[9][3])
+{
+	// Irradiance is so smooth that a small copy of the sky gives the same answer
+	std::vector<CubeLevel> levels = BuildLevels(faces, isGammaEncoded, IrradianceSourceSize);
+	const CubeLevel& level = levels[0];
+
+	float radiance[9][3] = {};
+	float totalSolidAngle = 0.0f;
+	for(int face = 0; face < 6; face++)
+	{
+		for(unsigned int y = 0; y < level.size; y++)
+		{
+			for(unsigned int x = 0; x < level.size; x++)
+			{
+				float direction[3];
+				GetTexelDirection(face, (float) x, (float) y, level.size, direction);
+				Normalize(direction);
+
+				float basis[9];
+				EvaluateBasis(direction, basis);
+				float solidAngle = GetTexelSolidAngle(x, y, level.size);
+				const float* color = &level.faces[face][((size_t) y * level.size + x) * 3];
+				for(int i = 0; i < 9; i++)
+				{
+					for(int c = 0; c < 3; c++)
+						radiance[i][c] += color[c] * basis[i] * solidAngle;
+				}
+				totalSolidAngle += solidAngle;
+			}
+		}
+	}
+
+	// Convolve with the clamped cosine lobe (per band), correcting for any rounding in the solid angles
+	const float BandScales[3] = { Pi, 2.0f * Pi / 3.0f, Pi / 4.0f };
+	const int Bands[9] = { 0, 1, 1, 1, 2, 2, 2, 2, 2 };
+	float normalization = 4.0f * Pi / totalSolidAngle;
+	for(int i = 0; i < 9; i++)
+	{
+		for(int c = 0; c < 3; c++)
+			coefficients[i][c] = radiance[i][c] * normalization * BandScales[Bands[i]];
+	}
+}
+
+void EvaluateIrradianceSH(const float coefficients[9][3], const float direction[3], float irradiance[3])
+{
+	float basis[9];
+	EvaluateBasis(direction, basis);
+	for(int c = 0; c < 3; c++)
+	{
+		irradiance[c] = 0.0f;
+		for(int i = 0; i < 9; i++)
+			irradiance[c] += coefficients[i][c] * basis[i];
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Image.h"
+
+// --------------------------------------------------------
+// Image based lighting data for a cube map, made on the CPU
+// - Faces are in cube map order (+X, -X, +Y, -Y, +Z, -Z),
+//   square and all the same size
+// - Specular: every mip below the top one is the sky
+//   convolved with a GGX lobe, rougher for each smaller mip
+//   (roughness = mip / (mipCount - 1)), as sampled with
+//   N = V = R (the usual split sum approximation)
+// - Diffuse: irradiance as 9 spherical harmonic coefficients
+//   (bands 0-2, already convolved with the cosine lobe), so
+//   irradiance(n) = sum(coefficient[i] * basis[i](n)) and
+//   diffuse light is albedo * irradiance / pi
+// - Gamma-encoded faces (the usual for skies) are filtered
+//   in linear space and re-encoded, like MipGenerator
+// --------------------------------------------------------
+const unsigned int PrefilterSampleCount = 32;	// GGX samples per texel (filtered importance sampling keeps this low)
+const unsigned int IrradianceSourceSize = 64;	// Faces are shrunk to at most this before projecting onto SH
+
+// Builds the prefiltered mip chain, face-major (mips[face * mipCount + mip]), with each face's
+// top mip being the face itself (always expanded to RGBA)
+// - Rows of every face are split across the global thread pool
+// - Returns the number of GGX samples taken, for benchmarking
+size_t PrefilterCubemap(const std::vector<Image>& faces, bool isGammaEncoded, std::vector<Image>& mips);
+
+// Projects the faces' radiance onto SH and convolves it into irradiance (RGB per coefficient)
+void ProjectIrradianceSH(const std::vector<Image>& faces, bool isGammaEncoded, float coefficients[9][3]);
+
+// Irradiance arriving from every direction around the given (normalized) one
+void EvaluateIrradianceSH(const float coefficients[9][3], const float direction[3], float irradiance[3]);
@@ -1,38 +1,116 @@
 #include "Entity.h"
 #include "Graphics.h"
+#include "Window.h"
+
+#include <cmath>
 
 using namespace DirectX;
 
 Entity::Entity(std::shared_ptr<Mesh> mesh, std::shared_ptr<Material> material) :
-	mesh(mesh), material(material)
+	mesh(mesh), material(material), lod(0)
 {
 	
 }
 
-void Entity::Draw(std::shared_ptr<Camera> camera, float totalTime)
+void Entity::Draw(std::shared_ptr<Camera> camera)
 {
-	std::shared_ptr<SimpleVertexShader> vs = material->GetVertexShader();
+	std::shared_ptr<SimpleVertexShader> vs = GetVertexShader();
 	std::shared_ptr<SimplePixelShader> ps = material->GetPixelShader();
 
-	material->GetVertexShader()->SetShader();
-	material->GetPixelShader()->SetShader();
+	vs->SetShader();
+	ps->SetShader();
 
-	// Have the material set up the shader with its private values
+	// Have the material set up the shader with its private values (the camera, lights
+	// and time come from the shared frame data)
 	material->PrepareMaterial();
+	ps->CopyAllBufferData();
+
+	mesh->SetBuffers();
+	UpdateLod(camera);
+	DrawObject(camera);
+}
+void Entity::DrawObject(std::shared_ptr<Camera> camera)
+{
+	std::shared_ptr<SimpleVertexShader> vs = GetVertexShader();
 
-	// Create data to be sent to the vertex shader
 	vs->SetMatrix4x4("worldMatrix", transform.GetWorldMatrix());
 	vs->SetMatrix4x4("worldInvTranspose", transform.GetWorldInverseTransposeMatrix());
-	vs->SetMatrix4x4("viewMatrix", camera->GetViewMatrix());
-	vs->SetMatrix4x4("projMatrix", camera->GetProjectionMatrix());
-	
-	ps->SetFloat3("cameraLocation", camera->GetTransform().GetLocation());
-	ps->SetFloat("totalTime", totalTime);
+
+	// Packed meshes need their bounds to rebuild positions
+	if(mesh->GetVertexFormat() == VertexFormat::Packed)
+	{
+		vs->SetFloat3("positionOffset", mesh->GetQuantization().positionOffset);
+		vs->SetFloat3("positionScale", mesh->GetQuantization().positionScale);
+	}
 
 	vs->CopyAllBufferData();
-	ps->CopyAllBufferData();
 
-	mesh->Draw();
+	// Cull meshlets in the mesh's own space, so their bounds never need transforming
+	XMFLOAT4X4 worldMatrix = transform.GetWorldMatrix();
+	XMFLOAT4X4 viewMatrix = camera->GetViewMatrix();
+	XMFLOAT4X4 projMatrix = camera->GetProjectionMatrix();
+	XMMATRIX world = XMLoadFloat4x4(&worldMatrix);
+
+	XMFLOAT4X4 localViewProjection;
+	XMStoreFloat4x4(&localViewProjection, world * XMLoadFloat4x4(&viewMatrix) * XMLoadFloat4x4(&projMatrix));
+
+	XMFLOAT3 cameraLocation = camera->GetTransform().GetLocation();
+	XMFLOAT4X4 worldInverseMatrix = transform.GetWorldInverseMatrix();
+	XMFLOAT3 localCameraPosition;
+	XMStoreFloat3(&localCameraPosition, XMVector3TransformCoord(XMLoadFloat3(&cameraLocation), XMLoadFloat4x4(&worldInverseMatrix)));
+
+	mesh->Draw(Frustum::FromMatrix(localViewProjection), localCameraPosition, lod, false);
+}
+
+// --------------------------------------------------------
+// Picks the coarsest level of detail whose simplification
+// error, projected onto the screen from the camera's
+// distance and FOV, covers no more than lodPixelError pixels
+// --------------------------------------------------------
+int Entity::SelectLod(std::shared_ptr<Camera> camera)
+{
+	const std::vector<MeshLod>& lods = mesh->GetLods();
+	if(lods.size() < 2)
+		return 0;
+
+	// Errors are in the mesh's local units, so scale them into the world (by the longest axis of
+	// the world matrix, which includes any parents' scales)
+	XMFLOAT4X4 world = transform.GetWorldMatrix();
+	float maxScale = 0.0f;
+	for(int axis = 0; axis < 3; axis++)
+		maxScale = std::fmax(maxScale, XMVectorGetX(XMVector3Length(XMLoadFloat3((XMFLOAT3*) world.m[axis]))));
+
+	XMFLOAT3 location = transform.GetWorldLocation();
+	XMFLOAT3 cameraLocation = camera->GetTransform().GetLocation();
+	float distance = XMVectorGetX(XMVector3Length(XMLoadFloat3(&location) - XMLoadFloat3(&cameraLocation)));
+
+	// World units covered by a single pixel at that distance
+	float viewHeight = 2.0f * distance * std::tan(XMConvertToRadians(camera->GetFOV()) * 0.5f);
+	float pixelSize = viewHeight / std::fmax((float) Window::Height(), 1.0f);
+
+	for(int i = (int) lods.size() - 1; i > 0; i--)
+	{
+		if(lods[i].error * maxScale <= lodPixelError * pixelSize)
+			return i;
+	}
+	return 0;
+}
+
+// --------------------------------------------------------
+// The vertex shader this entity draws with, which depends on
+// both its material and its mesh's vertex format
+// --------------------------------------------------------
+std::shared_ptr<SimpleVertexShader> Entity::GetVertexShader()
+{
+	if(mesh->GetVertexFormat() == VertexFormat::Packed)
+		return material->GetPackedVertexShader();
+	return material->GetVertexShader();
+}
+std::shared_ptr<SimpleVertexShader> Entity::GetInstancedVertexShader()
+{
+	if(mesh->GetVertexFormat() == VertexFormat::Packed)
+		return material->GetPackedInstancedVertexShader();
+	return material->GetInstancedVertexShader();
 }
 
 Transform* Entity::GetTransform() { return &transform; }
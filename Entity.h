@@ -9,6 +9,10 @@
 
 class Entity
 {
+public:
+	// How many pixels of simplification error an entity may show on screen before it switches to a more detailed LOD
+	static inline float lodPixelError = 1.0f;
+
 private:
 	Transform transform;
 	std::shared_ptr<Mesh> mesh;
@@ -16,14 +20,27 @@ private:
 
 	Microsoft::WRL::ComPtr<ID3D11Buffer> constantBuffer;
 
+	// Level of detail picked by the last UpdateLod()
+	int lod;
+
 public:
 	Entity(std::shared_ptr<Mesh> mesh, std::shared_ptr<Material> material);
 
-	void Draw(std::shared_ptr<Camera> camera, float totalTime);
+	void Draw(std::shared_ptr<Camera> camera);
+	// The part of Draw() that's specific to this entity, for when its shaders, material and mesh buffers
+	// are already set up (e.g. by a render queue that shares them between entities), at the level of
+	// detail from the last UpdateLod()
+	void DrawObject(std::shared_ptr<Camera> camera);
+	int SelectLod(std::shared_ptr<Camera> camera);
+	// Picks the level of detail to draw with (for every pass) until the next update
+	int UpdateLod(std::shared_ptr<Camera> camera) { lod = SelectLod(camera); return lod; };
 
 	Transform* GetTransform();
 	std::shared_ptr<Mesh> GetMesh();
 	std::shared_ptr<Material> GetMaterial() { return material; };
+	std::shared_ptr<SimpleVertexShader> GetVertexShader();
+	std::shared_ptr<SimpleVertexShader> GetInstancedVertexShader(); // Null if the material can't be instanced
+	int GetLod() { return lod; };
 
 	void SetMaterial(std::shared_ptr<Material> value) { material = value; };
 };
\ No newline at end of file
@@ -2,6 +2,25 @@
 
 #include "Graphics.h"
 
+namespace
+{
+	// Clears the compute stage's SRVs and UAVs between dispatches, so the textures can swap roles;
+	// through the state cache, which knows which slots are still bound
+	void UnbindComputeResources()
+	{
+		ShaderStateCache& stateCache = ShaderStateCache::ForContext(Graphics::Context.Get());
+		ID3D11ShaderResourceView* nullSRVs[8] = {};
+		ID3D11UnorderedAccessView* nullUAVs[8] = {};
+		unsigned int firstSlot = 0, slotCount = 8;
+		if(stateCache.UnbindShaderResourceViews(ShaderStage::Compute, firstSlot, slotCount))
+			Graphics::Context->CSSetShaderResources(firstSlot, slotCount, nullSRVs);
+		firstSlot = 0;
+		slotCount = 8;
+		if(stateCache.UnbindUnorderedAccessViews(ShaderStage::Compute, firstSlot, slotCount))
+			Graphics::Context->CSSetUnorderedAccessViews(firstSlot, slotCount, nullUAVs, nullptr);
+	}
+}
+
 FluidVolume::FluidVolume()
 {
 
@@ -37,8 +56,7 @@ void FluidVolume::Initialize()
 
 		fluidComputeShaderInitialize->DispatchByThreads(width, height, depth);
 
-		ID3D11UnorderedAccessView* nullUAVs[8] = {};
-		Graphics::Context->CSSetUnorderedAccessViews(0, 8, nullUAVs, nullptr);
+		UnbindComputeResources();
 
 		// Swap buffers
 		std::swap(velocityPreviousTexture, velocityCurrentTexture);
@@ -353,10 +371,7 @@ void FluidVolume::Update(float deltaTime)
 
 		fluidComputeShaderUpdate->DispatchByThreads(width, height, depth);
 
-		ID3D11ShaderResourceView* nullSRVs[8] = {};
-		Graphics::Context->CSSetShaderResources(0, 8, nullSRVs);
-		ID3D11UnorderedAccessView* nullUAVs[8] = {};
-		Graphics::Context->CSSetUnorderedAccessViews(0, 8, nullUAVs, nullptr);
+		UnbindComputeResources();
 
 		// Swap buffers
 		std::swap(velocityPreviousTexture, velocityCurrentTexture);
@@ -393,10 +408,7 @@ void FluidVolume::Update(float deltaTime)
 
 		fluidComputeShaderAdvection->DispatchByThreads(width, height, depth);
 
-		ID3D11ShaderResourceView* nullSRVs[8] = {};
-		Graphics::Context->CSSetShaderResources(0, 8, nullSRVs);
-		ID3D11UnorderedAccessView* nullUAVs[8] = {};
-		Graphics::Context->CSSetUnorderedAccessViews(0, 8, nullUAVs, nullptr);
+		UnbindComputeResources();
 
 		// Swap buffers
 		std::swap(velocityPreviousTexture, velocityCurrentTexture);
@@ -431,10 +443,7 @@ void FluidVolume::Update(float deltaTime)
 
 		fluidComputeShaderBuoyancy->DispatchByThreads(width, height, depth);
 
-		ID3D11ShaderResourceView* nullSRVs[8] = {};
-		Graphics::Context->CSSetShaderResources(0, 8, nullSRVs);
-		ID3D11UnorderedAccessView* nullUAVs[8] = {};
-		Graphics::Context->CSSetUnorderedAccessViews(0, 8, nullUAVs, nullptr);
+		UnbindComputeResources();
 
 		// Swap buffers
 		std::swap(velocityPreviousTexture, velocityCurrentTexture);
@@ -457,10 +466,7 @@ void FluidVolume::Update(float deltaTime)
 
 		fluidComputeShaderCooling->DispatchByThreads(width, height, depth);
 
-		ID3D11ShaderResourceView* nullSRVs[8] = {};
-		Graphics::Context->CSSetShaderResources(0, 8, nullSRVs);
-		ID3D11UnorderedAccessView* nullUAVs[8] = {};
-		Graphics::Context->CSSetUnorderedAccessViews(0, 8, nullUAVs, nullptr);
+		UnbindComputeResources();
 
 		// Swap buffers
 		std::swap(reactionPreviousTexture, reactionCurrentTexture);
@@ -481,10 +487,7 @@ void FluidVolume::Update(float deltaTime)
 
 		fluidComputeShaderDivergence->DispatchByThreads(width, height, depth);
 
-		ID3D11ShaderResourceView* nullSRVs[8] = {};
-		Graphics::Context->CSSetShaderResources(0, 8, nullSRVs);
-		ID3D11UnorderedAccessView* nullUAVs[8] = {};
-		Graphics::Context->CSSetUnorderedAccessViews(0, 8, nullUAVs, nullptr);
+		UnbindComputeResources();
 	}
 
 	/* Pressure */
@@ -503,10 +506,7 @@ void FluidVolume::Update(float deltaTime)
 
 			fluidComputeShaderPressure->DispatchByThreads(width, height, depth);
 
-			ID3D11ShaderResourceView* nullSRVs[8] = {};
-			Graphics::Context->CSSetShaderResources(0, 8, nullSRVs);
-			ID3D11UnorderedAccessView* nullUAVs[8] = {};
-			Graphics::Context->CSSetUnorderedAccessViews(0, 8, nullUAVs, nullptr);
+			UnbindComputeResources();
 
 			// Swap buffers
 			std::swap(pressurePreviousTexture, pressureCurrentTexture);
@@ -529,10 +529,7 @@ void FluidVolume::Update(float deltaTime)
 
 		fluidComputeShaderProjection->DispatchByThreads(width, height, depth);
 
-		ID3D11ShaderResourceView* nullSRVs[8] = {};
-		Graphics::Context->CSSetShaderResources(0, 8, nullSRVs);
-		ID3D11UnorderedAccessView* nullUAVs[8] = {};
-		Graphics::Context->CSSetUnorderedAccessViews(0, 8, nullUAVs, nullptr);
+		UnbindComputeResources();
 
 		// Swap buffers
 		std::swap(velocityPreviousTexture, velocityCurrentTexture);
@@ -564,5 +561,7 @@ void FluidVolume::Draw(std::shared_ptr<Camera> camera)
 	Graphics::Context->Draw(36, 0);
 
 	ID3D11ShaderResourceView* none[16] = {};
-	Graphics::Context->VSSetShaderResources(0, 16, none);
+	unsigned int firstSlot = 0, slotCount = 16;
+	if(ShaderStateCache::ForContext(Graphics::Context.Get()).UnbindShaderResourceViews(ShaderStage::Vertex, firstSlot, slotCount))
+		Graphics::Context->VSSetShaderResources(firstSlot, slotCount, none);
 }
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+
+#include <DirectXMath.h>
+
+#include "Lights.h"
+
+// --------------------------------------------------------
+// Data that's the same for everything drawn in a frame,
+// copied to the GPU once per frame into shared constant
+// buffers (see ISimpleShader::CreateSharedBuffer)
+//
+// - Must match the FrameData and LightData cbuffers in
+//   FrameData.hlsli
+// --------------------------------------------------------
+struct FrameData
+{
+	DirectX::XMFLOAT4X4 viewMatrix;
+	DirectX::XMFLOAT4X4 projMatrix;
+
+	DirectX::XMFLOAT4X4 lightView; // Main (shadow-casting) directional light
+	DirectX::XMFLOAT4X4 lightProj;
+
+	DirectX::XMFLOAT3 cameraLocation;
+	float totalTime;
+};
+
+struct LightData
+{
+	int lightCount;
+	DirectX::XMFLOAT3 padding; // HLSL starts arrays on a 16 byte boundary
+	Light lights[MAX_LIGHTS];
+};
+
+// The layouts HLSL's packing rules give those cbuffers; a shader whose cbuffer doesn't match
+// its shared buffer fails to load (see ISimpleShader::LoadShaderFile), so catch it here first
+static_assert(sizeof(FrameData) == 272, "FrameData must match the FrameData cbuffer in FrameData.hlsli");
+static_assert(sizeof(Light) == 64, "Light must match the Light struct in FrameData.hlsli");
+static_assert(offsetof(LightData, lights) == 16, "LightData's lights must start on a 16 byte boundary, as in FrameData.hlsli");
+static_assert(sizeof(LightData) == 16 + sizeof(Light) * MAX_LIGHTS, "LightData must match the LightData cbuffer in FrameData.hlsli");
@@ -0,0 +1,30 @@
+#ifndef __FRAME_DATA__
+#define __FRAME_DATA__
+
+#include "ShaderStructs.hlsli"
+
+#define MAX_LIGHTS 64
+
+// Data that's the same for everything drawn in a frame
+// - These are shared buffers (see ISimpleShader::CreateSharedBuffer), so they're copied
+//   to the GPU once per frame, not once per shader or per entity
+// - These should match the FrameData and LightData structs in our C++ code
+cbuffer FrameData : register(b1)
+{
+	matrix viewMatrix;
+	matrix projMatrix;
+
+	matrix lightView; // Main (shadow-casting) directional light
+	matrix lightProj;
+
+	float3 cameraLocation;
+	float totalTime;
+}
+
+cbuffer LightData : register(b2)
+{
+	int lightCount;
+	Light lights[MAX_LIGHTS];
+}
+
+#endif
@@ -0,0 +1,57 @@
+#include "Frustum.h"
+
+#include <cmath>
+
+using namespace DirectX;
+
+Frustum Frustum::FromMatrix(const XMFLOAT4X4& viewProjection)
+{
+	// DirectXMath uses row vectors (clip = point * matrix), so each clip
+	// coordinate is a dot product with one of the matrix's columns
+	const auto& m = viewProjection.m;
+	XMFLOAT4 x(m[0][0], m[1][0], m[2][0], m[3][0]);
+	XMFLOAT4 y(m[0][1], m[1][1], m[2][1], m[3][1]);
+	XMFLOAT4 z(m[0][2], m[1][2], m[2][2], m[3][2]);
+	XMFLOAT4 w(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+	Frustum frustum = {};
+	frustum.planes[0] = XMFLOAT4(w.x + x.x, w.y + x.y, w.z + x.z, w.w + x.w); // -w <= x
+	frustum.planes[1] = XMFLOAT4(w.x - x.x, w.y - x.y, w.z - x.z, w.w - x.w); // x <= w
+	frustum.planes[2] = XMFLOAT4(w.x + y.x, w.y + y.y, w.z + y.z, w.w + y.w); // -w <= y
+	frustum.planes[3] = XMFLOAT4(w.x - y.x, w.y - y.y, w.z - y.z, w.w - y.w); // y <= w
+	frustum.planes[4] = z;                                                    // 0 <= z
+	frustum.planes[5] = XMFLOAT4(w.x - z.x, w.y - z.y, w.z - z.z, w.w - z.w); // z <= w
+
+	// Normalize so plane tests give real distances
+	for(XMFLOAT4& plane : frustum.planes)
+	{
+		float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+		if(length > 0.0f)
+			plane = XMFLOAT4(plane.x / length, plane.y / length, plane.z / length, plane.w / length);
+	}
+
+	return frustum;
+}
+
+bool Frustum::IntersectsSphere(const XMFLOAT3& center, float radius) const
+{
+	for(const XMFLOAT4& plane : planes)
+	{
+		// Entirely outside any one plane means entirely outside the frustum
+		if(plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius)
+			return false;
+	}
+	return true;
+}
+
+bool Frustum::IntersectsBox(const XMFLOAT3& center, const XMFLOAT3& extents) const
+{
+	for(const XMFLOAT4& plane : planes)
+	{
+		// How far the box reaches towards the plane's normal, from its center
+		float reach = std::fabs(plane.x) * extents.x + std::fabs(plane.y) * extents.y + std::fabs(plane.z) * extents.z;
+		if(plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -reach)
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// The 6 planes of a view frustum, each stored as (normal, d)
+// with the normal pointing inwards and normalized, so
+// dot(normal, point) + d is the signed distance inside
+// - Extracted from a combined (world)-view-projection matrix,
+//   so the planes live in whatever space that matrix starts in
+//   (world space for view * proj, object space for world * view * proj)
+// --------------------------------------------------------
+struct Frustum
+{
+	DirectX::XMFLOAT4 planes[6];
+
+	// Left, right, bottom, top, near, far (Gribb & Hartmann, D3D's 0-1 depth range)
+	static Frustum FromMatrix(const DirectX::XMFLOAT4X4& viewProjection);
+
+	bool IntersectsSphere(const DirectX::XMFLOAT3& center, float radius) const;
+	// Axis-aligned box, given by its center and half-size
+	bool IntersectsBox(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents) const;
+};
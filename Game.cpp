@@ -6,9 +6,10 @@
 #include "Window.h"
 #include <memory>
 #include <iostream>
-
-// From DirectX Tool Kit
-#include "WICTextureLoader.h"
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
 
 #include <DirectXMath.h>
 
@@ -29,10 +30,20 @@ using namespace DirectX;
 // --------------------------------------------------------
 void Game::Initialize()
 {
+	initializeStartTime = std::chrono::high_resolution_clock::now();
+
 	// Helper methods for loading shaders, creating some basic
 	// geometry to draw and some simple camera matrices.
 	//  - You'll be expanding and/or replacing these later
+	//  - Meshes and textures only start loading here (meshes first,
+	//    since they're quick), and arrive over the first few frames
+	LoadMeshes();
+	assetLoader.SetTextureCacheDirectory(FixPath(L"TextureCache"));
 	LoadTextures();
+
+	// Frame-wide data is shared by every shader that uses it, so it has to exist before they load
+	ISimpleShader::CreateSharedBuffer(Graphics::Device, "FrameData", sizeof(FrameData));
+	ISimpleShader::CreateSharedBuffer(Graphics::Device, "LightData", sizeof(LightData));
 	LoadShaders();
 	
 	CreateShadowMap();
@@ -71,6 +82,9 @@ void Game::Initialize()
 	ImGui_ImplDX11_Init(Graphics::Device.Get(), Graphics::Context.Get());
 
 	ImGui::StyleColorsDark();
+
+	double initializeSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - initializeStartTime).count();
+	printf("Initialized in %.1f ms (%u assets loading in the background)\n", initializeSeconds * 1000.0, assetLoader.GetPendingCount());
 }
 
 
@@ -86,32 +100,141 @@ Game::~Game()
 	ImGui_ImplDX11_Shutdown();
 	ImGui_ImplWin32_Shutdown();
 	ImGui::DestroyContext();
+
+	ISimpleShader::ReleaseSharedBuffers();
+}
+
+// --------------------------------------------------------
+// Creates every mesh empty (so it draws nothing) and starts
+// loading its data in the background; each mesh fills in
+// as soon as its data arrives
+// --------------------------------------------------------
+void Game::LoadMeshes()
+{
+	// Packed, since entities are drawn with shaders that can unpack them
+	for(const std::wstring& meshPath : meshPaths)
+		meshes.push_back(std::make_shared<Mesh>(std::filesystem::path(meshPath).stem().string(), VertexFormat::Packed));
+
+	// The sky shader only understands full vertices, so it gets its own cube
+	skyMesh = std::make_shared<Mesh>("cube");
+
+	for(size_t i = 0; i < meshPaths.size(); i++)
+	{
+		std::shared_ptr<Mesh> mesh = meshes[i];
+		std::shared_ptr<Mesh> sky = skyMesh;
+		assetLoader.LoadMesh(FixPath(meshPaths[i]), [mesh, sky](MeshData& data)
+		{
+			mesh->Upload(data);
+
+			// Shares the file's data rather than loading it twice (two loads of one file could both try to cook it)
+			if(mesh->GetName() == sky->GetName())
+				sky->Upload(data);
+		});
+	}
 }
 
+// --------------------------------------------------------
+// Creates a 1x1 placeholder for every texture (so materials
+// can use them right away) and starts decoding the real ones
+// in the background, swapping each in once it's uploaded
+// - Mips are made on the CPU and cached (see TextureData), so
+//   they're filtered according to what the texture holds
+// --------------------------------------------------------
 void Game::LoadTextures()
 {
-	// Load all textures from their paths and associate them with identifiers in an unordered map
 	for(std::wstring texturePath : texturePaths)
 	{
-		/* The overload that takes the device context also makes mipmaps */
-		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> textureSRV;
-		CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(), FixPath(texturePath).c_str(), 0, textureSRV.GetAddressOf());
-
 		// Texture name is the final argument of the path (after the last /), i.e. "brokentiles.png"
 		std::wstring textureName = texturePath.substr(texturePath.find_last_of('/') + 1);
+		if(textureSRVs.count(textureName) > 0)
+			continue; // The first path with a name wins
+
+		// Placeholders are neutral for whatever the texture is used for: flat normals, no metalness, mid-gray otherwise
+		Image placeholder = { 1, 1, 4, false, { 128, 128, 128, 255 } };
+		if(textureName.find(L"_normals.") != std::wstring::npos)
+			placeholder.pixels = { 128, 128, 255, 255 };
+		else if(textureName.find(L"_metal.") != std::wstring::npos)
+			placeholder.pixels = { 0, 0, 0, 255 };
+
+		TextureData placeholderData;
+		placeholderData.SetMips({ placeholder });
+
 		// Add the SRV to the map so it can be accessed by its texture name
-		textureSRVs.insert({ textureName.c_str(), textureSRV });
+		textureSRVs.insert({ textureName, CreateTexture(placeholderData) });
+
+		// Colors are gamma-encoded (the shaders decode them with pow 2.2); normals and PBR values are linear data
+		bool isNormalMap = textureName.find(L"_normals.") != std::wstring::npos;
+		bool isSingleChannel =
+			textureName.find(L"_roughness.") != std::wstring::npos ||
+			textureName.find(L"_metal.") != std::wstring::npos ||
+			textureName.find(L"_specular.") != std::wstring::npos;
+
+		// Normals only need X and Y (the shader rebuilds Z), and PBR values only their red channel
+		TextureCookOptions cookOptions = {};
+		cookOptions.generateMips = true;
+		cookOptions.mipOptions.isNormalMap = isNormalMap;
+		cookOptions.mipOptions.isGammaEncoded = !isNormalMap && !isSingleChannel;
+		cookOptions.format = isNormalMap ? BlockFormat::BC5 : (isSingleChannel ? BlockFormat::BC4 : colorTextureFormat);
+
+		bool isRoughnessOrMetalness = textureName.find(L"_roughness.") != std::wstring::npos || textureName.find(L"_metal.") != std::wstring::npos;
+		assetLoader.LoadTexture(FixPath(texturePath), cookOptions, [this, textureName, isRoughnessOrMetalness](TextureData& data)
+		{
+			textureBytes += data.GetByteSize();
+			uncompressedTextureBytes += data.GetUncompressedByteSize();
+			if(isRoughnessOrMetalness)
+				roughnessMetalnessBytes += data.GetByteSize();
+			ReplaceTexture(textureName, CreateTexture(data));
+		});
 	}
 
-	// Load cubemaps from paths and add them to textureSRVs
+	// Packed occlusion/roughness/metalness maps start out unoccluded, mid-rough and not metal
+	for(const std::wstring& materialName : ormMaterialNames)
+	{
+		std::wstring textureName = materialName + L"_orm";
+
+		Image placeholder = { 1, 1, 4, false, { 255, 128, 0, 255 } };
+		TextureData placeholderData;
+		placeholderData.SetMips({ placeholder });
+		textureSRVs.insert({ textureName, CreateTexture(placeholderData) });
+
+		TextureCookOptions cookOptions = {};
+		cookOptions.generateMips = true;
+		cookOptions.format = ormTextureFormat;
+
+		std::wstring roughnessPath = FixPath(ormTextureDirectory + materialName + L"_roughness.png");
+		std::wstring metalnessPath = FixPath(ormTextureDirectory + materialName + L"_metal.png");
+		assetLoader.LoadOrmTexture(L"", roughnessPath, metalnessPath, cookOptions, [this, textureName](TextureData& data)
+		{
+			textureBytes += data.GetByteSize();
+			uncompressedTextureBytes += data.GetUncompressedByteSize();
+			ormBytes += data.GetByteSize();
+			ReplaceTexture(textureName, CreateTexture(data));
+		});
+	}
+
+	// Cubemaps start out as the background color
+	// - Cooking them (prefiltering every mip and projecting irradiance) is slow, but only ever happens once
 	for(auto& cubemap : cubemapPaths)
-		textureSRVs.insert({ cubemap.first, CreateCubemap(
-			FixPath(cubemap.second[0]).c_str(),
-			FixPath(cubemap.second[1]).c_str(),
-			FixPath(cubemap.second[2]).c_str(),
-			FixPath(cubemap.second[3]).c_str(),
-			FixPath(cubemap.second[4]).c_str(),
-			FixPath(cubemap.second[5]).c_str()) });
+	{
+		Image placeholderFace = { 1, 1, 4, false, {
+			(uint8_t) (backgroundColor[0] * 255), (uint8_t) (backgroundColor[1] * 255), (uint8_t) (backgroundColor[2] * 255), 255 } };
+		TextureData placeholderData;
+		placeholderData.SetMips(std::vector<Image>(6, placeholderFace), 6);
+		textureSRVs.insert({ cubemap.first, CreateCubemap(placeholderData) });
+
+		std::vector<std::wstring> facePaths;
+		for(const std::wstring& facePath : cubemap.second)
+			facePaths.push_back(FixPath(facePath));
+
+		std::wstring cubemapName = cubemap.first;
+		assetLoader.LoadCubemap(facePaths, [this, cubemapName](TextureData& data)
+		{
+			// The sky's lighting comes with it
+			if(skybox && skybox->GetCubeMapSRV() == textureSRVs[cubemapName])
+				skybox->SetIrradianceSH(data.irradianceSH);
+			ReplaceTexture(cubemapName, CreateCubemap(data));
+		});
+	}
 
 	// Create the basic texture sampler
 	D3D11_SAMPLER_DESC samplerDesc = {};
@@ -138,6 +261,7 @@ void Game::LoadShaders()
 {
 	vertexShader = std::make_shared<SimpleVertexShader>(Graphics::Device, Graphics::Context, FixPath(L"VertexShader.cso").c_str());
 	pixelShader = std::make_shared<SimplePixelShader>(Graphics::Device, Graphics::Context, FixPath(L"PixelShader.cso").c_str());
+	ormPixelShader = std::make_shared<SimplePixelShader>(Graphics::Device, Graphics::Context, FixPath(L"PSPackedOrm.cso").c_str());
 	normalPixelShader = std::make_shared<SimplePixelShader>(Graphics::Device, Graphics::Context, FixPath(L"PSNormal.cso").c_str());
 	uvPixelShader = std::make_shared<SimplePixelShader>(Graphics::Device, Graphics::Context, FixPath(L"PSUV.cso").c_str());
 	customPixelShader = std::make_shared<SimplePixelShader>(Graphics::Device, Graphics::Context, FixPath(L"PSCustom.cso").c_str());
@@ -147,6 +271,33 @@ void Game::LoadShaders()
 
 	shadowVertexShader = std::make_shared<SimpleVertexShader>(Graphics::Device, Graphics::Context, FixPath(L"VSShadowMap.cso").c_str());
 
+	/* Vertex shaders for packed meshes */
+
+	// Reflection can't tell what formats packed attributes are stored in, so describe the layout by hand
+	// - Must match the PackedVertex struct
+	D3D11_INPUT_ELEMENT_DESC packedInputElements[] =
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TANGENT", 0, DXGI_FORMAT_R16G16_SNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+	};
+	Microsoft::WRL::ComPtr<ID3DBlob> packedShaderBlob;
+	Microsoft::WRL::ComPtr<ID3D11InputLayout> packedInputLayout;
+	D3DReadFileToBlob(FixPath(L"VSPacked.cso").c_str(), packedShaderBlob.GetAddressOf());
+	Graphics::Device->CreateInputLayout(packedInputElements, ARRAYSIZE(packedInputElements),
+		packedShaderBlob->GetBufferPointer(), packedShaderBlob->GetBufferSize(), packedInputLayout.GetAddressOf());
+
+	packedVertexShader = std::make_shared<SimpleVertexShader>(Graphics::Device, Graphics::Context, FixPath(L"VSPacked.cso").c_str(), packedInputLayout, false);
+	packedShadowVertexShader = std::make_shared<SimpleVertexShader>(Graphics::Device, Graphics::Context, FixPath(L"VSShadowMapPacked.cso").c_str(), packedInputLayout, false);
+
+	/* Vertex shaders for instanced draws (same vertices, so the same input layouts) */
+
+	instancedVertexShader = std::make_shared<SimpleVertexShader>(Graphics::Device, Graphics::Context, FixPath(L"VSInstanced.cso").c_str());
+	instancedShadowVertexShader = std::make_shared<SimpleVertexShader>(Graphics::Device, Graphics::Context, FixPath(L"VSShadowMapInstanced.cso").c_str());
+	packedInstancedVertexShader = std::make_shared<SimpleVertexShader>(Graphics::Device, Graphics::Context, FixPath(L"VSPackedInstanced.cso").c_str(), packedInputLayout, false);
+	packedInstancedShadowVertexShader = std::make_shared<SimpleVertexShader>(Graphics::Device, Graphics::Context, FixPath(L"VSShadowMapPackedInstanced.cso").c_str(), packedInputLayout, false);
+
 	postProcessVertexShader = std::make_shared<SimpleVertexShader>(Graphics::Device, Graphics::Context, FixPath(L"VSFullscreen.cso").c_str());
 	postProcessBlurPixelShader = std::make_shared<SimplePixelShader>(Graphics::Device, Graphics::Context, FixPath(L"PSBoxBlur.cso").c_str());
 	postProcessAberrationPixelShader = std::make_shared<SimplePixelShader>(Graphics::Device, Graphics::Context, FixPath(L"PSChromaticAberration.cso").c_str());
@@ -330,12 +481,24 @@ void Game::CreateMaterials()
 
 	materials.push_back(std::make_shared<Material>(vertexShader, pixelShader, XMFLOAT4(1, 1, 1, 1), XMFLOAT2(5, 5))); // Floor material
 
+	// Every material can also draw meshes with packed vertices, and many instances at once
+	for(std::shared_ptr<Material> material : materials)
+	{
+		material->SetPackedVertexShader(packedVertexShader);
+		material->SetInstancedVertexShaders(instancedVertexShader, packedInstancedVertexShader);
+	}
+
+	// PBR materials can read roughness and metalness from either separate maps or a packed one, so bind both
+	for(int i = 0; i < 8; i++)
+		materials[i]->SetPixelShader(usePackedOrm ? ormPixelShader : pixelShader);
+
 	/* Materials with albedo, normals, roughness, metalness maps (PBR) */
 
 	materials[0]->AddTextureSRV("AlbedoTexture", textureSRVs[L"bronze_albedo.png"]);
 	materials[0]->AddTextureSRV("NormalMap", textureSRVs[L"bronze_normals.png"]);
 	materials[0]->AddTextureSRV("RoughnessMap", textureSRVs[L"bronze_roughness.png"]);
 	materials[0]->AddTextureSRV("MetalnessMap", textureSRVs[L"bronze_metal.png"]);
+	materials[0]->AddTextureSRV("OrmMap", textureSRVs[L"bronze_orm"]);
 	materials[0]->AddTextureSRV("ShadowMap", shadowSRV);
 	materials[0]->AddSampler("BasicSampler", sampler);
 	materials[0]->AddSampler("ShadowSampler", shadowSampler);
@@ -344,6 +507,7 @@ void Game::CreateMaterials()
 	materials[1]->AddTextureSRV("NormalMap", textureSRVs[L"cobblestone_normals.png"]);
 	materials[1]->AddTextureSRV("RoughnessMap", textureSRVs[L"cobblestone_roughness.png"]);
 	materials[1]->AddTextureSRV("MetalnessMap", textureSRVs[L"cobblestone_metal.png"]);
+	materials[1]->AddTextureSRV("OrmMap", textureSRVs[L"cobblestone_orm"]);
 	materials[1]->AddTextureSRV("ShadowMap", shadowSRV);
 	materials[1]->AddSampler("BasicSampler", sampler);
 	materials[1]->AddSampler("ShadowSampler", shadowSampler);
@@ -352,6 +516,7 @@ void Game::CreateMaterials()
 	materials[2]->AddTextureSRV("NormalMap", textureSRVs[L"floor_normals.png"]);
 	materials[2]->AddTextureSRV("RoughnessMap", textureSRVs[L"floor_roughness.png"]);
 	materials[2]->AddTextureSRV("MetalnessMap", textureSRVs[L"floor_metal.png"]);
+	materials[2]->AddTextureSRV("OrmMap", textureSRVs[L"floor_orm"]);
 	materials[2]->AddTextureSRV("ShadowMap", shadowSRV);
 	materials[2]->AddSampler("BasicSampler", sampler);
 	materials[2]->AddSampler("ShadowSampler", shadowSampler);
@@ -360,6 +525,7 @@ void Game::CreateMaterials()
 	materials[3]->AddTextureSRV("NormalMap", textureSRVs[L"paint_normals.png"]);
 	materials[3]->AddTextureSRV("RoughnessMap", textureSRVs[L"paint_roughness.png"]);
 	materials[3]->AddTextureSRV("MetalnessMap", textureSRVs[L"paint_metal.png"]);
+	materials[3]->AddTextureSRV("OrmMap", textureSRVs[L"paint_orm"]);
 	materials[3]->AddTextureSRV("ShadowMap", shadowSRV);
 	materials[3]->AddSampler("BasicSampler", sampler);
 	materials[3]->AddSampler("ShadowSampler", shadowSampler);
@@ -368,6 +534,7 @@ void Game::CreateMaterials()
 	materials[4]->AddTextureSRV("NormalMap", textureSRVs[L"rough_normals.png"]);
 	materials[4]->AddTextureSRV("RoughnessMap", textureSRVs[L"rough_roughness.png"]);
 	materials[4]->AddTextureSRV("MetalnessMap", textureSRVs[L"rough_metal.png"]);
+	materials[4]->AddTextureSRV("OrmMap", textureSRVs[L"rough_orm"]);
 	materials[4]->AddTextureSRV("ShadowMap", shadowSRV);
 	materials[4]->AddSampler("BasicSampler", sampler);
 	materials[4]->AddSampler("ShadowSampler", shadowSampler);
@@ -376,6 +543,7 @@ void Game::CreateMaterials()
 	materials[5]->AddTextureSRV("NormalMap", textureSRVs[L"scratched_normals.png"]);
 	materials[5]->AddTextureSRV("RoughnessMap", textureSRVs[L"scratched_roughness.png"]);
 	materials[5]->AddTextureSRV("MetalnessMap", textureSRVs[L"scratched_metal.png"]);
+	materials[5]->AddTextureSRV("OrmMap", textureSRVs[L"scratched_orm"]);
 	materials[5]->AddTextureSRV("ShadowMap", shadowSRV);
 	materials[5]->AddSampler("BasicSampler", sampler);
 	materials[5]->AddSampler("ShadowSampler", shadowSampler);
@@ -384,6 +552,7 @@ void Game::CreateMaterials()
 	materials[6]->AddTextureSRV("NormalMap", textureSRVs[L"wood_normals.png"]);
 	materials[6]->AddTextureSRV("RoughnessMap", textureSRVs[L"wood_roughness.png"]);
 	materials[6]->AddTextureSRV("MetalnessMap", textureSRVs[L"wood_metal.png"]);
+	materials[6]->AddTextureSRV("OrmMap", textureSRVs[L"wood_orm"]);
 	materials[6]->AddTextureSRV("ShadowMap", shadowSRV);
 	materials[6]->AddSampler("BasicSampler", sampler);
 	materials[6]->AddSampler("ShadowSampler", shadowSampler);
@@ -392,6 +561,7 @@ void Game::CreateMaterials()
 	materials[7]->AddTextureSRV("NormalMap", textureSRVs[L"wood_normals.png"]);
 	materials[7]->AddTextureSRV("RoughnessMap", textureSRVs[L"wood_roughness.png"]);
 	materials[7]->AddTextureSRV("MetalnessMap", textureSRVs[L"wood_metal.png"]);
+	materials[7]->AddTextureSRV("OrmMap", textureSRVs[L"wood_orm"]);
 	materials[7]->AddTextureSRV("ShadowMap", shadowSRV);
 	materials[7]->AddSampler("BasicSampler", sampler);
 	materials[7]->AddSampler("ShadowSampler", shadowSampler);
@@ -402,17 +572,11 @@ void Game::CreateMaterials()
 // --------------------------------------------------------
 void Game::CreateGeometry()
 {
-	// Import meshes from file
-	meshes.push_back(std::make_shared<Mesh>(FixPath(L"../../Assets/Models/cube.obj").c_str()));
-	meshes.push_back(std::make_shared<Mesh>(FixPath(L"../../Assets/Models/cylinder.obj").c_str()));
-	meshes.push_back(std::make_shared<Mesh>(FixPath(L"../../Assets/Models/helix.obj").c_str()));
-	meshes.push_back(std::make_shared<Mesh>(FixPath(L"../../Assets/Models/sphere.obj").c_str()));
-	meshes.push_back(std::make_shared<Mesh>(FixPath(L"../../Assets/Models/torus.obj").c_str()));
-	meshes.push_back(std::make_shared<Mesh>(FixPath(L"../../Assets/Models/quad.obj").c_str()));
-	meshes.push_back(std::make_shared<Mesh>(FixPath(L"../../Assets/Models/quad_double_sided.obj").c_str()));
+	// Meshes (including the sky's cube) were created by LoadMeshes()
 
 	/* Create skybox */
-	skybox = std::make_shared<Skybox>(skyboxVertexShader, skyboxPixelShader, meshes[0], sampler, textureSRVs[L"Cold Sunset"]);
+
+	skybox = std::make_shared<Skybox>(skyboxVertexShader, skyboxPixelShader, skyMesh, sampler, textureSRVs[L"Cold Sunset"]);
 
 	/* Create entities */
 	std::shared_ptr<Entity> floor = std::make_shared<Entity>(meshes[5], materials[7]);
@@ -535,6 +699,55 @@ void Game::CreateShadowMap()
 	Graphics::Device->CreateSamplerState(&shadowSampDesc, &shadowSampler);
 }
 
+// --------------------------------------------------------
+// Uploads a texture and whatever mips it came with
+// - Grayscale images become R8_UNORM, everything else RGBA,
+//   marked sRGB if the file said it was (like WIC)
+// - Compressed textures use the matching BC format (BC4 and
+//   BC5 have no sRGB versions, but only hold linear data)
+// - Mips were already made on the CPU, so the texture can be
+//   immutable and created in one call
+// --------------------------------------------------------
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Game::CreateTexture(const TextureData& data)
+{
+	D3D11_TEXTURE2D_DESC textureDesc = {};
+	textureDesc.Width = data.width;
+	textureDesc.Height = data.height;
+	textureDesc.MipLevels = data.GetMipCount();
+	textureDesc.ArraySize = 1;
+	switch(data.format)
+	{
+	case BlockFormat::BC1: textureDesc.Format = data.isSRGB ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM; break;
+	case BlockFormat::BC3: textureDesc.Format = data.isSRGB ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM; break;
+	case BlockFormat::BC4: textureDesc.Format = DXGI_FORMAT_BC4_UNORM; break;
+	case BlockFormat::BC5: textureDesc.Format = DXGI_FORMAT_BC5_UNORM; break;
+	case BlockFormat::BC7: textureDesc.Format = data.isSRGB ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM; break;
+	default:
+		textureDesc.Format = data.channels == 1 ? DXGI_FORMAT_R8_UNORM :
+			(data.isSRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM);
+		break;
+	}
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+	// One subresource per mip, each half the size of the last
+	std::vector<D3D11_SUBRESOURCE_DATA> mipData(data.GetMipCount());
+	for(unsigned int i = 0; i < data.GetMipCount(); i++)
+	{
+		mipData[i].pSysMem = data.mipPixels[i];
+		mipData[i].SysMemPitch = data.GetRowPitch(i);
+	}
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> textureSRV;
+	if(FAILED(Graphics::Device->CreateTexture2D(&textureDesc, mipData.data(), texture.GetAddressOf())))
+		return textureSRV;
+
+	Graphics::Device->CreateShaderResourceView(texture.Get(), 0, textureSRV.GetAddressOf());
+	return textureSRV;
+}
+
 // --------------------------------------------------------
 // Author: Chris Cascioli
 // Purpose: Creates a cube map on the GPU from 6 individual textures
@@ -550,36 +763,16 @@ void Game::CreateShadowMap()
 // --------------------------------------------------------
 
 // --------------------------------------------------------
-// Loads six individual textures (the six faces of a cube map), then
-// creates a blank cube map and copies each of the six textures to
-// another face.  Afterwards, creates a shader resource view for
-// the cube map and cleans up all of the temporary resources.
+// Uploads a cooked cube map (six faces, each with its own
+// mip chain)
+// - Order matters here!  +X, -X, +Y, -Y, +Z, -Z
+// - Mips below the top are prefiltered for reflections (see
+//   CubemapCooker), so they're all uploaded and all visible
+// - Originally loaded each face with WIC and copied it into
+//   the cube; decoded faces can go straight in as its data
 // --------------------------------------------------------
-Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Game::CreateCubemap(
-	const wchar_t* right,
-	const wchar_t* left,
-	const wchar_t* up,
-	const wchar_t* down,
-	const wchar_t* front,
-	const wchar_t* back)
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Game::CreateCubemap(const TextureData& data)
 {
-	// Load the 6 textures into an array.
-	// - We need references to the TEXTURES, not SHADER RESOURCE VIEWS!
-	// - Explicitly NOT generating mipmaps, as we don't need them for the sky!
-	// - Order matters here!  +X, -X, +Y, -Y, +Z, -Z
-	Microsoft::WRL::ComPtr<ID3D11Texture2D> textures[6] = {};
-	CreateWICTextureFromFile(Graphics::Device.Get(), right, (ID3D11Resource**)textures[0].GetAddressOf(), 0);
-	CreateWICTextureFromFile(Graphics::Device.Get(), left, (ID3D11Resource**)textures[1].GetAddressOf(), 0);
-	CreateWICTextureFromFile(Graphics::Device.Get(), up, (ID3D11Resource**)textures[2].GetAddressOf(), 0);
-	CreateWICTextureFromFile(Graphics::Device.Get(), down, (ID3D11Resource**)textures[3].GetAddressOf(), 0);
-	CreateWICTextureFromFile(Graphics::Device.Get(), front, (ID3D11Resource**)textures[4].GetAddressOf(), 0);
-	CreateWICTextureFromFile(Graphics::Device.Get(), back, (ID3D11Resource**)textures[5].GetAddressOf(), 0);
-
-	// We'll assume all of the textures are the same color format and resolution,
-	// so get the description of the first texture
-	D3D11_TEXTURE2D_DESC faceDesc = {};
-	textures[0]->GetDesc(&faceDesc);
-
 	// Describe the resource for the cube map, which is simply 
 	// a "texture 2d array" with the TEXTURECUBE flag set.  
 	// This is a special GPU resource format, NOT just a 
@@ -588,55 +781,58 @@ Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Game::CreateCubemap(
 	cubeDesc.ArraySize = 6;            // Cube map!
 	cubeDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE; // We'll be using as a texture in a shader
 	cubeDesc.CPUAccessFlags = 0;       // No read back
-	cubeDesc.Format = faceDesc.Format; // Match the loaded texture's color format
-	cubeDesc.Width = faceDesc.Width;   // Match the size
-	cubeDesc.Height = faceDesc.Height; // Match the size
-	cubeDesc.MipLevels = 1;            // Only need 1
+	cubeDesc.Format = data.channels == 1 ? DXGI_FORMAT_R8_UNORM :
+		(data.isSRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM);
+	cubeDesc.Width = data.width;       // Match the size
+	cubeDesc.Height = data.height;     // Match the size
+	cubeDesc.MipLevels = data.GetMipCount(); // Every prefiltered level
 	cubeDesc.MiscFlags = D3D11_RESOURCE_MISC_TEXTURECUBE; // This should be treated as a CUBE, not 6 separate textures
-	cubeDesc.Usage = D3D11_USAGE_DEFAULT; // Standard usage
+	cubeDesc.Usage = D3D11_USAGE_IMMUTABLE; // Never changes after it's created
 	cubeDesc.SampleDesc.Count = 1;
 	cubeDesc.SampleDesc.Quality = 0;
 
-	// Create the final texture resource to hold the cube map
-	Microsoft::WRL::ComPtr<ID3D11Texture2D> cubeMapTexture;
-	Graphics::Device->CreateTexture2D(&cubeDesc, 0, cubeMapTexture.GetAddressOf());
-
-	// Loop through the individual face textures and copy them,
-	// one at a time, to the cube map texure
-	for (int i = 0; i < 6; i++)
+	// One subresource per mip of each face, in the same face-major order the data is in
+	std::vector<D3D11_SUBRESOURCE_DATA> faceData(data.mipPixels.size());
+	for(size_t i = 0; i < faceData.size(); i++)
 	{
-		// Calculate the subresource position to copy into
-		unsigned int subresource = D3D11CalcSubresource(
-			0,  // Which mip (zero, since there's only one)
-			i,  // Which array element?
-			1); // How many mip levels are in the texture?
-
-		// Copy from one resource (texture) to another
-		Graphics::Context->CopySubresourceRegion(
-			cubeMapTexture.Get(),  // Destination resource
-			subresource,           // Dest subresource index (one of the array elements)
-			0, 0, 0,               // XYZ location of copy
-			textures[i].Get(),     // Source resource
-			0,                     // Source subresource index (we're assuming there's only one)
-			0);                    // Source subresource "box" of data to copy (zero means the whole thing)
+		faceData[i].pSysMem = data.mipPixels[i];
+		faceData[i].SysMemPitch = data.GetRowPitch((unsigned int) (i % data.GetMipCount()));
 	}
 
-	// At this point, all of the faces have been copied into the 
-	// cube map texture, so we can describe a shader resource view for it
+	// Create the final texture resource to hold the cube map
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> cubeMapTexture;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> cubeSRV;
+	if(data.faceCount != 6 || FAILED(Graphics::Device->CreateTexture2D(&cubeDesc, faceData.data(), cubeMapTexture.GetAddressOf())))
+		return cubeSRV;
+
+	// Describe a shader resource view for the cube map
 	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 	srvDesc.Format = cubeDesc.Format;         // Same format as texture
 	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE; // Treat this as a cube!
-	srvDesc.TextureCube.MipLevels = 1;        // Only need access to 1 mip
+	srvDesc.TextureCube.MipLevels = cubeDesc.MipLevels; // Every mip, for reflections
 	srvDesc.TextureCube.MostDetailedMip = 0;  // Index of the first mip we want to see
 
 	// Make the SRV
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> cubeSRV;
 	Graphics::Device->CreateShaderResourceView(cubeMapTexture.Get(), &srvDesc, cubeSRV.GetAddressOf());
 
 	// Send back the SRV, which is what we need for our shaders
 	return cubeSRV;
 }
 
+void Game::ReplaceTexture(const std::wstring& name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
+{
+	auto placeholder = textureSRVs.find(name);
+	if(placeholder == textureSRVs.end() || !srv)
+		return;
+
+	for(std::shared_ptr<Material> material : materials)
+		material->ReplaceTextureSRV(placeholder->second.Get(), srv);
+	if(skybox && skybox->GetCubeMapSRV().Get() == placeholder->second.Get())
+		skybox->SetCubeMapSRV(srv);
+
+	placeholder->second = srv;
+}
+
 
 // --------------------------------------------------------
 // Handle resizing to match the new window size
@@ -670,6 +866,9 @@ void Game::Update(float deltaTime, float totalTime)
 
 	GetCamera()->Update(deltaTime);
 
+	// Upload whatever finished loading in the background (a few at a time, so no one frame hitches)
+	assetLoader.Update(4);
+
 	for(int i = 1; i < entities.size(); i++)
 	{
 		entities[i]->GetTransform()->Rotate(0, deltaTime, 0);
@@ -679,6 +878,14 @@ void Game::Update(float deltaTime, float totalTime)
 			5 + sin(i * totalTime / 10.0f) * 5);
 	}
 
+	// Rebuild the matrices of everything that moved in one go, rather than one at a time as each is drawn
+	auto transformUpdateStart = std::chrono::high_resolution_clock::now();
+	transformsRebuilt = TransformSystem::Global().UpdateWorldMatrices();
+	transformUpdateMilliseconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - transformUpdateStart).count() * 1000.0;
+
+	UpdateEntityBvh();
+	PickEntity();
+
 	for(std::shared_ptr<FluidVolume> fluid : fluidVolumes)
 		fluid->Update(deltaTime);
 }
@@ -780,6 +987,44 @@ void Game::BuildUI()
 	ImGui::Text("Rotation (Radians): (%.2f, %.2f, %.2f)", rotation.x, rotation.y, rotation.z);
 	ImGui::Text("FOV (Degrees): %.1f", GetCamera()->GetFOV());
 
+	if(ImGui::TreeNode("Asset Loading"))
+	{
+		ImGui::Text("Time to First Frame: %.1f ms", firstFrameMilliseconds);
+		ImGui::Text("Loaded: %u / %u (%u failed)", assetLoader.GetLoadedCount(), assetLoader.GetRequestedCount(), assetLoader.GetFailedCount());
+		if(assetLoader.IsIdle())
+			ImGui::Text("All Loaded After: %.1f ms", assetLoader.GetAllLoadedMilliseconds());
+		else
+			ImGui::Text("Still Loading: %u", assetLoader.GetPendingCount());
+		ImGui::Text("Texture Memory: %.1f MB (%.1f MB uncompressed, %.1fx smaller)", textureBytes / (1024.0 * 1024.0),
+			uncompressedTextureBytes / (1024.0 * 1024.0), textureBytes > 0 ? (double) uncompressedTextureBytes / textureBytes : 1.0);
+		ImGui::TreePop();
+	}
+	if(ImGui::TreeNode("Texture Packing"))
+	{
+		// Swap every PBR material between the separate and packed maps (they bind both)
+		if(ImGui::Checkbox("Packed ORM Maps", &usePackedOrm))
+		{
+			for(std::shared_ptr<Material> material : materials)
+			{
+				if(material->GetPixelShader() == pixelShader || material->GetPixelShader() == ormPixelShader)
+					material->SetPixelShader(usePackedOrm ? ormPixelShader : pixelShader);
+			}
+		}
+
+		// Albedo, normals, then either roughness and metalness or one ORM map
+		ImGui::Text("Material Texture Samples: %i per pixel", usePackedOrm ? 3 : 4);
+		ImGui::Text("Roughness + Metalness: %.2f MB separate, %.2f MB packed", roughnessMetalnessBytes / (1024.0 * 1024.0), ormBytes / (1024.0 * 1024.0));
+		ImGui::TreePop();
+	}
+	if(ImGui::TreeNode("Sky Lighting"))
+	{
+		// Ambient light from the sky's irradiance SH, straight up and straight down
+		DirectX::XMFLOAT3 up = skybox->GetIrradiance(DirectX::XMFLOAT3(0, 1, 0));
+		DirectX::XMFLOAT3 down = skybox->GetIrradiance(DirectX::XMFLOAT3(0, -1, 0));
+		ImGui::Text("Irradiance Up: %.2f, %.2f, %.2f", up.x, up.y, up.z);
+		ImGui::Text("Irradiance Down: %.2f, %.2f, %.2f", down.x, down.y, down.z);
+		ImGui::TreePop();
+	}
 	if(ImGui::TreeNode("Meshes"))
 	{
 		// Display the vertex and triangle count of each mesh
@@ -787,14 +1032,104 @@ void Game::BuildUI()
 		{
 			if(ImGui::TreeNode(mesh->GetName().c_str()))
 			{
-				ImGui::Text("Vertices: %i", mesh->GetVertexCount());
-				ImGui::Text("Triangles: %i", mesh->GetIndexCount() / 3);
-				ImGui::Text("Indices: %i", mesh->GetIndexCount());
+				ImGui::Text("Vertices: %i (%i before welding)", mesh->GetVertexCount(), mesh->GetSourceVertexCount());
+				ImGui::Text("Triangles: %i", mesh->GetTriangleCount());
+				ImGui::Text("Indices (All LODs): %i", mesh->GetIndexCount());
+				ImGui::Text("Vertex Format: %s (%i bytes each)", mesh->GetVertexFormat() == VertexFormat::Packed ? "Packed" : "Full", mesh->GetVertexStride());
+				ImGui::Text("Vertex Memory: %.1f KB", mesh->GetVertexCount() * mesh->GetVertexStride() / 1024.0f);
+				ImGui::Text("Meshlets: %i", (int) mesh->GetMeshlets().size());
+
+				// Simplified versions, with how far (in local units) each strays from the full mesh
+				const std::vector<MeshLod>& lods = mesh->GetLods();
+				for(int i = 1; i < lods.size(); i++)
+					ImGui::Text("LOD %i: %i triangles, error %.4f", i, mesh->GetTriangleCount(i), lods[i].error);
 				ImGui::TreePop();
 			}
 		}
 		ImGui::TreePop();
 	}
+	if(ImGui::TreeNode("Entity Culling"))
+	{
+		// Results from the last frame, per pass
+		ImGui::Text("Shadow Pass: %zu drawn, %zu culled", shadowVisibleCount, entities.size() - shadowVisibleCount);
+		ImGui::Text("Main Pass: %zu drawn, %zu culled", cameraVisibleCount, entities.size() - cameraVisibleCount);
+		ImGui::Text("BVH: %zu nodes, cost %.1f, updated in %.3f ms (%u rebuilds)", entityBvh.GetNodeCount(), entityBvh.GetCost(),
+			bvhUpdateMilliseconds, bvhRebuildCount);
+		ImGui::DragFloat("Rebuild Cost Ratio", &BoundingVolumeHierarchy::rebuildCostRatio, 0.01f, 1.0f, 4.0f);
+		if(pickedEntity >= 0)
+		{
+			ImGui::Text("Picked (Right Click): Entity %i (%s), %.1f%% of the way to the far plane, overlapping %zu others", pickedEntity,
+				entities[pickedEntity]->GetMesh()->GetName().c_str(), pickedDistance * 100.0f, pickedOverlapCount);
+		}
+		else
+			ImGui::Text("Picked (Right Click): Nothing");
+		ImGui::TreePop();
+	}
+	if(ImGui::TreeNode("Render Queue"))
+	{
+		// State set by the last frame's queue, against what setting everything for every draw would take
+		const RenderQueueStatistics& stats = renderQueueStatistics;
+		size_t instancedCount = 0;
+		for(const InstanceGroup& group : instanceBatcher.GetGroups())
+			instancedCount += group.instanceCount > 1 ? group.instanceCount : 0;
+		ImGui::Text("Draws: %zu (%zu passes), %zu without instancing", stats.drawCount, stats.passBinds, instanceBatcher.GetObjectCount());
+		ImGui::Text("Instanced Entities: %zu", instancedCount);
+		ImGui::Text("Shader Binds: %zu", stats.shaderBinds);
+		ImGui::Text("Material Binds: %zu", stats.materialBinds);
+		ImGui::Text("Mesh Binds: %zu", stats.meshBinds);
+		ImGui::TreePop();
+	}
+	if(ImGui::TreeNode("Shader State Cache"))
+	{
+		// Binds made through SimpleShader last frame; hits are the API calls that were skipped
+		const ShaderStateCacheStatistics& stats = shaderStateStatistics;
+		size_t totalBinds = stats.hits + stats.misses;
+		ImGui::Checkbox("Skip Redundant Binds", &ShaderStateCache::isEnabled);
+		ImGui::Text("Binds Skipped: %zu / %zu (%.1f%%)", stats.hits, totalBinds, totalBinds > 0 ? 100.0f * stats.hits / totalBinds : 0.0f);
+		ImGui::Text("Binds Made: %zu", stats.misses);
+		ImGui::TreePop();
+	}
+	if(ImGui::TreeNode("Constant Buffer Copies"))
+	{
+		// Last frame's copies; without skipping, every buffer would be copied in full every time
+		const SimpleBufferCopyStats& stats = bufferCopyStats;
+		size_t totalCopies = stats.CopyCount + stats.SkipCount;
+		size_t totalBytes = stats.BytesCopied + stats.BytesSkipped;
+		ImGui::Checkbox("Skip Unchanged Buffers", &ISimpleShader::SkipCleanBuffers);
+		ImGui::Text("Copies Made: %zu / %zu", stats.CopyCount, totalCopies);
+		ImGui::Text("Bytes Copied: %.1f KB (%.1f KB without skipping)", stats.BytesCopied / 1024.0f, totalBytes / 1024.0f);
+		ImGui::Text("Bytes Saved: %.1f%%", totalBytes > 0 ? 100.0f * stats.BytesSkipped / totalBytes : 0.0f);
+		ImGui::TreePop();
+	}
+	if(ImGui::TreeNode("Meshlet Culling"))
+	{
+		// Results from the last frame's main pass (shadows draw every meshlet)
+		const MeshletCullStatistics& stats = Mesh::meshletStatistics;
+		unsigned int totalTriangles = stats.trianglesVisible + stats.trianglesCulled;
+		ImGui::Text("Meshlets Drawn: %u", stats.meshletsVisible);
+		ImGui::Text("Meshlets Culled (Frustum): %u", stats.meshletsFrustumCulled);
+		ImGui::Text("Meshlets Culled (Normal Cone): %u", stats.meshletsConeCulled);
+		ImGui::Text("Triangles Culled: %u / %u (%.1f%%)", stats.trianglesCulled, totalTriangles,
+			totalTriangles > 0 ? 100.0f * stats.trianglesCulled / totalTriangles : 0.0f);
+		ImGui::TreePop();
+	}
+	if(ImGui::TreeNode("Level of Detail"))
+	{
+		ImGui::DragFloat("Max Pixel Error", &Entity::lodPixelError, 0.05f, 0.0f, 16.0f);
+
+		// How many entities drew each level last frame
+		int lodCounts[4] = {};
+		for(std::shared_ptr<Entity> entity : entities)
+			lodCounts[entity->GetLod() < 3 ? entity->GetLod() : 3]++;
+		for(int i = 0; i < 4; i++)
+			ImGui::Text("LOD %i: %i entities", i, lodCounts[i]);
+		ImGui::TreePop();
+	}
+	if(ImGui::TreeNode("Transforms"))
+	{
+		ImGui::Text("Transforms: %zu (%zu rebuilt this frame in %.3f ms)", TransformSystem::Global().GetCount(), transformsRebuilt, transformUpdateMilliseconds);
+		ImGui::TreePop();
+	}
 	if(ImGui::TreeNode("Entities"))
 	{
 		// Display the transform information for each entity
@@ -817,10 +1152,13 @@ void Game::BuildUI()
 					transform->SetLocation(location);
 				if(ImGui::DragFloat3("Rotation", &rotation.x, 0.1f))
 					transform->SetRotation(rotation);
+				XMFLOAT4 quaternion = transform->GetRotation();
+				ImGui::Text("Quaternion: (%.2f, %.2f, %.2f, %.2f)", quaternion.x, quaternion.y, quaternion.z, quaternion.w);
 				if(ImGui::DragFloat3("Scale", &scale.x, 0.1f))
 					transform->SetScale(scale);
 
 				ImGui::Text("Mesh Index Count: %i", entity->GetMesh()->GetIndexCount());
+				ImGui::Text("LOD: %i (%i triangles)", entity->GetLod(), entity->GetMesh()->GetTriangleCount(entity->GetLod()));
 
 				ImGui::TreePop();
 			}
@@ -865,6 +1203,236 @@ void Game::UpdateShadowMapMatrices(Light directionalLight)
 	XMStoreFloat4x4(&shadowProjectionMatrix, lightProjection);
 }
 
+// --------------------------------------------------------
+// Fits the entity BVH around where every entity is now
+// - Refitting is much cheaper than building, but loosens the
+//   tree as things move apart from where it was built; it's
+//   rebuilt once that's cost too much (or entities come or go)
+// --------------------------------------------------------
+void Game::UpdateEntityBvh()
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	entityWorldBounds.resize(entities.size());
+	for(size_t i = 0; i < entities.size(); i++)
+		entityWorldBounds[i] = TransformMeshBounds(entities[i]->GetMesh()->GetBounds(), entities[i]->GetTransform()->GetWorldMatrix());
+
+	if(entityBvh.GetObjectCount() != entities.size() || entityBvh.NeedsRebuild())
+	{
+		entityBvh.Build(entityWorldBounds.data(), entityWorldBounds.size());
+		bvhRebuildCount++;
+	}
+	else
+		entityBvh.Refit(entityWorldBounds.data());
+
+	bvhUpdateMilliseconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count() * 1000.0;
+}
+
+// --------------------------------------------------------
+// Casts a ray from the camera through the mouse on right
+// click, and keeps track of what the picked entity's bounds
+// overlap as it moves
+// --------------------------------------------------------
+void Game::PickEntity()
+{
+	if(Input::MouseRightPress())
+	{
+		XMFLOAT3 origin, direction;
+		GetCamera()->ScreenPointToRay((float) Input::GetMouseX(), (float) Input::GetMouseY(), (float) Window::Width(), (float) Window::Height(), origin, direction);
+
+		uint32_t entity;
+		pickedEntity = entityBvh.Raycast(origin, direction, 1.0f, entity, pickedDistance) ? (int) entity : -1;
+	}
+
+	if(pickedEntity >= (int) entities.size())
+		pickedEntity = -1;
+	if(pickedEntity >= 0)
+	{
+		bvhQueryResults.clear();
+		const MeshBounds& bounds = entityWorldBounds[pickedEntity];
+		pickedOverlapCount = entityBvh.QueryOverlap(bounds.center, bounds.extents, bvhQueryResults) - 1;
+	}
+}
+
+// --------------------------------------------------------
+// Copies every group's instance data into one buffer for the
+// instanced vertex shaders, growing it if needed
+// --------------------------------------------------------
+void Game::UploadInstances()
+{
+	const std::vector<InstanceData>& instances = instanceBatcher.GetInstances();
+	if(instances.empty())
+		return;
+
+	// Double the capacity when it runs out, so the buffer is rarely recreated
+	if(instances.size() > instanceBufferCapacity)
+	{
+		instanceBufferCapacity = 64;
+		while(instanceBufferCapacity < instances.size())
+			instanceBufferCapacity *= 2;
+
+		D3D11_BUFFER_DESC instanceBufferDesc = {};
+		instanceBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+		instanceBufferDesc.ByteWidth = (UINT) (sizeof(InstanceData) * instanceBufferCapacity);
+		instanceBufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		instanceBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		instanceBufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+		instanceBufferDesc.StructureByteStride = sizeof(InstanceData);
+		instanceBuffer.Reset();
+		Graphics::Device->CreateBuffer(&instanceBufferDesc, nullptr, instanceBuffer.GetAddressOf());
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC instanceSRVDesc = {};
+		instanceSRVDesc.Format = DXGI_FORMAT_UNKNOWN;
+		instanceSRVDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+		instanceSRVDesc.Buffer.FirstElement = 0;
+		instanceSRVDesc.Buffer.NumElements = (UINT) instanceBufferCapacity;
+		instanceSRV.Reset();
+		Graphics::Device->CreateShaderResourceView(instanceBuffer.Get(), &instanceSRVDesc, instanceSRV.GetAddressOf());
+	}
+
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	Graphics::Context->Map(instanceBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+	memcpy(mapped.pData, instances.data(), sizeof(InstanceData) * instances.size());
+	Graphics::Context->Unmap(instanceBuffer.Get(), 0);
+}
+
+// --------------------------------------------------------
+// Render queue backend: sets up each pass, shader, material
+// and mesh as the queue reaches it, then draws the group
+// (with an instanced draw if it has more than one entity)
+// - Whatever's the same for a whole pass (targets) is set
+//   along with the pass, and whatever's the same for a whole
+//   frame (camera, lights) is in the shared frame buffers
+// --------------------------------------------------------
+void Game::BindPass(const RenderItem& item)
+{
+	if(GetSortKeyPass(item.key) == MainPass)
+	{
+		SetMainPassTargets();
+		return;
+	}
+
+	/* Shadow mapping setup */
+
+	ID3D11RenderTargetView* nullRTV{};
+	Graphics::Context->OMSetRenderTargets(1, &nullRTV, shadowDSV.Get());
+
+	if(ShaderStateCache::ForContext(Graphics::Context.Get()).SetShader(ShaderStage::Pixel, nullptr))
+		Graphics::Context->PSSetShader(0, 0, 0);
+
+	Graphics::Context->RSSetState(shadowRasterizer.Get());
+
+	D3D11_VIEWPORT viewport = {};
+	viewport.Width = 1024.0f;
+	viewport.Height = 1024.0f;
+	viewport.MaxDepth = 1.0f;
+	Graphics::Context->RSSetViewports(1, &viewport);
+}
+void Game::BindShader(const RenderItem& item)
+{
+	const InstanceGroup& group = instanceBatcher.GetGroups()[item.object];
+	std::shared_ptr<Entity> e = entities[instanceBatcher.GetObjects()[group.firstInstance]];
+	bool isInstanced = group.instanceCount > 1;
+
+	std::shared_ptr<SimpleVertexShader> vs;
+	if(GetSortKeyPass(item.key) == ShadowPass)
+	{
+		// Packed meshes need the shadow shaders that can unpack them
+		if(e->GetMesh()->GetVertexFormat() == VertexFormat::Packed)
+			vs = isInstanced ? packedInstancedShadowVertexShader : packedShadowVertexShader;
+		else
+			vs = isInstanced ? instancedShadowVertexShader : shadowVertexShader;
+		vs->SetShader();
+	}
+	else
+	{
+		vs = isInstanced ? e->GetInstancedVertexShader() : e->GetVertexShader();
+		std::shared_ptr<SimplePixelShader> ps = e->GetMaterial()->GetPixelShader();
+		vs->SetShader();
+		ps->SetShader();
+	}
+
+	if(isInstanced)
+		vs->SetShaderResourceView("Instances", instanceSRV);
+}
+void Game::BindMaterial(const RenderItem& item)
+{
+	// Shadows don't use materials
+	if(GetSortKeyPass(item.key) == ShadowPass)
+		return;
+
+	// Have the material set up the shader with its private values (the pixel shader's buffer is only ever
+	// changed by this and BindShader(), which always comes with a new material)
+	const InstanceGroup& group = instanceBatcher.GetGroups()[item.object];
+	std::shared_ptr<Material> material = entities[instanceBatcher.GetObjects()[group.firstInstance]]->GetMaterial();
+	material->PrepareMaterial();
+	material->GetPixelShader()->CopyAllBufferData();
+}
+void Game::BindMesh(const RenderItem& item)
+{
+	const InstanceGroup& group = instanceBatcher.GetGroups()[item.object];
+	entities[instanceBatcher.GetObjects()[group.firstInstance]]->GetMesh()->SetBuffers();
+}
+void Game::Draw(const RenderItem& item)
+{
+	const InstanceGroup& group = instanceBatcher.GetGroups()[item.object];
+	std::shared_ptr<Entity> e = entities[instanceBatcher.GetObjects()[group.firstInstance]];
+	std::shared_ptr<Mesh> mesh = e->GetMesh();
+	bool isShadowPass = GetSortKeyPass(item.key) == ShadowPass;
+
+	// Lone entities draw just as they would without instancing (with meshlet culling in the main pass)
+	if(group.instanceCount == 1)
+	{
+		if(!isShadowPass)
+		{
+			e->DrawObject(GetCamera());
+			return;
+		}
+
+		std::shared_ptr<SimpleVertexShader> vs = shadowVertexShader;
+		if(mesh->GetVertexFormat() == VertexFormat::Packed)
+		{
+			vs = packedShadowVertexShader;
+			vs->SetFloat3("positionOffset", mesh->GetQuantization().positionOffset);
+			vs->SetFloat3("positionScale", mesh->GetQuantization().positionScale);
+		}
+
+		vs->SetMatrix4x4("world", e->GetTransform()->GetWorldMatrix());
+		vs->CopyAllBufferData();
+
+		// Draw the mesh directly to avoid the entity's material
+		mesh->Draw(group.lod, false);
+		return;
+	}
+
+	// Instances read their matrices from the instance buffer, starting at the group's first
+	std::shared_ptr<SimpleVertexShader> vs;
+	if(isShadowPass)
+		vs = mesh->GetVertexFormat() == VertexFormat::Packed ? packedInstancedShadowVertexShader : instancedShadowVertexShader;
+	else
+		vs = e->GetInstancedVertexShader();
+	if(mesh->GetVertexFormat() == VertexFormat::Packed)
+	{
+		vs->SetFloat3("positionOffset", mesh->GetQuantization().positionOffset);
+		vs->SetFloat3("positionScale", mesh->GetQuantization().positionScale);
+	}
+	vs->SetInt("firstInstance", (int) group.firstInstance);
+	vs->CopyAllBufferData();
+
+	mesh->DrawInstanced(group.instanceCount, group.lod, false);
+}
+void Game::SetMainPassTargets()
+{
+	Graphics::Context->RSSetState(0);
+
+	D3D11_VIEWPORT viewport = {};
+	viewport.Width = (float) Window::Width();
+	viewport.Height = (float) Window::Height();
+	viewport.MaxDepth = 1.0f;
+	Graphics::Context->RSSetViewports(1, &viewport);
+	// Start draw by setting render target to first post-process step (results are processed by blur first before sent to back buffer)
+	Graphics::Context->OMSetRenderTargets(1, postProcessBlurRTV.GetAddressOf(), Graphics::DepthBufferDSV.Get());
+}
 
 // --------------------------------------------------------
 // Clear the screen, redraw everything, present to the user
@@ -881,62 +1449,118 @@ void Game::Draw(float deltaTime, float totalTime)
 
 		Graphics::Context->ClearRenderTargetView(postProcessBlurRTV.Get(), backgroundColor);
 
-		/* Shadow mapping setup */
-
-		Graphics::Context->ClearDepthStencilView(shadowDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
-
-		ID3D11RenderTargetView* nullRTV{};
-		Graphics::Context->OMSetRenderTargets(1, &nullRTV, shadowDSV.Get());
-
-		Graphics::Context->PSSetShader(0, 0, 0);
+		// Meshlet culling is counted per frame
+		Mesh::meshletStatistics = {};
+
+		// So are the shader state cache's hits and misses
+		ShaderStateCache& stateCache = ShaderStateCache::ForContext(Graphics::Context.Get());
+		shaderStateStatistics = stateCache.GetStatistics();
+		stateCache.ResetStatistics();
+
+		// And constant buffer copies
+		bufferCopyStats = ISimpleShader::BufferCopyStats;
+		ISimpleShader::BufferCopyStats = {};
+
+		// Camera, shadow and light data is the same for every shader drawing this frame, so it's copied just once
+		FrameData frameData = {};
+		frameData.viewMatrix = GetCamera()->GetViewMatrix();
+		frameData.projMatrix = GetCamera()->GetProjectionMatrix();
+		frameData.lightView = shadowViewMatrix;
+		frameData.lightProj = shadowProjectionMatrix;
+		frameData.cameraLocation = GetCamera()->GetTransform().GetLocation();
+		frameData.totalTime = totalTime;
+		ISimpleShader::SetSharedBufferData("FrameData", &frameData, sizeof(FrameData));
+
+		LightData lightData = {};
+		lightData.lightCount = lights.size() < MAX_LIGHTS ? (int) lights.size() : MAX_LIGHTS;
+		memcpy(lightData.lights, lights.data(), sizeof(Light) * lightData.lightCount);
+		ISimpleShader::SetSharedBufferData("LightData", &lightData, (unsigned int) (offsetof(LightData, lights) + sizeof(Light) * lightData.lightCount));
+		ISimpleShader::CopySharedBufferData(Graphics::Context);
+
+		// Cull whole entities against both passes (through the BVH, fitted in Update), before any of them are set up to draw
+		auto cullEntities = [&](const XMFLOAT4X4& view, const XMFLOAT4X4& projection, std::vector<uint8_t>& visibility)
+		{
+			XMFLOAT4X4 viewProjection;
+			XMStoreFloat4x4(&viewProjection, XMLoadFloat4x4(&view) * XMLoadFloat4x4(&projection));
+
+			bvhQueryResults.clear();
+			entityBvh.QueryFrustum(Frustum::FromMatrix(viewProjection), bvhQueryResults);
+			visibility.assign(entities.size(), 0);
+			for(uint32_t entity : bvhQueryResults)
+				visibility[entity] = 1;
+			return bvhQueryResults.size();
+		};
+		shadowVisibleCount = cullEntities(shadowViewMatrix, shadowProjectionMatrix, shadowVisibility);
+		cameraVisibleCount = cullEntities(GetCamera()->GetViewMatrix(), GetCamera()->GetProjectionMatrix(), cameraVisibility);
+
+		// Sort key for drawing an entity in a pass, on its own or as part of an instanced draw
+		auto getId = [](auto& ids, const auto& key) { return ids.try_emplace(key, (uint32_t) ids.size()).first->second; };
+		XMFLOAT3 cameraLocation = GetCamera()->GetTransform().GetLocation();
+		float farDistance = GetCamera()->GetFarDistance();
+		auto makeKey = [&](RenderPass pass, uint32_t entity, bool isInstanced)
+		{
+			std::shared_ptr<Entity> e = entities[entity];
+			std::shared_ptr<Mesh> mesh = e->GetMesh();
+			uint32_t meshId = getId(meshIds, mesh.get());
 
-		Graphics::Context->RSSetState(shadowRasterizer.Get());
+			// Shadows skip materials, and only need different shaders for packed meshes and instancing
+			if(pass == ShadowPass)
+			{
+				uint32_t shaderId = (mesh->GetVertexFormat() == VertexFormat::Packed ? 1 : 0) + (isInstanced ? 2 : 0);
+				return MakeSortKey(ShadowPass, shaderId, 0, meshId, 0.0f);
+			}
 
-		D3D11_VIEWPORT viewport = {};
-		viewport.Width = 1024.0f;
-		viewport.Height = 1024.0f;
-		viewport.MaxDepth = 1.0f;
-		Graphics::Context->RSSetViewports(1, &viewport);
+			std::shared_ptr<SimpleVertexShader> vs = isInstanced ? e->GetInstancedVertexShader() : e->GetVertexShader();
+			std::pair<const void*, const void*> shaders(vs.get(), e->GetMaterial()->GetPixelShader().get());
+			float distance = XMVectorGetX(XMVector3Length(XMLoadFloat3(&entityWorldBounds[entity].center) - XMLoadFloat3(&cameraLocation)));
+			return MakeSortKey(MainPass, getId(shaderIds, shaders), getId(materialIds, e->GetMaterial().get()), meshId, distance / farDistance);
+		};
 
-		shadowVertexShader->SetShader();
-		shadowVertexShader->SetMatrix4x4("view", shadowViewMatrix);
-		shadowVertexShader->SetMatrix4x4("projection", shadowProjectionMatrix);
-		// Loop and draw all entities
-		for(auto& e : entities)
+		// Group each visible entity, once per pass it's visible in, with any others it can be instanced with
+		instanceBatcher.Clear();
+		for(uint32_t i = 0; i < (uint32_t) entities.size(); i++)
 		{
-			shadowVertexShader->SetMatrix4x4("world", e->GetTransform()->GetWorldMatrix());
-			shadowVertexShader->CopyAllBufferData();
-
-			// Draw the mesh directly to avoid the entity's material
-			e->GetMesh()->Draw();
+			if(!shadowVisibility[i] && !cameraVisibility[i])
+				continue;
+			std::shared_ptr<Entity> e = entities[i];
+			Transform* transform = e->GetTransform();
+			uint32_t lod = (uint32_t) e->UpdateLod(GetCamera()); // The camera's, so shadows match what it sees
+
+			if(shadowVisibility[i])
+				instanceBatcher.Add(makeKey(ShadowPass, i, false), lod, i, transform->GetWorldMatrix(), transform->GetWorldInverseTransposeMatrix());
+			if(cameraVisibility[i])
+			{
+				instanceBatcher.Add(makeKey(MainPass, i, false), lod, i, transform->GetWorldMatrix(), transform->GetWorldInverseTransposeMatrix(),
+					e->GetInstancedVertexShader() != nullptr);
+			}
 		}
+		instanceBatcher.Build();
+		UploadInstances();
 
-		Graphics::Context->RSSetState(0);
+		// Queue each group, switching groups of more than one over to the instanced shaders
+		renderQueue.Clear();
+		const std::vector<InstanceGroup>& groups = instanceBatcher.GetGroups();
+		for(uint32_t i = 0; i < (uint32_t) groups.size(); i++)
+		{
+			const InstanceGroup& group = groups[i];
+			uint64_t key = group.key;
+			if(group.instanceCount > 1)
+				key = makeKey((RenderPass) GetSortKeyPass(key), instanceBatcher.GetObjects()[group.firstInstance], true);
+			renderQueue.Add(key, i);
+		}
+		renderQueue.Sort();
 
-		viewport.Width = (float) Window::Width();
-		viewport.Height = (float) Window::Height();
-		Graphics::Context->RSSetViewports(1, &viewport);
-		// Start draw by setting render target to first post-process step (results are processed by blur first before sent to back buffer)
-		Graphics::Context->OMSetRenderTargets(1, postProcessBlurRTV.GetAddressOf(), Graphics::DepthBufferDSV.Get());
+		Graphics::Context->ClearDepthStencilView(shadowDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
 	}
 
 	// DRAW geometry
 	// - These steps are generally repeated for EACH object you draw
 	// - Other Direct3D calls will also be necessary to do more complex things
 	{
-		// Draw all entities
-		for(std::shared_ptr<Entity> e : entities)
-		{
-			// Give light data for main (shadow-casting) directional light
-			e->GetMaterial()->GetVertexShader()->SetMatrix4x4("lightView", shadowViewMatrix);
-			e->GetMaterial()->GetVertexShader()->SetMatrix4x4("lightProj", shadowProjectionMatrix);
-
-			// Give all light data
-			e->GetMaterial()->GetPixelShader()->SetInt("lightCount", (int) lights.size());
-			e->GetMaterial()->GetPixelShader()->SetData("lights", &lights[0], sizeof(Light) * (int) lights.size());
-
-			e->Draw(GetCamera(), totalTime);
-		}
+		// Draw all entities (in view), shadows first; the main pass's targets are set by the queue once it gets there
+		renderQueueStatistics = renderQueue.Submit(*this);
+		if(renderQueue.GetItems().empty() || GetSortKeyPass(renderQueue.GetItems().back().key) != MainPass)
+			SetMainPassTargets();
 
 		// Draw skybox
 		skybox->Draw(GetCamera());
@@ -1017,21 +1641,37 @@ void Game::Draw(float deltaTime, float totalTime)
 		ImGui::Render(); // Turn's this frame's UI into renderable triangles
 		ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData()); // Draws to the screen
 
+		// ImGui puts back everything it binds, apart from clearing these shaders
+		ShaderStateCache& stateCache = ShaderStateCache::ForContext(Graphics::Context.Get());
+		stateCache.InvalidateShader(ShaderStage::Hull);
+		stateCache.InvalidateShader(ShaderStage::Domain);
+		stateCache.InvalidateShader(ShaderStage::Compute);
+
 		// Present at the end of the frame
 		bool vsync = Graphics::VsyncState();
 		Graphics::SwapChain->Present(
 			vsync ? 1 : 0,
 			vsync ? 0 : DXGI_PRESENT_ALLOW_TEARING);
 
+		// Report how long it took to get something on screen (while assets may still be arriving)
+		if(firstFrameMilliseconds == 0.0)
+		{
+			firstFrameMilliseconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - initializeStartTime).count() * 1000.0;
+			printf("Time to first frame: %.1f ms (%u of %u assets still loading)\n",
+				firstFrameMilliseconds, assetLoader.GetPendingCount(), assetLoader.GetRequestedCount());
+		}
+
 		// Re-bind back buffer and depth buffer after presenting
 		Graphics::Context->OMSetRenderTargets(
 			1,
 			Graphics::BackBufferRTV.GetAddressOf(),
 			Graphics::DepthBufferDSV.Get());
 
-		// Unbind ALL SRVs
+		// Unbind ALL SRVs (or rather, the ones the cache knows are still bound)
 		ID3D11ShaderResourceView* nullSRVs[128] = {};
-		Graphics::Context->PSSetShaderResources(0, 128, nullSRVs);
+		unsigned int firstSlot = 0, slotCount = 128;
+		if(stateCache.UnbindShaderResourceViews(ShaderStage::Pixel, firstSlot, slotCount))
+			Graphics::Context->PSSetShaderResources(firstSlot, slotCount, nullSRVs);
 	}
 }
 
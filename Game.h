@@ -2,7 +2,10 @@
 
 #include <d3d11.h>
 #include <wrl/client.h>
+#include <chrono>
+#include <map>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include <DirectXMath.h>
@@ -15,11 +18,16 @@
 #include "Camera.h"
 #include "Material.h"
 #include "Lights.h"
+#include "FrameData.h"
 #include "Skybox.h"
 #include "ParticleSystem.h"
 #include "FluidVolume.h"
+#include "AssetLoader.h"
+#include "BoundingVolumeHierarchy.h"
+#include "RenderQueue.h"
+#include "InstanceBatcher.h"
 
-class Game
+class Game : public RenderQueueBackend
 {
 private:
 #pragma region FilePaths
@@ -76,6 +84,21 @@ private:
 
 		L"../../Assets/Textures/Particles/Transparent/smoke_01.png"
 	};
+	// File paths of all meshes, in the order they're stored in meshes
+	const std::vector<std::wstring> meshPaths =
+	{
+		L"../../Assets/Models/cube.obj",
+		L"../../Assets/Models/cylinder.obj",
+		L"../../Assets/Models/helix.obj",
+		L"../../Assets/Models/sphere.obj",
+		L"../../Assets/Models/torus.obj",
+		L"../../Assets/Models/quad.obj",
+		L"../../Assets/Models/quad_double_sided.obj"
+	};
+	// Materials whose roughness and metalness maps are also packed into one ORM texture, named "<material>_orm"
+	// - i.e. "bronze" packs PBR/bronze_roughness.png and PBR/bronze_metal.png (there are no occlusion maps)
+	const std::wstring ormTextureDirectory = L"../../Assets/Textures/PBR/";
+	const std::vector<std::wstring> ormMaterialNames = { L"bronze", L"cobblestone", L"floor", L"paint", L"rough", L"scratched", L"wood" };
 	const std::unordered_map<std::wstring, std::vector<std::wstring>> cubemapPaths =
 	{
 		{ L"Cold Sunset",
@@ -93,8 +116,12 @@ private:
 
 	// Shaders and shader-related constructs
 	std::shared_ptr<SimpleVertexShader> vertexShader;
+	std::shared_ptr<SimpleVertexShader> packedVertexShader;
+	std::shared_ptr<SimpleVertexShader> instancedVertexShader;
+	std::shared_ptr<SimpleVertexShader> packedInstancedVertexShader;
 	std::shared_ptr<SimpleVertexShader> skyboxVertexShader;
 	std::shared_ptr<SimplePixelShader> pixelShader;
+	std::shared_ptr<SimplePixelShader> ormPixelShader; // Same as pixelShader, but reads roughness and metalness from one packed map
 	std::shared_ptr<SimplePixelShader> skyboxPixelShader;
 	std::shared_ptr<SimplePixelShader> normalPixelShader;
 	std::shared_ptr<SimplePixelShader> uvPixelShader;
@@ -103,6 +130,64 @@ private:
 	std::unordered_map<std::wstring, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> textureSRVs;
 	Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler;
 
+	// Textures and meshes load in the background, starting out as placeholders
+	AssetLoader assetLoader;
+	std::chrono::high_resolution_clock::time_point initializeStartTime;
+	double firstFrameMilliseconds = 0.0; // From the start of Initialize() to the first Present()
+
+	// Color textures go to BC1 (BC3 with transparency); BC7 doubles their size for ~8 dB more PSNR
+	const BlockFormat colorTextureFormat = BlockFormat::BC1;
+	size_t textureBytes = 0;				// Loaded textures as uploaded (full mip chains)
+	size_t uncompressedTextureBytes = 0;	// The same textures as plain 8-bit texels
+
+	// PBR materials sample one packed ORM map instead of separate roughness and metalness maps
+	// - BC1 halves the bytes of two BC4 maps but costs ~8 dB of roughness PSNR; BC7 keeps quality at the same size
+	bool usePackedOrm = true;
+	const BlockFormat ormTextureFormat = BlockFormat::BC1;
+	size_t roughnessMetalnessBytes = 0;	// Separate roughness and metalness maps, as uploaded
+	size_t ormBytes = 0;				// Packed ORM maps, as uploaded
+
+	// Every transform's matrices are rebuilt in one batch per frame (see TransformSystem)
+	size_t transformsRebuilt = 0;
+	double transformUpdateMilliseconds = 0.0;
+
+	// Entities are culled against each pass's frustum before drawing, through a BVH over their world bounds
+	// that's refit every frame (and rebuilt once that's loosened it too much)
+	BoundingVolumeHierarchy entityBvh;
+	std::vector<MeshBounds> entityWorldBounds;
+	std::vector<uint32_t> bvhQueryResults;
+	std::vector<uint8_t> shadowVisibility;
+	std::vector<uint8_t> cameraVisibility;
+	size_t shadowVisibleCount = 0;
+	size_t cameraVisibleCount = 0;
+	unsigned int bvhRebuildCount = 0;
+	double bvhUpdateMilliseconds = 0.0;
+
+	// Visible entities draw through a render queue, sorted by pass, shader, material and mesh (then front to
+	// back) so each of those is only set when it changes; ids for the sort keys are handed out as things are first drawn
+	// - Entities that would draw with the same state and LOD are grouped first, and queued as one instanced draw
+	enum RenderPass { ShadowPass, MainPass };
+	InstanceBatcher instanceBatcher;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> instanceBuffer; // Every group's InstanceData, uploaded once per frame
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> instanceSRV;
+	size_t instanceBufferCapacity = 0;
+	RenderQueue renderQueue;
+	RenderQueueStatistics renderQueueStatistics = {};
+	std::map<std::pair<const void*, const void*>, uint32_t> shaderIds; // Vertex and pixel shader pairs
+	std::unordered_map<const void*, uint32_t> materialIds;
+	std::unordered_map<const void*, uint32_t> meshIds;
+
+	// Shaders skip binding what's already bound (see ShaderStateCache); these are the last frame's binds
+	ShaderStateCacheStatistics shaderStateStatistics = {};
+
+	// Shaders also skip copying constant buffers that haven't changed; these are the last frame's copies
+	SimpleBufferCopyStats bufferCopyStats;
+
+	// Right clicking picks the entity under the mouse (-1 for none)
+	int pickedEntity = -1;
+	float pickedDistance = 0.0f;
+	size_t pickedOverlapCount = 0; // Other entities whose bounds overlap the picked one's
+
 	Microsoft::WRL::ComPtr<ID3D11BlendState> particleBlendState;
 	Microsoft::WRL::ComPtr<ID3D11DepthStencilState> particleDepthState;
 
@@ -115,6 +200,9 @@ private:
 	Microsoft::WRL::ComPtr<ID3D11RasterizerState> shadowRasterizer;
 	Microsoft::WRL::ComPtr<ID3D11SamplerState> shadowSampler;
 	std::shared_ptr<SimpleVertexShader> shadowVertexShader;
+	std::shared_ptr<SimpleVertexShader> packedShadowVertexShader;
+	std::shared_ptr<SimpleVertexShader> instancedShadowVertexShader;
+	std::shared_ptr<SimpleVertexShader> packedInstancedShadowVertexShader;
 	DirectX::XMFLOAT4X4 shadowViewMatrix;
 	DirectX::XMFLOAT4X4 shadowProjectionMatrix;
 
@@ -146,6 +234,7 @@ private:
 	unsigned int activeCameraIndex;
 
 	std::shared_ptr<Skybox> skybox;
+	std::shared_ptr<Mesh> skyMesh;
 
 	std::vector<std::shared_ptr<Material>> materials;
 	std::vector<std::shared_ptr<Mesh>> meshes;
@@ -180,6 +269,7 @@ public:
 
 private:
 	// Initialization helper methods
+	void LoadMeshes();
 	void LoadTextures();
 	void LoadShaders();
 	void InitializePostProcessEffects();
@@ -190,9 +280,11 @@ private:
 	void CreateLights();
 	void CreateShadowMap();
 
-	// Helper for creating a cubemap from 6 individual textures
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> CreateCubemap(
-		const wchar_t* right, const wchar_t* left, const wchar_t* up, const wchar_t* down, const wchar_t* front, const wchar_t* back);
+	// Helpers for uploading decoded images as a texture (with mipmaps) or a cubemap (from 6 faces)
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> CreateTexture(const TextureData& data);
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> CreateCubemap(const TextureData& data);
+	// Swaps a texture that has finished loading in for its placeholder, everywhere the placeholder is used
+	void ReplaceTexture(const std::wstring& name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
 
 	// ImGUI implementation
 	void UpdateImGui(float deltaTime, float totalTime) const;
@@ -201,4 +293,16 @@ private:
 	void UpdatePostProcessRenderTargets();
 
 	void UpdateShadowMapMatrices(Light directionalLight);
+	void UpdateEntityBvh();
+	void PickEntity();
+
+	void UploadInstances();
+
+	// Render queue backend, for drawing entities (each item is one of instanceBatcher's groups)
+	void BindPass(const RenderItem& item) override;
+	void BindShader(const RenderItem& item) override;
+	void BindMaterial(const RenderItem& item) override;
+	void BindMesh(const RenderItem& item) override;
+	void Draw(const RenderItem& item) override;
+	void SetMainPassTargets();
 };
\ No newline at end of file
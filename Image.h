@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// --------------------------------------------------------
+// Decoded 8-bit image in CPU memory, ready to upload
+// - Rows run top to bottom with no padding, so each row is
+//   width * channels bytes
+// - Grayscale images keep a single channel (like WIC's
+//   R8_UNORM); everything else is expanded to RGBA
+// - isSRGB is set when the file says its colors are sRGB,
+//   which is when WIC would pick an _SRGB format
+// --------------------------------------------------------
+struct Image
+{
+	unsigned int width;
+	unsigned int height;
+	unsigned int channels;
+	bool isSRGB;
+	std::vector<uint8_t> pixels;
+};
@@ -0,0 +1,67 @@
+#include "InstanceBatcher.h"
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <numeric>
+
+using namespace DirectX;
+
+void InstanceBatcher::Clear()
+{
+	added.clear();
+	groups.clear();
+	instances.clear();
+	objects.clear();
+}
+
+void InstanceBatcher::Add(uint64_t key, uint32_t lod, uint32_t object, const XMFLOAT4X4& world, const XMFLOAT4X4& worldInvTranspose, bool canInstance)
+{
+	added.push_back({ key, lod, object, canInstance, { world, worldInvTranspose } });
+}
+
+void InstanceBatcher::Build()
+{
+	groups.clear();
+	instances.clear();
+	objects.clear();
+
+	// Same state and level of detail side by side, nearest first (and in the order added, for equal keys)
+	order.resize(added.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b)
+		{
+			const Object& objectA = added[a];
+			const Object& objectB = added[b];
+			uint64_t stateA = GetSortKeyState(objectA.key);
+			uint64_t stateB = GetSortKeyState(objectB.key);
+			if(stateA != stateB)
+				return stateA < stateB;
+			if(objectA.lod != objectB.lod)
+				return objectA.lod < objectB.lod;
+			if(objectA.key != objectB.key)
+				return objectA.key < objectB.key;
+			return a < b;
+		});
+
+	instances.reserve(added.size());
+	objects.reserve(added.size());
+	for(uint32_t index : order)
+	{
+		const Object& object = added[index];
+
+		// Only joins the group before if that's instanced, and has the same state and level of detail
+		bool isNewGroup = groups.empty() || !object.canInstance;
+		if(!isNewGroup)
+		{
+			const InstanceGroup& group = groups.back();
+			const Object& first = added[order[group.firstInstance]];
+			isNewGroup = !first.canInstance || GetSortKeyState(first.key) != GetSortKeyState(object.key) || first.lod != object.lod;
+		}
+		if(isNewGroup)
+			groups.push_back({ object.key, object.lod, (uint32_t) instances.size(), 0 });
+
+		instances.push_back(object.instance);
+		objects.push_back(object.object);
+		groups.back().instanceCount++;
+	}
+}
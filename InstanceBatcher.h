@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <DirectXMath.h>
+
+// Per-instance data, as the instanced vertex shaders read it from their structured buffer
+struct InstanceData
+{
+	DirectX::XMFLOAT4X4 world;
+	DirectX::XMFLOAT4X4 worldInvTranspose;
+};
+
+// Instances that can be drawn together with one instanced draw
+struct InstanceGroup
+{
+	uint64_t key;			// Sort key of the group's nearest instance
+	uint32_t lod;
+	uint32_t firstInstance;	// Into GetInstances() and GetObjects()
+	uint32_t instanceCount;
+};
+
+// --------------------------------------------------------
+// Groups objects that would draw with exactly the same state
+// (the same sort key, apart from depth) and level of detail,
+// packing each group's instance data side by side so it can
+// go to the GPU in one upload and draw with one call
+// - Groups come out in key order, and instances within a
+//   group nearest first
+// --------------------------------------------------------
+class InstanceBatcher
+{
+private:
+	struct Object
+	{
+		uint64_t key;
+		uint32_t lod;
+		uint32_t object;
+		bool canInstance;
+		InstanceData instance;
+	};
+	std::vector<Object> added;
+	std::vector<uint32_t> order;
+
+	std::vector<InstanceGroup> groups;
+	std::vector<InstanceData> instances;
+	std::vector<uint32_t> objects; // Which object each instance is
+
+public:
+	void Clear();
+	// Objects that can't be instanced (e.g. their shader has no instanced version) always get a group of their own
+	void Add(uint64_t key, uint32_t lod, uint32_t object, const DirectX::XMFLOAT4X4& world, const DirectX::XMFLOAT4X4& worldInvTranspose, bool canInstance = true);
+	void Build();
+
+	size_t GetObjectCount() { return added.size(); };
+	const std::vector<InstanceGroup>& GetGroups() { return groups; };
+	const std::vector<InstanceData>& GetInstances() { return instances; };
+	const std::vector<uint32_t>& GetObjects() { return objects; };
+};
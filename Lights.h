@@ -4,6 +4,8 @@
 #define LIGHT_TYPE_POINT		1
 #define LIGHT_TYPE_SPOT			2
 
+#define MAX_LIGHTS 64 // Must match MAX_LIGHTS in FrameData.hlsli
+
 #include <DirectXMath.h>
 
 struct Light
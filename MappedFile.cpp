@@ -0,0 +1,73 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::filesystem::path& filePath) :
+	data(nullptr), size(0), fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr)
+{
+	fileHandle = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+	if(fileHandle == INVALID_HANDLE_VALUE)
+		return;
+
+	LARGE_INTEGER fileSize = {};
+	GetFileSizeEx(fileHandle, &fileSize);
+
+	// Empty files can't be mapped (and have nothing to read anyway)
+	if(fileSize.QuadPart == 0)
+		return;
+
+	mappingHandle = CreateFileMappingW(fileHandle, 0, PAGE_READONLY, 0, 0, 0);
+	if(!mappingHandle)
+		return;
+
+	data = (const char*) MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if(data)
+		size = (size_t) fileSize.QuadPart;
+}
+MappedFile::~MappedFile()
+{
+	if(data)
+		UnmapViewOfFile(data);
+	if(mappingHandle)
+		CloseHandle(mappingHandle);
+	if(fileHandle != INVALID_HANDLE_VALUE)
+		CloseHandle(fileHandle);
+}
+#else
+MappedFile::MappedFile(const std::filesystem::path& filePath) :
+	data(nullptr), size(0), fileDescriptor(-1)
+{
+	fileDescriptor = open(filePath.c_str(), O_RDONLY);
+	if(fileDescriptor < 0)
+		return;
+
+	struct stat fileStats = {};
+	if(fstat(fileDescriptor, &fileStats) != 0 || fileStats.st_size == 0)
+		return;
+
+	void* mapping = mmap(0, (size_t) fileStats.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	if(mapping == MAP_FAILED)
+		return;
+
+	// The file is read front to back, so let the OS read ahead aggressively
+	madvise(mapping, (size_t) fileStats.st_size, MADV_SEQUENTIAL);
+
+	data = (const char*) mapping;
+	size = (size_t) fileStats.st_size;
+}
+MappedFile::~MappedFile()
+{
+	if(data)
+		munmap((void*) data, size);
+	if(fileDescriptor >= 0)
+		close(fileDescriptor);
+}
+#endif
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+// --------------------------------------------------------
+// Read-only memory mapping of an entire file
+// - The mapped bytes are NOT null-terminated, so always
+//   bound reads with GetSize()
+// - Uses the Win32 file mapping API on Windows and mmap()
+//   everywhere else, so CPU-side asset code stays portable
+// --------------------------------------------------------
+class MappedFile
+{
+private:
+	const char* data;
+	size_t size;
+
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#else
+	int fileDescriptor;
+#endif
+
+public:
+	MappedFile(const std::filesystem::path& filePath);
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete; // Remove copy constructor
+	MappedFile& operator=(const MappedFile&) = delete; // Remove copy-assignment operator
+
+	bool IsOpen() const { return data != nullptr; };
+	const char* GetData() const { return data; };
+	size_t GetSize() const { return size; };
+};
@@ -33,6 +33,14 @@ void Material::AddTextureSRV(std::string identifier, Microsoft::WRL::ComPtr<ID3D
 {
 	textureSRVs.insert({identifier, srv});
 }
+void Material::ReplaceTextureSRV(ID3D11ShaderResourceView* oldSRV, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> newSRV)
+{
+	for(auto& srv : textureSRVs)
+	{
+		if(srv.second.Get() == oldSRV)
+			srv.second = newSRV;
+	}
+}
 void Material::AddSampler(std::string identifier, Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler)
 {
 	samplers.insert({identifier, sampler});
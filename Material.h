@@ -11,6 +11,10 @@ class Material
 {
 private:
 	std::shared_ptr<SimpleVertexShader> vertexShader;
+	std::shared_ptr<SimpleVertexShader> packedVertexShader; // Used instead of vertexShader for meshes with packed vertices
+	// Versions of the vertex shaders that draw many instances at once (reading InstanceData); none means never instanced
+	std::shared_ptr<SimpleVertexShader> instancedVertexShader;
+	std::shared_ptr<SimpleVertexShader> packedInstancedVertexShader;
 	std::shared_ptr<SimplePixelShader> pixelShader;
 
 	std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> textureSRVs;
@@ -29,13 +33,24 @@ public:
 	void PrepareMaterial();
 
 	void AddTextureSRV(std::string identifier, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
+	// Swaps every use of oldSRV for newSRV (i.e. a placeholder for the texture that has finished loading)
+	void ReplaceTextureSRV(ID3D11ShaderResourceView* oldSRV, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> newSRV);
 	void AddSampler(std::string identifier, Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler);
 
 	std::shared_ptr<SimpleVertexShader> GetVertexShader() { return vertexShader; };
+	std::shared_ptr<SimpleVertexShader> GetPackedVertexShader() { return packedVertexShader; };
+	std::shared_ptr<SimpleVertexShader> GetInstancedVertexShader() { return instancedVertexShader; };
+	std::shared_ptr<SimpleVertexShader> GetPackedInstancedVertexShader() { return packedInstancedVertexShader; };
 	std::shared_ptr<SimplePixelShader> GetPixelShader() { return pixelShader; };
 	DirectX::XMFLOAT4 GetColor() const { return color; };
 
 	void SetVertexShader(std::shared_ptr<SimpleVertexShader> value) { vertexShader = value; };
+	void SetPackedVertexShader(std::shared_ptr<SimpleVertexShader> value) { packedVertexShader = value; };
+	void SetInstancedVertexShaders(std::shared_ptr<SimpleVertexShader> value, std::shared_ptr<SimpleVertexShader> packedValue)
+	{
+		instancedVertexShader = value;
+		packedInstancedVertexShader = packedValue;
+	};
 	void SetPixelShader(std::shared_ptr<SimplePixelShader> value) { pixelShader = value; };
 	void SetColor(DirectX::XMFLOAT4 value) { color = value; };
 	void SetUVScale(DirectX::XMFLOAT2 value) { uvScale = value; };
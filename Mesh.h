@@ -5,32 +5,70 @@
 #include <string>
 #include <vector>
 #include "Vertex.h"
+#include "VertexPacking.h"
+#include "Meshlets.h"
+#include "MeshSimplifier.h"
+#include "MeshData.h"
 
 class Mesh
 {
+public:
+	// Meshlet culling results of every culled draw since this was last reset
+	static inline MeshletCullStatistics meshletStatistics = {};
+
 private:
 	Microsoft::WRL::ComPtr<ID3D11Buffer> vertexBuffer;
 	Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer;
-	Vertex* vertices;
 	UINT vertexCount;
-	UINT* indices;
+	UINT sourceVertexCount; // Before welding (see MeshData::sourceVertexCount)
 	UINT indexCount;
 	std::string name;
 
+	// Layout of the vertex buffer (packed meshes also need their quantization to be drawn)
+	VertexFormat vertexFormat;
+	VertexQuantization quantization;
+
+	// Clusters of triangles (contiguous in the index buffer) that can be culled individually
+	std::vector<Meshlet> meshlets;
+	std::vector<IndexRange> visibleRanges; // Reused between draws
+
+	// Levels of detail, from the full mesh (LOD 0) down; each has its own indices and meshlets
+	std::vector<MeshLod> lods;
+
+	// Local space box and sphere around every vertex, for culling whole entities
+	MeshBounds bounds;
+
 public:
-	Mesh(std::string name, UINT vertexCount, Vertex vertices[], UINT indexCount, UINT indices[]);
-	Mesh(const wchar_t* filePath);
+	Mesh(std::string name, UINT vertexCount, Vertex vertices[], UINT indexCount, UINT indices[], VertexFormat vertexFormat = VertexFormat::Full);
+	Mesh(const wchar_t* filePath, VertexFormat vertexFormat = VertexFormat::Full);
+	// Empty mesh (that draws nothing) to be filled in by Upload() once its data has loaded elsewhere
+	Mesh(std::string name, VertexFormat vertexFormat = VertexFormat::Full);
 	~Mesh();
 
-	void CalculateTangents(Vertex* vertices, int vertexCount, unsigned int* indices, int indexCount);
-
-	void CreateBuffers(Vertex* vertices, int vertexCount, UINT* indices, int indexCount);
+	// Creates this mesh's buffers from processed data (must be on the thread that owns the device context)
+	void Upload(const MeshData& data);
+	void CreateBuffers(const Vertex* vertices, int vertexCount, const UINT* indices, int indexCount);
 
-	void Draw();
+	// Binds this mesh's vertex and index buffers; draws skip doing so when told they're already bound
+	void SetBuffers();
+	void Draw(int lod = 0, bool setBuffers = true);
+	// Draws only the meshlets that pass frustum and normal cone culling (both given in this mesh's local space)
+	void Draw(const Frustum& localFrustum, const DirectX::XMFLOAT3& localCameraPosition, int lod = 0, bool setBuffers = true);
+	// Draws many copies at once (every meshlet, since each instance would cull differently)
+	void DrawInstanced(UINT instanceCount, int lod = 0, bool setBuffers = true);
 
 	Microsoft::WRL::ComPtr<ID3D11Buffer> GetVertexBuffer() { return vertexBuffer; };
 	Microsoft::WRL::ComPtr<ID3D11Buffer> GetIndexBuffer() { return indexBuffer; };
 	UINT GetVertexCount() { return vertexCount; };
+	UINT GetSourceVertexCount() { return sourceVertexCount; };
 	UINT GetIndexCount() { return indexCount; };
+	const std::vector<Meshlet>& GetMeshlets() { return meshlets; };
+	const std::vector<MeshLod>& GetLods() { return lods; };
+	const MeshBounds& GetBounds() { return bounds; };
+	UINT GetTriangleCount(int lod = 0) { return lods.empty() ? 0 : lods[lod].indexCount / 3; };
+	bool IsLoaded() { return !lods.empty(); };
 	std::string GetName() { return name; };
+	VertexFormat GetVertexFormat() { return vertexFormat; };
+	const VertexQuantization& GetQuantization() { return quantization; };
+	UINT GetVertexStride() { return vertexFormat == VertexFormat::Packed ? sizeof(PackedVertex) : sizeof(Vertex); };
 };
\ No newline at end of file
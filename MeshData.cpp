@@ -0,0 +1,100 @@
+#include "MeshData.h"
+#include "ObjLoader.h"
+#include "MeshOptimizer.h"
+#include "CookedMesh.h"
+#include "MeshTangents.h"
+
+#include <cstdio>
+#include <filesystem>
+
+bool LoadMeshData(const wchar_t* filePath, MeshData& data)
+{
+	data.name = std::filesystem::path(filePath).stem().string();
+
+	// If this mesh has already been cooked (and the source hasn't changed since),
+	// its mapped data is fully processed and only needs copying out
+	// - The mapping is closed before going on, as a stale file gets replaced below
+	{
+		CookedMesh cooked(filePath);
+		if(cooked.IsValid())
+		{
+			data.vertices.assign(cooked.GetVertices(), cooked.GetVertices() + cooked.GetVertexCount());
+			data.indices.assign(cooked.GetIndices(), cooked.GetIndices() + cooked.GetIndexCount());
+			data.meshlets.assign(cooked.GetMeshlets(), cooked.GetMeshlets() + cooked.GetMeshletCount());
+			data.lods.assign(cooked.GetLods(), cooked.GetLods() + cooked.GetLodCount());
+			data.sourceVertexCount = cooked.GetSourceVertexCount();
+			data.bounds = CalculateMeshBounds(data.vertices.data(), data.vertices.size());
+			return true;
+		}
+	}
+
+	std::vector<Vertex>& verts = data.vertices;			// Verts we're assembling
+	std::vector<unsigned int>& indices = data.indices;	// Indices of these verts
+
+	// Parse the whole file in one pass straight out of a memory mapping
+	if(!LoadObj(filePath, verts, indices) || indices.empty())
+		return false;
+	data.sourceVertexCount = (unsigned int) indices.size(); // One per corner, before welding shared them
+
+	// Reorder triangles for the post-transform vertex cache, simplify them into
+	// lower levels of detail (appended after the full mesh), group every level
+	// into meshlets (which keeps most of that order), then reorder the vertices
+	// to match so fetches walk memory linearly
+	OptimizeVertexCache(&indices[0], indices.size(), verts.size());
+	BuildMeshLods(data);
+	for(MeshLod& lod : data.lods)
+	{
+		std::vector<Meshlet> lodMeshlets = BuildMeshlets(&verts[0], verts.size(), &indices[lod.indexOffset], lod.indexCount);
+		for(Meshlet& meshlet : lodMeshlets)
+			meshlet.indexOffset += lod.indexOffset;
+
+		lod.meshletOffset = (unsigned int) data.meshlets.size();
+		lod.meshletCount = (unsigned int) lodMeshlets.size();
+		data.meshlets.insert(data.meshlets.end(), lodMeshlets.begin(), lodMeshlets.end());
+	}
+	OptimizeVertexFetch(verts, indices);
+
+	const MeshLod& fullLod = data.lods[0];
+
+	// Tangents only come from the full mesh; simplified levels share its vertices
+	CalculateTangents(&verts[0], verts.size(), &indices[0], fullLod.indexCount);
+
+	data.bounds = CalculateMeshBounds(&verts[0], verts.size());
+
+	// Cook the processed mesh so later runs can skip all of the above
+	if(!CookedMesh::Write(filePath, verts, indices, data.meshlets, data.lods, data.sourceVertexCount))
+		printf("Couldn't cook %ls, so it will be processed from source again next time\n", filePath);
+	return true;
+}
+
+// --------------------------------------------------------
+// Each level is simplified from the full mesh rather than
+// the level before it, so its error is measured against
+// the original surface
+// - Levels that can't get simpler than the one before them
+//   are skipped
+// --------------------------------------------------------
+void BuildMeshLods(MeshData& data)
+{
+	std::vector<Vertex>& vertices = data.vertices;
+	std::vector<unsigned int>& indices = data.indices;
+	std::vector<MeshLod>& lods = data.lods;
+
+	unsigned int fullIndexCount = (unsigned int) indices.size();
+	lods.clear();
+	lods.push_back({ 0, fullIndexCount, 0, 0, 0.0f });
+
+	for(float ratio : MeshLodTriangleRatios)
+	{
+		size_t targetIndexCount = (size_t) (fullIndexCount / 3 * ratio) * 3;
+
+		float error;
+		std::vector<unsigned int> lodIndices = SimplifyMesh(&vertices[0], vertices.size(), &indices[0], fullIndexCount, targetIndexCount, error);
+		if(lodIndices.empty() || lodIndices.size() >= lods.back().indexCount)
+			continue;
+
+		OptimizeVertexCache(&lodIndices[0], lodIndices.size(), vertices.size());
+		lods.push_back({ (unsigned int) indices.size(), (unsigned int) lodIndices.size(), 0, 0, error });
+		indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+	}
+}
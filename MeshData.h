@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Vertex.h"
+#include "Meshlets.h"
+#include "MeshSimplifier.h"
+#include "Bounds.h"
+
+// --------------------------------------------------------
+// Fully processed mesh in CPU memory, ready to upload into
+// a Mesh's vertex and index buffers
+// - Indices hold every level of detail one after another,
+//   and meshlets every level's clusters (see MeshLod)
+// --------------------------------------------------------
+struct MeshData
+{
+	std::string name;
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	std::vector<Meshlet> meshlets;
+	std::vector<MeshLod> lods;
+	MeshBounds bounds; // Around every vertex (which all levels of detail share)
+	unsigned int sourceVertexCount = 0; // Face corners in the source file, i.e. how many vertices it had before welding
+};
+
+// Loads a mesh from its cooked file if it's up to date, and otherwise parses the .OBJ, then
+// optimizes it, builds its levels of detail, meshlets and tangents, and cooks the result
+// - Bounds aren't cooked, since they're one quick pass over the vertices either way
+// - Touches no graphics API state, so it's safe to call from any thread (as long as no two
+//   threads load the same file at once, since both would write its cooked file)
+// - Returns false if the file couldn't be opened or has no triangles
+bool LoadMeshData(const wchar_t* filePath, MeshData& data);
+
+// Simplifies the full mesh (data's current indices) into each of the MeshLodTriangleRatios,
+// appending every level's indices after it and recording them in data.lods
+void BuildMeshLods(MeshData& data);
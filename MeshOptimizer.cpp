@@ -0,0 +1,230 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+namespace
+{
+	// Tuning values from Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+	// - https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+	const int MaxCacheSize = 32;
+	const float CacheDecayPower = 1.5f;
+	const float LastTriangleScore = 0.75f;
+	const float ValenceBoostScale = 2.0f;
+	const float ValenceBoostPower = 0.5f;
+
+	// Scores a vertex by how recently it was used and how many triangles still need it
+	float ScoreVertex(int cachePosition, unsigned int remainingTriangles)
+	{
+		// No triangles left to draw with this vertex
+		if(remainingTriangles == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+		if(cachePosition >= 0)
+		{
+			// The last triangle's vertices get a fixed score so the optimizer
+			// doesn't strongly prefer reusing all three of them
+			if(cachePosition < 3)
+				score = LastTriangleScore;
+			else
+			{
+				// Scores decay the further back in the cache the vertex is
+				float scaler = 1.0f / (MaxCacheSize - 3);
+				score = powf(1.0f - (cachePosition - 3) * scaler, CacheDecayPower);
+			}
+		}
+
+		// Boost vertices with few triangles left so lone triangles get finished off instead of stranded
+		score += ValenceBoostScale * powf((float) remainingTriangles, -ValenceBoostPower);
+		return score;
+	}
+}
+
+VertexCacheStatistics AnalyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize)
+{
+	VertexCacheStatistics statistics = {};
+
+	// Each vertex remembers when it entered the cache; anything that entered
+	// more than cacheSize misses ago has been pushed out of the FIFO
+	std::vector<unsigned int> cacheTimestamps(vertexCount, 0);
+	unsigned int timestamp = cacheSize + 1;
+
+	for(size_t i = 0; i < indexCount; i++)
+	{
+		unsigned int index = indices[i];
+		if(timestamp - cacheTimestamps[index] > cacheSize)
+		{
+			cacheTimestamps[index] = timestamp++;
+			statistics.misses++;
+		}
+	}
+
+	size_t triangleCount = indexCount / 3;
+	statistics.acmr = triangleCount ? (float) statistics.misses / triangleCount : 0.0f;
+	statistics.atvr = vertexCount ? (float) statistics.misses / vertexCount : 0.0f;
+	return statistics;
+}
+
+void OptimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount)
+{
+	size_t triangleCount = indexCount / 3;
+	if(triangleCount == 0)
+		return;
+
+	/* Build the list of triangles using each vertex */
+
+	std::vector<unsigned int> adjacencyOffsets(vertexCount + 1, 0);
+	for(size_t i = 0; i < indexCount; i++)
+		adjacencyOffsets[indices[i] + 1]++;
+	for(size_t v = 0; v < vertexCount; v++)
+		adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+
+	// Triangles are removed from these lists as they get drawn, so the count doubles as the valence
+	std::vector<unsigned int> adjacency(indexCount);
+	std::vector<unsigned int> remainingTriangles(vertexCount, 0);
+	for(size_t t = 0; t < triangleCount; t++)
+	{
+		for(int k = 0; k < 3; k++)
+		{
+			unsigned int v = indices[t * 3 + k];
+			adjacency[adjacencyOffsets[v] + remainingTriangles[v]++] = (unsigned int) t;
+		}
+	}
+
+	/* Initial scores */
+
+	std::vector<float> vertexScores(vertexCount);
+	for(size_t v = 0; v < vertexCount; v++)
+		vertexScores[v] = ScoreVertex(-1, remainingTriangles[v]);
+
+	std::vector<bool> triangleAdded(triangleCount, false);
+	std::vector<float> triangleScores(triangleCount);
+	int bestTriangle = -1;
+	float bestScore = -1.0f;
+	for(size_t t = 0; t < triangleCount; t++)
+	{
+		const unsigned int* triangle = &indices[t * 3];
+		triangleScores[t] = vertexScores[triangle[0]] + vertexScores[triangle[1]] + vertexScores[triangle[2]];
+		if(triangleScores[t] > bestScore)
+		{
+			bestScore = triangleScores[t];
+			bestTriangle = (int) t;
+		}
+	}
+
+	/* Greedily draw the best scoring triangle, updating the simulated cache each time */
+
+	std::vector<unsigned int> optimized;
+	optimized.reserve(indexCount);
+
+	unsigned int cache[MaxCacheSize + 3];
+	int cacheCount = 0;
+	size_t nextUnadded = 0;
+
+	while(optimized.size() < triangleCount * 3)
+	{
+		// Nothing in the cache leads anywhere; restart from the next undrawn triangle
+		if(bestTriangle < 0)
+		{
+			while(triangleAdded[nextUnadded])
+				nextUnadded++;
+			bestTriangle = (int) nextUnadded;
+		}
+
+		const unsigned int* triangle = &indices[bestTriangle * 3];
+		triangleAdded[bestTriangle] = true;
+		optimized.insert(optimized.end(), triangle, triangle + 3);
+
+		// Remove the triangle from each of its vertices' lists
+		for(int k = 0; k < 3; k++)
+		{
+			unsigned int v = triangle[k];
+			unsigned int* list = &adjacency[adjacencyOffsets[v]];
+			unsigned int count = remainingTriangles[v];
+			for(unsigned int i = 0; i < count; i++)
+			{
+				if(list[i] == (unsigned int) bestTriangle)
+				{
+					list[i] = list[count - 1];
+					remainingTriangles[v]--;
+					break;
+				}
+			}
+		}
+
+		// Move the triangle's vertices to the front of the LRU cache
+		unsigned int newCache[MaxCacheSize + 3];
+		int newCacheCount = 0;
+		for(int k = 0; k < 3; k++)
+		{
+			// Degenerate triangles can repeat a vertex; only add it once
+			bool alreadyAdded = false;
+			for(int i = 0; i < newCacheCount; i++)
+				alreadyAdded |= newCache[i] == triangle[k];
+
+			if(!alreadyAdded)
+				newCache[newCacheCount++] = triangle[k];
+		}
+		for(int i = 0; i < cacheCount; i++)
+		{
+			unsigned int v = cache[i];
+			if(v != triangle[0] && v != triangle[1] && v != triangle[2])
+				newCache[newCacheCount++] = v;
+		}
+
+		// Vertices pushed past the end of the cache fall out of it
+		for(int i = MaxCacheSize; i < newCacheCount; i++)
+			vertexScores[newCache[i]] = ScoreVertex(-1, remainingTriangles[newCache[i]]);
+
+		cacheCount = newCacheCount < MaxCacheSize ? newCacheCount : MaxCacheSize;
+		for(int i = 0; i < cacheCount; i++)
+		{
+			cache[i] = newCache[i];
+			vertexScores[cache[i]] = ScoreVertex(i, remainingTriangles[cache[i]]);
+		}
+
+		// Re-score every undrawn triangle touching the cache and pick the best one to draw next
+		bestTriangle = -1;
+		bestScore = -1.0f;
+		for(int i = 0; i < cacheCount; i++)
+		{
+			unsigned int v = cache[i];
+			const unsigned int* list = &adjacency[adjacencyOffsets[v]];
+			for(unsigned int j = 0; j < remainingTriangles[v]; j++)
+			{
+				unsigned int t = list[j];
+				const unsigned int* candidate = &indices[t * 3];
+				triangleScores[t] = vertexScores[candidate[0]] + vertexScores[candidate[1]] + vertexScores[candidate[2]];
+				if(triangleScores[t] > bestScore)
+				{
+					bestScore = triangleScores[t];
+					bestTriangle = (int) t;
+				}
+			}
+		}
+	}
+
+	std::copy(optimized.begin(), optimized.end(), indices);
+}
+
+void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	std::vector<unsigned int> remap(vertices.size(), UINT_MAX);
+	std::vector<Vertex> ordered;
+	ordered.reserve(vertices.size());
+
+	// Give each vertex a new slot the first time it's referenced
+	for(unsigned int& index : indices)
+	{
+		if(remap[index] == UINT_MAX)
+		{
+			remap[index] = (unsigned int) ordered.size();
+			ordered.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+
+	vertices.swap(ordered);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Vertex.h"
+
+// --------------------------------------------------------
+// Results of running an index buffer through a simulated
+// FIFO post-transform vertex cache
+// - ACMR: average cache misses (vertex shader runs) per triangle,
+//   0.5 is the best possible for a large regular grid
+// - ATVR: average transforms per vertex, 1.0 is ideal
+// --------------------------------------------------------
+struct VertexCacheStatistics
+{
+	unsigned int misses;
+	float acmr;
+	float atvr;
+};
+
+// Simulates a FIFO post-transform cache of the given size over a triangle list
+VertexCacheStatistics AnalyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize = 16);
+
+// Reorders the triangles of an index buffer (in place) so consecutive triangles reuse
+// recently transformed vertices, using Tom Forsyth's linear-speed vertex cache optimization
+void OptimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount);
+
+// Reorders vertices into the order the index buffer first references them (and remaps the
+// indices to match) so vertex fetches walk memory linearly; unreferenced vertices are dropped
+void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
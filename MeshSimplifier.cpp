@@ -0,0 +1,551 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <tuple>
+#include <unordered_map>
+
+using namespace DirectX;
+
+namespace
+{
+	// Open edges and seams weigh this much more than the surface around them, so they hold their shape
+	const double BorderWeight = 10.0;
+
+	// Borders and seams that turn sharper than this (cos 45 degrees) at a vertex lock it in place
+	// as a corner, since sliding a corner along either edge would cut it off
+	const double CornerCosine = 0.7071;
+
+	// How a vertex is allowed to move
+	enum class VertexKind
+	{
+		Manifold,	// Surrounded by triangles; can collapse onto any neighbor
+		Border,		// On an open edge; can only collapse along that edge
+		Seam,		// One of several copies split by uv/normal seams; collapses along a seam, with its twins
+		Locked		// Corners, seam ends and anything non-manifold never move
+	};
+
+	// Symmetric matrix form of the summed squared distances to a set of planes
+	// (each plane weighted by the area it came from)
+	struct Quadric
+	{
+		double a00, a11, a22, a10, a20, a21;
+		double b0, b1, b2;
+		double c;
+		double weight;
+	};
+
+	struct Collapse
+	{
+		unsigned int from;
+		unsigned int to;
+		double cost;
+	};
+
+	struct Double3
+	{
+		double x, y, z;
+	};
+
+	Double3 ToDouble3(const XMFLOAT3& v) { return { v.x, v.y, v.z }; }
+	Double3 Subtract(const Double3& a, const Double3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	double Dot(const Double3& a, const Double3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	Double3 Cross(const Double3& a, const Double3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+
+	// Quadric of a plane (normal must be unit length) with dot(normal, p) + d = 0
+	Quadric PlaneQuadric(const Double3& normal, double d, double weight)
+	{
+		Quadric q;
+		q.a00 = weight * normal.x * normal.x;
+		q.a11 = weight * normal.y * normal.y;
+		q.a22 = weight * normal.z * normal.z;
+		q.a10 = weight * normal.y * normal.x;
+		q.a20 = weight * normal.z * normal.x;
+		q.a21 = weight * normal.z * normal.y;
+		q.b0 = weight * normal.x * d;
+		q.b1 = weight * normal.y * d;
+		q.b2 = weight * normal.z * d;
+		q.c = weight * d * d;
+		q.weight = weight;
+		return q;
+	}
+
+	void AddQuadric(Quadric& q, const Quadric& other)
+	{
+		q.a00 += other.a00; q.a11 += other.a11; q.a22 += other.a22;
+		q.a10 += other.a10; q.a20 += other.a20; q.a21 += other.a21;
+		q.b0 += other.b0; q.b1 += other.b1; q.b2 += other.b2;
+		q.c += other.c;
+		q.weight += other.weight;
+	}
+
+	// Weighted average squared distance from a point to the quadric's planes
+	double QuadricError(const Quadric& q, const XMFLOAT3& position)
+	{
+		double x = position.x, y = position.y, z = position.z;
+		double rx = q.a00 * x + q.a10 * y + q.a20 * z;
+		double ry = q.a10 * x + q.a11 * y + q.a21 * z;
+		double rz = q.a20 * x + q.a21 * y + q.a22 * z;
+		double error = rx * x + ry * y + rz * z + 2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) + q.c;
+		return q.weight > 0.0 ? std::fabs(error) / q.weight : 0.0;
+	}
+
+	uint64_t EdgeKey(unsigned int a, unsigned int b)
+	{
+		if(a > b)
+			std::swap(a, b);
+		return ((uint64_t) a << 32) | b;
+	}
+
+	// How many triangles use each edge, both between positions and between actual vertices
+	void CountEdgeUses(const unsigned int* indices, size_t indexCount, const std::vector<unsigned int>& positionOf,
+		std::unordered_map<uint64_t, unsigned int>& positionEdgeUses, std::unordered_map<uint64_t, unsigned int>& vertexEdgeUses)
+	{
+		positionEdgeUses.clear();
+		vertexEdgeUses.clear();
+		for(size_t i = 0; i < indexCount; i += 3)
+		{
+			for(int e = 0; e < 3; e++)
+			{
+				unsigned int a = indices[i + e], b = indices[i + (e + 1) % 3];
+				positionEdgeUses[EdgeKey(positionOf[a], positionOf[b])]++;
+				vertexEdgeUses[EdgeKey(a, b)]++;
+			}
+		}
+	}
+
+	unsigned int GetEdgeUses(const std::unordered_map<uint64_t, unsigned int>& edgeUses, unsigned int a, unsigned int b)
+	{
+		auto found = edgeUses.find(EdgeKey(a, b));
+		return found != edgeUses.end() ? found->second : 0;
+	}
+
+	bool CanCollapse(VertexKind from, VertexKind to)
+	{
+		switch(from)
+		{
+		case VertexKind::Manifold: return true;
+		case VertexKind::Border: return to == VertexKind::Border;
+		case VertexKind::Seam: return to == VertexKind::Seam;
+		default: return false;
+		}
+	}
+
+	// Whether moving one corner of a triangle to a new position turns the triangle over (or very nearly)
+	bool WouldFlip(const Vertex* vertices, const unsigned int* triangle, unsigned int corner, const XMFLOAT3& newPosition)
+	{
+		Double3 p[3] = { ToDouble3(vertices[triangle[0]].position), ToDouble3(vertices[triangle[1]].position), ToDouble3(vertices[triangle[2]].position) };
+		Double3 before = Cross(Subtract(p[1], p[0]), Subtract(p[2], p[0]));
+
+		p[corner] = ToDouble3(newPosition);
+		Double3 after = Cross(Subtract(p[1], p[0]), Subtract(p[2], p[0]));
+
+		// Also rejects collapses that would rotate a triangle by more than ~75 degrees
+		return Dot(before, after) <= 0.25 * std::sqrt(Dot(before, before) * Dot(after, after));
+	}
+}
+
+std::vector<unsigned int> SimplifyMesh(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, size_t targetIndexCount, float& error)
+{
+	std::vector<unsigned int> result(indices, indices + indexCount);
+	error = 0.0f;
+	if(indexCount <= targetIndexCount || vertexCount == 0)
+		return result;
+
+	/* Group vertices that share a position */
+
+	// positionOf is the first vertex at each vertex's position (which stands in for the
+	// whole group), twin cycles through the other vertices at the same position
+	// - Vertices identical in everything but tangent can't be told apart, so repeats (which some
+	//   exporters write out, along with repeated triangles) are folded into the first copy
+	std::vector<unsigned int> positionOf(vertexCount);
+	std::vector<unsigned int> twin(vertexCount);
+	std::vector<unsigned int> groupSize(vertexCount, 0);
+	{
+		auto key = [&](unsigned int v)
+		{
+			const Vertex& vertex = vertices[v];
+			return std::tie(vertex.position.x, vertex.position.y, vertex.position.z,
+				vertex.normal.x, vertex.normal.y, vertex.normal.z, vertex.uv.x, vertex.uv.y);
+		};
+		auto samePosition = [&](unsigned int a, unsigned int b)
+		{
+			const XMFLOAT3& pa = vertices[a].position;
+			const XMFLOAT3& pb = vertices[b].position;
+			return pa.x == pb.x && pa.y == pb.y && pa.z == pb.z;
+		};
+
+		std::vector<unsigned int> sorted(vertexCount);
+		std::iota(sorted.begin(), sorted.end(), 0);
+		std::sort(sorted.begin(), sorted.end(), [&](unsigned int a, unsigned int b) { return key(a) < key(b); });
+
+		std::vector<unsigned int> firstCopy(vertexCount);
+		std::vector<unsigned int> group;
+		for(size_t start = 0; start < vertexCount;)
+		{
+			size_t end = start + 1;
+			while(end < vertexCount && samePosition(sorted[start], sorted[end]))
+				end++;
+
+			group.clear();
+			for(size_t i = start; i < end; i++)
+			{
+				if(i > start && key(sorted[i]) == key(sorted[i - 1]))
+					firstCopy[sorted[i]] = firstCopy[sorted[i - 1]];
+				else
+				{
+					firstCopy[sorted[i]] = sorted[i];
+					group.push_back(sorted[i]);
+				}
+				positionOf[sorted[i]] = group[0];
+			}
+
+			for(size_t i = 0; i < group.size(); i++)
+				twin[group[i]] = group[(i + 1) % group.size()];
+			groupSize[group[0]] = (unsigned int) group.size();
+			start = end;
+		}
+
+		for(unsigned int& index : result)
+			index = firstCopy[index];
+
+		// Drop repeated triangles (in any rotation), keeping the first of each
+		std::vector<std::pair<std::array<unsigned int, 3>, size_t>> triangles(result.size() / 3);
+		for(size_t t = 0; t < triangles.size(); t++)
+		{
+			const unsigned int* triangle = &result[t * 3];
+			int first = (int) (std::min_element(triangle, triangle + 3) - triangle);
+			triangles[t] = { { triangle[first], triangle[(first + 1) % 3], triangle[(first + 2) % 3] }, t };
+		}
+		std::sort(triangles.begin(), triangles.end());
+
+		std::vector<bool> repeated(triangles.size(), false);
+		for(size_t t = 1; t < triangles.size(); t++)
+			repeated[triangles[t].second] = triangles[t].first == triangles[t - 1].first;
+
+		size_t written = 0;
+		for(size_t t = 0; t < triangles.size(); t++)
+		{
+			if(repeated[t])
+				continue;
+			for(int c = 0; c < 3; c++)
+				result[written++] = result[t * 3 + c];
+		}
+		result.resize(written);
+	}
+
+	/* Classify vertices by the edges around them */
+
+	std::unordered_map<uint64_t, unsigned int> positionEdgeUses;
+	std::unordered_map<uint64_t, unsigned int> vertexEdgeUses;
+	CountEdgeUses(result.data(), result.size(), positionOf, positionEdgeUses, vertexEdgeUses);
+
+	std::vector<unsigned int> openEdges(vertexCount, 0);	// Per position
+	std::vector<unsigned int> creaseCounts(vertexCount, 0);	// Per position, how many others it meets along borders or seams
+	std::vector<std::array<unsigned int, 2>> creaseNeighbors(vertexCount); // Per position, the first two of those
+	std::vector<bool> nonManifold(vertexCount, false);		// Per position
+	std::vector<bool> onSeam(vertexCount, false);			// Per vertex
+
+	auto addCreaseNeighbor = [&](unsigned int p, unsigned int neighbor)
+	{
+		// Seam edges show up once from each side
+		for(unsigned int i = 0; i < creaseCounts[p] && i < 2; i++)
+		{
+			if(creaseNeighbors[p][i] == neighbor)
+				return;
+		}
+		if(creaseCounts[p] < 2)
+			creaseNeighbors[p][creaseCounts[p]] = neighbor;
+		creaseCounts[p]++;
+	};
+
+	for(size_t i = 0; i < result.size(); i += 3)
+	{
+		for(int e = 0; e < 3; e++)
+		{
+			unsigned int a = result[i + e], b = result[i + (e + 1) % 3];
+			unsigned int pa = positionOf[a], pb = positionOf[b];
+			if(pa == pb)
+				continue;
+
+			unsigned int uses = GetEdgeUses(positionEdgeUses, pa, pb);
+			if(uses == 1)
+			{
+				openEdges[pa]++;
+				openEdges[pb]++;
+			}
+			else if(uses > 2)
+				nonManifold[pa] = nonManifold[pb] = true;
+			else if(GetEdgeUses(vertexEdgeUses, a, b) == 1)
+				onSeam[a] = onSeam[b] = true;
+			else
+				continue;
+
+			addCreaseNeighbor(pa, pb);
+			addCreaseNeighbor(pb, pa);
+		}
+	}
+
+	// Whether a border or seam runs straight enough through a position for it to slide along
+	// (it has to pass through, rather than end or branch there, and not turn a corner)
+	auto isOnStraightCrease = [&](unsigned int p)
+	{
+		if(creaseCounts[p] != 2)
+			return false;
+
+		Double3 position = ToDouble3(vertices[p].position);
+		Double3 in = Subtract(position, ToDouble3(vertices[creaseNeighbors[p][0]].position));
+		Double3 out = Subtract(ToDouble3(vertices[creaseNeighbors[p][1]].position), position);
+
+		// (Swapping the neighbors negates both, so their order doesn't matter)
+		return Dot(in, out) >= CornerCosine * std::sqrt(Dot(in, in) * Dot(out, out));
+	};
+
+	std::vector<VertexKind> kinds(vertexCount);
+	for(size_t v = 0; v < vertexCount; v++)
+	{
+		unsigned int p = positionOf[v];
+		if(nonManifold[p])
+			kinds[v] = VertexKind::Locked;
+		else if(groupSize[p] > 1)
+			kinds[v] = (openEdges[p] == 0 && isOnStraightCrease(p)) ? VertexKind::Seam : VertexKind::Locked;
+		else if(openEdges[p] > 0)
+			kinds[v] = (openEdges[p] == 2 && isOnStraightCrease(p)) ? VertexKind::Border : VertexKind::Locked;
+		else
+			kinds[v] = onSeam[v] ? VertexKind::Locked : VertexKind::Manifold;
+	}
+
+	/* Build the error quadric of each position */
+
+	std::vector<Quadric> quadrics(vertexCount, Quadric{});
+	for(size_t i = 0; i < result.size(); i += 3)
+	{
+		Double3 p0 = ToDouble3(vertices[result[i]].position);
+		Double3 p1 = ToDouble3(vertices[result[i + 1]].position);
+		Double3 p2 = ToDouble3(vertices[result[i + 2]].position);
+		Double3 normal = Cross(Subtract(p1, p0), Subtract(p2, p0));
+		double length = std::sqrt(Dot(normal, normal));
+		if(length <= 0.0)
+			continue;
+		normal = { normal.x / length, normal.y / length, normal.z / length };
+
+		// The triangle's own plane, weighted by its area
+		Quadric plane = PlaneQuadric(normal, -Dot(normal, p0), length * 0.5);
+		for(int c = 0; c < 3; c++)
+			AddQuadric(quadrics[positionOf[result[i + c]]], plane);
+
+		// Borders and seams also get a plane through the edge, perpendicular to the triangle,
+		// which holds their vertices in line with the edge
+		for(int e = 0; e < 3; e++)
+		{
+			unsigned int a = result[i + e], b = result[i + (e + 1) % 3];
+			unsigned int uses = GetEdgeUses(positionEdgeUses, positionOf[a], positionOf[b]);
+			if(uses != 1 && !(uses == 2 && GetEdgeUses(vertexEdgeUses, a, b) == 1))
+				continue;
+
+			Double3 pa = ToDouble3(vertices[a].position);
+			Double3 edge = Subtract(ToDouble3(vertices[b].position), pa);
+			Double3 edgeNormal = Cross(edge, normal);
+			double edgeNormalLength = std::sqrt(Dot(edgeNormal, edgeNormal));
+			if(edgeNormalLength <= 0.0)
+				continue;
+			edgeNormal = { edgeNormal.x / edgeNormalLength, edgeNormal.y / edgeNormalLength, edgeNormal.z / edgeNormalLength };
+
+			Quadric edgePlane = PlaneQuadric(edgeNormal, -Dot(edgeNormal, pa), Dot(edge, edge) * BorderWeight);
+			AddQuadric(quadrics[positionOf[a]], edgePlane);
+			AddQuadric(quadrics[positionOf[b]], edgePlane);
+		}
+	}
+
+	/* Collapse edges in passes, cheapest first */
+
+	std::vector<unsigned int> fanOffsets(vertexCount + 1);	// Triangles around each position
+	std::vector<unsigned int> fanTriangles;
+	std::vector<bool> locked(vertexCount);					// Per position, for the current pass
+	std::vector<unsigned int> collapseTo(vertexCount);
+	std::vector<Collapse> collapses;
+	double maxCost = 0.0;
+
+	while(result.size() > targetIndexCount)
+	{
+		size_t triangleCount = result.size() / 3;
+
+		std::fill(fanOffsets.begin(), fanOffsets.end(), 0);
+		for(unsigned int index : result)
+			fanOffsets[positionOf[index] + 1]++;
+		for(size_t p = 0; p < vertexCount; p++)
+			fanOffsets[p + 1] += fanOffsets[p];
+		fanTriangles.resize(result.size());
+		{
+			std::vector<unsigned int> fanFill(fanOffsets.begin(), fanOffsets.end() - 1);
+			for(size_t i = 0; i < result.size(); i++)
+				fanTriangles[fanFill[positionOf[result[i]]]++] = (unsigned int) (i / 3);
+		}
+
+		// Where each copy of a vertex would go if it collapsed: the copy of the target it shares a
+		// triangle with, which keeps the copies' uvs/normals on their own side of any seam
+		// - Fails if a copy has no triangle reaching the target, or reaches more than one of its
+		//   copies, since either would tear or smear the seam
+		std::vector<std::pair<unsigned int, unsigned int>> wedgeMoves;
+		auto findWedgeMoves = [&](unsigned int from, unsigned int to)
+		{
+			unsigned int fromPosition = positionOf[from], toPosition = positionOf[to];
+			wedgeMoves.clear();
+
+			unsigned int wedge = from;
+			do
+			{
+				bool used = false;
+				unsigned int target = UINT_MAX;
+				for(unsigned int f = fanOffsets[fromPosition]; f < fanOffsets[fromPosition + 1]; f++)
+				{
+					const unsigned int* triangle = &result[fanTriangles[f] * 3];
+					if(triangle[0] != wedge && triangle[1] != wedge && triangle[2] != wedge)
+						continue;
+					used = true;
+
+					for(int c = 0; c < 3; c++)
+					{
+						if(positionOf[triangle[c]] != toPosition)
+							continue;
+						if(target != UINT_MAX && target != triangle[c])
+							return false;
+						target = triangle[c];
+					}
+				}
+
+				if(used)
+				{
+					if(target == UINT_MAX)
+						return false;
+					wedgeMoves.push_back({ wedge, target });
+				}
+				wedge = twin[wedge];
+			} while(wedge != from);
+
+			return true;
+		};
+
+		// Borders may only slide along their open edge, and seams along themselves
+		CountEdgeUses(result.data(), result.size(), positionOf, positionEdgeUses, vertexEdgeUses);
+		auto canSlide = [&](unsigned int from, unsigned int to)
+		{
+			if(kinds[from] == VertexKind::Border)
+				return GetEdgeUses(positionEdgeUses, positionOf[from], positionOf[to]) == 1;
+			if(kinds[from] == VertexKind::Seam)
+				return findWedgeMoves(from, to);
+			return true;
+		};
+
+		// Every edge, in every direction it's allowed to collapse
+		collapses.clear();
+		for(size_t t = 0; t < triangleCount; t++)
+		{
+			for(int e = 0; e < 3; e++)
+			{
+				unsigned int a = result[t * 3 + e], b = result[t * 3 + (e + 1) % 3];
+				if(CanCollapse(kinds[a], kinds[b]) && canSlide(a, b))
+					collapses.push_back({ a, b, QuadricError(quadrics[positionOf[a]], vertices[b].position) });
+				if(CanCollapse(kinds[b], kinds[a]) && canSlide(b, a))
+					collapses.push_back({ b, a, QuadricError(quadrics[positionOf[b]], vertices[a].position) });
+			}
+		}
+		if(collapses.empty())
+			break;
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+		// Only take the cheapest collapses each pass (about as many as there are triangles left to
+		// remove), so edges near those collapses get re-evaluated before they're considered
+		size_t trianglesToRemove = (result.size() - targetIndexCount + 2) / 3;
+		double costLimit = collapses[std::min(collapses.size() - 1, trianglesToRemove)].cost;
+
+		std::fill(locked.begin(), locked.end(), false);
+		std::iota(collapseTo.begin(), collapseTo.end(), 0);
+		size_t trianglesRemoved = 0;
+
+		for(const Collapse& collapse : collapses)
+		{
+			if(trianglesRemoved >= trianglesToRemove || collapse.cost > costLimit)
+				break;
+
+			unsigned int from = collapse.from, to = collapse.to;
+			unsigned int fromPosition = positionOf[from], toPosition = positionOf[to];
+			if(locked[fromPosition] || locked[toPosition] || !findWedgeMoves(from, to))
+				continue;
+
+			// Triangles on the edge disappear (one for borders, two everywhere else)
+			unsigned int sharedTriangles = 0;
+			for(unsigned int f = fanOffsets[fromPosition]; f < fanOffsets[fromPosition + 1]; f++)
+			{
+				const unsigned int* triangle = &result[fanTriangles[f] * 3];
+				sharedTriangles += positionOf[triangle[0]] == toPosition || positionOf[triangle[1]] == toPosition || positionOf[triangle[2]] == toPosition;
+			}
+			if(sharedTriangles != (kinds[from] == VertexKind::Border ? 1u : 2u))
+				continue;
+
+			// Never collapse the last of the mesh away
+			if(trianglesRemoved + sharedTriangles >= triangleCount)
+				continue;
+
+			// Don't fold the surface over itself
+			bool flips = false;
+			for(unsigned int f = fanOffsets[fromPosition]; f < fanOffsets[fromPosition + 1] && !flips; f++)
+			{
+				const unsigned int* triangle = &result[fanTriangles[f] * 3];
+				unsigned int corner = 0;
+				bool hasTo = false;
+				for(unsigned int c = 0; c < 3; c++)
+				{
+					hasTo |= positionOf[triangle[c]] == toPosition;
+					if(positionOf[triangle[c]] == fromPosition)
+						corner = c;
+				}
+				if(!hasTo)
+					flips = WouldFlip(vertices, triangle, corner, vertices[to].position);
+			}
+			if(flips)
+				continue;
+
+			for(const auto& move : wedgeMoves)
+				collapseTo[move.first] = move.second;
+			AddQuadric(quadrics[toPosition], quadrics[fromPosition]);
+
+			// Everything around the collapse has changed, so leave it alone until the next pass
+			for(unsigned int f = fanOffsets[fromPosition]; f < fanOffsets[fromPosition + 1]; f++)
+			{
+				for(int c = 0; c < 3; c++)
+					locked[positionOf[result[fanTriangles[f] * 3 + c]]] = true;
+			}
+
+			trianglesRemoved += sharedTriangles;
+			maxCost = std::max(maxCost, collapse.cost);
+		}
+
+		if(trianglesRemoved == 0)
+			break;
+
+		// Apply the collapses, dropping triangles that have lost their area
+		size_t written = 0;
+		for(size_t t = 0; t < triangleCount; t++)
+		{
+			unsigned int a = collapseTo[result[t * 3]];
+			unsigned int b = collapseTo[result[t * 3 + 1]];
+			unsigned int c = collapseTo[result[t * 3 + 2]];
+			if(positionOf[a] == positionOf[b] || positionOf[b] == positionOf[c] || positionOf[c] == positionOf[a])
+				continue;
+
+			result[written++] = a;
+			result[written++] = b;
+			result[written++] = c;
+		}
+		result.resize(written);
+	}
+
+	error = (float) std::sqrt(maxCost);
+	return result;
+}
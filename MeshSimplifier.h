@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Vertex.h"
+
+// --------------------------------------------------------
+// One level of detail of a mesh, stored as its own run of
+// triangles in the mesh's shared index buffer
+// - Every level draws from the same vertex buffer
+// - error is roughly how far (in the mesh's local units) the
+//   simplified surface strays from the original; 0 for LOD 0
+// --------------------------------------------------------
+struct MeshLod
+{
+	unsigned int indexOffset;
+	unsigned int indexCount;
+	unsigned int meshletOffset;
+	unsigned int meshletCount;
+	float error;
+};
+
+// Triangle counts (relative to the full mesh) that loaded meshes build levels of detail for
+const float MeshLodTriangleRatios[] = { 0.5f, 0.25f, 0.125f };
+
+// Simplifies a triangle list down to (at most) targetIndexCount indices using quadric error
+// metric edge collapses (Garland & Heckbert), returning the new indices into the same vertices
+// - Open borders and uv/normal seams only collapse along themselves, so they keep their shape,
+//   and their corners (where they turn more than 45 degrees) never move
+// - Vertices and triangles that are exact repeats of others are merged first
+// - Stops early if no more edges can collapse without folding the surface over (or emptying it)
+// - error receives the largest collapse error, as a distance in the mesh's local units
+std::vector<unsigned int> SimplifyMesh(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, size_t targetIndexCount, float& error);
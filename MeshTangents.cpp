@@ -0,0 +1,452 @@
+#include "MeshTangents.h"
+
+#include <cstddef>
+#include <vector>
+
+#include <DirectXMath.h>
+
+// SIMD kernels are only available on x86/x64
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TANGENT_KERNELS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// MSVC compiles any intrinsic anywhere; GCC/Clang need each SIMD function tagged with its target
+#if defined(TANGENT_KERNELS_X86) && !defined(_MSC_VER)
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE41
+#define TARGET_AVX2
+#endif
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Tangent math originally adapted from: http://www.terathon.com/code/tangent.html
+// - Updated version found here: http://foundationsofgameenginedev.com/FGED2-sample.pdf
+// - See listing 7.4 in section 7.5 (page 9 of the PDF)
+//
+// - Note: For this code to work, your Vertex format must
+// contain an XMFLOAT3 called Tangent
+// --------------------------------------------------------
+namespace
+{
+	// Minimum amount of work handed to each thread (per triangle / per vertex)
+	const size_t MinTrianglesPerChunk = 4096;
+	const size_t MinVerticesPerChunk = 4096;
+
+	// Calculates the (un-normalized) tangent of a single triangle
+	// - The SIMD kernels below mirror this math exactly, lane by lane
+	XMFLOAT3 CalculateTriangleTangent(const Vertex* v1, const Vertex* v2, const Vertex* v3)
+	{
+		// Calculate vectors relative to triangle positions
+		float x1 = v2->position.x - v1->position.x;
+		float y1 = v2->position.y - v1->position.y;
+		float z1 = v2->position.z - v1->position.z;
+		float x2 = v3->position.x - v1->position.x;
+		float y2 = v3->position.y - v1->position.y;
+		float z2 = v3->position.z - v1->position.z;
+		// Do the same for vectors relative to triangle uv's
+		float s1 = v2->uv.x - v1->uv.x;
+		float t1 = v2->uv.y - v1->uv.y;
+		float s2 = v3->uv.x - v1->uv.x;
+		float t2 = v3->uv.y - v1->uv.y;
+		// Create vectors for tangent calculation
+		float r = 1.0f / (s1 * t2 - s2 * t1);
+		return XMFLOAT3(
+			(t2 * x1 - t1 * x2) * r,
+			(t2 * y1 - t1 * y2) * r,
+			(t2 * z1 - t1 * z2) * r);
+	}
+
+	// Calculates the (un-normalized) bitangent of a single triangle, pointing up the
+	// texture (along decreasing V, since DirectX's V runs down), as normal maps expect
+	XMFLOAT3 CalculateTriangleBitangent(const Vertex* v1, const Vertex* v2, const Vertex* v3)
+	{
+		float x1 = v2->position.x - v1->position.x;
+		float y1 = v2->position.y - v1->position.y;
+		float z1 = v2->position.z - v1->position.z;
+		float x2 = v3->position.x - v1->position.x;
+		float y2 = v3->position.y - v1->position.y;
+		float z2 = v3->position.z - v1->position.z;
+		float s1 = v2->uv.x - v1->uv.x;
+		float t1 = v2->uv.y - v1->uv.y;
+		float s2 = v3->uv.x - v1->uv.x;
+		float t2 = v3->uv.y - v1->uv.y;
+		float r = 1.0f / (s1 * t2 - s2 * t1);
+		return XMFLOAT3(
+			(s2 * x1 - s1 * x2) * r,
+			(s2 * y1 - s1 * y2) * r,
+			(s2 * z1 - s1 * z2) * r);
+	}
+
+	// Ensures a vertex's accumulated tangent is orthogonal to its normal
+	void OrthonormalizeTangent(Vertex* vertex)
+	{
+		// Grab the two vectors
+		XMVECTOR normal = XMLoadFloat3(&vertex->normal);
+		XMVECTOR tangent = XMLoadFloat3(&vertex->tangent);
+		// Use Gram-Schmidt orthonormalize to ensure
+		// the normal and tangent are exactly 90 degrees apart
+		tangent = XMVector3Normalize(
+			tangent - normal * XMVector3Dot(normal, tangent));
+		// Store the tangent
+		XMStoreFloat3(&vertex->tangent, tangent);
+	}
+
+	void TriangleTangentsScalar(const Vertex* vertices, const unsigned int* indices, size_t begin, size_t end, XMFLOAT3* triangleTangents)
+	{
+		for(size_t t = begin; t < end; t++)
+		{
+			triangleTangents[t] = CalculateTriangleTangent(
+				&vertices[indices[t * 3]],
+				&vertices[indices[t * 3 + 1]],
+				&vertices[indices[t * 3 + 2]]);
+		}
+	}
+
+#ifdef TANGENT_KERNELS_X86
+	// Transposes the positions of 4 vertices into x, y and z registers (one vertex per lane)
+	// - Each load also picks up normal.x, which just falls out of the transpose
+	TARGET_SSE41 void LoadPositions4(const Vertex* a, const Vertex* b, const Vertex* c, const Vertex* d, __m128& x, __m128& y, __m128& z)
+	{
+		__m128 rowA = _mm_loadu_ps(&a->position.x);
+		__m128 rowB = _mm_loadu_ps(&b->position.x);
+		__m128 rowC = _mm_loadu_ps(&c->position.x);
+		__m128 rowD = _mm_loadu_ps(&d->position.x);
+		_MM_TRANSPOSE4_PS(rowA, rowB, rowC, rowD);
+		x = rowA;
+		y = rowB;
+		z = rowC;
+	}
+
+	// Transposes the uvs of 4 vertices into u and v registers (one vertex per lane)
+	// - uv is the last member of a Vertex, so only ever load the 8 bytes it occupies
+	TARGET_SSE41 void LoadUVs4(const Vertex* a, const Vertex* b, const Vertex* c, const Vertex* d, __m128& u, __m128& v)
+	{
+		__m128 ab = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*) &a->uv), (const __m64*) &b->uv);
+		__m128 cd = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*) &c->uv), (const __m64*) &d->uv);
+		u = _mm_shuffle_ps(ab, cd, _MM_SHUFFLE(2, 0, 2, 0));
+		v = _mm_shuffle_ps(ab, cd, _MM_SHUFFLE(3, 1, 3, 1));
+	}
+
+	// Transposes 4 tangents back out of x, y and z registers into 4 consecutive XMFLOAT3s
+	TARGET_SSE41 void StoreTangents4(XMFLOAT3* tangents, __m128 x, __m128 y, __m128 z)
+	{
+		__m128 w = _mm_setzero_ps();
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+
+		// Each store spills one float into the next tangent, which the next store then overwrites
+		_mm_storeu_ps(&tangents[0].x, x);
+		_mm_storeu_ps(&tangents[1].x, y);
+		_mm_storeu_ps(&tangents[2].x, z);
+		_mm_storel_pi((__m64*) &tangents[3].x, w);
+		_mm_store_ss(&tangents[3].z, _mm_movehl_ps(w, w));
+	}
+
+	TARGET_SSE41 void TriangleTangentsSSE41(const Vertex* vertices, const unsigned int* indices, size_t begin, size_t end, XMFLOAT3* triangleTangents)
+	{
+		size_t t = begin;
+		for(; t + 4 <= end; t += 4)
+		{
+			const unsigned int* tri = &indices[t * 3];
+
+			// Each triangle's corners, one triangle per lane
+			__m128 p[3][3], uv[3][2];
+			for(int c = 0; c < 3; c++)
+			{
+				const Vertex* a = &vertices[tri[c]];
+				const Vertex* b = &vertices[tri[3 + c]];
+				const Vertex* cc = &vertices[tri[6 + c]];
+				const Vertex* d = &vertices[tri[9 + c]];
+				LoadPositions4(a, b, cc, d, p[c][0], p[c][1], p[c][2]);
+				LoadUVs4(a, b, cc, d, uv[c][0], uv[c][1]);
+			}
+
+			// Same operations, in the same order, as CalculateTriangleTangent()
+			__m128 x1 = _mm_sub_ps(p[1][0], p[0][0]);
+			__m128 y1 = _mm_sub_ps(p[1][1], p[0][1]);
+			__m128 z1 = _mm_sub_ps(p[1][2], p[0][2]);
+			__m128 x2 = _mm_sub_ps(p[2][0], p[0][0]);
+			__m128 y2 = _mm_sub_ps(p[2][1], p[0][1]);
+			__m128 z2 = _mm_sub_ps(p[2][2], p[0][2]);
+			__m128 s1 = _mm_sub_ps(uv[1][0], uv[0][0]);
+			__m128 t1 = _mm_sub_ps(uv[1][1], uv[0][1]);
+			__m128 s2 = _mm_sub_ps(uv[2][0], uv[0][0]);
+			__m128 t2 = _mm_sub_ps(uv[2][1], uv[0][1]);
+
+			__m128 r = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sub_ps(_mm_mul_ps(s1, t2), _mm_mul_ps(s2, t1)));
+			StoreTangents4(&triangleTangents[t],
+				_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(t2, x1), _mm_mul_ps(t1, x2)), r),
+				_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(t2, y1), _mm_mul_ps(t1, y2)), r),
+				_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(t2, z1), _mm_mul_ps(t1, z2)), r));
+		}
+
+		// Leftover triangles that don't fill a register
+		TriangleTangentsScalar(vertices, indices, t, end, triangleTangents);
+	}
+
+	// Same as LoadPositions4/LoadUVs4, but for 8 vertices (a-d in the low half of each register, e-h in the high half)
+	TARGET_AVX2 void LoadCorners8(const Vertex* const (&corner)[8], __m256& x, __m256& y, __m256& z, __m256& u, __m256& v)
+	{
+		__m128 loX, loY, loZ, hiX, hiY, hiZ, loU, loV, hiU, hiV;
+		LoadPositions4(corner[0], corner[1], corner[2], corner[3], loX, loY, loZ);
+		LoadPositions4(corner[4], corner[5], corner[6], corner[7], hiX, hiY, hiZ);
+		LoadUVs4(corner[0], corner[1], corner[2], corner[3], loU, loV);
+		LoadUVs4(corner[4], corner[5], corner[6], corner[7], hiU, hiV);
+		x = _mm256_insertf128_ps(_mm256_castps128_ps256(loX), hiX, 1);
+		y = _mm256_insertf128_ps(_mm256_castps128_ps256(loY), hiY, 1);
+		z = _mm256_insertf128_ps(_mm256_castps128_ps256(loZ), hiZ, 1);
+		u = _mm256_insertf128_ps(_mm256_castps128_ps256(loU), hiU, 1);
+		v = _mm256_insertf128_ps(_mm256_castps128_ps256(loV), hiV, 1);
+	}
+
+	TARGET_AVX2 void TriangleTangentsAVX2(const Vertex* vertices, const unsigned int* indices, size_t begin, size_t end, XMFLOAT3* triangleTangents)
+	{
+		size_t t = begin;
+		for(; t + 8 <= end; t += 8)
+		{
+			const unsigned int* tri = &indices[t * 3];
+
+			// Each triangle's corners, one triangle per lane
+			__m256 p[3][3], uv[3][2];
+			for(int c = 0; c < 3; c++)
+			{
+				const Vertex* const corner[8] = {
+					&vertices[tri[c]], &vertices[tri[3 + c]], &vertices[tri[6 + c]], &vertices[tri[9 + c]],
+					&vertices[tri[12 + c]], &vertices[tri[15 + c]], &vertices[tri[18 + c]], &vertices[tri[21 + c]] };
+				LoadCorners8(corner, p[c][0], p[c][1], p[c][2], uv[c][0], uv[c][1]);
+			}
+
+			// Same operations, in the same order, as CalculateTriangleTangent()
+			__m256 x1 = _mm256_sub_ps(p[1][0], p[0][0]);
+			__m256 y1 = _mm256_sub_ps(p[1][1], p[0][1]);
+			__m256 z1 = _mm256_sub_ps(p[1][2], p[0][2]);
+			__m256 x2 = _mm256_sub_ps(p[2][0], p[0][0]);
+			__m256 y2 = _mm256_sub_ps(p[2][1], p[0][1]);
+			__m256 z2 = _mm256_sub_ps(p[2][2], p[0][2]);
+			__m256 s1 = _mm256_sub_ps(uv[1][0], uv[0][0]);
+			__m256 t1 = _mm256_sub_ps(uv[1][1], uv[0][1]);
+			__m256 s2 = _mm256_sub_ps(uv[2][0], uv[0][0]);
+			__m256 t2 = _mm256_sub_ps(uv[2][1], uv[0][1]);
+
+			__m256 r = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sub_ps(_mm256_mul_ps(s1, t2), _mm256_mul_ps(s2, t1)));
+			__m256 tx = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(t2, x1), _mm256_mul_ps(t1, x2)), r);
+			__m256 ty = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(t2, y1), _mm256_mul_ps(t1, y2)), r);
+			__m256 tz = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(t2, z1), _mm256_mul_ps(t1, z2)), r);
+
+			StoreTangents4(&triangleTangents[t], _mm256_castps256_ps128(tx), _mm256_castps256_ps128(ty), _mm256_castps256_ps128(tz));
+			StoreTangents4(&triangleTangents[t + 4], _mm256_extractf128_ps(tx, 1), _mm256_extractf128_ps(ty, 1), _mm256_extractf128_ps(tz, 1));
+		}
+
+		// Leftover triangles that don't fill a register
+		TriangleTangentsScalar(vertices, indices, t, end, triangleTangents);
+	}
+
+	void CpuId(int leaf, int subleaf, int info[4])
+	{
+#ifdef _MSC_VER
+		__cpuidex(info, leaf, subleaf);
+#else
+		__cpuid_count(leaf, subleaf, info[0], info[1], info[2], info[3]);
+#endif
+	}
+
+	// Which register state the OS saves on context switches
+	unsigned long long ReadExtendedControlRegister()
+	{
+#ifdef _MSC_VER
+		return _xgetbv(0);
+#else
+		unsigned int low, high;
+		__asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+		return ((unsigned long long) high << 32) | low;
+#endif
+	}
+#endif
+
+	TangentKernel DetectTangentKernel()
+	{
+#ifdef TANGENT_KERNELS_X86
+		int info[4] = {};
+		CpuId(0, 0, info);
+		int highestLeaf = info[0];
+
+		CpuId(1, 0, info);
+		bool hasSSE41 = (info[2] & (1 << 19)) != 0;
+		bool hasOSXSAVE = (info[2] & (1 << 27)) != 0;
+		bool hasAVX = (info[2] & (1 << 28)) != 0;
+
+		// AVX registers are only usable if the OS preserves them (XMM and YMM state)
+		bool osSavesAVX = hasOSXSAVE && hasAVX && (ReadExtendedControlRegister() & 0x6) == 0x6;
+
+		bool hasAVX2 = false;
+		if(highestLeaf >= 7)
+		{
+			CpuId(7, 0, info);
+			hasAVX2 = (info[1] & (1 << 5)) != 0;
+		}
+
+		if(hasAVX2 && osSavesAVX)
+			return TangentKernel::AVX2;
+		if(hasSSE41)
+			return TangentKernel::SSE41;
+#endif
+		return TangentKernel::Scalar;
+	}
+}
+
+TangentKernel GetBestTangentKernel()
+{
+	// Only needs to be checked once
+	static const TangentKernel bestKernel = DetectTangentKernel();
+	return bestKernel;
+}
+
+const char* GetTangentKernelName(TangentKernel kernel)
+{
+	switch(kernel)
+	{
+	case TangentKernel::SSE41: return "SSE4.1";
+	case TangentKernel::AVX2: return "AVX2";
+	default: return "Scalar";
+	}
+}
+
+void CalculateTriangleTangents(const Vertex* vertices, const unsigned int* indices, size_t triangleBegin, size_t triangleEnd,
+	XMFLOAT3* triangleTangents, TangentKernel kernel)
+{
+	switch(kernel)
+	{
+#ifdef TANGENT_KERNELS_X86
+	case TangentKernel::AVX2: TriangleTangentsAVX2(vertices, indices, triangleBegin, triangleEnd, triangleTangents); break;
+	case TangentKernel::SSE41: TriangleTangentsSSE41(vertices, indices, triangleBegin, triangleEnd, triangleTangents); break;
+#endif
+	default: TriangleTangentsScalar(vertices, indices, triangleBegin, triangleEnd, triangleTangents); break;
+	}
+}
+
+void CalculateTangentsSerial(Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, TangentKernel kernel)
+{
+	size_t triangleCount = indexCount / 3;
+
+	// Calculate tangents one whole triangle at a time
+	std::vector<XMFLOAT3> triangleTangents(triangleCount);
+	CalculateTriangleTangents(vertices, indices, 0, triangleCount, triangleTangents.data(), kernel);
+
+	// Reset tangents
+	for(size_t i = 0; i < vertexCount; i++)
+	{
+		vertices[i].tangent = XMFLOAT3(0, 0, 0);
+	}
+	// Adjust tangents of each vert of each triangle
+	for(size_t t = 0; t < triangleCount; t++)
+	{
+		const XMFLOAT3& tangent = triangleTangents[t];
+		for(int k = 0; k < 3; k++)
+		{
+			Vertex* v = &vertices[indices[t * 3 + k]];
+			v->tangent.x += tangent.x;
+			v->tangent.y += tangent.y;
+			v->tangent.z += tangent.z;
+		}
+	}
+	// Ensure all of the tangents are orthogonal to the normals
+	for(size_t i = 0; i < vertexCount; i++)
+	{
+		OrthonormalizeTangent(&vertices[i]);
+	}
+}
+
+void CalculateTangentsParallel(Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, ThreadPool& threadPool, TangentKernel kernel)
+{
+	size_t triangleCount = indexCount / 3;
+
+	/* Pass 1: Every triangle's tangent, independently */
+
+	std::vector<XMFLOAT3> triangleTangents(triangleCount);
+	threadPool.ParallelFor(triangleCount, MinTrianglesPerChunk, [&](size_t begin, size_t end)
+	{
+		CalculateTriangleTangents(vertices, indices, begin, end, triangleTangents.data(), kernel);
+	});
+
+	/* Build each vertex's list of triangles, in ascending triangle order */
+
+	// (A linear counting sort - cheap next to the passes on either side of it)
+	std::vector<unsigned int> adjacencyOffsets(vertexCount + 1, 0);
+	for(size_t i = 0; i < triangleCount * 3; i++)
+		adjacencyOffsets[indices[i] + 1]++;
+	for(size_t v = 0; v < vertexCount; v++)
+		adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+
+	std::vector<unsigned int> adjacency(triangleCount * 3);
+	std::vector<unsigned int> fillCursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for(size_t i = 0; i < triangleCount * 3; i++)
+		adjacency[fillCursors[indices[i]]++] = (unsigned int) (i / 3);
+
+	/* Pass 2: Each vertex gathers its triangles' tangents and orthonormalizes */
+
+	// Each vertex only writes to itself, so there are no races, and the sums
+	// happen in the same order as the serial version's scattered adds
+	threadPool.ParallelFor(vertexCount, MinVerticesPerChunk, [&](size_t begin, size_t end)
+	{
+		for(size_t v = begin; v < end; v++)
+		{
+			XMFLOAT3 tangent(0, 0, 0);
+			for(unsigned int i = adjacencyOffsets[v]; i < adjacencyOffsets[v + 1]; i++)
+			{
+				const XMFLOAT3& t = triangleTangents[adjacency[i]];
+				tangent.x += t.x;
+				tangent.y += t.y;
+				tangent.z += t.z;
+			}
+
+			vertices[v].tangent = tangent;
+			OrthonormalizeTangent(&vertices[v]);
+		}
+	});
+}
+
+void CalculateTangents(Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount)
+{
+	if(indexCount / 3 >= ParallelTangentTriangleCount)
+		CalculateTangentsParallel(vertices, vertexCount, indices, indexCount, ThreadPool::Global());
+	else
+		CalculateTangentsSerial(vertices, vertexCount, indices, indexCount);
+}
+
+void CalculateBitangentSigns(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, float* signs)
+{
+	// Sum each vertex's triangle bitangents, just like its tangents
+	std::vector<XMFLOAT3> bitangents(vertexCount, XMFLOAT3(0, 0, 0));
+	for(size_t i = 0; i + 2 < indexCount; i += 3)
+	{
+		XMFLOAT3 bitangent = CalculateTriangleBitangent(&vertices[indices[i]], &vertices[indices[i + 1]], &vertices[indices[i + 2]]);
+		for(int k = 0; k < 3; k++)
+		{
+			XMFLOAT3& b = bitangents[indices[i + k]];
+			b.x += bitangent.x;
+			b.y += bitangent.y;
+			b.z += bitangent.z;
+		}
+	}
+
+	// Compare against the bitangent the shader would build
+	for(size_t i = 0; i < vertexCount; i++)
+	{
+		const XMFLOAT3& t = vertices[i].tangent;
+		const XMFLOAT3& n = vertices[i].normal;
+		const XMFLOAT3& b = bitangents[i];
+		float handedness =
+			(t.y * n.z - t.z * n.y) * b.x +
+			(t.z * n.x - t.x * n.z) * b.y +
+			(t.x * n.y - t.y * n.x) * b.z;
+		signs[i] = handedness < 0.0f ? -1.0f : 1.0f;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+
+#include "Vertex.h"
+#include "ThreadPool.h"
+
+// --------------------------------------------------------
+// Per-triangle tangent kernels
+// - SIMD kernels gather 4 (SSE4.1) or 8 (AVX2) triangles into
+//   structure-of-arrays registers and do the same float math
+//   as the scalar kernel in each lane (no FMA or approximate
+//   reciprocals), so every kernel gives identical results
+// - The best kernel the CPU supports is picked at runtime
+// --------------------------------------------------------
+enum class TangentKernel
+{
+	Scalar,
+	SSE41,
+	AVX2
+};
+
+TangentKernel GetBestTangentKernel();
+const char* GetTangentKernelName(TangentKernel kernel);
+
+// Writes the (un-normalized) tangent of each triangle in [triangleBegin, triangleEnd) to triangleTangents[triangle]
+void CalculateTriangleTangents(const Vertex* vertices, const unsigned int* indices, size_t triangleBegin, size_t triangleEnd,
+	DirectX::XMFLOAT3* triangleTangents, TangentKernel kernel = GetBestTangentKernel());
+
+// --------------------------------------------------------
+// Tangent generation for indexed triangle lists
+// - Each vertex's tangent is the sum of the uv-aligned tangents
+//   of every triangle using it, Gram-Schmidt orthonormalized
+//   against the vertex normal
+// - The parallel version gathers each vertex's triangles in
+//   the same order the serial version scatters them, so both
+//   produce bit-identical results
+// - The kernel can be forced (i.e. to test each of them), but
+//   must be one the CPU supports
+// --------------------------------------------------------
+void CalculateTangentsSerial(Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+	TangentKernel kernel = GetBestTangentKernel());
+void CalculateTangentsParallel(Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, ThreadPool& threadPool,
+	TangentKernel kernel = GetBestTangentKernel());
+
+// Meshes with at least this many triangles generate tangents on multiple threads
+const size_t ParallelTangentTriangleCount = 16384;
+
+// Splits large meshes across the global thread pool; small ones aren't worth the hand-off
+void CalculateTangents(Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount);
+
+// Handedness of each vertex's tangent frame, written to signs[vertex]: +1 where the uv-aligned
+// bitangent points along cross(tangent, normal) (what the pixel shader assumes), and -1 where
+// the uvs are mirrored
+// - Needs the tangents to have been calculated already
+void CalculateBitangentSigns(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, float* signs);
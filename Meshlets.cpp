@@ -0,0 +1,282 @@
+#include "Meshlets.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cstdint>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	// Facing direction of a triangle (clockwise winding is front-facing), or false if it has no area
+	bool CalculateFaceNormal(const Vertex* vertices, const unsigned int* triangle, XMFLOAT3& normal)
+	{
+		XMVECTOR p0 = XMLoadFloat3(&vertices[triangle[0]].position);
+		XMVECTOR p1 = XMLoadFloat3(&vertices[triangle[1]].position);
+		XMVECTOR p2 = XMLoadFloat3(&vertices[triangle[2]].position);
+		XMVECTOR cross = XMVector3Cross(p1 - p0, p2 - p0);
+		if(XMVectorGetX(XMVector3LengthSq(cross)) <= 0.0f)
+			return false;
+
+		XMStoreFloat3(&normal, XMVector3Normalize(cross));
+		return true;
+	}
+
+	// Fills in the bounding sphere and normal cone of a finished meshlet
+	void CalculateMeshletBounds(Meshlet& meshlet, const Vertex* vertices, const unsigned int* indices, const std::vector<unsigned int>& meshletVertices)
+	{
+		// Sphere around the center of the meshlet's bounding box
+		XMFLOAT3 min = vertices[meshletVertices[0]].position;
+		XMFLOAT3 max = min;
+		for(unsigned int v : meshletVertices)
+		{
+			const XMFLOAT3& p = vertices[v].position;
+			min = XMFLOAT3(std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z));
+			max = XMFLOAT3(std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z));
+		}
+		meshlet.center = XMFLOAT3((min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f);
+
+		float radiusSquared = 0.0f;
+		for(unsigned int v : meshletVertices)
+		{
+			const XMFLOAT3& p = vertices[v].position;
+			float dx = p.x - meshlet.center.x, dy = p.y - meshlet.center.y, dz = p.z - meshlet.center.z;
+			radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+		}
+		meshlet.radius = std::sqrt(radiusSquared);
+
+		// Cone around the average facing direction, wide enough for every triangle
+		std::vector<XMFLOAT3> faceNormals;
+		faceNormals.reserve(meshlet.triangleCount);
+		XMVECTOR normalSum = XMVectorZero();
+		for(unsigned int t = 0; t < meshlet.triangleCount; t++)
+		{
+			XMFLOAT3 normal;
+			if(CalculateFaceNormal(vertices, &indices[meshlet.indexOffset + t * 3], normal))
+			{
+				faceNormals.push_back(normal);
+				normalSum = normalSum + XMLoadFloat3(&normal);
+			}
+		}
+
+		meshlet.coneAxis = XMFLOAT3(0, 0, 1);
+		meshlet.coneCutoff = -1.0f;
+		if(faceNormals.empty() || XMVectorGetX(XMVector3LengthSq(normalSum)) <= 0.0f)
+			return;
+
+		XMVECTOR axis = XMVector3Normalize(normalSum);
+		XMStoreFloat3(&meshlet.coneAxis, axis);
+
+		meshlet.coneCutoff = 1.0f;
+		for(const XMFLOAT3& normal : faceNormals)
+			meshlet.coneCutoff = std::min(meshlet.coneCutoff, XMVectorGetX(XMVector3Dot(axis, XMLoadFloat3(&normal))));
+	}
+}
+
+std::vector<Meshlet> BuildMeshlets(const Vertex* vertices, size_t vertexCount, unsigned int* indices, size_t indexCount)
+{
+	std::vector<Meshlet> meshlets;
+	size_t triangleCount = indexCount / 3;
+	if(triangleCount == 0)
+		return meshlets;
+
+	// Each vertex's list of triangles
+	std::vector<unsigned int> adjacencyOffsets(vertexCount + 1, 0);
+	for(size_t i = 0; i < triangleCount * 3; i++)
+		adjacencyOffsets[indices[i] + 1]++;
+	for(size_t v = 0; v < vertexCount; v++)
+		adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+
+	std::vector<unsigned int> adjacency(triangleCount * 3);
+	std::vector<unsigned int> fillCursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for(size_t i = 0; i < triangleCount * 3; i++)
+		adjacency[fillCursors[indices[i]]++] = (unsigned int) (i / 3);
+
+	// Rough radius of a full meshlet (an 8x8 grid of vertices), for weighing distance against normal spread
+	double edgeLengthSum = 0.0;
+	for(size_t t = 0; t < triangleCount; t++)
+	{
+		for(int k = 0; k < 3; k++)
+		{
+			const XMFLOAT3& a = vertices[indices[t * 3 + k]].position;
+			const XMFLOAT3& b = vertices[indices[t * 3 + (k + 1) % 3]].position;
+			edgeLengthSum += std::sqrt((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y) + (a.z - b.z) * (a.z - b.z));
+		}
+	}
+	float meshletSize = std::max(4.0f * (float) (edgeLengthSum / (triangleCount * 3)), FLT_MIN);
+
+	// Which meshlet each vertex was last added to (so nothing needs clearing between meshlets)
+	std::vector<unsigned int> vertexMeshlet(vertexCount, UINT_MAX);
+	std::vector<bool> isTriangleUsed(triangleCount, false);
+
+	std::vector<unsigned int> reorderedIndices;
+	reorderedIndices.reserve(triangleCount * 3);
+
+	std::vector<unsigned int> meshletVertices;
+	size_t seedCursor = 0;
+	while(true)
+	{
+		// Start each meshlet at the earliest triangle not in one yet
+		while(seedCursor < triangleCount && isTriangleUsed[seedCursor])
+			seedCursor++;
+		if(seedCursor == triangleCount)
+			break;
+
+		unsigned int meshletIndex = (unsigned int) meshlets.size();
+		Meshlet meshlet = {};
+		meshlet.indexOffset = (unsigned int) reorderedIndices.size();
+		meshletVertices.clear();
+		XMFLOAT3 centroidSum(0, 0, 0);
+		XMFLOAT3 normalSum(0, 0, 0);
+
+		size_t next = seedCursor;
+		while(true)
+		{
+			// Add the chosen triangle
+			isTriangleUsed[next] = true;
+			meshlet.triangleCount++;
+			XMFLOAT3 faceNormal;
+			if(CalculateFaceNormal(vertices, &indices[next * 3], faceNormal))
+				normalSum = XMFLOAT3(normalSum.x + faceNormal.x, normalSum.y + faceNormal.y, normalSum.z + faceNormal.z);
+			for(int k = 0; k < 3; k++)
+			{
+				unsigned int v = indices[next * 3 + k];
+				reorderedIndices.push_back(v);
+				if(vertexMeshlet[v] != meshletIndex)
+				{
+					vertexMeshlet[v] = meshletIndex;
+					meshletVertices.push_back(v);
+					centroidSum.x += vertices[v].position.x;
+					centroidSum.y += vertices[v].position.y;
+					centroidSum.z += vertices[v].position.z;
+				}
+			}
+
+			if(meshlet.triangleCount == MaxMeshletTriangles)
+				break;
+
+			// Pick the next triangle from the unused ones touching this meshlet
+			// - Triangles that add no new vertices are free, so they always come first
+			// - Otherwise, the one closest to the centroid and best aligned with the average
+			//   facing direction wins (keeping bounding spheres and normal cones tight)
+			float normalLength = std::sqrt(normalSum.x * normalSum.x + normalSum.y * normalSum.y + normalSum.z * normalSum.z);
+			XMFLOAT3 centroid(centroidSum.x / meshletVertices.size(), centroidSum.y / meshletVertices.size(), centroidSum.z / meshletVertices.size());
+			size_t best = SIZE_MAX;
+			unsigned int bestNewVertices = 4;
+			float bestScore = FLT_MAX;
+			for(size_t i = 0; i < meshletVertices.size(); i++)
+			{
+				unsigned int v = meshletVertices[i];
+				for(unsigned int a = adjacencyOffsets[v]; a < adjacencyOffsets[v + 1]; a++)
+				{
+					unsigned int t = adjacency[a];
+					if(isTriangleUsed[t])
+						continue;
+
+					unsigned int newVertices = 0;
+					XMFLOAT3 offset(-3.0f * centroid.x, -3.0f * centroid.y, -3.0f * centroid.z);
+					for(int k = 0; k < 3; k++)
+					{
+						unsigned int corner = indices[t * 3 + k];
+						newVertices += vertexMeshlet[corner] != meshletIndex;
+						offset.x += vertices[corner].position.x;
+						offset.y += vertices[corner].position.y;
+						offset.z += vertices[corner].position.z;
+					}
+					if(meshletVertices.size() + newVertices > MaxMeshletVertices)
+						continue;
+
+					float score = std::sqrt(offset.x * offset.x + offset.y * offset.y + offset.z * offset.z) / (3.0f * meshletSize);
+					XMFLOAT3 normal;
+					if(CalculateFaceNormal(vertices, &indices[t * 3], normal) && normalLength > 0.0f)
+						score += 1.0f - (normal.x * normalSum.x + normal.y * normalSum.y + normal.z * normalSum.z) / normalLength;
+
+					bool isFree = newVertices == 0;
+					bool isBestFree = bestNewVertices == 0;
+					if(isFree != isBestFree ? isFree : score < bestScore)
+					{
+						best = t;
+						bestNewVertices = newVertices;
+						bestScore = score;
+					}
+				}
+			}
+
+			// Nothing connected (or nothing that fits) ends the meshlet, rather than making it sprawl
+			if(best == SIZE_MAX)
+				break;
+
+			next = best;
+		}
+
+		meshlet.vertexCount = (unsigned int) meshletVertices.size();
+		meshlets.push_back(meshlet);
+		CalculateMeshletBounds(meshlets.back(), vertices, reorderedIndices.data(), meshletVertices);
+	}
+
+	std::copy(reorderedIndices.begin(), reorderedIndices.end(), indices);
+	return meshlets;
+}
+
+bool IsMeshletInFrustum(const Meshlet& meshlet, const Frustum& frustum)
+{
+	return frustum.IntersectsSphere(meshlet.center, meshlet.radius);
+}
+
+// --------------------------------------------------------
+// Normal cone test
+// - A triangle faces away if the camera is behind its plane,
+//   i.e. dot(point - camera, normal) >= 0
+// - Over the bounding sphere (center s, radius r) and the cone
+//   (axis a, half angle alpha), the smallest that can get is
+//   |s - camera| * cos(theta + alpha) - r, where theta is the
+//   angle between (s - camera) and a
+// --------------------------------------------------------
+bool IsMeshletFrontFacing(const Meshlet& meshlet, const XMFLOAT3& cameraPosition)
+{
+	if(meshlet.coneCutoff <= 0.0f)
+		return true;
+
+	XMFLOAT3 toCenter(meshlet.center.x - cameraPosition.x, meshlet.center.y - cameraPosition.y, meshlet.center.z - cameraPosition.z);
+	float distance = std::sqrt(toCenter.x * toCenter.x + toCenter.y * toCenter.y + toCenter.z * toCenter.z);
+	if(distance <= meshlet.radius)
+		return true;
+
+	float cosTheta = (toCenter.x * meshlet.coneAxis.x + toCenter.y * meshlet.coneAxis.y + toCenter.z * meshlet.coneAxis.z) / distance;
+	float sinTheta = std::sqrt(std::max(0.0f, 1.0f - cosTheta * cosTheta));
+	float sinAlpha = std::sqrt(std::max(0.0f, 1.0f - meshlet.coneCutoff * meshlet.coneCutoff));
+
+	return distance * (cosTheta * meshlet.coneCutoff - sinTheta * sinAlpha) < meshlet.radius;
+}
+
+void CullMeshlets(const Meshlet* meshlets, size_t meshletCount, const Frustum& frustum, const XMFLOAT3& cameraPosition,
+	std::vector<IndexRange>& visibleRanges, MeshletCullStatistics& statistics)
+{
+	for(size_t i = 0; i < meshletCount; i++)
+	{
+		const Meshlet& meshlet = meshlets[i];
+		if(!IsMeshletInFrustum(meshlet, frustum))
+		{
+			statistics.meshletsFrustumCulled++;
+			statistics.trianglesCulled += meshlet.triangleCount;
+			continue;
+		}
+		if(!IsMeshletFrontFacing(meshlet, cameraPosition))
+		{
+			statistics.meshletsConeCulled++;
+			statistics.trianglesCulled += meshlet.triangleCount;
+			continue;
+		}
+
+		statistics.meshletsVisible++;
+		statistics.trianglesVisible += meshlet.triangleCount;
+
+		// Meshlets are stored back to back, so visible neighbors can share a draw
+		if(!visibleRanges.empty() && visibleRanges.back().start + visibleRanges.back().count == meshlet.indexOffset)
+			visibleRanges.back().count += meshlet.triangleCount * 3;
+		else
+			visibleRanges.push_back({ meshlet.indexOffset, meshlet.triangleCount * 3 });
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <DirectXMath.h>
+
+#include "Vertex.h"
+#include "Frustum.h"
+
+// Limits per meshlet (the usual mesh shader sizes, which keep clusters small and tight)
+const unsigned int MaxMeshletVertices = 64;
+const unsigned int MaxMeshletTriangles = 124;
+
+// --------------------------------------------------------
+// A cluster of nearby triangles that is culled as a unit
+// - Its triangles are contiguous in the mesh's index buffer,
+//   so a visible meshlet is just a range of indices to draw
+// - Bounds are in the mesh's local space
+// - Every triangle's facing direction lies within the normal
+//   cone (within acos(coneCutoff) of coneAxis); a cutoff of
+//   0 or less means the cone is too wide to ever be culled
+// --------------------------------------------------------
+struct Meshlet
+{
+	unsigned int indexOffset;
+	unsigned int triangleCount;
+	unsigned int vertexCount;
+
+	DirectX::XMFLOAT3 center;
+	float radius;
+
+	DirectX::XMFLOAT3 coneAxis;
+	float coneCutoff;
+};
+
+// --------------------------------------------------------
+// Why meshlets were (or weren't) drawn, summed over any
+// number of CullMeshlets() calls
+// --------------------------------------------------------
+struct MeshletCullStatistics
+{
+	unsigned int meshletsVisible;
+	unsigned int meshletsFrustumCulled;
+	unsigned int meshletsConeCulled;
+	unsigned int trianglesVisible;
+	unsigned int trianglesCulled;
+};
+
+// A run of consecutive indices to draw
+struct IndexRange
+{
+	unsigned int start;
+	unsigned int count;
+};
+
+// Groups triangles into meshlets, reordering the index buffer (in place) so each meshlet's triangles are contiguous
+// - Each meshlet grows outward from the earliest unused triangle, through connected triangles that
+//   keep it compact and facing one way, until it hits a size limit or runs out of neighbors
+std::vector<Meshlet> BuildMeshlets(const Vertex* vertices, size_t vertexCount, unsigned int* indices, size_t indexCount);
+
+// Whether any part of the meshlet could be visible from the camera
+// - frustum and cameraPosition must be in the mesh's local space
+// - The cone test culls meshlets whose triangles all face away from the camera
+bool IsMeshletInFrustum(const Meshlet& meshlet, const Frustum& frustum);
+bool IsMeshletFrontFacing(const Meshlet& meshlet, const DirectX::XMFLOAT3& cameraPosition);
+
+// Tests every meshlet and appends the visible ones to visibleRanges (merging neighbors into single ranges)
+void CullMeshlets(const Meshlet* meshlets, size_t meshletCount, const Frustum& frustum, const DirectX::XMFLOAT3& cameraPosition,
+	std::vector<IndexRange>& visibleRanges, MeshletCullStatistics& statistics);
@@ -0,0 +1,261 @@
+#include "MipGenerator.h"
+#include "ThreadPool.h"
+
+#include <cmath>
+
+// --------------------------------------------------------
+// Separable resampling with a Kaiser-windowed sinc filter
+// (the same default NVIDIA's texture tools use for mips),
+// which keeps mips sharper than a box filter without the
+// aliasing of point sampling
+// - Works on any size ratio, so odd dimensions still get a
+//   correctly centered filter instead of dropping a pixel
+// --------------------------------------------------------
+namespace
+{
+	const float KaiserWidth = 3.0f;	// Filter radius, in destination pixels
+	const float KaiserAlpha = 4.0f;	// Sharpness of the window's falloff
+	const float Gamma = 2.2f;		// Matches the pow(color, 2.2) the shaders decode with
+	const float Pi = 3.14159265f;
+
+	// Zeroth order modified Bessel function of the first kind (power series)
+	float BesselI0(float x)
+	{
+		float sum = 1.0f;
+		float term = 1.0f;
+		float halfX = x * 0.5f;
+		for(int k = 1; k < 32; k++)
+		{
+			term *= (halfX / k) * (halfX / k);
+			sum += term;
+			if(term < sum * 1e-7f)
+				break;
+		}
+		return sum;
+	}
+
+	float Sinc(float x)
+	{
+		if(std::fabs(x) < 1e-4f)
+			return 1.0f;
+		return std::sin(Pi * x) / (Pi * x);
+	}
+
+	float KaiserFilter(float x)
+	{
+		if(std::fabs(x) >= KaiserWidth)
+			return 0.0f;
+		float t = x / KaiserWidth;
+		return Sinc(x) * BesselI0(KaiserAlpha * std::sqrt(1.0f - t * t)) / BesselI0(KaiserAlpha);
+	}
+
+	// Linear-space working copy of an image (same channels, one float each)
+	struct FloatImage
+	{
+		unsigned int width;
+		unsigned int height;
+		unsigned int channels;
+		std::vector<float> pixels;
+	};
+
+	// Source pixels (and their weights) that make up each destination pixel along one axis
+	struct FilterTaps
+	{
+		int tapCount;
+		std::vector<unsigned int> sources; // tapCount per destination pixel
+		std::vector<float> weights;
+	};
+
+	FilterTaps BuildTaps(unsigned int sourceSize, unsigned int destinationSize)
+	{
+		// Widen the filter when shrinking so it covers every source pixel (never narrow it when growing)
+		float scale = (float) sourceSize / destinationSize;
+		float filterScale = std::fmax(scale, 1.0f);
+		float radius = KaiserWidth * filterScale;
+
+		FilterTaps taps;
+		taps.tapCount = (int) std::ceil(radius * 2.0f) + 1;
+		taps.sources.resize((size_t) destinationSize * taps.tapCount);
+		taps.weights.resize((size_t) destinationSize * taps.tapCount);
+
+		for(unsigned int destination = 0; destination < destinationSize; destination++)
+		{
+			// Both centers are in source pixel coordinates
+			float center = (destination + 0.5f) * scale;
+			int first = (int) std::floor(center - radius);
+
+			float total = 0.0f;
+			size_t base = (size_t) destination * taps.tapCount;
+			for(int i = 0; i < taps.tapCount; i++)
+			{
+				int source = first + i;
+				float weight = KaiserFilter((source + 0.5f - center) / filterScale);
+
+				// Wrap around the edges, since textures tile
+				int wrapped = source % (int) sourceSize;
+				taps.sources[base + i] = (unsigned int) (wrapped < 0 ? wrapped + (int) sourceSize : wrapped);
+				taps.weights[base + i] = weight;
+				total += weight;
+			}
+
+			for(int i = 0; i < taps.tapCount; i++)
+				taps.weights[base + i] /= total;
+		}
+		return taps;
+	}
+
+	FloatImage Resample(const FloatImage& source, unsigned int width, unsigned int height)
+	{
+		unsigned int channels = source.channels;
+		FilterTaps horizontalTaps = BuildTaps(source.width, width);
+		FilterTaps verticalTaps = BuildTaps(source.height, height);
+
+		// Horizontal pass: every source row, shrunk to the new width
+		FloatImage horizontal = { width, source.height, channels, {} };
+		horizontal.pixels.resize((size_t) width * source.height * channels);
+		ThreadPool::Global().ParallelFor(source.height, 16, [&](size_t begin, size_t end)
+		{
+			for(size_t y = begin; y < end; y++)
+			{
+				const float* sourceRow = &source.pixels[y * source.width * channels];
+				float* row = &horizontal.pixels[y * width * channels];
+				for(unsigned int x = 0; x < width; x++)
+				{
+					const unsigned int* sources = &horizontalTaps.sources[(size_t) x * horizontalTaps.tapCount];
+					const float* weights = &horizontalTaps.weights[(size_t) x * horizontalTaps.tapCount];
+					float sums[4] = {};
+					for(int i = 0; i < horizontalTaps.tapCount; i++)
+					{
+						const float* sourcePixel = &sourceRow[sources[i] * channels];
+						for(unsigned int c = 0; c < channels; c++)
+							sums[c] += sourcePixel[c] * weights[i];
+					}
+					for(unsigned int c = 0; c < channels; c++)
+						row[x * channels + c] = sums[c];
+				}
+			}
+		});
+
+		// Vertical pass: combine those rows into each new row
+		FloatImage result = { width, height, channels, {} };
+		result.pixels.resize((size_t) width * height * channels);
+		ThreadPool::Global().ParallelFor(height, 16, [&](size_t begin, size_t end)
+		{
+			size_t rowLength = (size_t) width * channels;
+			for(size_t y = begin; y < end; y++)
+			{
+				const unsigned int* sources = &verticalTaps.sources[y * verticalTaps.tapCount];
+				const float* weights = &verticalTaps.weights[y * verticalTaps.tapCount];
+				float* row = &result.pixels[y * rowLength];
+				for(int i = 0; i < verticalTaps.tapCount; i++)
+				{
+					const float* sourceRow = &horizontal.pixels[sources[i] * rowLength];
+					for(size_t j = 0; j < rowLength; j++)
+						row[j] += sourceRow[j] * weights[i];
+				}
+			}
+		});
+
+		return result;
+	}
+
+	FloatImage ToFloat(const Image& image, const MipOptions& options)
+	{
+		// Lookup table for decoding gamma-encoded bytes
+		float linear[256];
+		for(int i = 0; i < 256; i++)
+			linear[i] = std::pow(i / 255.0f, Gamma);
+
+		FloatImage result = { image.width, image.height, image.channels, {} };
+		result.pixels.resize(image.pixels.size());
+		for(size_t i = 0; i < image.pixels.size(); i++)
+		{
+			// Alpha is never gamma-encoded or part of a normal
+			bool isAlpha = image.channels == 4 && i % 4 == 3;
+			uint8_t value = image.pixels[i];
+			if(options.isNormalMap && !isAlpha)
+				result.pixels[i] = value / 255.0f * 2.0f - 1.0f;
+			else if(options.isGammaEncoded && !isAlpha)
+				result.pixels[i] = linear[value];
+			else
+				result.pixels[i] = value / 255.0f;
+		}
+		return result;
+	}
+
+	uint8_t ToByte(float value)
+	{
+		value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+		return (uint8_t) (value * 255.0f + 0.5f);
+	}
+
+	Image ToImage(const FloatImage& source, bool isSRGB, const MipOptions& options)
+	{
+		Image result = { source.width, source.height, source.channels, isSRGB, {} };
+		result.pixels.resize(source.pixels.size());
+
+		size_t pixelCount = (size_t) source.width * source.height;
+		for(size_t p = 0; p < pixelCount; p++)
+		{
+			const float* in = &source.pixels[p * source.channels];
+			uint8_t* out = &result.pixels[p * source.channels];
+
+			if(options.isNormalMap && source.channels >= 3)
+			{
+				// Filtering shortens normals, so stretch them back out
+				float length = std::sqrt(in[0] * in[0] + in[1] * in[1] + in[2] * in[2]);
+				float normal[3] = { 0.0f, 0.0f, 1.0f };
+				if(length > 1e-6f)
+				{
+					for(int c = 0; c < 3; c++)
+						normal[c] = in[c] / length;
+				}
+				for(int c = 0; c < 3; c++)
+					out[c] = ToByte(normal[c] * 0.5f + 0.5f);
+				if(source.channels == 4)
+					out[3] = ToByte(in[3]);
+				continue;
+			}
+
+			for(unsigned int c = 0; c < source.channels; c++)
+			{
+				bool isAlpha = source.channels == 4 && c == 3;
+				if(options.isGammaEncoded && !isAlpha)
+					out[c] = ToByte(std::pow(in[c] > 0.0f ? in[c] : 0.0f, 1.0f / Gamma));
+				else
+					out[c] = ToByte(in[c]);
+			}
+		}
+		return result;
+	}
+}
+
+unsigned int GetMipCount(unsigned int width, unsigned int height)
+{
+	unsigned int count = 1;
+	while(width > 1 || height > 1)
+	{
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+		count++;
+	}
+	return count;
+}
+
+Image ResizeImage(const Image& image, unsigned int width, unsigned int height, const MipOptions& options)
+{
+	return ToImage(Resample(ToFloat(image, options), width, height), image.isSRGB, options);
+}
+
+void GenerateMips(const Image& image, const MipOptions& options, std::vector<Image>& mips)
+{
+	// Nothing reads the image after this, so it's fine for it to live in mips
+	bool isSRGB = image.isSRGB;
+	FloatImage level = ToFloat(image, options);
+	while(level.width > 1 || level.height > 1)
+	{
+		FloatImage next = Resample(level, level.width > 1 ? level.width / 2 : 1, level.height > 1 ? level.height / 2 : 1);
+		mips.push_back(ToImage(next, isSRGB, options));
+		level = std::move(next);
+	}
+}
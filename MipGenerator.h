@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+
+#include "Image.h"
+
+// --------------------------------------------------------
+// How a texture's values should be filtered into its mips
+// - Gamma-encoded (color) values are filtered in linear
+//   space, so mips don't darken
+// - Normal maps are filtered as vectors and renormalized
+// - Anything else (roughness, metalness, alpha) is filtered
+//   as-is
+// --------------------------------------------------------
+struct MipOptions
+{
+	bool isGammaEncoded;
+	bool isNormalMap;
+};
+
+// Number of levels in a full mip chain (down to 1x1)
+unsigned int GetMipCount(unsigned int width, unsigned int height);
+
+// Shrinks an image to the given size with a windowed-sinc (Kaiser) filter, wrapping around
+// the edges since textures tile
+Image ResizeImage(const Image& image, unsigned int width, unsigned int height, const MipOptions& options);
+
+// Appends every mip below the given image to mips (half the size each, rounded down, to 1x1)
+// - Each level is filtered from the one above it, kept in floating point between levels so
+//   rounding doesn't build up
+// - Rows are split across the global thread pool
+void GenerateMips(const Image& image, const MipOptions& options, std::vector<Image>& mips);
@@ -0,0 +1,320 @@
+#include "ObjLoader.h"
+#include "MappedFile.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Hand-rolled .OBJ tokenizer
+// - Based on Chris Cascioli's basic .OBJ loader, but works
+//   directly on the (memory mapped) file contents instead of
+//   copying each line into a fixed-size buffer for sscanf_s,
+//   so there is no limit on line length
+// - Every read is bounded by "end" since mapped files are
+//   not null-terminated
+// --------------------------------------------------------
+namespace
+{
+	// Corner of a face; each value is the raw (1-based or negative relative) .OBJ index, or 0 if absent
+	struct ObjCorner
+	{
+		int position;
+		int uv;
+		int normal;
+	};
+
+	// Resolved (0-based, -1 if absent) attribute indices identifying one unique vertex
+	struct ObjVertexKey
+	{
+		int position;
+		int uv;
+		int normal;
+
+		bool operator==(const ObjVertexKey& other) const
+		{
+			return position == other.position && uv == other.uv && normal == other.normal;
+		}
+	};
+
+	struct ObjVertexKeyHash
+	{
+		size_t operator()(const ObjVertexKey& key) const
+		{
+			// Mix each index with a large odd constant so neighbouring triples don't collide
+			uint64_t hash = (uint32_t) key.position * 0x9E3779B97F4A7C15ull;
+			hash ^= ((uint32_t) key.uv + 0x7F4A7C15ull) * 0xC2B2AE3D27D4EB4Full;
+			hash ^= ((uint32_t) key.normal + 0x165667B1ull) * 0x165667B19E3779F9ull;
+			return (size_t) (hash ^ (hash >> 29));
+		}
+	};
+
+	// Every power of ten that is exactly representable as a double
+	const double powersOfTen[] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+	bool IsSpace(char c) { return c == ' ' || c == '\t'; }
+
+	// Skips spaces and tabs, but never a line break
+	void SkipSpaces(const char*& p, const char* end)
+	{
+		while(p < end && IsSpace(*p))
+			p++;
+	}
+
+	// Moves to the first character of the next line
+	void SkipLine(const char*& p, const char* end)
+	{
+		const char* newline = (const char*) memchr(p, '\n', end - p);
+		p = newline ? newline + 1 : end;
+	}
+
+	int ParseInt(const char*& p, const char* end)
+	{
+		bool negative = false;
+		if(p < end && (*p == '-' || *p == '+'))
+			negative = *p++ == '-';
+
+		int value = 0;
+		for(; p < end && IsDigit(*p); p++)
+			value = value * 10 + (*p - '0');
+
+		return negative ? -value : value;
+	}
+
+	// Parses a decimal float ("-1.25", "3", ".5", "1.0e-3") without going through the C locale machinery
+	float ParseFloat(const char*& p, const char* end)
+	{
+		SkipSpaces(p, end);
+
+		bool negative = false;
+		if(p < end && (*p == '-' || *p == '+'))
+			negative = *p++ == '-';
+
+		// Accumulate up to 19 significant digits as an integer, tracking the decimal exponent separately
+		uint64_t mantissa = 0;
+		int significantDigits = 0;
+		int exponent = 0;
+		for(; p < end && IsDigit(*p); p++)
+		{
+			if(significantDigits < 19)
+			{
+				mantissa = mantissa * 10 + (*p - '0');
+				if(mantissa)
+					significantDigits++;
+			}
+			else
+				exponent++; // Too many digits to hold; just keep the magnitude
+		}
+		if(p < end && *p == '.')
+		{
+			for(p++; p < end && IsDigit(*p); p++)
+			{
+				if(significantDigits < 19)
+				{
+					mantissa = mantissa * 10 + (*p - '0');
+					if(mantissa)
+						significantDigits++;
+					exponent--;
+				}
+			}
+		}
+		if(p < end && (*p == 'e' || *p == 'E'))
+		{
+			p++;
+			int explicitExponent = ParseInt(p, end);
+			exponent += explicitExponent;
+		}
+
+		double value = (double) mantissa;
+		if(exponent < 0)
+			value = exponent >= -22 ? value / powersOfTen[-exponent] : value * pow(10.0, exponent);
+		else if(exponent > 0)
+			value = exponent <= 22 ? value * powersOfTen[exponent] : value * pow(10.0, exponent);
+
+		return (float) (negative ? -value : value);
+	}
+
+	// Parses one "v", "v/vt", "v//vn" or "v/vt/vn" face corner, returning false at the end of the line
+	bool ParseCorner(const char*& p, const char* end, ObjCorner& corner)
+	{
+		SkipSpaces(p, end);
+		if(p >= end || !(IsDigit(*p) || *p == '-'))
+			return false;
+
+		corner = {};
+		corner.position = ParseInt(p, end);
+		if(p < end && *p == '/')
+		{
+			p++;
+			if(p < end && *p != '/')
+				corner.uv = ParseInt(p, end);
+			if(p < end && *p == '/')
+			{
+				p++;
+				corner.normal = ParseInt(p, end);
+			}
+		}
+
+		return true;
+	}
+
+	// Converts a 1-based (or negative, relative to the end) .OBJ index to a 0-based one; -1 if absent or out of range
+	int ResolveIndex(int objIndex, size_t count)
+	{
+		int index = objIndex > 0 ? objIndex - 1 : (int) count + objIndex;
+		return (objIndex != 0 && index >= 0 && index < (int) count) ? index : -1;
+	}
+}
+
+void ParseObj(const char* data, size_t size, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	const char* end = data + size;
+
+	// Quick sweep over line starts so every array can be sized up front
+	// instead of repeatedly growing while parsing
+	size_t positionCount = 0;
+	size_t uvCount = 0;
+	size_t normalCount = 0;
+	size_t triangleCount = 0;
+	for(const char* p = data; p < end; SkipLine(p, end))
+	{
+		if(p[0] == 'v' && p + 1 < end)
+		{
+			if(IsSpace(p[1])) positionCount++;
+			else if(p[1] == 't') uvCount++;
+			else if(p[1] == 'n') normalCount++;
+		}
+		else if(p[0] == 'f')
+		{
+			// Count the corners of this face (each run of non-space characters after the "f")
+			int cornerCount = 0;
+			for(const char* c = p + 1; c < end && *c != '\n' && *c != '\r'; c++)
+			{
+				if(!IsSpace(*c) && IsSpace(c[-1]))
+					cornerCount++;
+			}
+			if(cornerCount >= 3)
+				triangleCount += cornerCount - 2;
+		}
+	}
+
+	std::vector<XMFLOAT3> positions;	// Positions from the file
+	std::vector<XMFLOAT3> normals;		// Normals from the file
+	std::vector<XMFLOAT2> uvs;			// UVs from the file
+	positions.reserve(positionCount);
+	normals.reserve(normalCount);
+	uvs.reserve(uvCount);
+
+	vertices.clear();
+	indices.clear();
+	indices.reserve(triangleCount * 3);
+
+	// Smooth meshes end up with roughly one welded vertex per position
+	size_t attributeCount = positionCount > normalCount ? positionCount : normalCount;
+	vertices.reserve(attributeCount > uvCount ? attributeCount : uvCount);
+
+	// Maps each unique (v, vt, vn) triple to the vertex that was built for it,
+	// so faces sharing a corner share a vertex instead of getting a copy
+	std::unordered_map<ObjVertexKey, unsigned int, ObjVertexKeyHash> weldedVertices;
+	weldedVertices.reserve(vertices.capacity() * 2);
+
+	// Vertex indices of the face currently being triangulated (reused between faces)
+	std::vector<unsigned int> polygon;
+	polygon.reserve(8);
+
+	// Tokenize every line in a single pass
+	for(const char* p = data; p < end; SkipLine(p, end))
+	{
+		if(p[0] == 'v' && p + 1 < end && p[1] == 'n')
+		{
+			p += 2;
+			XMFLOAT3 norm;
+			norm.x = ParseFloat(p, end);
+			norm.y = ParseFloat(p, end);
+			norm.z = ParseFloat(p, end);
+			normals.push_back(norm);
+		}
+		else if(p[0] == 'v' && p + 1 < end && p[1] == 't')
+		{
+			p += 2;
+			XMFLOAT2 uv;
+			uv.x = ParseFloat(p, end);
+			uv.y = ParseFloat(p, end);
+			uvs.push_back(uv);
+		}
+		else if(p[0] == 'v' && p + 1 < end && IsSpace(p[1]))
+		{
+			p += 1;
+			XMFLOAT3 pos;
+			pos.x = ParseFloat(p, end);
+			pos.y = ParseFloat(p, end);
+			pos.z = ParseFloat(p, end);
+			positions.push_back(pos);
+		}
+		else if(p[0] == 'f' && p + 1 < end && IsSpace(p[1]))
+		{
+			p += 1;
+			polygon.clear();
+
+			ObjCorner corner;
+			while(ParseCorner(p, end, corner))
+			{
+				ObjVertexKey key;
+				key.position = ResolveIndex(corner.position, positions.size());
+				key.uv = ResolveIndex(corner.uv, uvs.size());
+				key.normal = ResolveIndex(corner.normal, normals.size());
+
+				// Reuse the vertex if this exact corner has been seen before
+				auto welded = weldedVertices.try_emplace(key, (unsigned int) vertices.size());
+				if(welded.second)
+				{
+					// - Create the vert by looking up the corresponding
+					//    data; anything missing from the file stays zeroed
+					Vertex v = {};
+					if(key.position >= 0) v.position = positions[key.position];
+					if(key.uv >= 0) v.uv = uvs[key.uv];
+					if(key.normal >= 0) v.normal = normals[key.normal];
+
+					// The model is most likely in a right-handed space,
+					// so convert to DirectX's left-handed space:
+					//  - Flip the UV since DirectX defines (0,0) as the top left
+					//  - Invert the Z position and the normal's Z
+					//  - (The winding order is flipped below)
+					v.uv.y = 1.0f - v.uv.y;
+					v.position.z *= -1.0f;
+					v.normal.z *= -1.0f;
+
+					vertices.push_back(v);
+				}
+
+				polygon.push_back(welded.first->second);
+			}
+
+			// Fan-triangulate the face, flipping the winding order
+			for(size_t i = 2; i < polygon.size(); i++)
+			{
+				indices.push_back(polygon[0]);
+				indices.push_back(polygon[i]);
+				indices.push_back(polygon[i - 1]);
+			}
+		}
+	}
+}
+
+bool LoadObj(const wchar_t* filePath, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	MappedFile file(filePath);
+	if(!file.IsOpen())
+		return false;
+
+	ParseObj(file.GetData(), file.GetSize(), vertices, indices);
+	return true;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Vertex.h"
+
+// --------------------------------------------------------
+// Parses .OBJ text (positions, uvs and normals) into vertex
+// and index arrays that can be handed straight to a Mesh
+// - Corners with identical (v, vt, vn) indices are welded into
+//   a single vertex, so the index buffer is truly indexed
+// - Polygons with any number of corners are fan-triangulated
+// - Converts from the file's right-handed space to DirectX's
+//   left-handed space (flips Z, V and the winding order)
+// - Tangents are left zeroed for Mesh::CalculateTangents()
+// --------------------------------------------------------
+void ParseObj(const char* data, size_t size, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+// Memory maps the file and parses it with ParseObj()
+// - Returns false if the file couldn't be opened
+bool LoadObj(const wchar_t* filePath, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
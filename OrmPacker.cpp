@@ -0,0 +1,54 @@
+#include "OrmPacker.h"
+#include "MipGenerator.h"
+
+#include <cstddef>
+
+bool PackOrm(const Image* occlusion, const Image* roughness, const Image* metalness, Image& packed)
+{
+	const Image* sources[3] = { occlusion, roughness, metalness };
+	const uint8_t defaults[3] = { DefaultOcclusion, DefaultRoughness, DefaultMetalness };
+
+	// The packed texture is as big as the biggest map
+	unsigned int width = 0;
+	unsigned int height = 0;
+	for(const Image* source : sources)
+	{
+		if(source && (size_t) source->width * source->height > (size_t) width * height)
+		{
+			width = source->width;
+			height = source->height;
+		}
+	}
+	if(width == 0 || height == 0)
+		return false;
+
+	packed = { width, height, 4, false, {} };
+	packed.pixels.resize((size_t) width * height * 4);
+
+	size_t pixelCount = (size_t) width * height;
+	for(int channel = 0; channel < 3; channel++)
+	{
+		const Image* source = sources[channel];
+		if(!source)
+		{
+			for(size_t p = 0; p < pixelCount; p++)
+				packed.pixels[p * 4 + channel] = defaults[channel];
+			continue;
+		}
+
+		// All of these are linear data, so they're resized as-is
+		Image resized;
+		if(source->width != width || source->height != height)
+		{
+			resized = ResizeImage(*source, width, height, { false, false });
+			source = &resized;
+		}
+
+		for(size_t p = 0; p < pixelCount; p++)
+			packed.pixels[p * 4 + channel] = source->pixels[p * source->channels];
+	}
+
+	for(size_t p = 0; p < pixelCount; p++)
+		packed.pixels[p * 4 + 3] = 255;
+	return true;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "Image.h"
+
+// --------------------------------------------------------
+// Channel packing for PBR maps: occlusion, roughness and
+// metalness (ORM) share one RGBA texture, so a material
+// binds and samples one texture instead of one per value
+// - Occlusion goes in red, roughness in green, metalness
+//   in blue; alpha is always opaque
+// - Each source map only contributes its red channel
+// --------------------------------------------------------
+const uint8_t DefaultOcclusion = 255;	// Unoccluded
+const uint8_t DefaultRoughness = 255;	// Fully rough
+const uint8_t DefaultMetalness = 0;		// Not metal
+
+// Packs whichever maps are given (the rest can be null, and get the defaults above)
+// - Maps are resized to the largest one, since metalness maps are often much smaller
+// - Returns false when every map is null
+bool PackOrm(const Image* occlusion, const Image* roughness, const Image* metalness, Image& packed);
@@ -1,9 +1,9 @@
 #include "ShaderStructs.hlsli"
+#include "FrameData.hlsli"
 
 cbuffer DataFromCPU : register(b0)
 {
     float4 colorTint;
-    float totalTime;
 }
 
 float4 main(VertexToPixel input) : SV_TARGET
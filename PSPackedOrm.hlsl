@@ -0,0 +1,4 @@
+// Same as PixelShader.hlsl, but with roughness and metalness read from one
+// packed occlusion/roughness/metalness (ORM) map instead of two separate ones
+#define PACKED_ORM
+#include "PixelShader.hlsl"
@@ -10,5 +10,6 @@ TextureCube SkyCubeMap : register(t0);
 float4 main(VertexToPixel_Sky input) : SV_TARGET
 {
 	// Just sample the cubemap with the given direction
-    return SkyCubeMap.Sample(SkySampler, input.sampleDirection);
+	// - Only the top mip is the actual sky; the rest are prefiltered for reflections
+    return SkyCubeMap.SampleLevel(SkySampler, input.sampleDirection, 0);
 }
\ No newline at end of file
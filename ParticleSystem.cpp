@@ -193,8 +193,11 @@ void ParticleSystem::CreateBuffers()
 void ParticleSystem::Update(float deltaTime)
 {
 	// Reset UAVs
+	ShaderStateCache& stateCache = ShaderStateCache::ForContext(Graphics::Context.Get());
 	ID3D11UnorderedAccessView* none[8] = {};
-	Graphics::Context->CSSetUnorderedAccessViews(0, 8, none, 0);
+	unsigned int firstSlot = 0, slotCount = 8;
+	if(stateCache.UnbindUnorderedAccessViews(ShaderStage::Compute, firstSlot, slotCount))
+		Graphics::Context->CSSetUnorderedAccessViews(firstSlot, slotCount, none, 0);
 
 	// Check if particle system should emit
 	emissionCooldown -= deltaTime;
@@ -247,16 +250,21 @@ void ParticleSystem::Emit(uint32_t count)
 	particleComputeShaderEmit->CopyAllBufferData();
 
 	// Manually set dead list counter buffer
-	Graphics::Context->CSSetConstantBuffers(1, 1, deadListCounterBuffer.GetAddressOf());
+	if(ShaderStateCache::ForContext(Graphics::Context.Get()).SetConstantBuffer(ShaderStage::Compute, 1, deadListCounterBuffer.Get()))
+		Graphics::Context->CSSetConstantBuffers(1, 1, deadListCounterBuffer.GetAddressOf());
 
 	particleComputeShaderEmit->DispatchByThreads(count, 1, 1);
 }
 void ParticleSystem::Draw(std::shared_ptr<Camera> camera)
 {
+	ShaderStateCache& stateCache = ShaderStateCache::ForContext(Graphics::Context.Get());
+
 	// Dispatch particle draw shader
 	{
 		ID3D11UnorderedAccessView* none[8] = {};
-		Graphics::Context->CSSetUnorderedAccessViews(0, 8, none, 0);
+		unsigned int firstSlot = 0, slotCount = 8;
+		if(stateCache.UnbindUnorderedAccessViews(ShaderStage::Compute, firstSlot, slotCount))
+			Graphics::Context->CSSetUnorderedAccessViews(firstSlot, slotCount, none, 0);
 
 		particleComputeShaderDraw->SetShader();
 		particleComputeShaderDraw->SetUnorderedAccessView("DrawArgs", drawArgsUAV);
@@ -269,7 +277,10 @@ void ParticleSystem::Draw(std::shared_ptr<Camera> camera)
 		particleComputeShaderDraw->DispatchByThreads(1, 1, 1);
 
 		// Reset again before the normal rendering pipeline steps
-		Graphics::Context->CSSetUnorderedAccessViews(0, 8, none, 0);
+		firstSlot = 0;
+		slotCount = 8;
+		if(stateCache.UnbindUnorderedAccessViews(ShaderStage::Compute, firstSlot, slotCount))
+			Graphics::Context->CSSetUnorderedAccessViews(firstSlot, slotCount, none, 0);
 	}
 
 	// Vertex and Pixel shaders
@@ -300,7 +311,9 @@ void ParticleSystem::Draw(std::shared_ptr<Camera> camera)
 		Graphics::Context->DrawIndexedInstancedIndirect(drawArgsBuffer.Get(), 0);
 
 		ID3D11ShaderResourceView* none[16] = {};
-		Graphics::Context->VSSetShaderResources(0, 16, none);
+		unsigned int firstSlot = 0, slotCount = 16;
+		if(stateCache.UnbindShaderResourceViews(ShaderStage::Vertex, firstSlot, slotCount))
+			Graphics::Context->VSSetShaderResources(firstSlot, slotCount, none);
 	}
 }
 
@@ -1,17 +1,12 @@
 #include "ShaderStructs.hlsli"
 #include "ShaderFunctions.hlsli"
-
-#define MAX_LIGHTS 64
+#include "FrameData.hlsli"
 
 cbuffer DataFromCPU : register(b0) // Take the data from memory register b0 ("buffer 0")
 {
     float4 colorTint;
     float2 uvScale;
     float2 uvOffset;
-	float3 cameraLocation;
-
-	int lightCount;
-	Light lights[MAX_LIGHTS];
 }
 
 // Set of options for sampling
@@ -21,8 +16,12 @@ SamplerComparisonState ShadowSampler : register(s1);
 // Define textures
 Texture2D AlbedoTexture : register(t0);
 Texture2D NormalMap : register(t1);
+#ifdef PACKED_ORM
+Texture2D OrmMap : register(t2); // Occlusion, roughness, metalness in R, G, B (see PSPackedOrm.hlsl)
+#else
 Texture2D RoughnessMap : register(t2);
 Texture2D MetalnessMap : register(t3);
+#endif
 Texture2D ShadowMap : register(t4);
 
 // --------------------------------------------------------
@@ -51,17 +50,25 @@ float4 main(VertexToPixel input) : SV_TARGET
 
     // Sample textures
     float3 textureColor = pow(AlbedoTexture.Sample(BasicSampler, input.uv).rgb * colorTint.rgb, 2.2f); // Reverse gamma correction of surface texture - final color is re-corrected
+#ifdef PACKED_ORM
+    float3 orm = OrmMap.Sample(BasicSampler, input.uv).rgb; // Occlusion is packed too, but there's no ambient light for it to darken
+    float roughness = orm.g;
+    float metalness = orm.b;
+#else
     float roughness = RoughnessMap.Sample(BasicSampler, input.uv).r;
     float metalness = MetalnessMap.Sample(BasicSampler, input.uv).r;
+#endif
     float3 specularColor = lerp(F0_NON_METAL, textureColor, metalness); // Specular is somewhere between a constant and the albedo color, depending on metalness
     
-    float3 unpackedNormal = normalize(NormalMap.Sample(BasicSampler, input.uv).rgb * 2 - 1);
+    // Only X and Y are stored (BC5), so rebuild Z from them - normal maps always point out of the surface
+    float2 normalXY = NormalMap.Sample(BasicSampler, input.uv).rg * 2 - 1;
+    float3 unpackedNormal = float3(normalXY, sqrt(saturate(1 - dot(normalXY, normalXY))));
 
     // Calculate normal, tangent and bitangent for normal mapping
     // Orthonormalize normal and tangent using Gram-Schmidt Process
     float3 N = normalize(input.normal);
     float3 T = normalize(input.tangent - N * dot(N, input.tangent));
-    float3 B = cross(T, N);
+    float3 B = cross(T, N) * input.bitangentSign;
     float3x3 rotationMatrix = float3x3(T, B, N); // Rotation matrix that transforms tangent space to world space
 
     // Transform normal value from normal map to world space and update the input parameter
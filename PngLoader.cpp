@@ -0,0 +1,664 @@
+#include "PngLoader.h"
+#include "MappedFile.h"
+
+#include <cstring>
+#include <vector>
+
+// --------------------------------------------------------
+// Hand-rolled .PNG decoder
+// - Inflates the zlib stream (all DEFLATE block types) with
+//   table-driven Huffman decoding, then undoes each row's
+//   filter and expands the pixels to 8-bit gray or RGBA
+// - Every read is bounded, so truncated or corrupt files
+//   fail to decode instead of reading past the mapping
+// - CRCs aren't checked, but the zlib Adler-32 checksum is
+// --------------------------------------------------------
+namespace
+{
+	/* DEFLATE decompression */
+
+	const int MaxCodeLength = 15;
+	const int FastBits = 10; // Codes up to this long decode with a single table lookup
+
+	// Reads DEFLATE's least-significant-bit-first bit stream
+	// - Reading past the end gives zeros, which IsOverrun() reports afterwards
+	class BitReader
+	{
+	private:
+		const uint8_t* data;
+		size_t size;
+		size_t position;
+		uint64_t bits;
+		int bitCount;
+
+	public:
+		BitReader(const uint8_t* data, size_t size) :
+			data(data), size(size), position(0), bits(0), bitCount(0)
+		{
+
+		}
+
+		void Refill()
+		{
+			while(bitCount <= 56)
+			{
+				uint64_t byte = position < size ? data[position] : 0;
+				bits |= byte << bitCount;
+				bitCount += 8;
+				position++;
+			}
+		}
+		uint32_t Peek(int count)
+		{
+			if(bitCount < count)
+				Refill();
+			return (uint32_t) (bits & ((1ull << count) - 1));
+		}
+		void Consume(int count)
+		{
+			bits >>= count;
+			bitCount -= count;
+		}
+		uint32_t Read(int count)
+		{
+			uint32_t value = Peek(count);
+			Consume(count);
+			return value;
+		}
+		void AlignToByte() { Consume(bitCount % 8); };
+		bool IsOverrun() const { return position - bitCount / 8 > size; };
+	};
+
+	// Canonical Huffman code, decoded through a lookup table for short codes
+	struct Huffman
+	{
+		uint16_t fast[1 << FastBits];       // (symbol << 4) | length for codes up to FastBits long, 0 for longer ones
+		uint16_t counts[MaxCodeLength + 1]; // Number of codes of each length
+		uint16_t symbols[288];              // Symbols sorted by code
+	};
+
+	bool BuildHuffman(Huffman& huffman, const uint8_t* lengths, int symbolCount)
+	{
+		memset(huffman.counts, 0, sizeof(huffman.counts));
+		for(int i = 0; i < symbolCount; i++)
+			huffman.counts[lengths[i]]++;
+		huffman.counts[0] = 0;
+
+		// More codes of some length than the bits allow means the lengths are corrupt
+		// (fewer is fine; DEFLATE allows incomplete codes, like a lone distance code)
+		int codesLeft = 1;
+		for(int length = 1; length <= MaxCodeLength; length++)
+		{
+			codesLeft = (codesLeft << 1) - huffman.counts[length];
+			if(codesLeft < 0)
+				return false;
+		}
+
+		uint16_t offsets[MaxCodeLength + 2] = {};
+		for(int length = 1; length <= MaxCodeLength; length++)
+			offsets[length + 1] = offsets[length] + huffman.counts[length];
+		for(int symbol = 0; symbol < symbolCount; symbol++)
+		{
+			if(lengths[symbol] != 0)
+				huffman.symbols[offsets[lengths[symbol]]++] = (uint16_t) symbol;
+		}
+
+		// Codes are stored most-significant-bit first but read least-significant-bit first,
+		// so each short code fills every table slot whose low bits are its reversed code
+		memset(huffman.fast, 0, sizeof(huffman.fast));
+		int code = 0;
+		int index = 0;
+		for(int length = 1; length <= FastBits; length++)
+		{
+			for(int i = 0; i < huffman.counts[length]; i++)
+			{
+				int reversed = 0;
+				for(int bit = 0; bit < length; bit++)
+					reversed |= ((code >> bit) & 1) << (length - 1 - bit);
+
+				uint16_t entry = (uint16_t) ((huffman.symbols[index] << 4) | length);
+				for(int slot = reversed; slot < (1 << FastBits); slot += 1 << length)
+					huffman.fast[slot] = entry;
+
+				code++;
+				index++;
+			}
+			code <<= 1;
+		}
+		return true;
+	}
+
+	// Returns the next symbol, or -1 for a code that doesn't exist
+	int DecodeSymbol(BitReader& reader, const Huffman& huffman)
+	{
+		uint32_t bits = reader.Peek(MaxCodeLength);
+		uint16_t entry = huffman.fast[bits & ((1 << FastBits) - 1)];
+		if(entry != 0)
+		{
+			reader.Consume(entry & 15);
+			return entry >> 4;
+		}
+
+		// Longer code, so walk the canonical code one bit at a time
+		int code = 0;
+		int first = 0;
+		int index = 0;
+		for(int length = 1; length <= MaxCodeLength; length++)
+		{
+			code |= (bits >> (length - 1)) & 1;
+			int count = huffman.counts[length];
+			if(code - first < count)
+			{
+				reader.Consume(length);
+				return huffman.symbols[index + code - first];
+			}
+			index += count;
+			first = (first + count) << 1;
+			code <<= 1;
+		}
+		return -1;
+	}
+
+	const uint16_t LengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	const uint8_t LengthExtraBits[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	const uint16_t DistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	const uint8_t DistanceExtraBits[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+	const uint8_t CodeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	void BuildFixedHuffman(Huffman& lengths, Huffman& distances)
+	{
+		uint8_t codeLengths[288];
+		memset(codeLengths, 8, 144);
+		memset(codeLengths + 144, 9, 112);
+		memset(codeLengths + 256, 7, 24);
+		memset(codeLengths + 280, 8, 8);
+		BuildHuffman(lengths, codeLengths, 288);
+
+		memset(codeLengths, 5, 30);
+		BuildHuffman(distances, codeLengths, 30);
+	}
+
+	bool ReadDynamicHuffman(BitReader& reader, Huffman& lengths, Huffman& distances)
+	{
+		int lengthCount = reader.Read(5) + 257;
+		int distanceCount = reader.Read(5) + 1;
+		int codeLengthCount = reader.Read(4) + 4;
+		if(lengthCount > 286 || distanceCount > 30)
+			return false;
+
+		// The code lengths are themselves Huffman coded
+		uint8_t codeLengthLengths[19] = {};
+		for(int i = 0; i < codeLengthCount; i++)
+			codeLengthLengths[CodeLengthOrder[i]] = (uint8_t) reader.Read(3);
+
+		Huffman codeLengthHuffman;
+		if(!BuildHuffman(codeLengthHuffman, codeLengthLengths, 19))
+			return false;
+
+		uint8_t codeLengths[286 + 30];
+		int count = 0;
+		while(count < lengthCount + distanceCount)
+		{
+			int symbol = DecodeSymbol(reader, codeLengthHuffman);
+			if(symbol < 0)
+				return false;
+
+			if(symbol < 16)
+			{
+				codeLengths[count++] = (uint8_t) symbol;
+				continue;
+			}
+
+			// Runs of the previous length (16) or of zeros (17, 18)
+			uint8_t value = 0;
+			int repeat;
+			if(symbol == 16)
+			{
+				if(count == 0)
+					return false;
+				value = codeLengths[count - 1];
+				repeat = 3 + reader.Read(2);
+			}
+			else if(symbol == 17)
+				repeat = 3 + reader.Read(3);
+			else
+				repeat = 11 + reader.Read(7);
+
+			if(count + repeat > lengthCount + distanceCount)
+				return false;
+			memset(codeLengths + count, value, repeat);
+			count += repeat;
+		}
+
+		// A block with no end-of-block code could never end
+		if(codeLengths[256] == 0)
+			return false;
+
+		return BuildHuffman(lengths, codeLengths, lengthCount) && BuildHuffman(distances, codeLengths + lengthCount, distanceCount);
+	}
+
+	bool InflateBlock(BitReader& reader, const Huffman& lengths, const Huffman& distances, uint8_t* output, size_t outputSize, size_t& written)
+	{
+		while(true)
+		{
+			int symbol = DecodeSymbol(reader, lengths);
+			if(symbol < 0)
+				return false;
+
+			// Literal byte
+			if(symbol < 256)
+			{
+				if(written >= outputSize)
+					return false;
+				output[written++] = (uint8_t) symbol;
+				continue;
+			}
+
+			// End of block
+			if(symbol == 256)
+				return true;
+
+			// Copy of earlier output (which may overlap what it's writing, so copy byte by byte)
+			symbol -= 257;
+			if(symbol >= 29)
+				return false;
+			size_t length = LengthBase[symbol] + reader.Read(LengthExtraBits[symbol]);
+
+			int distanceSymbol = DecodeSymbol(reader, distances);
+			if(distanceSymbol < 0 || distanceSymbol >= 30)
+				return false;
+			size_t distance = DistanceBase[distanceSymbol] + reader.Read(DistanceExtraBits[distanceSymbol]);
+
+			if(distance > written || length > outputSize - written)
+				return false;
+			const uint8_t* from = output + written - distance;
+			uint8_t* to = output + written;
+			for(size_t i = 0; i < length; i++)
+				to[i] = from[i];
+			written += length;
+		}
+	}
+
+	uint32_t Adler32(const uint8_t* data, size_t size)
+	{
+		uint32_t a = 1;
+		uint32_t b = 0;
+		while(size > 0)
+		{
+			// Largest run that can't overflow before the modulo
+			size_t run = size < 5552 ? size : 5552;
+			for(size_t i = 0; i < run; i++)
+			{
+				a += data[i];
+				b += a;
+			}
+			a %= 65521;
+			b %= 65521;
+			data += run;
+			size -= run;
+		}
+		return (b << 16) | a;
+	}
+
+	// Decompresses a zlib stream that must fill exactly outputSize bytes
+	bool ZlibInflate(const uint8_t* data, size_t size, uint8_t* output, size_t outputSize)
+	{
+		// Header: DEFLATE with a window of at most 32 KB, a valid check value and no preset dictionary
+		if(size < 6)
+			return false;
+		uint8_t method = data[0];
+		uint8_t flags = data[1];
+		if((method & 15) != 8 || (method >> 4) > 7 || (method * 256 + flags) % 31 != 0 || (flags & 32) != 0)
+			return false;
+
+		BitReader reader(data + 2, size - 2);
+		Huffman lengths;
+		Huffman distances;
+		size_t written = 0;
+
+		bool isFinalBlock = false;
+		while(!isFinalBlock)
+		{
+			isFinalBlock = reader.Read(1) != 0;
+			uint32_t blockType = reader.Read(2);
+
+			if(blockType == 0)
+			{
+				// Stored (uncompressed) block
+				reader.AlignToByte();
+				uint32_t length = reader.Read(16);
+				uint32_t lengthComplement = reader.Read(16);
+				if((length ^ 0xFFFF) != lengthComplement || length > outputSize - written)
+					return false;
+				for(uint32_t i = 0; i < length; i++)
+					output[written++] = (uint8_t) reader.Read(8);
+			}
+			else if(blockType == 1)
+			{
+				BuildFixedHuffman(lengths, distances);
+				if(!InflateBlock(reader, lengths, distances, output, outputSize, written))
+					return false;
+			}
+			else if(blockType == 2)
+			{
+				if(!ReadDynamicHuffman(reader, lengths, distances) ||
+					!InflateBlock(reader, lengths, distances, output, outputSize, written))
+					return false;
+			}
+			else
+				return false;
+
+			if(reader.IsOverrun())
+				return false;
+		}
+
+		// Big-endian Adler-32 of the decompressed data, starting on a byte boundary
+		reader.AlignToByte();
+		uint32_t checksum = 0;
+		for(int i = 0; i < 4; i++)
+			checksum = (checksum << 8) | reader.Read(8);
+
+		return !reader.IsOverrun() && written == outputSize && checksum == Adler32(output, outputSize);
+	}
+
+	/* PNG structure */
+
+	const uint8_t PngSignature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+	enum PngColorType
+	{
+		Gray = 0,
+		RGB = 2,
+		Palette = 3,
+		GrayAlpha = 4,
+		RGBA = 6
+	};
+
+	uint32_t ReadBigEndian(const uint8_t* bytes)
+	{
+		return ((uint32_t) bytes[0] << 24) | ((uint32_t) bytes[1] << 16) | ((uint32_t) bytes[2] << 8) | bytes[3];
+	}
+
+	// Samples per pixel, or 0 for an invalid color type and bit depth pairing
+	unsigned int GetSampleCount(uint8_t colorType, uint8_t bitDepth)
+	{
+		switch(colorType)
+		{
+		case Gray: return (bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8 || bitDepth == 16) ? 1 : 0;
+		case RGB: return (bitDepth == 8 || bitDepth == 16) ? 3 : 0;
+		case Palette: return (bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8) ? 1 : 0;
+		case GrayAlpha: return (bitDepth == 8 || bitDepth == 16) ? 2 : 0;
+		case RGBA: return (bitDepth == 8 || bitDepth == 16) ? 4 : 0;
+		default: return 0;
+		}
+	}
+
+	uint8_t PaethPredictor(uint8_t left, uint8_t up, uint8_t upLeft)
+	{
+		int estimate = left + up - upLeft;
+		int leftDistance = estimate > left ? estimate - left : left - estimate;
+		int upDistance = estimate > up ? estimate - up : up - estimate;
+		int upLeftDistance = estimate > upLeft ? estimate - upLeft : upLeft - estimate;
+		if(leftDistance <= upDistance && leftDistance <= upLeftDistance)
+			return left;
+		return upDistance <= upLeftDistance ? up : upLeft;
+	}
+
+	// Undoes the filter of every row, in place (each row starts with its filter type byte)
+	// - Filters predict each byte from the pixel to the left and the row above, pixelBytes apart
+	bool Unfilter(uint8_t* data, size_t rowBytes, unsigned int height, size_t pixelBytes)
+	{
+		std::vector<uint8_t> zeroRow(rowBytes, 0);
+		const uint8_t* previous = zeroRow.data();
+		for(unsigned int y = 0; y < height; y++)
+		{
+			uint8_t filter = data[y * (rowBytes + 1)];
+			uint8_t* row = data + y * (rowBytes + 1) + 1;
+
+			switch(filter)
+			{
+			case 0: // None
+				break;
+			case 1: // Sub
+				for(size_t i = pixelBytes; i < rowBytes; i++)
+					row[i] += row[i - pixelBytes];
+				break;
+			case 2: // Up
+				for(size_t i = 0; i < rowBytes; i++)
+					row[i] += previous[i];
+				break;
+			case 3: // Average
+				for(size_t i = 0; i < rowBytes; i++)
+					row[i] += (uint8_t) (((i >= pixelBytes ? row[i - pixelBytes] : 0) + previous[i]) / 2);
+				break;
+			case 4: // Paeth
+				for(size_t i = 0; i < rowBytes; i++)
+				{
+					uint8_t left = i >= pixelBytes ? row[i - pixelBytes] : 0;
+					uint8_t upLeft = i >= pixelBytes ? previous[i - pixelBytes] : 0;
+					row[i] += PaethPredictor(left, previous[i], upLeft);
+				}
+				break;
+			default:
+				return false;
+			}
+			previous = row;
+		}
+		return true;
+	}
+
+	// Raw value of sample "index" in a row (full 16 bits for 16-bit images)
+	uint32_t GetSample(const uint8_t* row, size_t index, uint8_t bitDepth)
+	{
+		if(bitDepth == 8)
+			return row[index];
+		if(bitDepth == 16)
+			return (row[index * 2] << 8) | row[index * 2 + 1];
+
+		size_t bit = index * bitDepth;
+		return (row[bit / 8] >> (8 - bitDepth - bit % 8)) & ((1 << bitDepth) - 1);
+	}
+
+	// Scales a raw sample to the 0-255 range
+	uint8_t To8Bit(uint32_t sample, uint8_t bitDepth)
+	{
+		if(bitDepth == 16)
+			return (uint8_t) (sample >> 8);
+		return (uint8_t) (sample * 255 / ((1 << bitDepth) - 1));
+	}
+}
+
+bool DecodePng(const uint8_t* data, size_t size, Image& image)
+{
+	if(size < sizeof(PngSignature) || memcmp(data, PngSignature, sizeof(PngSignature)) != 0)
+		return false;
+
+	/* Gather the chunks we care about */
+
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint8_t bitDepth = 0;
+	uint8_t colorType = 0;
+	bool hasHeader = false;
+	bool isSRGB = false;
+
+	uint8_t palette[256][4] = {};
+	uint32_t paletteSize = 0;
+	bool hasTransparency = false;
+	uint32_t transparentColor[3] = {}; // Gray/RGB images' fully transparent color (in raw sample values)
+
+	std::vector<uint8_t> compressed;
+
+	size_t position = sizeof(PngSignature);
+	while(true)
+	{
+		if(size - position < 12)
+			return false;
+		uint32_t length = ReadBigEndian(data + position);
+		const uint8_t* type = data + position + 4;
+		const uint8_t* chunk = data + position + 8;
+		if(length > size - position - 12)
+			return false;
+
+		if(memcmp(type, "IHDR", 4) == 0)
+		{
+			if(length != 13)
+				return false;
+			width = ReadBigEndian(chunk);
+			height = ReadBigEndian(chunk + 4);
+			bitDepth = chunk[8];
+			colorType = chunk[9];
+			uint8_t interlace = chunk[12];
+
+			// Compression and filter methods only have one valid value
+			if(width == 0 || height == 0 || width > (1 << 16) || height > (1 << 16) ||
+				GetSampleCount(colorType, bitDepth) == 0 || chunk[10] != 0 || chunk[11] != 0 || interlace != 0)
+				return false;
+			hasHeader = true;
+		}
+		else if(!hasHeader)
+			return false; // IHDR must come first
+		else if(memcmp(type, "PLTE", 4) == 0)
+		{
+			if(length % 3 != 0 || length / 3 > 256)
+				return false;
+			paletteSize = length / 3;
+			for(uint32_t i = 0; i < paletteSize; i++)
+			{
+				palette[i][0] = chunk[i * 3];
+				palette[i][1] = chunk[i * 3 + 1];
+				palette[i][2] = chunk[i * 3 + 2];
+				palette[i][3] = 255;
+			}
+		}
+		else if(memcmp(type, "tRNS", 4) == 0)
+		{
+			// Alpha per palette entry, or a single color key
+			if(colorType == Palette)
+			{
+				for(uint32_t i = 0; i < length && i < 256; i++)
+					palette[i][3] = chunk[i];
+			}
+			else if(colorType == Gray && length >= 2)
+				transparentColor[0] = (chunk[0] << 8) | chunk[1];
+			else if(colorType == RGB && length >= 6)
+			{
+				for(int i = 0; i < 3; i++)
+					transparentColor[i] = (chunk[i * 2] << 8) | chunk[i * 2 + 1];
+			}
+			hasTransparency = colorType == Palette || colorType == Gray || colorType == RGB;
+		}
+		else if(memcmp(type, "sRGB", 4) == 0)
+			isSRGB = true;
+		else if(memcmp(type, "IDAT", 4) == 0)
+			compressed.insert(compressed.end(), chunk, chunk + length);
+		else if(memcmp(type, "IEND", 4) == 0)
+			break;
+
+		position += 12 + (size_t) length;
+	}
+
+	if(!hasHeader || compressed.empty() || (colorType == Palette && paletteSize == 0))
+		return false;
+
+	/* Decompress and unfilter */
+
+	unsigned int sampleCount = GetSampleCount(colorType, bitDepth);
+	size_t rowBytes = ((size_t) width * sampleCount * bitDepth + 7) / 8;
+	size_t pixelBytes = (sampleCount * bitDepth + 7) / 8;
+
+	std::vector<uint8_t> filtered((rowBytes + 1) * height);
+	if(!ZlibInflate(compressed.data(), compressed.size(), filtered.data(), filtered.size()) ||
+		!Unfilter(filtered.data(), rowBytes, height, pixelBytes))
+		return false;
+
+	/* Expand to 8-bit gray or RGBA */
+
+	image.width = width;
+	image.height = height;
+	image.channels = (colorType == Gray && !hasTransparency) ? 1 : 4;
+	image.isSRGB = isSRGB;
+	image.pixels.resize((size_t) width * height * image.channels);
+
+	for(uint32_t y = 0; y < height; y++)
+	{
+		const uint8_t* row = filtered.data() + y * (rowBytes + 1) + 1;
+		uint8_t* out = image.pixels.data() + (size_t) y * width * image.channels;
+
+		// The common 8-bit layouts are straight copies
+		if(bitDepth == 8 && (colorType == RGBA || (colorType == Gray && image.channels == 1)))
+		{
+			memcpy(out, row, rowBytes);
+			continue;
+		}
+		if(bitDepth == 8 && colorType == RGB && !hasTransparency)
+		{
+			for(uint32_t x = 0; x < width; x++)
+			{
+				out[x * 4] = row[x * 3];
+				out[x * 4 + 1] = row[x * 3 + 1];
+				out[x * 4 + 2] = row[x * 3 + 2];
+				out[x * 4 + 3] = 255;
+			}
+			continue;
+		}
+
+		for(uint32_t x = 0; x < width; x++)
+		{
+			size_t sample = (size_t) x * sampleCount;
+			uint8_t* pixel = out + (size_t) x * image.channels;
+			switch(colorType)
+			{
+			case Gray:
+			{
+				uint32_t gray = GetSample(row, sample, bitDepth);
+				pixel[0] = To8Bit(gray, bitDepth);
+				if(image.channels == 4)
+				{
+					pixel[1] = pixel[2] = pixel[0];
+					pixel[3] = (hasTransparency && gray == transparentColor[0]) ? 0 : 255;
+				}
+				break;
+			}
+			case RGB:
+			{
+				uint32_t red = GetSample(row, sample, bitDepth);
+				uint32_t green = GetSample(row, sample + 1, bitDepth);
+				uint32_t blue = GetSample(row, sample + 2, bitDepth);
+				pixel[0] = To8Bit(red, bitDepth);
+				pixel[1] = To8Bit(green, bitDepth);
+				pixel[2] = To8Bit(blue, bitDepth);
+				pixel[3] = (hasTransparency && red == transparentColor[0] && green == transparentColor[1] && blue == transparentColor[2]) ? 0 : 255;
+				break;
+			}
+			case Palette:
+			{
+				uint32_t index = GetSample(row, sample, bitDepth);
+				if(index >= paletteSize)
+					return false;
+				memcpy(pixel, palette[index], 4);
+				break;
+			}
+			case GrayAlpha:
+				pixel[0] = pixel[1] = pixel[2] = To8Bit(GetSample(row, sample, bitDepth), bitDepth);
+				pixel[3] = To8Bit(GetSample(row, sample + 1, bitDepth), bitDepth);
+				break;
+			case RGBA:
+				for(int channel = 0; channel < 4; channel++)
+					pixel[channel] = To8Bit(GetSample(row, sample + channel, bitDepth), bitDepth);
+				break;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool LoadPng(const wchar_t* filePath, Image& image)
+{
+	MappedFile file(filePath);
+	if(!file.IsOpen())
+		return false;
+
+	return DecodePng((const uint8_t*) file.GetData(), file.GetSize(), image);
+}
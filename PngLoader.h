@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Image.h"
+
+// --------------------------------------------------------
+// Decodes .PNG files without WIC, so textures can be loaded
+// on any thread (and any platform)
+// - Handles every non-interlaced color type and bit depth,
+//   including palettes and tRNS transparency
+// - 16-bit channels keep their high byte
+// - Adam7 interlaced files are rejected
+// --------------------------------------------------------
+bool DecodePng(const uint8_t* data, size_t size, Image& image);
+
+// Memory maps the file and decodes it with DecodePng()
+// - Returns false if the file couldn't be opened or decoded
+bool LoadPng(const wchar_t* filePath, Image& image);
@@ -0,0 +1,110 @@
+#include "RenderQueue.h"
+
+namespace
+{
+	const unsigned int DepthShift = 0;
+	const unsigned int MeshShift = DepthShift + SortKeyDepthBits;
+	const unsigned int MaterialShift = MeshShift + SortKeyMeshBits;
+	const unsigned int ShaderShift = MaterialShift + SortKeyMaterialBits;
+	const unsigned int PassShift = ShaderShift + SortKeyShaderBits;
+
+	uint64_t Field(uint32_t value, unsigned int bits, unsigned int shift)
+	{
+		return ((uint64_t) value & ((1ull << bits) - 1)) << shift;
+	}
+	uint32_t GetField(uint64_t key, unsigned int bits, unsigned int shift)
+	{
+		return (uint32_t) ((key >> shift) & ((1ull << bits) - 1));
+	}
+}
+
+uint64_t MakeSortKey(uint32_t pass, uint32_t shader, uint32_t material, uint32_t mesh, float depth)
+{
+	depth = depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+	uint32_t quantizedDepth = (uint32_t) (depth * ((1u << SortKeyDepthBits) - 1));
+	return Field(pass, SortKeyPassBits, PassShift) | Field(shader, SortKeyShaderBits, ShaderShift) |
+		Field(material, SortKeyMaterialBits, MaterialShift) | Field(mesh, SortKeyMeshBits, MeshShift) |
+		Field(quantizedDepth, SortKeyDepthBits, DepthShift);
+}
+uint32_t GetSortKeyPass(uint64_t key) { return GetField(key, SortKeyPassBits, PassShift); }
+uint32_t GetSortKeyShader(uint64_t key) { return GetField(key, SortKeyShaderBits, ShaderShift); }
+uint32_t GetSortKeyMaterial(uint64_t key) { return GetField(key, SortKeyMaterialBits, MaterialShift); }
+uint32_t GetSortKeyMesh(uint64_t key) { return GetField(key, SortKeyMeshBits, MeshShift); }
+uint64_t GetSortKeyState(uint64_t key) { return key >> MeshShift << MeshShift; }
+
+void RenderQueue::Sort()
+{
+	size_t count = items.size();
+	if(count < 2)
+		return;
+
+	// Every byte's histogram in one pass over the keys
+	std::vector<size_t> histograms(8 * 256, 0);
+	for(const RenderItem& item : items)
+	{
+		for(int byte = 0; byte < 8; byte++)
+			histograms[byte * 256 + ((item.key >> (byte * 8)) & 0xFF)]++;
+	}
+
+	sortScratch.resize(count);
+	for(int byte = 0; byte < 8; byte++)
+	{
+		size_t* histogram = &histograms[byte * 256];
+
+		// Every key has the same value in this byte, so it can't change the order
+		if(histogram[(items[0].key >> (byte * 8)) & 0xFF] == count)
+			continue;
+
+		size_t offset = 0;
+		for(int digit = 0; digit < 256; digit++)
+		{
+			size_t digitCount = histogram[digit];
+			histogram[digit] = offset;
+			offset += digitCount;
+		}
+		for(const RenderItem& item : items)
+			sortScratch[histogram[(item.key >> (byte * 8)) & 0xFF]++] = item;
+		items.swap(sortScratch);
+	}
+}
+
+RenderQueueStatistics RenderQueue::Submit(RenderQueueBackend& backend)
+{
+	RenderQueueStatistics statistics = {};
+	for(size_t i = 0; i < items.size(); i++)
+	{
+		const RenderItem& item = items[i];
+		bool isFirst = i == 0;
+		uint64_t previous = isFirst ? 0 : items[i - 1].key;
+
+		// Anything bigger changing means everything under it has to be bound again
+		bool isNewPass = isFirst || GetSortKeyPass(item.key) != GetSortKeyPass(previous);
+		bool isNewShader = isNewPass || GetSortKeyShader(item.key) != GetSortKeyShader(previous);
+		bool isNewMaterial = isNewShader || GetSortKeyMaterial(item.key) != GetSortKeyMaterial(previous);
+		bool isNewMesh = isNewPass || GetSortKeyMesh(item.key) != GetSortKeyMesh(previous);
+
+		if(isNewPass)
+		{
+			backend.BindPass(item);
+			statistics.passBinds++;
+		}
+		if(isNewShader)
+		{
+			backend.BindShader(item);
+			statistics.shaderBinds++;
+		}
+		if(isNewMaterial)
+		{
+			backend.BindMaterial(item);
+			statistics.materialBinds++;
+		}
+		if(isNewMesh)
+		{
+			backend.BindMesh(item);
+			statistics.meshBinds++;
+		}
+		backend.Draw(item);
+		statistics.drawCount++;
+	}
+	return statistics;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// --------------------------------------------------------
+// 64-bit draw sort keys, from the most significant bit down:
+// pass (4 bits) | shader (10) | material (12) | mesh (14) |
+// depth (24)
+// - Sorting by key groups draws by pass, then by shader,
+//   material and mesh (so each changes as rarely as it can),
+//   and finally front to back
+// - Ids are masked to their field's width; depth is 0 to 1
+//   (e.g. distance over the far plane's), clamped
+// --------------------------------------------------------
+const unsigned int SortKeyPassBits = 4;
+const unsigned int SortKeyShaderBits = 10;
+const unsigned int SortKeyMaterialBits = 12;
+const unsigned int SortKeyMeshBits = 14;
+const unsigned int SortKeyDepthBits = 24;
+
+uint64_t MakeSortKey(uint32_t pass, uint32_t shader, uint32_t material, uint32_t mesh, float depth);
+uint32_t GetSortKeyPass(uint64_t key);
+uint32_t GetSortKeyShader(uint64_t key);
+uint32_t GetSortKeyMaterial(uint64_t key);
+uint32_t GetSortKeyMesh(uint64_t key);
+// Everything but depth: keys with the same state bind exactly the same things
+uint64_t GetSortKeyState(uint64_t key);
+
+// One draw: its key, and whatever the backend needs to find what to draw (e.g. an entity's index)
+struct RenderItem
+{
+	uint64_t key;
+	uint32_t object;
+};
+
+// --------------------------------------------------------
+// Whatever actually sets state and draws - the queue only
+// decides when
+// - Each Bind call gets the first item that needs that state
+// - A new pass rebinds everything, and a new shader rebinds
+//   the material (since materials set the shader's inputs)
+// --------------------------------------------------------
+class RenderQueueBackend
+{
+public:
+	virtual ~RenderQueueBackend() {}
+
+	virtual void BindPass(const RenderItem& item) = 0;
+	virtual void BindShader(const RenderItem& item) = 0;
+	virtual void BindMaterial(const RenderItem& item) = 0;
+	virtual void BindMesh(const RenderItem& item) = 0;
+	virtual void Draw(const RenderItem& item) = 0;
+};
+
+// State changes (and draws) from one Submit()
+struct RenderQueueStatistics
+{
+	size_t drawCount;
+	size_t passBinds;
+	size_t shaderBinds;
+	size_t materialBinds;
+	size_t meshBinds;
+};
+
+// --------------------------------------------------------
+// A frame's draws, sorted by key before being submitted
+// - Sort() is an LSD radix sort, a byte at a time, skipping
+//   bytes every key shares (often the upper pass and shader
+//   bits); it's stable, so equal keys keep the order added
+// --------------------------------------------------------
+class RenderQueue
+{
+private:
+	std::vector<RenderItem> items;
+	std::vector<RenderItem> sortScratch;
+
+public:
+	void Clear() { items.clear(); };
+	void Add(uint64_t key, uint32_t object) { items.push_back({ key, object }); };
+	void Sort();
+
+	// Draws every item in order, binding only the state that differs from the item before
+	RenderQueueStatistics Submit(RenderQueueBackend& backend);
+
+	const std::vector<RenderItem>& GetItems() { return items; };
+};
@@ -0,0 +1,147 @@
+#include "ShaderStateCache.h"
+
+#include <memory>
+#include <unordered_map>
+
+namespace
+{
+	// Recorded for slots whose binding isn't known (no real object can have this address)
+	const void* const Unknown = reinterpret_cast<const void*>(~(uintptr_t) 0);
+}
+
+ShaderStateCache::ShaderStateCache()
+{
+	Invalidate();
+}
+
+ShaderStateCache& ShaderStateCache::ForContext(const void* context)
+{
+	static std::unordered_map<const void*, std::unique_ptr<ShaderStateCache>> caches;
+	std::unique_ptr<ShaderStateCache>& cache = caches[context];
+	if(!cache)
+		cache = std::make_unique<ShaderStateCache>();
+	return *cache;
+}
+
+bool ShaderStateCache::Set(const void*& bound, const void* value)
+{
+	if(isEnabled && bound == value)
+	{
+		statistics.hits++;
+		return false;
+	}
+	bound = value;
+	statistics.misses++;
+	return true;
+}
+
+bool ShaderStateCache::SetShader(ShaderStage stage, const void* shader)
+{
+	return Set(stages[(int) stage].shader, shader);
+}
+bool ShaderStateCache::SetInputLayout(const void* layout)
+{
+	return Set(inputLayout, layout);
+}
+bool ShaderStateCache::SetConstantBuffer(ShaderStage stage, unsigned int slot, const void* buffer)
+{
+	if(slot >= ConstantBufferSlots)
+		return true;
+	return Set(stages[(int) stage].constantBuffers[slot], buffer);
+}
+bool ShaderStateCache::SetShaderResourceView(ShaderStage stage, unsigned int slot, const void* srv)
+{
+	if(slot >= ShaderResourceSlots)
+		return true;
+	return Set(stages[(int) stage].shaderResources[slot], srv);
+}
+bool ShaderStateCache::SetSampler(ShaderStage stage, unsigned int slot, const void* sampler)
+{
+	if(slot >= SamplerSlots)
+		return true;
+	return Set(stages[(int) stage].samplers[slot], sampler);
+}
+bool ShaderStateCache::SetUnorderedAccessView(ShaderStage stage, unsigned int slot, const void* uav, bool setsCounter)
+{
+	if(slot >= UnorderedAccessSlots)
+		return true;
+
+	const void*& bound = stages[(int) stage].unorderedAccessViews[slot];
+	if(setsCounter)
+	{
+		bound = uav;
+		statistics.misses++;
+		return true;
+	}
+	return Set(bound, uav);
+}
+
+bool ShaderStateCache::Unbind(const void** bound, unsigned int slotCount, unsigned int& firstSlot, unsigned int& count)
+{
+	unsigned int endSlot = firstSlot + count;
+	unsigned int firstBound = endSlot, endBound = firstSlot;
+	for(unsigned int slot = firstSlot; slot < endSlot && slot < slotCount; slot++)
+	{
+		if(!isEnabled || bound[slot] != nullptr)
+		{
+			if(firstBound == endSlot)
+				firstBound = slot;
+			endBound = slot + 1;
+		}
+		bound[slot] = nullptr;
+	}
+
+	// Slots past the tracked ones can't be filtered, so always stay in the range
+	if(endSlot > slotCount)
+	{
+		if(firstBound == endSlot)
+			firstBound = firstSlot > slotCount ? firstSlot : slotCount;
+		endBound = endSlot;
+	}
+
+	if(firstBound == endSlot)
+	{
+		statistics.hits++;
+		return false;
+	}
+	firstSlot = firstBound;
+	count = endBound - firstBound;
+	statistics.misses++;
+	return true;
+}
+bool ShaderStateCache::UnbindShaderResourceViews(ShaderStage stage, unsigned int& firstSlot, unsigned int& count)
+{
+	return Unbind(stages[(int) stage].shaderResources, ShaderResourceSlots, firstSlot, count);
+}
+bool ShaderStateCache::UnbindUnorderedAccessViews(ShaderStage stage, unsigned int& firstSlot, unsigned int& count)
+{
+	return Unbind(stages[(int) stage].unorderedAccessViews, UnorderedAccessSlots, firstSlot, count);
+}
+
+void ShaderStateCache::Invalidate()
+{
+	for(int stage = 0; stage < (int) ShaderStage::Count; stage++)
+		InvalidateStage((ShaderStage) stage);
+	inputLayout = Unknown;
+}
+void ShaderStateCache::InvalidateStage(ShaderStage stage)
+{
+	StageState& state = stages[(int) stage];
+	state.shader = Unknown;
+	for(const void*& buffer : state.constantBuffers)
+		buffer = Unknown;
+	for(const void*& srv : state.shaderResources)
+		srv = Unknown;
+	for(const void*& sampler : state.samplers)
+		sampler = Unknown;
+	for(const void*& uav : state.unorderedAccessViews)
+		uav = Unknown;
+
+	// The input layout goes with the vertex shader
+	if(stage == ShaderStage::Vertex)
+		inputLayout = Unknown;
+}
+void ShaderStateCache::InvalidateShader(ShaderStage stage)
+{
+	stages[(int) stage].shader = Unknown;
+}
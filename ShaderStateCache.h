@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// The pipeline stages SimpleShader can bind to
+enum class ShaderStage
+{
+	Vertex,
+	Pixel,
+	Domain,
+	Hull,
+	Geometry,
+	Compute,
+	Count
+};
+
+// Bind calls made since the last ResetStatistics(): hits are redundant ones that were dropped
+struct ShaderStateCacheStatistics
+{
+	size_t hits;
+	size_t misses;
+};
+
+// --------------------------------------------------------
+// A shadow copy of what's bound to a device context's shader
+// stages, so binding what's already there can be skipped
+// - Each Set*() records the new binding and returns whether
+//   it actually changed (and so still has to be made)
+// - Objects are only compared by address; a context keeps
+//   its bound objects alive, so an address can't be reused
+//   while it's still recorded as bound
+// - Anything bound without going through the cache (or
+//   unbound by Direct3D itself, i.e. an SRV whose resource
+//   is then bound as a render target or UAV) makes the copy
+//   wrong, so invalidate whatever that touched afterwards
+// --------------------------------------------------------
+class ShaderStateCache
+{
+public:
+	// Slots tracked per stage (matching Direct3D 11's limits); bindings past them are never filtered
+	static const unsigned int ConstantBufferSlots = 14;
+	static const unsigned int ShaderResourceSlots = 128;
+	static const unsigned int SamplerSlots = 16;
+	static const unsigned int UnorderedAccessSlots = 8;
+
+	// Turns filtering off (every call is made, and counted as a miss) to compare against
+	static inline bool isEnabled = true;
+
+private:
+	struct StageState
+	{
+		const void* shader;
+		const void* constantBuffers[ConstantBufferSlots];
+		const void* shaderResources[ShaderResourceSlots];
+		const void* samplers[SamplerSlots];
+		const void* unorderedAccessViews[UnorderedAccessSlots];
+	};
+	StageState stages[(int) ShaderStage::Count];
+	const void* inputLayout;
+
+	ShaderStateCacheStatistics statistics = {};
+
+	bool Set(const void*& bound, const void* value);
+	bool Unbind(const void** bound, unsigned int slotCount, unsigned int& firstSlot, unsigned int& count);
+
+public:
+	ShaderStateCache();
+
+	// The cache for one device context, created the first time it's asked for
+	static ShaderStateCache& ForContext(const void* context);
+
+	bool SetShader(ShaderStage stage, const void* shader);
+	bool SetInputLayout(const void* layout);
+	bool SetConstantBuffer(ShaderStage stage, unsigned int slot, const void* buffer);
+	bool SetShaderResourceView(ShaderStage stage, unsigned int slot, const void* srv);
+	bool SetSampler(ShaderStage stage, unsigned int slot, const void* sampler);
+	// Setting an append/consume counter always has to be done, even for the same UAV
+	bool SetUnorderedAccessView(ShaderStage stage, unsigned int slot, const void* uav, bool setsCounter);
+
+	// Unbinding a range of slots at once: records them all as empty, and narrows the range down to the
+	// slots that weren't already (false when that's none of them, and there's nothing to unbind)
+	bool UnbindShaderResourceViews(ShaderStage stage, unsigned int& firstSlot, unsigned int& count);
+	bool UnbindUnorderedAccessViews(ShaderStage stage, unsigned int& firstSlot, unsigned int& count);
+
+	// Forgets what's bound (everywhere, to one stage, or just a stage's shader), so the next bind of
+	// each slot is always made
+	void Invalidate();
+	void InvalidateStage(ShaderStage stage);
+	void InvalidateShader(ShaderStage stage);
+
+	const ShaderStateCacheStatistics& GetStatistics() { return statistics; };
+	void ResetStatistics() { statistics = {}; };
+};
@@ -33,6 +33,46 @@ struct VertexShaderInput
 	float2 uv				: TEXCOORD;
 };
 
+// Compressed version of VertexShaderInput
+// - This should match the PackedVertex struct in our C++ code
+// - Formats come from the input layout, so everything arrives already
+//   converted to floats (UNORM to 0-1, SNORM to -1-1, halves to floats)
+struct PackedVertexShaderInput
+{
+	float4 localPosition	: POSITION;     // XYZ position within the mesh's bounds, W is the bitangent sign (0 is -1, 1 is +1)
+	float2 normal			: NORMAL;       // Octahedral-encoded
+    float2 tangent          : TANGENT;      // Octahedral-encoded
+	float2 uv				: TEXCOORD;
+};
+
+// Turns an octahedral-encoded direction back into a unit vector
+// (mirrors DecodeOctahedral() in VertexPacking.cpp)
+float3 DecodeOctahedral(float2 encoded)
+{
+    float3 direction = float3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+    float fold = saturate(-direction.z);
+    direction.xy += direction.xy >= 0.0f ? -fold : fold;
+    return normalize(direction);
+}
+
+// Expands a packed vertex to the regular vertex format
+// - positionOffset/positionScale are the mesh's VertexQuantization
+VertexShaderInput UnpackVertex(PackedVertexShaderInput input, float3 positionOffset, float3 positionScale)
+{
+    VertexShaderInput output;
+    output.localPosition = positionOffset + input.localPosition.xyz * positionScale;
+    output.normal = DecodeOctahedral(input.normal);
+    output.tangent = DecodeOctahedral(input.tangent);
+    output.uv = input.uv;
+    return output;
+}
+
+// +1, or -1 where the mesh's uvs are mirrored (see CalculateBitangentSigns())
+float UnpackBitangentSign(PackedVertexShaderInput input)
+{
+    return input.localPosition.w * 2.0f - 1.0f;
+}
+
 // Struct representing the data we're sending down the pipeline
 // - Should match our pixel shader's input (hence the name: Vertex to Pixel)
 // - At a minimum, we need a piece of data defined tagged as SV_POSITION
@@ -43,9 +83,18 @@ struct VertexToPixel
 	float4 screenPosition   	: SV_POSITION;
 	float3 normal   			: NORMAL;
     float3 tangent              : TANGENT;
+    nointerpolation float bitangentSign : BITANGENT_SIGN; // Flips cross(T, N) where uvs are mirrored
 	float2 uv   				: TEXCOORD;
 	float3 worldPosition    	: POSITION;
     float4 shadowMapPosition    : SHADOW_POSITION;
 };
 
+// One instance's matrices, for instanced draws
+// - This should match the InstanceData struct in our C++ code
+struct InstanceData
+{
+    matrix worldMatrix;
+    matrix worldInvTranspose;
+};
+
 #endif
\ No newline at end of file
@@ -11,6 +11,11 @@ bool ISimpleShader::ReportWarnings = false;
 // ISimpleShader::ReportErrors = true;
 // ISimpleShader::ReportWarnings = true;
 
+// Default buffer copying state
+bool ISimpleShader::SkipCleanBuffers = true;
+SimpleBufferCopyStats ISimpleShader::BufferCopyStats;
+std::unordered_map<std::string, SimpleConstantBuffer> ISimpleShader::sharedBuffers;
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // ------ BASE SIMPLE SHADER --------------------------------------------------
@@ -24,6 +29,7 @@ ISimpleShader::ISimpleShader(Microsoft::WRL::ComPtr<ID3D11Device> device, Micros
 	// Save the device
 	this->device = device;
 	this->deviceContext = context;
+	this->stateCache = &ShaderStateCache::ForContext(context.Get());
 
 	// Set up fields
 	this->constantBufferCount = 0;
@@ -188,6 +194,31 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		constantBuffers[b].Name = bufferDesc.Name;
 		cbTable.insert(std::pair<std::string, SimpleConstantBuffer*>(bufferDesc.Name, &constantBuffers[b]));
 
+		// Is this one of the shared buffers?  If so, just bind the shared
+		// one - its data is set through SetSharedBufferData() instead, so
+		// its variables are left out of this shader's variable table
+		std::unordered_map<std::string, SimpleConstantBuffer>::iterator shared =
+			sharedBuffers.find(bufferDesc.Name);
+		if (shared != sharedBuffers.end())
+		{
+			if (bufferDesc.Size <= shared->second.Size)
+			{
+				constantBuffers[b].IsShared = true;
+				constantBuffers[b].IsDirty = false;
+				constantBuffers[b].Size = bufferDesc.Size;
+				constantBuffers[b].ConstantBuffer = shared->second.ConstantBuffer;
+				continue;
+			}
+
+			// Nothing would ever fill a private copy, so the shader would silently read zeros; this is always
+			// reported (whatever ReportErrors says) and the shader isn't loaded
+			LogError("SimpleShader::LoadShaderFile() - Constant buffer '");
+			Log(bufferDesc.Name);
+			LogError("' is larger than the shared buffer of the same name. Ensure the shader and C++ definitions match.\n");
+			shaderValid = false;
+			return false;
+		}
+
 		// Create this constant buffer
 		D3D11_BUFFER_DESC newBuffDesc = {};
 		newBuffDesc.Usage = D3D11_USAGE_DEFAULT;
@@ -335,6 +366,28 @@ void ISimpleShader::SetShader()
 	SetShaderAndCBs();
 }
 
+// --------------------------------------------------------
+// Copies a constant buffer's local data to the GPU,
+// skipping it if none of the data has changed since
+// the last copy (the GPU copy is still the same then)
+//
+// cb - The buffer to copy
+//
+// NOTE: Constant buffers can't be partially updated with
+//       UpdateSubresource(), so a changed buffer is always
+//       copied in full
+// --------------------------------------------------------
+void ISimpleShader::CopyBufferIfDirty(ID3D11DeviceContext* context, SimpleConstantBuffer* cb)
+{
+	if (!ShouldCopyConstantBuffer(cb->IsDirty, cb->Size, SkipCleanBuffers, BufferCopyStats))
+		return;
+
+	// Copy the entire local data buffer
+	context->UpdateSubresource(
+		cb->ConstantBuffer.Get(), 0, 0,
+		cb->LocalDataBuffer, 0, 0);
+}
+
 // --------------------------------------------------------
 // Copies the relevant data to the all of this 
 // shader's constant buffers.  To just copy one
@@ -345,13 +398,12 @@ void ISimpleShader::CopyAllBufferData()
 	// Ensure the shader is valid
 	if (!shaderValid) return;
 
-	// Loop through the constant buffers and copy all data
+	// Loop through the constant buffers and copy any changed data
+	// (shared buffers are copied separately, once for every shader)
 	for (unsigned int i = 0; i < constantBufferCount; i++)
 	{
-		// Copy the entire local data buffer
-		deviceContext->UpdateSubresource(
-			constantBuffers[i].ConstantBuffer.Get(), 0, 0,
-			constantBuffers[i].LocalDataBuffer, 0, 0);
+		if (!constantBuffers[i].IsShared)
+			CopyBufferIfDirty(deviceContext.Get(), &constantBuffers[i]);
 	}
 }
 
@@ -377,12 +429,10 @@ void ISimpleShader::CopyBufferData(unsigned int index)
 
 	// Check for the buffer
 	SimpleConstantBuffer* cb = &this->constantBuffers[index];
-	if (!cb) return;
+	if (!cb || cb->IsShared) return;
 
 	// Copy the data and get out
-	deviceContext->UpdateSubresource(
-		cb->ConstantBuffer.Get(), 0, 0, 
-		cb->LocalDataBuffer, 0, 0);
+	CopyBufferIfDirty(deviceContext.Get(), cb);
 }
 
 // --------------------------------------------------------
@@ -399,12 +449,90 @@ void ISimpleShader::CopyBufferData(std::string bufferName)
 
 	// Check for the buffer
 	SimpleConstantBuffer* cb = this->FindConstantBuffer(bufferName);
-	if (!cb) return;
+	if (!cb || cb->IsShared) return;
 
 	// Copy the data and get out
-	deviceContext->UpdateSubresource(
-		cb->ConstantBuffer.Get(), 0, 0, 
-		cb->LocalDataBuffer, 0, 0);
+	CopyBufferIfDirty(deviceContext.Get(), cb);
+}
+
+// --------------------------------------------------------
+// Creates a constant buffer shared by every shader that
+// declares one with the same name.  Those shaders bind it
+// (at whichever register they declare it), but its data
+// is set and copied just once, for all of them
+//
+// device - The device used to create the buffer
+// name   - The name of the cbuffer in the shaders
+// size   - The size of its data, in bytes
+//
+// NOTE: Must be called before loading any shader that
+//       uses the buffer, or that shader gets its own
+// --------------------------------------------------------
+void ISimpleShader::CreateSharedBuffer(Microsoft::WRL::ComPtr<ID3D11Device> device, std::string name, unsigned int size)
+{
+	// Already created?
+	if (sharedBuffers.find(name) != sharedBuffers.end())
+		return;
+
+	SimpleConstantBuffer cb;
+	cb.Name = name;
+	cb.Size = size;
+	cb.IsShared = true;
+
+	D3D11_BUFFER_DESC newBuffDesc = {};
+	newBuffDesc.Usage = D3D11_USAGE_DEFAULT;
+	newBuffDesc.ByteWidth = ((size + 15) / 16) * 16;
+	newBuffDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	device->CreateBuffer(&newBuffDesc, 0, cb.ConstantBuffer.GetAddressOf());
+
+	cb.LocalDataBuffer = new unsigned char[size];
+	ZeroMemory(cb.LocalDataBuffer, size);
+
+	sharedBuffers.insert(std::pair<std::string, SimpleConstantBuffer>(name, cb));
+}
+
+// --------------------------------------------------------
+// Sets the start of a shared buffer's data (only marking
+// it to be copied if the data is actually different)
+//
+// name - The name of the shared buffer
+// data - The data to set in the buffer
+// size - The size of the data (this must be less than or equal to the buffer's size)
+//
+// Returns true if data is copied, false if the buffer doesn't exist or is too small
+// --------------------------------------------------------
+bool ISimpleShader::SetSharedBufferData(std::string name, const void* data, unsigned int size)
+{
+	std::unordered_map<std::string, SimpleConstantBuffer>::iterator shared =
+		sharedBuffers.find(name);
+	if (shared == sharedBuffers.end() || size > shared->second.Size)
+		return false;
+
+	SimpleConstantBuffer* cb = &shared->second;
+	SetConstantData(cb->LocalDataBuffer, cb->IsDirty, 0, data, size);
+	return true;
+}
+
+// --------------------------------------------------------
+// Copies every shared buffer with changed data to the GPU
+//
+// context - The context to copy with
+// --------------------------------------------------------
+void ISimpleShader::CopySharedBufferData(Microsoft::WRL::ComPtr<ID3D11DeviceContext> context)
+{
+	for (auto& shared : sharedBuffers)
+		CopyBufferIfDirty(context.Get(), &shared.second);
+}
+
+// --------------------------------------------------------
+// Releases all shared buffers (shaders already using them
+// keep their own references)
+// --------------------------------------------------------
+void ISimpleShader::ReleaseSharedBuffers()
+{
+	for (auto& shared : sharedBuffers)
+		delete[] shared.second.LocalDataBuffer;
+	sharedBuffers.clear();
 }
 
 
@@ -445,11 +573,10 @@ bool ISimpleShader::SetData(std::string name, const void* data, unsigned int siz
 		return false;
 	}
 
-	// Set the data in the local data buffer
-	memcpy(
-		constantBuffers[var->ConstantBufferIndex].LocalDataBuffer + var->ByteOffset,
-		data,
-		size);
+	// Set the data in the local data buffer, only dirtying
+	// the buffer if the data is actually different
+	SimpleConstantBuffer* cb = &constantBuffers[var->ConstantBufferIndex];
+	SetConstantData(cb->LocalDataBuffer, cb->IsDirty, var->ByteOffset, data, size);
 
 	// Success
 	return true;
@@ -869,8 +996,10 @@ void SimpleVertexShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 
 	// Set the shader and input layout
-	deviceContext->IASetInputLayout(inputLayout.Get());
-	deviceContext->VSSetShader(shader.Get(), 0, 0);
+	if (stateCache->SetInputLayout(inputLayout.Get()))
+		deviceContext->IASetInputLayout(inputLayout.Get());
+	if (stateCache->SetShader(ShaderStage::Vertex, shader.Get()))
+		deviceContext->VSSetShader(shader.Get(), 0, 0);
 
 	// Set the constant buffers
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -879,11 +1008,12 @@ void SimpleVertexShader::SetShaderAndCBs()
 		if (constantBuffers[i].Type != D3D11_CT_CBUFFER)
 			continue;
 
-		// This is a real constant buffer, so set it
-		deviceContext->VSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			constantBuffers[i].ConstantBuffer.GetAddressOf());
+		// This is a real constant buffer, so set it (unless it's already bound there)
+		if (stateCache->SetConstantBuffer(ShaderStage::Vertex, constantBuffers[i].BindIndex, constantBuffers[i].ConstantBuffer.Get()))
+			deviceContext->VSSetConstantBuffers(
+				constantBuffers[i].BindIndex,
+				1,
+				constantBuffers[i].ConstantBuffer.GetAddressOf());
 	}
 }
 
@@ -911,7 +1041,8 @@ bool SimpleVertexShader::SetShaderResourceView(std::string name, Microsoft::WRL:
 	}
 
 	// Set the shader resource view
-	deviceContext->VSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
+	if (stateCache->SetShaderResourceView(ShaderStage::Vertex, srvInfo->BindIndex, srv.Get()))
+		deviceContext->VSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
 
 	// Success
 	return true;
@@ -941,7 +1072,8 @@ bool SimpleVertexShader::SetSamplerState(std::string name, Microsoft::WRL::ComPt
 	}
 
 	// Set the shader resource view
-	deviceContext->VSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
+	if (stateCache->SetSampler(ShaderStage::Vertex, sampInfo->BindIndex, samplerState.Get()))
+		deviceContext->VSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
 
 	// Success
 	return true;
@@ -1012,7 +1144,8 @@ void SimplePixelShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 	
 	// Set the shader
-	deviceContext->PSSetShader(shader.Get(), 0, 0);
+	if (stateCache->SetShader(ShaderStage::Pixel, shader.Get()))
+		deviceContext->PSSetShader(shader.Get(), 0, 0);
 
 	// Set the constant buffers
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -1021,11 +1154,12 @@ void SimplePixelShader::SetShaderAndCBs()
 		if (constantBuffers[i].Type != D3D11_CT_CBUFFER)
 			continue;
 
-		// This is a real constant buffer, so set it
-		deviceContext->PSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			constantBuffers[i].ConstantBuffer.GetAddressOf());
+		// This is a real constant buffer, so set it (unless it's already bound there)
+		if (stateCache->SetConstantBuffer(ShaderStage::Pixel, constantBuffers[i].BindIndex, constantBuffers[i].ConstantBuffer.Get()))
+			deviceContext->PSSetConstantBuffers(
+				constantBuffers[i].BindIndex,
+				1,
+				constantBuffers[i].ConstantBuffer.GetAddressOf());
 	}
 }
 
@@ -1053,7 +1187,8 @@ bool SimplePixelShader::SetShaderResourceView(std::string name, Microsoft::WRL::
 	}
 
 	// Set the shader resource view
-	deviceContext->PSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
+	if (stateCache->SetShaderResourceView(ShaderStage::Pixel, srvInfo->BindIndex, srv.Get()))
+		deviceContext->PSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
 
 	// Success
 	return true;
@@ -1083,7 +1218,8 @@ bool SimplePixelShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr
 	}
 
 	// Set the shader resource view
-	deviceContext->PSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
+	if (stateCache->SetSampler(ShaderStage::Pixel, sampInfo->BindIndex, samplerState.Get()))
+		deviceContext->PSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
 
 	// Success
 	return true;
@@ -1156,7 +1292,8 @@ void SimpleDomainShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 
 	// Set the shader
-	deviceContext->DSSetShader(shader.Get(), 0, 0);
+	if (stateCache->SetShader(ShaderStage::Domain, shader.Get()))
+		deviceContext->DSSetShader(shader.Get(), 0, 0);
 
 	// Set the constant buffers
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -1165,11 +1302,12 @@ void SimpleDomainShader::SetShaderAndCBs()
 		if (constantBuffers[i].Type != D3D11_CT_CBUFFER)
 			continue;
 
-		// This is a real constant buffer, so set it
-		deviceContext->DSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			constantBuffers[i].ConstantBuffer.GetAddressOf());
+		// This is a real constant buffer, so set it (unless it's already bound there)
+		if (stateCache->SetConstantBuffer(ShaderStage::Domain, constantBuffers[i].BindIndex, constantBuffers[i].ConstantBuffer.Get()))
+			deviceContext->DSSetConstantBuffers(
+				constantBuffers[i].BindIndex,
+				1,
+				constantBuffers[i].ConstantBuffer.GetAddressOf());
 	}
 }
 
@@ -1197,7 +1335,8 @@ bool SimpleDomainShader::SetShaderResourceView(std::string name, Microsoft::WRL:
 	}
 
 	// Set the shader resource view
-	deviceContext->DSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
+	if (stateCache->SetShaderResourceView(ShaderStage::Domain, srvInfo->BindIndex, srv.Get()))
+		deviceContext->DSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
 
 	// Success
 	return true;
@@ -1227,7 +1366,8 @@ bool SimpleDomainShader::SetSamplerState(std::string name, Microsoft::WRL::ComPt
 	}
 
 	// Set the shader resource view
-	deviceContext->DSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
+	if (stateCache->SetSampler(ShaderStage::Domain, sampInfo->BindIndex, samplerState.Get()))
+		deviceContext->DSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
 
 	// Success
 	return true;
@@ -1299,7 +1439,8 @@ void SimpleHullShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 
 	// Set the shader
-	deviceContext->HSSetShader(shader.Get(), 0, 0);
+	if (stateCache->SetShader(ShaderStage::Hull, shader.Get()))
+		deviceContext->HSSetShader(shader.Get(), 0, 0);
 
 	// Set the constant buffers?
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -1308,11 +1449,12 @@ void SimpleHullShader::SetShaderAndCBs()
 		if (constantBuffers[i].Type != D3D11_CT_CBUFFER)
 			continue;
 
-		// This is a real constant buffer, so set it
-		deviceContext->HSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			constantBuffers[i].ConstantBuffer.GetAddressOf());
+		// This is a real constant buffer, so set it (unless it's already bound there)
+		if (stateCache->SetConstantBuffer(ShaderStage::Hull, constantBuffers[i].BindIndex, constantBuffers[i].ConstantBuffer.Get()))
+			deviceContext->HSSetConstantBuffers(
+				constantBuffers[i].BindIndex,
+				1,
+				constantBuffers[i].ConstantBuffer.GetAddressOf());
 	}
 }
 
@@ -1340,7 +1482,8 @@ bool SimpleHullShader::SetShaderResourceView(std::string name, Microsoft::WRL::C
 	}
 
 	// Set the shader resource view
-	deviceContext->HSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
+	if (stateCache->SetShaderResourceView(ShaderStage::Hull, srvInfo->BindIndex, srv.Get()))
+		deviceContext->HSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
 
 	// Success
 	return true;
@@ -1370,7 +1513,8 @@ bool SimpleHullShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<
 	}
 
 	// Set the shader resource view
-	deviceContext->HSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
+	if (stateCache->SetSampler(ShaderStage::Hull, sampInfo->BindIndex, samplerState.Get()))
+		deviceContext->HSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
 
 	// Success
 	return true;
@@ -1573,7 +1717,8 @@ void SimpleGeometryShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 
 	// Set the shader
-	deviceContext->GSSetShader(shader.Get(), 0, 0);
+	if (stateCache->SetShader(ShaderStage::Geometry, shader.Get()))
+		deviceContext->GSSetShader(shader.Get(), 0, 0);
 
 	// Set the constant buffers?
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -1582,11 +1727,12 @@ void SimpleGeometryShader::SetShaderAndCBs()
 		if (constantBuffers[i].Type != D3D11_CT_CBUFFER)
 			continue;
 
-		// This is a real constant buffer, so set it
-		deviceContext->GSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			constantBuffers[i].ConstantBuffer.GetAddressOf());
+		// This is a real constant buffer, so set it (unless it's already bound there)
+		if (stateCache->SetConstantBuffer(ShaderStage::Geometry, constantBuffers[i].BindIndex, constantBuffers[i].ConstantBuffer.Get()))
+			deviceContext->GSSetConstantBuffers(
+				constantBuffers[i].BindIndex,
+				1,
+				constantBuffers[i].ConstantBuffer.GetAddressOf());
 	}
 }
 
@@ -1614,7 +1760,8 @@ bool SimpleGeometryShader::SetShaderResourceView(std::string name, Microsoft::WR
 	}
 
 	// Set the shader resource view
-	deviceContext->GSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
+	if (stateCache->SetShaderResourceView(ShaderStage::Geometry, srvInfo->BindIndex, srv.Get()))
+		deviceContext->GSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
 
 	// Success
 	return true;
@@ -1644,7 +1791,8 @@ bool SimpleGeometryShader::SetSamplerState(std::string name, Microsoft::WRL::Com
 	}
 
 	// Set the shader resource view
-	deviceContext->GSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
+	if (stateCache->SetSampler(ShaderStage::Geometry, sampInfo->BindIndex, samplerState.Get()))
+		deviceContext->GSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
 
 	// Success
 	return true;
@@ -1783,7 +1931,8 @@ void SimpleComputeShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 
 	// Set the shader
-	deviceContext->CSSetShader(shader.Get(), 0, 0);
+	if (stateCache->SetShader(ShaderStage::Compute, shader.Get()))
+		deviceContext->CSSetShader(shader.Get(), 0, 0);
 
 	// Set the constant buffers?
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -1792,11 +1941,12 @@ void SimpleComputeShader::SetShaderAndCBs()
 		if (constantBuffers[i].Type != D3D11_CT_CBUFFER)
 			continue;
 
-		// This is a real constant buffer, so set it
-		deviceContext->CSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			constantBuffers[i].ConstantBuffer.GetAddressOf());
+		// This is a real constant buffer, so set it (unless it's already bound there)
+		if (stateCache->SetConstantBuffer(ShaderStage::Compute, constantBuffers[i].BindIndex, constantBuffers[i].ConstantBuffer.Get()))
+			deviceContext->CSSetConstantBuffers(
+				constantBuffers[i].BindIndex,
+				1,
+				constantBuffers[i].ConstantBuffer.GetAddressOf());
 	}
 }
 
@@ -1885,7 +2035,8 @@ bool SimpleComputeShader::SetShaderResourceView(std::string name, Microsoft::WRL
 	}
 
 	// Set the shader resource view
-	deviceContext->CSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
+	if (stateCache->SetShaderResourceView(ShaderStage::Compute, srvInfo->BindIndex, srv.Get()))
+		deviceContext->CSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
 
 	// Success
 	return true;
@@ -1915,7 +2066,8 @@ bool SimpleComputeShader::SetSamplerState(std::string name, Microsoft::WRL::ComP
 	}
 
 	// Set the shader resource view
-	deviceContext->CSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
+	if (stateCache->SetSampler(ShaderStage::Compute, sampInfo->BindIndex, samplerState.Get()))
+		deviceContext->CSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
 
 	// Success
 	return true;
@@ -1945,8 +2097,9 @@ bool SimpleComputeShader::SetUnorderedAccessView(std::string name, Microsoft::WR
 		return false;
 	}
 
-	// Set the shader resource view
-	deviceContext->CSSetUnorderedAccessViews(bindIndex, 1, uav.GetAddressOf(), &appendConsumeOffset);
+	// Set the unordered access view (always, when it also sets an append/consume counter)
+	if (stateCache->SetUnorderedAccessView(ShaderStage::Compute, bindIndex, uav.Get(), appendConsumeOffset != (unsigned int)-1))
+		deviceContext->CSSetUnorderedAccessViews(bindIndex, 1, uav.GetAddressOf(), &appendConsumeOffset);
 
 	// Success
 	return true;
@@ -11,6 +11,9 @@
 #include <vector>
 #include <string>
 
+#include "ConstantBufferData.h"
+#include "ShaderStateCache.h"
+
 
 // --------------------------------------------------------
 // Used by simple shaders to store information about
@@ -36,6 +39,8 @@ struct SimpleConstantBuffer
 	unsigned int BindIndex = 0;
 	Microsoft::WRL::ComPtr<ID3D11Buffer> ConstantBuffer = 0;
 	unsigned char* LocalDataBuffer = 0;
+	bool IsDirty = true; // Local data has changed since it was last copied to the GPU
+	bool IsShared = false; // One of the shared buffers (see ISimpleShader::CreateSharedBuffer), filled in outside the shader
 	std::vector<SimpleShaderVariable> Variables;
 };
 
@@ -122,12 +127,26 @@ public:
 	static bool ReportErrors;
 	static bool ReportWarnings;
 
+	// Copying only buffers whose data changed (turn off to always copy everything, to compare)
+	static bool SkipCleanBuffers;
+	static SimpleBufferCopyStats BufferCopyStats;
+
+	// Constant buffers shared by every shader that declares one with the same name
+	// (e.g. per-frame data), filled in and copied to the GPU once for all of them
+	// - Create them before loading shaders; a shader whose buffer is larger than the
+	//   shared one of the same name fails to load
+	static void CreateSharedBuffer(Microsoft::WRL::ComPtr<ID3D11Device> device, std::string name, unsigned int size);
+	static bool SetSharedBufferData(std::string name, const void* data, unsigned int size);
+	static void CopySharedBufferData(Microsoft::WRL::ComPtr<ID3D11DeviceContext> context);
+	static void ReleaseSharedBuffers();
+
 protected:
 	
 	bool shaderValid;
 	Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob;
 	Microsoft::WRL::ComPtr<ID3D11Device> device;
 	Microsoft::WRL::ComPtr<ID3D11DeviceContext> deviceContext;
+	ShaderStateCache* stateCache; // Shared by every shader on the same context, to skip redundant binds
 
 	// Resource counts
 	unsigned int constantBufferCount;
@@ -144,6 +163,12 @@ protected:
 	// Initialization method
 	bool LoadShaderFile(LPCWSTR shaderFile);
 
+	// Copies a buffer's local data to the GPU, unless it's unchanged since the last copy
+	static void CopyBufferIfDirty(ID3D11DeviceContext* context, SimpleConstantBuffer* cb);
+
+	// Shared buffers by name, which must be created before any shader that uses them is loaded
+	static std::unordered_map<std::string, SimpleConstantBuffer> sharedBuffers;
+
 	// Pure virtual functions for dealing with shader types
 	virtual bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob) = 0;
 	virtual void SetShaderAndCBs() = 0;
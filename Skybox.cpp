@@ -1,10 +1,11 @@
 #include "Skybox.h"
 #include "Graphics.h"
+#include "CubemapCooker.h"
 
 Skybox::Skybox(
 	std::shared_ptr<SimpleVertexShader> vertexShader, std::shared_ptr<SimplePixelShader> pixelShader, 
 	std::shared_ptr<Mesh> skyMesh, Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> cubeMapSRV) :
-	vertexShader(vertexShader), pixelShader(pixelShader), skyMesh(skyMesh), sampler(sampler), cubeMapSRV(cubeMapSRV)
+	vertexShader(vertexShader), pixelShader(pixelShader), skyMesh(skyMesh), sampler(sampler), cubeMapSRV(cubeMapSRV), irradianceSH()
 {
 	/* Create Rasterizer State */
 
@@ -50,4 +51,26 @@ void Skybox::Draw(std::shared_ptr<Camera> camera)
 	// Reset render states
 	Graphics::Context->RSSetState(nullptr);
 	Graphics::Context->OMSetDepthStencilState(nullptr, 0);
-}
\ No newline at end of file
+}
+
+void Skybox::SetIrradianceSH(const float coefficients[9][3])
+{
+	for(int i = 0; i < 9; i++)
+		irradianceSH[i] = DirectX::XMFLOAT3(coefficients[i][0], coefficients[i][1], coefficients[i][2]);
+}
+
+DirectX::XMFLOAT3 Skybox::GetIrradiance(DirectX::XMFLOAT3 direction)
+{
+	float coefficients[9][3];
+	for(int i = 0; i < 9; i++)
+	{
+		coefficients[i][0] = irradianceSH[i].x;
+		coefficients[i][1] = irradianceSH[i].y;
+		coefficients[i][2] = irradianceSH[i].z;
+	}
+
+	float normal[3] = { direction.x, direction.y, direction.z };
+	float irradiance[3];
+	EvaluateIrradianceSH(coefficients, normal, irradiance);
+	return DirectX::XMFLOAT3(irradiance[0], irradiance[1], irradiance[2]);
+}
@@ -2,6 +2,7 @@
 
 #include <d3d11.h>
 #include <wrl/client.h>
+#include <DirectXMath.h>
 #include <memory>
 
 #include "Mesh.h"
@@ -20,6 +21,9 @@ private:
 	std::shared_ptr<SimpleVertexShader> vertexShader;
 	std::shared_ptr<SimplePixelShader> pixelShader;
 
+	// Diffuse light from the whole sky, as SH (see CubemapCooker); black until the cube map is cooked
+	DirectX::XMFLOAT3 irradianceSH[9];
+
 public:
 	Skybox(
 		std::shared_ptr<SimpleVertexShader> vertexShader, std::shared_ptr<SimplePixelShader> pixelShader,
@@ -27,4 +31,12 @@ public:
 	~Skybox();
 
 	void Draw(std::shared_ptr<Camera> camera);
+
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> GetCubeMapSRV() { return cubeMapSRV; };
+	void SetCubeMapSRV(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> value) { cubeMapSRV = value; };
+	const DirectX::XMFLOAT3* GetIrradianceSH() { return irradianceSH; };
+	void SetIrradianceSH(const float coefficients[9][3]);
+
+	// Irradiance arriving at a surface facing the given (normalized) direction
+	DirectX::XMFLOAT3 GetIrradiance(DirectX::XMFLOAT3 direction);
 };
\ No newline at end of file
@@ -0,0 +1,216 @@
+#include "TestFramework.h"
+#include "AssetLoader.h"
+#include "CookedMesh.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+	const char* const TestTextures[] = {
+		"Textures/PBR/wood_albedo.png", "Textures/PBR/wood_normals.png", "Textures/PBR/wood_roughness.png", "Textures/PBR/bronze_albedo.png" };
+
+	TextureCookOptions GetCookOptions(const char* texture)
+	{
+		return { true, { strstr(texture, "_albedo") != nullptr, strstr(texture, "_normals") != nullptr }, BlockFormat::None };
+	}
+
+	// Meshes are cooked next to their source, so load copies rather than the real Assets folder's
+	std::vector<std::filesystem::path> CopyModels(const char* scratchName)
+	{
+		std::filesystem::path directory = MakeScratchDirectory(scratchName);
+		std::vector<std::filesystem::path> copies;
+		for(const auto& model : GetBundledModels())
+		{
+			copies.push_back(directory / model.filename());
+			std::filesystem::copy_file(model, copies.back());
+		}
+		return copies;
+	}
+
+	bool SameMips(const TextureData& a, const TextureData& b)
+	{
+		if(a.width != b.width || a.height != b.height || a.channels != b.channels || a.format != b.format ||
+			a.GetMipCount() != b.GetMipCount() || a.faceCount != b.faceCount)
+			return false;
+
+		for(size_t i = 0; i < a.mipPixels.size(); i++)
+		{
+			if(memcmp(a.mipPixels[i], b.mipPixels[i], a.GetMipSize((unsigned int) (i % a.GetMipCount()))) != 0)
+				return false;
+		}
+		return true;
+	}
+
+	template<typename T>
+	bool SameBytes(const std::vector<T>& a, const std::vector<T>& b)
+	{
+		return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+	}
+
+	bool SameMesh(const MeshData& a, const MeshData& b)
+	{
+		return a.name == b.name && SameBytes(a.vertices, b.vertices) && SameBytes(a.indices, b.indices) &&
+			SameBytes(a.meshlets, b.meshlets) && SameBytes(a.lods, b.lods);
+	}
+}
+
+// Loaded in the background with a stub in place of uploading, everything arrives once, on the
+// calling thread, exactly as loading it directly would have given it
+TEST(AssetLoader, MatchesSynchronousLoads)
+{
+	std::filesystem::path cache = MakeScratchDirectory("AssetLoaderCache");
+	std::vector<std::filesystem::path> models = CopyModels("AssetLoaderModels");
+
+	AssetLoader loader(2);
+	loader.SetTextureCacheDirectory(cache);
+	std::thread::id mainThread = std::this_thread::get_id();
+	size_t callbackCount = 0, wrongThreadCount = 0;
+
+	std::vector<AssetLoader::TextureFuture> textures;
+	std::vector<const TextureData*> uploadedTextures;
+	for(const char* texture : TestTextures)
+	{
+		textures.push_back(loader.LoadTexture(GetAssetPath(texture).wstring(), GetCookOptions(texture), [&](TextureData& data)
+			{
+				callbackCount++;
+				wrongThreadCount += std::this_thread::get_id() != mainThread;
+				uploadedTextures.push_back(&data);
+			}));
+	}
+	std::vector<AssetLoader::MeshFuture> meshes;
+	std::vector<const MeshData*> uploadedMeshes;
+	for(const auto& model : models)
+	{
+		meshes.push_back(loader.LoadMesh(model.wstring(), [&](MeshData& data)
+			{
+				callbackCount++;
+				wrongThreadCount += std::this_thread::get_id() != mainThread;
+				uploadedMeshes.push_back(&data);
+			}));
+	}
+	CHECK(loader.GetRequestedCount() == textures.size() + meshes.size());
+
+	loader.WaitForAll();
+	CHECK(loader.IsIdle());
+	CHECK(callbackCount == textures.size() + meshes.size());
+	CHECK(wrongThreadCount == 0);
+	CHECK(loader.GetLoadedCount() == callbackCount && loader.GetFailedCount() == 0);
+	CHECK(loader.GetAllLoadedMilliseconds() > 0.0);
+
+	for(size_t i = 0; i < textures.size(); i++)
+	{
+		std::shared_ptr<TextureData> loaded = textures[i].get();
+		CHECK(loaded != nullptr);
+		if(!loaded)
+			continue;
+		CHECK(std::find(uploadedTextures.begin(), uploadedTextures.end(), loaded.get()) != uploadedTextures.end());
+
+		TextureData expected;
+		CHECK(LoadTextureData(GetAssetPath(TestTextures[i]).wstring().c_str(), cache, GetCookOptions(TestTextures[i]), expected));
+		CHECK(SameMips(*loaded, expected));
+	}
+	for(size_t i = 0; i < meshes.size(); i++)
+	{
+		std::shared_ptr<MeshData> loaded = meshes[i].get();
+		CHECK(loaded != nullptr);
+		if(!loaded)
+			continue;
+		CHECK(std::find(uploadedMeshes.begin(), uploadedMeshes.end(), loaded.get()) != uploadedMeshes.end());
+
+		MeshData expected;
+		CHECK(LoadMeshData(models[i].wstring().c_str(), expected));
+		CHECK(SameMesh(*loaded, expected));
+	}
+}
+
+TEST(AssetLoader, UpdateLimitsCallbacks)
+{
+	std::vector<std::filesystem::path> models = CopyModels("AssetLoaderUpdate");
+	AssetLoader loader(2);
+	size_t callbackCount = 0;
+	std::vector<AssetLoader::MeshFuture> meshes;
+	for(const auto& model : models)
+		meshes.push_back(loader.LoadMesh(model.wstring(), [&](MeshData&) { callbackCount++; }));
+	for(const AssetLoader::MeshFuture& mesh : meshes)
+		mesh.wait();
+
+	// Everything's ready, but each Update() only finishes up to its limit
+	loader.Update(0);
+	CHECK(callbackCount == 0);
+	while(!loader.IsIdle())
+	{
+		size_t pendingCount = loader.GetPendingCount();
+		loader.Update(2);
+		CHECK(loader.GetPendingCount() == pendingCount - (pendingCount < 2 ? pendingCount : 2));
+	}
+	CHECK(callbackCount == models.size());
+	CHECK(loader.GetLoadedCount() == models.size());
+}
+
+TEST(AssetLoader, MissingFilesFail)
+{
+	std::filesystem::path directory = MakeScratchDirectory("AssetLoaderMissing");
+	AssetLoader loader(1);
+	loader.SetTextureCacheDirectory(directory / "Cache");
+	size_t callbackCount = 0;
+	AssetLoader::TextureFuture texture = loader.LoadTexture((directory / "missing.png").wstring(), GetCookOptions("missing.png"),
+		[&](TextureData&) { callbackCount++; });
+	AssetLoader::MeshFuture mesh = loader.LoadMesh((directory / "missing.obj").wstring(), [&](MeshData&) { callbackCount++; });
+	AssetLoader::MeshFuture found = loader.LoadMesh(CopyModels("AssetLoaderFound")[0].wstring(), nullptr);
+
+	loader.WaitForAll();
+	CHECK(texture.get() == nullptr);
+	CHECK(mesh.get() == nullptr);
+	CHECK(callbackCount == 0);
+	CHECK(loader.GetFailedCount() == 2);
+	CHECK(loader.GetLoadedCount() == 1);
+	CHECK(found.get() != nullptr);
+}
+
+BENCHMARK(AssetLoader, BackgroundVsDirect)
+{
+	// Loading on workers should beat loading one asset after another, on top of not blocking the caller
+	std::vector<std::filesystem::path> models = CopyModels("AssetLoaderBenchmark");
+	std::vector<std::wstring> textures;
+	for(const auto& entry : std::filesystem::directory_iterator(GetAssetPath("Textures/PBR")))
+		textures.push_back(entry.path().wstring());
+	TextureCookOptions options = GetCookOptions("");
+
+	auto uncook = [&]()
+	{
+		for(const auto& model : models)
+			std::filesystem::remove(CookedMesh::GetCookedPath(model.wstring().c_str()));
+	};
+	double directMilliseconds = MeasureMilliseconds([&]()
+		{
+			uncook();
+			for(const std::wstring& texture : textures)
+			{
+				TextureData data;
+				LoadTextureData(texture.c_str(), std::filesystem::path(), options, data);
+			}
+			for(const auto& model : models)
+			{
+				MeshData data;
+				LoadMeshData(model.wstring().c_str(), data);
+			}
+		}, 3);
+
+	unsigned int threadCount = std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() : 2;
+	double backgroundMilliseconds = MeasureMilliseconds([&]()
+		{
+			uncook();
+			AssetLoader loader(threadCount);
+			for(const std::wstring& texture : textures)
+				loader.LoadTexture(texture, options, nullptr);
+			for(const auto& model : models)
+				loader.LoadMesh(model.wstring(), nullptr);
+			loader.WaitForAll();
+		}, 3);
+
+	printf("  %-8s %-8s %10s %14s %10s\n", "assets", "threads", "direct ms", "background ms", "speedup");
+	printf("  %-8zu %-8u %10.3f %14.3f %9.2fx\n", textures.size() + models.size(), threadCount, directMilliseconds, backgroundMilliseconds,
+		directMilliseconds / backgroundMilliseconds);
+}
@@ -0,0 +1,134 @@
+#include "TestFramework.h"
+#include "BlockCompression.h"
+#include "PngLoader.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+namespace
+{
+	const BlockFormat AllFormats[] = { BlockFormat::BC1, BlockFormat::BC3, BlockFormat::BC4, BlockFormat::BC5, BlockFormat::BC7 };
+
+	Image LoadTestTexture(const std::filesystem::path& path)
+	{
+		Image image = {};
+		CHECK(LoadPng(path.wstring().c_str(), image));
+		return image;
+	}
+
+	double CompressAndMeasure(const Image& image, BlockFormat format)
+	{
+		std::vector<uint8_t> blocks;
+		CompressImage(image, format, blocks);
+		CHECK(blocks.size() == GetSurfaceSize(format, image.channels, image.width, image.height));
+		return ComputePsnr(image, DecompressImage(blocks.data(), image.width, image.height, format), GetBlockFormatChannels(format));
+	}
+
+	// The format Game::LoadTextures cooks each PBR map to (when not packing ORM maps)
+	BlockFormat GetMaterialFormat(const std::string& fileName)
+	{
+		if(fileName.find("_normals.") != std::string::npos)
+			return BlockFormat::BC5;
+		if(fileName.find("_roughness.") != std::string::npos || fileName.find("_metal.") != std::string::npos)
+			return BlockFormat::BC4;
+		return BlockFormat::BC1;
+	}
+}
+
+TEST(BlockCompression, SurfaceSizes)
+{
+	CHECK(GetBlockBytes(BlockFormat::None) == 0);
+	CHECK(GetBlockBytes(BlockFormat::BC1) == 8 && GetBlockBytes(BlockFormat::BC4) == 8);
+	CHECK(GetBlockBytes(BlockFormat::BC3) == 16 && GetBlockBytes(BlockFormat::BC5) == 16 && GetBlockBytes(BlockFormat::BC7) == 16);
+
+	// Partial blocks at the edges still take a whole block
+	CHECK(GetSurfaceSize(BlockFormat::BC1, 4, 6, 5) == 4 * 8);
+	CHECK(GetSurfaceSize(BlockFormat::BC7, 4, 1, 1) == 16);
+	CHECK(GetSurfaceSize(BlockFormat::None, 1, 6, 5) == 30);
+	CHECK(GetRowPitch(BlockFormat::BC5, 4, 1024) == 256 * 16);
+	CHECK(GetRowPitch(BlockFormat::None, 4, 1024) == 4096);
+
+	CHECK(CanBlockCompress(1024, 512));
+	CHECK(!CanBlockCompress(1022, 512));
+	CHECK(!CanBlockCompress(2, 2));
+}
+
+// A flat block only loses what its endpoints can't store: BC4/BC5 keep 8 bits exactly, BC1/BC3
+// round color to 565 (up to 4 levels off), and BC7 mode 6 shares a p-bit across the channels
+TEST(BlockCompression, SolidColors)
+{
+	Image solid = { 8, 8, 4, false, std::vector<uint8_t>(8 * 8 * 4) };
+	for(size_t i = 0; i < solid.pixels.size(); i++)
+		solid.pixels[i] = (uint8_t) (i % 4 == 0 ? 77 : i % 4 == 1 ? 140 : i % 4 == 2 ? 210 : 255);
+
+	for(BlockFormat format : AllFormats)
+	{
+		double psnr = CompressAndMeasure(solid, format);
+		if(format == BlockFormat::BC1 || format == BlockFormat::BC3)
+			CHECK(psnr >= 36.0);
+		else if(format == BlockFormat::BC7)
+			CHECK(psnr >= 48.0);
+		else
+			CHECK(std::isinf(psnr));
+	}
+}
+
+// Odd sizes repeat their last row/column into the edge blocks rather than reading past the image
+TEST(BlockCompression, PartialBlocks)
+{
+	Image gradient = { 6, 5, 1, false, {} };
+	for(int i = 0; i < 30; i++)
+		gradient.pixels.push_back((uint8_t) (i * 8));
+
+	CHECK(CompressAndMeasure(gradient, BlockFormat::BC1) >= 28.0);
+	CHECK(CompressAndMeasure(gradient, BlockFormat::BC4) >= 32.0);
+	CHECK(CompressAndMeasure(gradient, BlockFormat::BC7) >= 36.0);
+}
+
+// Quality floors on one real material set, a couple of dB under what the encoder gets today
+TEST(BlockCompression, MaterialQuality)
+{
+	Image albedo = LoadTestTexture(GetAssetPath("Textures/PBR/wood_albedo.png"));
+	double bc1 = CompressAndMeasure(albedo, BlockFormat::BC1);
+	double bc7 = CompressAndMeasure(albedo, BlockFormat::BC7);
+	CHECK(bc1 >= 39.0);
+	CHECK(bc7 >= 47.0);
+	CHECK(bc7 >= bc1 + 5.0);
+
+	CHECK(CompressAndMeasure(LoadTestTexture(GetAssetPath("Textures/PBR/wood_normals.png")), BlockFormat::BC5) >= 55.0);
+	CHECK(CompressAndMeasure(LoadTestTexture(GetAssetPath("Textures/PBR/wood_roughness.png")), BlockFormat::BC4) >= 50.0);
+}
+
+// Every PBR map, in the format the game picks for it, with its size and quality
+BENCHMARK(BlockCompression, MaterialSet)
+{
+	std::vector<std::filesystem::path> textures;
+	for(const auto& entry : std::filesystem::directory_iterator(GetAssetPath("Textures/PBR")))
+		textures.push_back(entry.path());
+	std::sort(textures.begin(), textures.end());
+
+	size_t uncompressedBytes = 0, compressedBytes = 0;
+	double totalMs = 0.0;
+	for(const auto& texture : textures)
+	{
+		Image image = LoadTestTexture(texture);
+		std::string fileName = texture.filename().string();
+		BlockFormat format = GetMaterialFormat(fileName);
+		if(!CanBlockCompress(image.width, image.height))
+			continue;
+
+		std::vector<uint8_t> blocks;
+		double ms = MeasureMilliseconds([&]() { CompressImage(image, format, blocks); }, 1);
+		double psnr = ComputePsnr(image, DecompressImage(blocks.data(), image.width, image.height, format), GetBlockFormatChannels(format));
+		double megapixels = (double) image.width * image.height / 1000000.0;
+		printf("  %-28s %s %8.3f ms (%5.1f MP/s) %6.2f MB -> %5.2f MB, %6.2f dB PSNR\n", fileName.c_str(), GetBlockFormatName(format),
+			ms, megapixels / (ms / 1000.0), image.pixels.size() / (1024.0 * 1024.0), blocks.size() / (1024.0 * 1024.0), psnr);
+
+		uncompressedBytes += image.pixels.size();
+		compressedBytes += blocks.size();
+		totalMs += ms;
+	}
+	printf("  Total: %.3f ms, %.2f MB -> %.2f MB (%.1fx smaller)\n", totalMs,
+		uncompressedBytes / (1024.0 * 1024.0), compressedBytes / (1024.0 * 1024.0), (double) uncompressedBytes / compressedBytes);
+}
@@ -0,0 +1,256 @@
+#include "TestFramework.h"
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	struct TestRandom
+	{
+		uint32_t state;
+		float Next() { state = state * 1664525u + 1013904223u; return (state >> 8) / 16777216.0f; }
+	};
+
+	// Objects scattered with the same density at every count, so queries find similar numbers of them
+	struct TestScene
+	{
+		float size;
+		std::vector<MeshBounds> bounds;
+		TestRandom random = { 97531 };
+
+		XMFLOAT3 RandomPoint() { return XMFLOAT3(random.Next() * size, random.Next() * size, random.Next() * size); }
+
+		explicit TestScene(size_t objectCount) :
+			size(std::cbrt((float) objectCount) * 4.0f), bounds(objectCount)
+		{
+			for(MeshBounds& object : bounds)
+			{
+				object.center = RandomPoint();
+				object.extents = XMFLOAT3(0.25f + random.Next(), 0.25f + random.Next(), 0.25f + random.Next());
+				object.radius = std::sqrt(object.extents.x * object.extents.x + object.extents.y * object.extents.y + object.extents.z * object.extents.z);
+			}
+		}
+
+		// Everything moves by up to maxOffset along each axis, as if the whole scene moved for a frame
+		void Drift(float maxOffset)
+		{
+			for(MeshBounds& object : bounds)
+			{
+				object.center.x += (random.Next() - 0.5f) * 2.0f * maxOffset;
+				object.center.y += (random.Next() - 0.5f) * 2.0f * maxOffset;
+				object.center.z += (random.Next() - 0.5f) * 2.0f * maxOffset;
+			}
+		}
+
+		// A camera at a random spot looking a random way, seeing 50 units
+		Frustum RandomFrustum()
+		{
+			XMFLOAT3 location = RandomPoint();
+			XMVECTOR direction = XMVectorSet(random.Next() - 0.5f, random.Next() - 0.5f, random.Next() - 0.5f + 0.01f, 0);
+			XMFLOAT4X4 viewProjection;
+			XMStoreFloat4x4(&viewProjection, XMMatrixLookToLH(XMLoadFloat3(&location), direction, XMVectorSet(0, 1, 0, 0)) *
+				XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 50.0f));
+			return Frustum::FromMatrix(viewProjection);
+		}
+	};
+
+	// Where (if anywhere within maxDistance) a ray enters a box, by the slab test
+	bool RayEntersBox(const MeshBounds& box, const XMFLOAT3& origin, const XMFLOAT3& direction, float maxDistance, float& entry)
+	{
+		float enter = 0.0f, exit = maxDistance;
+		const float* center = &box.center.x;
+		const float* extents = &box.extents.x;
+		const float* start = &origin.x;
+		const float* step = &direction.x;
+		for(int axis = 0; axis < 3; axis++)
+		{
+			float inverse = 1.0f / step[axis];
+			float nearDistance = (center[axis] - extents[axis] - start[axis]) * inverse;
+			float farDistance = (center[axis] + extents[axis] - start[axis]) * inverse;
+			enter = std::fmax(enter, std::fmin(nearDistance, farDistance));
+			exit = std::fmin(exit, std::fmax(nearDistance, farDistance));
+		}
+		entry = enter;
+		return enter <= exit;
+	}
+
+	// Every kind of query, checked against testing every object, for queryCount random queries
+	void CheckQueries(BoundingVolumeHierarchy& bvh, TestScene& scene, int queryCount)
+	{
+		std::vector<uint32_t> found, expected;
+		for(int query = 0; query < queryCount; query++)
+		{
+			Frustum frustum = scene.RandomFrustum();
+			found.clear();
+			expected.clear();
+			CHECK(bvh.QueryFrustum(frustum, found) == found.size());
+			for(uint32_t i = 0; i < scene.bounds.size(); i++)
+			{
+				const MeshBounds& object = scene.bounds[i];
+				if(frustum.IntersectsBox(object.center, object.extents) && frustum.IntersectsSphere(object.center, object.radius))
+					expected.push_back(i);
+			}
+			std::sort(found.begin(), found.end());
+			CHECK(found == expected);
+
+			// Boxes 10 units across
+			MeshBounds box = { scene.RandomPoint(), XMFLOAT3(5.0f, 5.0f, 5.0f), 0.0f };
+			found.clear();
+			expected.clear();
+			CHECK(bvh.QueryOverlap(box.center, box.extents, found) == found.size());
+			for(uint32_t i = 0; i < scene.bounds.size(); i++)
+			{
+				const MeshBounds& object = scene.bounds[i];
+				if(std::fabs(object.center.x - box.center.x) <= object.extents.x + box.extents.x &&
+					std::fabs(object.center.y - box.center.y) <= object.extents.y + box.extents.y &&
+					std::fabs(object.center.z - box.center.z) <= object.extents.z + box.extents.z)
+					expected.push_back(i);
+			}
+			std::sort(found.begin(), found.end());
+			CHECK(found == expected);
+
+			// A ray from one random spot to another
+			XMFLOAT3 origin = scene.RandomPoint();
+			XMFLOAT3 target = scene.RandomPoint();
+			XMFLOAT3 direction(target.x - origin.x, target.y - origin.y, target.z - origin.z);
+			float nearest = INFINITY;
+			for(const MeshBounds& object : scene.bounds)
+			{
+				float entry;
+				if(RayEntersBox(object, origin, direction, 1.0f, entry))
+					nearest = std::fmin(nearest, entry);
+			}
+			uint32_t hitObject;
+			float hitDistance;
+			bool isHit = bvh.Raycast(origin, direction, 1.0f, hitObject, hitDistance);
+			CHECK(isHit == (nearest != INFINITY));
+			if(isHit && nearest != INFINITY)
+			{
+				CHECK_NEAR(hitDistance, nearest, 1e-6f);
+				float entry;
+				CHECK(hitObject < scene.bounds.size() && RayEntersBox(scene.bounds[hitObject], origin, direction, 1.0f, entry));
+			}
+		}
+	}
+}
+
+TEST(BoundingVolumeHierarchy, QueriesMatchBruteForce)
+{
+	TestScene scene(5000);
+	BoundingVolumeHierarchy bvh;
+	bvh.Build(scene.bounds.data(), scene.bounds.size());
+	CHECK(bvh.GetObjectCount() == scene.bounds.size());
+	CHECK(!bvh.NeedsRebuild());
+	CheckQueries(bvh, scene, 50);
+
+	// Still right after refitting around moved objects
+	scene.Drift(0.5f);
+	bvh.Refit(scene.bounds.data());
+	CheckQueries(bvh, scene, 50);
+}
+
+TEST(BoundingVolumeHierarchy, RebuildsOnceLoosened)
+{
+	TestScene scene(5000);
+	BoundingVolumeHierarchy bvh;
+	bvh.Build(scene.bounds.data(), scene.bounds.size());
+	float builtCost = bvh.GetCost();
+	CHECK(builtCost > 0.0f);
+
+	// A little drift barely changes the tree; scattering everything makes refitting hopeless
+	scene.Drift(0.1f);
+	bvh.Refit(scene.bounds.data());
+	CHECK(!bvh.NeedsRebuild());
+
+	scene.Drift(scene.size * 0.5f);
+	bvh.Refit(scene.bounds.data());
+	CHECK(bvh.GetCost() > builtCost);
+	CHECK(bvh.NeedsRebuild());
+	CheckQueries(bvh, scene, 10);
+
+	bvh.Build(scene.bounds.data(), scene.bounds.size());
+	CHECK(!bvh.NeedsRebuild());
+}
+
+TEST(BoundingVolumeHierarchy, EmptyAndTiny)
+{
+	std::vector<uint32_t> found;
+	uint32_t object;
+	float distance;
+
+	BoundingVolumeHierarchy bvh;
+	bvh.Build(nullptr, 0);
+	CHECK(bvh.GetNodeCount() == 0);
+	CHECK(bvh.QueryOverlap(XMFLOAT3(0, 0, 0), XMFLOAT3(100, 100, 100), found) == 0);
+	CHECK(!bvh.Raycast(XMFLOAT3(0, 0, -10), XMFLOAT3(0, 0, 20), 1.0f, object, distance));
+
+	// One object is a single leaf; rays parallel to an axis still hit it
+	MeshBounds single = { XMFLOAT3(0, 0, 0), XMFLOAT3(1, 1, 1), std::sqrt(3.0f) };
+	bvh.Build(&single, 1);
+	CHECK(bvh.GetNodeCount() == 1);
+	CHECK(bvh.Raycast(XMFLOAT3(0, 0, -10), XMFLOAT3(0, 0, 20), 1.0f, object, distance));
+	CHECK(object == 0);
+	CHECK_NEAR(distance, 9.0f / 20.0f, 1e-6f);
+	CHECK(!bvh.Raycast(XMFLOAT3(0, 5, -10), XMFLOAT3(0, 0, 20), 1.0f, object, distance));
+	CHECK(!bvh.Raycast(XMFLOAT3(0, 0, -10), XMFLOAT3(0, 0, 20), 0.4f, object, distance));
+	CHECK(bvh.QueryOverlap(XMFLOAT3(1.5f, 0, 0), XMFLOAT3(0.5f, 0.5f, 0.5f), found) == 1);
+}
+
+BENCHMARK(BoundingVolumeHierarchy, BuildRefitQuery)
+{
+	// Building and refitting should stay affordable, and queries fast, as the scene grows
+	printf("  %-9s %8s %10s %10s %12s %12s %12s\n", "objects", "nodes", "build ms", "refit ms", "frustums/s", "raycasts/s", "overlaps/s");
+	for(size_t count : { 10000, 100000, 1000000 })
+	{
+		TestScene scene(count);
+		BoundingVolumeHierarchy bvh;
+		double buildMilliseconds = MeasureMilliseconds([&]() { bvh.Build(scene.bounds.data(), scene.bounds.size()); }, 3);
+		scene.Drift(0.5f);
+		double refitMilliseconds = MeasureMilliseconds([&]() { bvh.Refit(scene.bounds.data()); });
+
+		const int queryCount = 1000;
+		std::vector<Frustum> frustums(queryCount);
+		for(Frustum& frustum : frustums)
+			frustum = scene.RandomFrustum();
+		const int rayCount = queryCount * 100;
+		std::vector<XMFLOAT3> origins(rayCount), directions(rayCount), overlapCenters(rayCount);
+		for(int ray = 0; ray < rayCount; ray++)
+		{
+			origins[ray] = scene.RandomPoint();
+			XMFLOAT3 target = scene.RandomPoint();
+			directions[ray] = XMFLOAT3(target.x - origins[ray].x, target.y - origins[ray].y, target.z - origins[ray].z);
+			overlapCenters[ray] = scene.RandomPoint();
+		}
+
+		std::vector<uint32_t> found;
+		double frustumMilliseconds = MeasureMilliseconds([&]()
+			{
+				for(const Frustum& frustum : frustums)
+				{
+					found.clear();
+					bvh.QueryFrustum(frustum, found);
+				}
+			}, 3);
+		double raycastMilliseconds = MeasureMilliseconds([&]()
+			{
+				uint32_t object;
+				float distance;
+				for(int ray = 0; ray < rayCount; ray++)
+					bvh.Raycast(origins[ray], directions[ray], 1.0f, object, distance);
+			}, 3);
+		double overlapMilliseconds = MeasureMilliseconds([&]()
+			{
+				for(const XMFLOAT3& center : overlapCenters)
+				{
+					found.clear();
+					bvh.QueryOverlap(center, XMFLOAT3(5.0f, 5.0f, 5.0f), found);
+				}
+			}, 3);
+
+		printf("  %-9zu %8zu %10.3f %10.3f %12.0f %12.0f %12.0f\n", count, bvh.GetNodeCount(), buildMilliseconds, refitMilliseconds,
+			queryCount / (frustumMilliseconds / 1000.0), rayCount / (raycastMilliseconds / 1000.0), rayCount / (overlapMilliseconds / 1000.0));
+	}
+}
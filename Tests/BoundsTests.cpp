@@ -0,0 +1,166 @@
+#include "TestFramework.h"
+#include "TestMeshes.h"
+#include "Bounds.h"
+
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	// A camera at the origin looking down +Z
+	Frustum MakeTestFrustum()
+	{
+		XMFLOAT4X4 viewProjection;
+		XMStoreFloat4x4(&viewProjection, XMMatrixLookToLH(XMVectorZero(), XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 1, 0, 0)) *
+			XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 100.0f));
+		return Frustum::FromMatrix(viewProjection);
+	}
+
+	// Objects scattered through a 200 unit cube around the camera, with spheres somewhere between
+	// their box's inner and outer radius
+	std::vector<MeshBounds> MakeRandomBounds(size_t objectCount)
+	{
+		uint32_t random = 24680;
+		auto next = [&random]() { random = random * 1664525u + 1013904223u; return (random >> 8) / 16777216.0f; };
+		std::vector<MeshBounds> bounds(objectCount);
+		for(MeshBounds& object : bounds)
+		{
+			object.center = XMFLOAT3((next() - 0.5f) * 200.0f, (next() - 0.5f) * 200.0f, (next() - 0.5f) * 200.0f);
+			object.extents = XMFLOAT3(0.1f + next() * 4.0f, 0.1f + next() * 4.0f, 0.1f + next() * 4.0f);
+			const XMFLOAT3& e = object.extents;
+			object.radius = std::sqrt(e.x * e.x + e.y * e.y + e.z * e.z) * (0.6f + next() * 0.4f);
+		}
+		return bounds;
+	}
+
+	bool IsInside(const MeshBounds& bounds, XMFLOAT3 point, float tolerance)
+	{
+		XMVECTOR offset = XMLoadFloat3(&point) - XMLoadFloat3(&bounds.center);
+		XMFLOAT3 distance;
+		XMStoreFloat3(&distance, XMVectorAbs(offset));
+		return distance.x <= bounds.extents.x + tolerance && distance.y <= bounds.extents.y + tolerance && distance.z <= bounds.extents.z + tolerance &&
+			XMVectorGetX(XMVector3Length(offset)) <= bounds.radius + tolerance;
+	}
+}
+
+TEST(Bounds, HoldEveryVertex)
+{
+	for(const auto& model : GetBundledModels())
+	{
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+		LoadTestModel(model, vertices, indices);
+		MeshBounds local = CalculateMeshBounds(vertices.data(), vertices.size());
+
+		// Rotated, scaled unevenly and moved, the world bounds still hold every transformed vertex
+		XMMATRIX worldMatrix = XMMatrixScaling(2.0f, 0.5f, 3.0f) * XMMatrixRotationRollPitchYaw(0.3f, 1.1f, -0.7f) * XMMatrixTranslation(5, -2, 8);
+		XMFLOAT4X4 world;
+		XMStoreFloat4x4(&world, worldMatrix);
+		MeshBounds worldBounds = TransformMeshBounds(local, world);
+
+		for(const Vertex& v : vertices)
+		{
+			CHECK(IsInside(local, v.position, 1e-4f));
+			XMFLOAT3 position;
+			XMStoreFloat3(&position, XMVector3TransformCoord(XMLoadFloat3(&v.position), worldMatrix));
+			CHECK(IsInside(worldBounds, position, 1e-3f));
+		}
+	}
+
+	// The sphere is the tightest around the box's center, touching the furthest vertex
+	Vertex triangle[3] = {};
+	triangle[0].position = XMFLOAT3(-1, 0, 0);
+	triangle[1].position = XMFLOAT3(1, 2, 0);
+	triangle[2].position = XMFLOAT3(0, 0, 3);
+	MeshBounds bounds = CalculateMeshBounds(triangle, 3);
+	CHECK_NEAR(bounds.center.x, 0.0f, 1e-6f);
+	CHECK_NEAR(bounds.center.y, 1.0f, 1e-6f);
+	CHECK_NEAR(bounds.center.z, 1.5f, 1e-6f);
+	CHECK_NEAR(bounds.extents.x, 1.0f, 1e-6f);
+	CHECK_NEAR(bounds.extents.y, 1.0f, 1e-6f);
+	CHECK_NEAR(bounds.extents.z, 1.5f, 1e-6f);
+	CHECK_NEAR(bounds.radius, std::sqrt(4.25f), 1e-5f);
+}
+
+TEST(Bounds, BatchedCullMatchesScalar)
+{
+	// Not a multiple of four, so the last group is partly padding
+	Frustum frustum = MakeTestFrustum();
+	std::vector<MeshBounds> bounds = MakeRandomBounds(10003);
+	BoundsBatch batch;
+	for(const MeshBounds& object : bounds)
+		batch.Add(object);
+	CHECK(batch.GetCount() == bounds.size());
+
+	// Outside any plane by either test is outside, so this is the same as needing both tests to pass
+	std::vector<uint8_t> visible;
+	size_t visibleCount = batch.Cull(frustum, visible);
+	CHECK(visible.size() == bounds.size());
+	size_t expectedCount = 0;
+	for(size_t i = 0; i < bounds.size(); i++)
+	{
+		bool expected = frustum.IntersectsSphere(bounds[i].center, bounds[i].radius) && frustum.IntersectsBox(bounds[i].center, bounds[i].extents);
+		CHECK(visible[i] == (expected ? 1 : 0));
+		expectedCount += expected;
+	}
+	CHECK(visibleCount == expectedCount);
+	CHECK(visibleCount > 0 && visibleCount < bounds.size());
+}
+
+TEST(Bounds, CullsOutsideFrustum)
+{
+	// The same mesh in front of and behind the camera, then the batch reused for one just off to the side
+	Vertex triangle[3] = {};
+	triangle[0].position = XMFLOAT3(-1, 0, 0);
+	triangle[1].position = XMFLOAT3(1, 2, 0);
+	triangle[2].position = XMFLOAT3(0, 0, 3);
+	MeshBounds local = CalculateMeshBounds(triangle, 3);
+
+	BoundsBatch batch;
+	XMFLOAT4X4 world;
+	XMStoreFloat4x4(&world, XMMatrixScaling(2, 2, 2) * XMMatrixRotationY(0.5f) * XMMatrixTranslation(0, 0, 10));
+	batch.Add(local, world);
+	XMStoreFloat4x4(&world, XMMatrixTranslation(0, 0, -10));
+	batch.Add(local, world);
+
+	Frustum frustum = MakeTestFrustum();
+	std::vector<uint8_t> visible;
+	CHECK(batch.Cull(frustum, visible) == 1);
+	CHECK(visible[0] == 1 && visible[1] == 0);
+
+	batch.Clear();
+	XMStoreFloat4x4(&world, XMMatrixTranslation(30, 0, 10));
+	batch.Add(local, world);
+	CHECK(batch.Cull(frustum, visible) == 0);
+	CHECK(visible.size() == 1);
+}
+
+BENCHMARK(Bounds, Culling)
+{
+	// Testing four objects at once should beat testing them one by one
+	Frustum frustum = MakeTestFrustum();
+	printf("  %-10s %10s %16s %12s %10s\n", "objects", "visible", "one at a time ms", "batched ms", "speedup");
+	for(size_t count : { 1000, 10000, 100000, 1000000 })
+	{
+		std::vector<MeshBounds> bounds = MakeRandomBounds(count);
+		BoundsBatch batch;
+		for(const MeshBounds& object : bounds)
+			batch.Add(object);
+
+		std::vector<uint8_t> scalarVisible(count), batchedVisible;
+		double scalarMilliseconds = MeasureMilliseconds([&]()
+			{
+				for(size_t i = 0; i < count; i++)
+				{
+					scalarVisible[i] = frustum.IntersectsSphere(bounds[i].center, bounds[i].radius) &&
+						frustum.IntersectsBox(bounds[i].center, bounds[i].extents);
+				}
+			});
+		size_t visibleCount = 0;
+		double batchedMilliseconds = MeasureMilliseconds([&]() { visibleCount = batch.Cull(frustum, batchedVisible); });
+
+		printf("  %-10zu %10zu %16.3f %12.3f %9.2fx\n", count, visibleCount, scalarMilliseconds, batchedMilliseconds,
+			scalarMilliseconds / batchedMilliseconds);
+	}
+}
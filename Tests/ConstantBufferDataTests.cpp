@@ -0,0 +1,284 @@
+#include "TestFramework.h"
+#include "ConstantBufferData.h"
+#include "FrameData.h"
+#include "Transform.h"
+
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+	// --------------------------------------------------------
+	// Stands in for a SimpleConstantBuffer: its local data, and
+	// a GPU copy that Copy() replaces whole, as UpdateSubresource
+	// does with a constant buffer
+	// --------------------------------------------------------
+	struct TestBuffer
+	{
+		std::vector<unsigned char> local;
+		std::vector<unsigned char> gpu;
+		bool isDirty = true;
+
+		explicit TestBuffer(size_t size) : local(size, 0), gpu(size, 0xCD) {}
+
+		void Set(unsigned int byteOffset, const void* data, unsigned int size)
+		{
+			SetConstantData(local.data(), isDirty, byteOffset, data, size);
+		}
+
+		bool Copy(bool skipClean, SimpleBufferCopyStats& stats)
+		{
+			if(!ShouldCopyConstantBuffer(isDirty, (unsigned int) local.size(), skipClean, stats))
+				return false;
+			gpu = local;
+			return true;
+		}
+
+		bool InStep() const { return gpu == local; }
+	};
+
+	// The lights Game::CreateLights() sets up
+	std::vector<Light> GetTestLights()
+	{
+		std::vector<Light> lights(5, Light{});
+		for(size_t i = 0; i < lights.size(); i++)
+		{
+			lights[i].LightType = i < 3 ? LIGHT_TYPE_DIRECTIONAL : LIGHT_TYPE_POINT;
+			lights[i].Direction = XMFLOAT3((float) i - 1, -1, 0.5f);
+			lights[i].Location = XMFLOAT3((float) i, 2, -(float) i);
+			lights[i].Range = 10;
+			lights[i].Intensity = 1;
+			lights[i].Color = XMFLOAT3(1, 0.9f, 0.8f);
+		}
+		return lights;
+	}
+
+	// --------------------------------------------------------
+	// Game::CreateGeometry()'s entities (a floor, then five meshes
+	// for each of eight materials) in the order the render queue
+	// draws them, material by material, replaying the constant
+	// buffer sets made for each in the main pass
+	// --------------------------------------------------------
+	struct TestScene
+	{
+		struct Material { XMFLOAT4 colorTint; XMFLOAT2 uvScale; XMFLOAT2 uvOffset; };
+
+		std::vector<Transform> transforms;
+		std::vector<int> materials;
+		Material materialData[8];
+		std::vector<Light> lights = GetTestLights();
+		XMFLOAT4X4 view, proj, lightView, lightProj;
+
+		TestScene()
+		{
+			for(int m = 0; m < 8; m++)
+				materialData[m] = { XMFLOAT4(1, 1, 1, 1), m == 7 ? XMFLOAT2(5, 5) : XMFLOAT2(1, 1), XMFLOAT2(0, 0) };
+
+			transforms.emplace_back();
+			transforms.back().MoveAbsolute(0, -3, 0);
+			transforms.back().Scale(10, 10, 10);
+			materials.push_back(7);
+			for(int m = 0; m < 8; m++)
+			{
+				for(int j = 0; j < 5; j++)
+				{
+					transforms.emplace_back();
+					transforms.back().MoveAbsolute(-4.5f + m * 1.5f, -2.5f + j * 1.5f, 5.0f);
+					transforms.back().Scale(0.5f, 0.5f, 0.5f);
+					materials.push_back(m);
+				}
+			}
+
+			XMStoreFloat4x4(&view, XMMatrixLookToLH(XMVectorSet(0, 0, -5, 0), XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 1, 0, 0)));
+			XMStoreFloat4x4(&proj, XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.01f, 100.0f));
+			XMStoreFloat4x4(&lightView, XMMatrixLookToLH(XMVectorSet(0, 20, -20, 0), XMVectorSet(0, -1, 1, 0), XMVectorSet(0, 1, 0, 0)));
+			XMStoreFloat4x4(&lightProj, XMMatrixOrthographicLH(20, 20, 1, 100));
+		}
+
+		// What Game::Update() does to every entity but the floor
+		void Move(float deltaTime, float totalTime)
+		{
+			for(size_t i = 1; i < transforms.size(); i++)
+			{
+				transforms[i].Rotate(0, deltaTime, 0);
+				XMFLOAT3 location = transforms[i].GetLocation();
+				transforms[i].SetLocation(location.x, location.y, 5 + sinf(i * totalTime / 10.0f) * 5);
+			}
+		}
+
+		// Frame and light data in every shader's own cbuffer, as before the shared buffers
+		void DrawPrivate(TestBuffer& vs, TestBuffer& ps, bool skipClean, SimpleBufferCopyStats& stats)
+		{
+			XMFLOAT3 cameraLocation(0, 0, -5);
+			int lightCount = (int) lights.size();
+			for(size_t i = 0; i < transforms.size(); i++)
+			{
+				XMFLOAT4X4 world = transforms[i].GetWorldMatrix(), worldInvTranspose = transforms[i].GetWorldInverseTransposeMatrix();
+				vs.Set(0, &world, sizeof(world));
+				vs.Set(64, &worldInvTranspose, sizeof(worldInvTranspose));
+				vs.Set(128, &view, sizeof(view));
+				vs.Set(192, &proj, sizeof(proj));
+				vs.Set(256, &lightView, sizeof(lightView));
+				vs.Set(320, &lightProj, sizeof(lightProj));
+				vs.Copy(skipClean, stats);
+
+				const Material& material = materialData[materials[i]];
+				ps.Set(0, &material, sizeof(material));
+				ps.Set(32, &cameraLocation, sizeof(cameraLocation));
+				ps.Set(44, &lightCount, sizeof(lightCount));
+				ps.Set(48, lights.data(), (unsigned int) (sizeof(Light) * lights.size()));
+				ps.Copy(skipClean, stats);
+			}
+		}
+
+		// Frame and light data set once, into the shared FrameData and LightData buffers
+		void DrawShared(TestBuffer& vs, TestBuffer& ps, TestBuffer& frameBuffer, TestBuffer& lightBuffer,
+			float totalTime, bool skipClean, SimpleBufferCopyStats& stats, SimpleBufferCopyStats& sharedStats)
+		{
+			FrameData frameData = { view, proj, lightView, lightProj, XMFLOAT3(0, 0, -5), totalTime };
+			frameBuffer.Set(0, &frameData, sizeof(frameData));
+			LightData lightData = {};
+			lightData.lightCount = (int) lights.size();
+			memcpy(lightData.lights, lights.data(), sizeof(Light) * lights.size());
+			lightBuffer.Set(0, &lightData, (unsigned int) (offsetof(LightData, lights) + sizeof(Light) * lights.size()));
+			frameBuffer.Copy(skipClean, sharedStats);
+			lightBuffer.Copy(skipClean, sharedStats);
+
+			for(size_t i = 0; i < transforms.size(); i++)
+			{
+				XMFLOAT4X4 world = transforms[i].GetWorldMatrix(), worldInvTranspose = transforms[i].GetWorldInverseTransposeMatrix();
+				vs.Set(0, &world, sizeof(world));
+				vs.Set(64, &worldInvTranspose, sizeof(worldInvTranspose));
+				vs.Copy(skipClean, stats);
+
+				ps.Set(0, &materialData[materials[i]], sizeof(Material));
+				ps.Copy(skipClean, stats);
+			}
+		}
+	};
+}
+
+TEST(ConstantBufferData, UnchangedSetsStayClean)
+{
+	SimpleBufferCopyStats stats;
+	TestBuffer buffer(64);
+
+	// A new buffer is dirty, so its first copy is made
+	CHECK(buffer.isDirty);
+	CHECK(buffer.Copy(true, stats));
+	CHECK(!buffer.isDirty && buffer.InStep());
+	CHECK(stats.CopyCount == 1 && stats.BytesCopied == 64 && stats.SkipCount == 0);
+
+	// Setting what's already there leaves it clean, and its copy is skipped
+	float value = 0;
+	buffer.Set(16, &value, sizeof(value));
+	CHECK(!buffer.isDirty);
+	CHECK(!buffer.Copy(true, stats));
+	CHECK(stats.CopyCount == 1 && stats.SkipCount == 1 && stats.BytesSkipped == 64);
+
+	// One changed byte dirties it, and lands only where it was set
+	unsigned char bytes[4] = { 0, 0, 0, 1 };
+	buffer.Set(16, bytes, sizeof(bytes));
+	CHECK(buffer.isDirty);
+	CHECK(buffer.local[19] == 1);
+	for(size_t i = 0; i < buffer.local.size(); i++)
+		CHECK(i == 19 || buffer.local[i] == 0);
+	CHECK(!buffer.InStep());
+	CHECK(buffer.Copy(true, stats));
+	CHECK(!buffer.isDirty && buffer.InStep());
+	CHECK(stats.CopyCount == 2 && stats.BytesCopied == 128);
+
+	// Setting it again is clean once more
+	buffer.Set(16, bytes, sizeof(bytes));
+	CHECK(!buffer.isDirty);
+
+	// Without skipping, even a clean buffer is copied (and counted as a copy)
+	CHECK(buffer.Copy(false, stats));
+	CHECK(stats.CopyCount == 3 && stats.SkipCount == 1 && stats.BytesCopied == 192);
+}
+
+TEST(ConstantBufferData, SharedBuffersCopyOnlyOnChange)
+{
+	SimpleBufferCopyStats stats;
+	TestBuffer frameBuffer(sizeof(FrameData)), lightBuffer(sizeof(LightData));
+	std::vector<Light> lights = GetTestLights();
+
+	auto setFrame = [&](float totalTime)
+	{
+		FrameData frameData = {};
+		frameData.cameraLocation = XMFLOAT3(0, 0, -5);
+		frameData.totalTime = totalTime;
+		frameBuffer.Set(0, &frameData, sizeof(frameData));
+
+		// Only as many lights as there are, as Game::Draw() sets them
+		LightData lightData = {};
+		lightData.lightCount = (int) lights.size();
+		memcpy(lightData.lights, lights.data(), sizeof(Light) * lights.size());
+		lightBuffer.Set(0, &lightData, (unsigned int) (offsetof(LightData, lights) + sizeof(Light) * lights.size()));
+	};
+
+	// The first frame copies both, in full
+	setFrame(0.0f);
+	CHECK(frameBuffer.Copy(true, stats) && lightBuffer.Copy(true, stats));
+	CHECK(stats.BytesCopied == sizeof(FrameData) + sizeof(LightData));
+
+	// Time moves on, so frame data changes every frame, but lights that stay put are never copied again
+	setFrame(1.0f / 60);
+	CHECK(frameBuffer.Copy(true, stats));
+	CHECK(!lightBuffer.Copy(true, stats));
+	CHECK(stats.SkipCount == 1 && stats.BytesSkipped == sizeof(LightData));
+
+	// A light that changes is copied the frame it does
+	lights[4].Intensity = 2;
+	setFrame(2.0f / 60);
+	CHECK(frameBuffer.Copy(true, stats) && lightBuffer.Copy(true, stats));
+	CHECK(lightBuffer.InStep());
+	Light copied;
+	memcpy(&copied, lightBuffer.gpu.data() + offsetof(LightData, lights) + sizeof(Light) * 4, sizeof(Light));
+	CHECK(copied.Intensity == 2);
+
+	// Fewer lights is a change too (the count is), even though what's left of the data isn't
+	lights.pop_back();
+	setFrame(2.0f / 60);
+	CHECK(!frameBuffer.Copy(true, stats));
+	CHECK(lightBuffer.Copy(true, stats));
+	int lightCount;
+	memcpy(&lightCount, lightBuffer.gpu.data(), sizeof(lightCount));
+	CHECK(lightCount == 4);
+}
+
+BENCHMARK(ConstantBufferData, SceneBytesCopied)
+{
+	// The scene's main pass over a second of frames: per-entity sets, with frame and light data either
+	// in every shader's own cbuffer or in the shared buffers, copying every buffer or only changed ones
+	// (entities all share a vertex shader, so its buffer changes every draw whether they move or not)
+	const int frameCount = 60;
+	const float deltaTime = 1.0f / frameCount;
+	printf("  %-8s %-5s %14s %14s %14s %16s\n", "buffers", "skip", "copies/frame", "skips/frame", "bytes/frame", "shared b/frame");
+	for(bool shared : { false, true })
+	{
+		for(bool skipClean : { false, true })
+		{
+			TestScene scene;
+			TestBuffer vs(shared ? 128 : 384), ps(shared ? 32 : 48 + sizeof(Light) * MAX_LIGHTS);
+			TestBuffer frameBuffer(sizeof(FrameData)), lightBuffer(sizeof(LightData));
+			SimpleBufferCopyStats stats, sharedStats;
+			for(int frame = 0; frame < frameCount; frame++)
+			{
+				float totalTime = frame * deltaTime;
+				scene.Move(deltaTime, totalTime);
+				if(shared)
+					scene.DrawShared(vs, ps, frameBuffer, lightBuffer, totalTime, skipClean, stats, sharedStats);
+				else
+					scene.DrawPrivate(vs, ps, skipClean, stats);
+			}
+
+			size_t copyCount = stats.CopyCount + sharedStats.CopyCount, skipCount = stats.SkipCount + sharedStats.SkipCount;
+			printf("  %-8s %-5s %14.1f %14.1f %14.0f %16.0f\n", shared ? "shared" : "private", skipClean ? "on" : "off",
+				(double) copyCount / frameCount, (double) skipCount / frameCount,
+				(double) (stats.BytesCopied + sharedStats.BytesCopied) / frameCount, (double) sharedStats.BytesCopied / frameCount);
+		}
+	}
+}
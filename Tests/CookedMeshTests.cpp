@@ -0,0 +1,123 @@
+#include "TestFramework.h"
+#include "CookedMesh.h"
+#include "MeshData.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	// Cooked files are written next to their source, so work on copies
+	// rather than cluttering (or racing with) the real Assets folder
+	std::vector<std::filesystem::path> CopyModels(const char* scratchName)
+	{
+		std::filesystem::path directory = MakeScratchDirectory(scratchName);
+
+		std::vector<std::filesystem::path> copies;
+		for(const auto& model : GetBundledModels())
+		{
+			copies.push_back(directory / model.filename());
+			std::filesystem::copy_file(model, copies.back());
+		}
+		return copies;
+	}
+
+	template<typename T>
+	bool SameBytes(const std::vector<T>& a, const std::vector<T>& b)
+	{
+		return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+	}
+}
+
+// Loading from the cooked file has to give back exactly what processing the source produced
+TEST(CookedMesh, RoundTrips)
+{
+	for(const auto& model : CopyModels("CookedMeshRoundTrip"))
+	{
+		MeshData source;
+		CHECK(!CookedMesh(model.wstring().c_str()).IsValid());
+		CHECK(LoadMeshData(model.wstring().c_str(), source));
+		CHECK(CookedMesh(model.wstring().c_str()).IsValid());
+
+		MeshData cooked;
+		CHECK(LoadMeshData(model.wstring().c_str(), cooked));
+		CHECK(SameBytes(cooked.vertices, source.vertices));
+		CHECK(SameBytes(cooked.indices, source.indices));
+		CHECK(SameBytes(cooked.meshlets, source.meshlets));
+		CHECK(SameBytes(cooked.lods, source.lods));
+		CHECK(memcmp(&cooked.bounds, &source.bounds, sizeof(MeshBounds)) == 0);
+		CHECK(cooked.name == source.name);
+	}
+}
+
+TEST(CookedMesh, RejectsStaleAndTruncatedFiles)
+{
+	std::filesystem::path model = CopyModels("CookedMeshStale")[0];
+	std::wstring sourcePath = model.wstring();
+	std::filesystem::path cookedPath = CookedMesh::GetCookedPath(sourcePath.c_str());
+
+	MeshData data;
+	LoadMeshData(sourcePath.c_str(), data);
+	CHECK(CookedMesh(sourcePath.c_str()).IsValid());
+
+	// Cut off the last byte
+	std::uintmax_t cookedSize = std::filesystem::file_size(cookedPath);
+	std::filesystem::resize_file(cookedPath, cookedSize - 1);
+	CHECK(!CookedMesh(sourcePath.c_str()).IsValid());
+
+	// Recook, then edit the source
+	LoadMeshData(sourcePath.c_str(), data);
+	CHECK(CookedMesh(sourcePath.c_str()).IsValid());
+	{
+		std::ofstream source(model, std::ios::app);
+		source << "# edited\n";
+	}
+	CHECK(!CookedMesh(sourcePath.c_str()).IsValid());
+
+	// A stale hit is cooked again (replacing the old file, with nothing left behind), and the new
+	// file gives back what processing the edited source does
+	MeshData recooked;
+	CHECK(LoadMeshData(sourcePath.c_str(), recooked));
+	CHECK(CookedMesh(sourcePath.c_str()).IsValid());
+	MeshData reloaded;
+	CHECK(LoadMeshData(sourcePath.c_str(), reloaded));
+	CHECK(SameBytes(reloaded.vertices, recooked.vertices));
+	CHECK(SameBytes(reloaded.indices, recooked.indices));
+	CHECK(SameBytes(reloaded.lods, recooked.lods));
+	for(const auto& entry : std::filesystem::directory_iterator(model.parent_path()))
+		CHECK(entry.path().extension() != ".tmp");
+
+	// Garbage with the right size
+	LoadMeshData(sourcePath.c_str(), data);
+	{
+		std::fstream cooked(cookedPath, std::ios::in | std::ios::out | std::ios::binary);
+		cooked.write("HSEM", 4);
+	}
+	CHECK(!CookedMesh(sourcePath.c_str()).IsValid());
+}
+
+BENCHMARK(CookedMesh, SourceVsCookedLoad)
+{
+	printf("  %-20s %12s %12s %8s %12s\n", "model", "source ms", "cooked ms", "speedup", "cooked KB");
+	for(const auto& model : CopyModels("CookedMeshBenchmark"))
+	{
+		std::wstring sourcePath = model.wstring();
+		std::filesystem::path cookedPath = CookedMesh::GetCookedPath(sourcePath.c_str());
+
+		MeshData data;
+		double sourceMilliseconds = MeasureMilliseconds([&]()
+			{
+				std::filesystem::remove(cookedPath);
+				data = {};
+				LoadMeshData(sourcePath.c_str(), data);
+			});
+		double cookedMilliseconds = MeasureMilliseconds([&]()
+			{
+				data = {};
+				LoadMeshData(sourcePath.c_str(), data);
+			}, 20);
+
+		printf("  %-20s %12.3f %12.3f %7.1fx %12.1f\n", model.filename().string().c_str(), sourceMilliseconds, cookedMilliseconds,
+			sourceMilliseconds / cookedMilliseconds, std::filesystem::file_size(cookedPath) / 1024.0);
+	}
+}
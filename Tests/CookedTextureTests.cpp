@@ -0,0 +1,146 @@
+#include "TestFramework.h"
+#include "TextureData.h"
+
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	const TextureCookOptions AlbedoOptions = { true, { true, false }, BlockFormat::None };
+
+	std::wstring GetTexturePath(const char* relativePath)
+	{
+		return GetAssetPath(relativePath).wstring();
+	}
+
+	bool SameMips(const TextureData& a, const TextureData& b)
+	{
+		if(a.width != b.width || a.height != b.height || a.channels != b.channels || a.format != b.format ||
+			a.GetMipCount() != b.GetMipCount() || a.faceCount != b.faceCount)
+			return false;
+
+		for(size_t i = 0; i < a.mipPixels.size(); i++)
+		{
+			if(memcmp(a.mipPixels[i], b.mipPixels[i], a.GetMipSize((unsigned int) (i % a.GetMipCount()))) != 0)
+				return false;
+		}
+		return true;
+	}
+
+	// The single cache file a test has written so far
+	std::filesystem::path GetOnlyCacheFile(const std::filesystem::path& cacheDirectory)
+	{
+		std::vector<std::filesystem::path> files;
+		for(const auto& entry : std::filesystem::directory_iterator(cacheDirectory))
+			files.push_back(entry.path());
+		CHECK(files.size() == 1);
+		return files.empty() ? std::filesystem::path() : files[0];
+	}
+}
+
+// A cache hit has to give back exactly the mips cooking produced
+TEST(CookedTexture, RoundTrips)
+{
+	std::filesystem::path cache = MakeScratchDirectory("CookedTextureRoundTrip");
+	std::wstring source = GetTexturePath("Textures/PBR/wood_albedo.png");
+
+	TextureData uncached, cooked, cached;
+	CHECK(LoadTextureData(source.c_str(), "", AlbedoOptions, uncached));
+	CHECK(LoadTextureData(source.c_str(), cache, AlbedoOptions, cooked));
+	CHECK(LoadTextureData(source.c_str(), cache, AlbedoOptions, cached));
+
+	CHECK(!uncached.cooked && !cooked.cooked && cached.cooked);
+	CHECK(uncached.GetMipCount() == GetMipCount(uncached.width, uncached.height));
+	CHECK(SameMips(cooked, uncached));
+	CHECK(SameMips(cached, uncached));
+	CHECK(cached.isSRGB == uncached.isSRGB);
+}
+
+// Files are named after their contents (and cook options), not their path
+TEST(CookedTexture, IsContentAddressed)
+{
+	std::filesystem::path cache = MakeScratchDirectory("CookedTextureContent");
+	std::filesystem::path copies = MakeScratchDirectory("CookedTextureContentSources");
+	std::filesystem::path original = GetAssetPath("Textures/PBR/wood_roughness.png");
+	std::filesystem::copy_file(original, copies / "renamed.png");
+
+	TextureCookOptions options = { true, { false, false }, BlockFormat::None };
+	TextureData first, renamed;
+	CHECK(LoadTextureData(original.wstring().c_str(), cache, options, first));
+	CHECK(LoadTextureData((copies / "renamed.png").wstring().c_str(), cache, options, renamed));
+	CHECK(renamed.cooked != nullptr);
+	GetOnlyCacheFile(cache);
+
+	// Other options cook into their own file
+	TextureData unfiltered;
+	options.generateMips = false;
+	CHECK(LoadTextureData(original.wstring().c_str(), cache, options, unfiltered));
+	CHECK(!unfiltered.cooked && unfiltered.GetMipCount() == 1);
+}
+
+TEST(CookedTexture, RejectsBadFiles)
+{
+	std::filesystem::path cache = MakeScratchDirectory("CookedTextureBad");
+	std::wstring source = GetTexturePath("Textures/PBR/wood_roughness.png");
+	TextureCookOptions options = { true, { false, false }, BlockFormat::None };
+
+	uint64_t hash = 0;
+	{
+		TextureData cooked, cached;
+		CHECK(LoadTextureData(source.c_str(), cache, options, cooked));
+		CHECK(LoadTextureData(source.c_str(), cache, options, cached));
+		CHECK(cached.cooked != nullptr);
+		if(cached.cooked)
+			hash = cached.cooked->GetHeader()->contentHash;
+	}
+	std::filesystem::path cookedPath = CookedTexture::GetCookedPath(cache, hash);
+	uintmax_t size = std::filesystem::file_size(cookedPath);
+	CHECK(CookedTexture(cache, hash).IsValid());
+	CHECK(!CookedTexture(cache, hash + 1).IsValid());
+
+	// A truncated file is ignored, and replaced by the next load
+	std::filesystem::resize_file(cookedPath, size - 1);
+	CHECK(!CookedTexture(cache, hash).IsValid());
+	{
+		TextureData recooked;
+		CHECK(LoadTextureData(source.c_str(), cache, options, recooked));
+		CHECK(!recooked.cooked);
+	}
+	CHECK(std::filesystem::file_size(cookedPath) == size);
+	CHECK(CookedTexture(cache, hash).IsValid());
+
+	// So is one from another version
+	{
+		std::fstream file(cookedPath, std::ios::binary | std::ios::in | std::ios::out);
+		uint32_t otherVersion = CookedTexture::Version + 1;
+		file.seekp(offsetof(CookedTextureHeader, version));
+		file.write((const char*) &otherVersion, sizeof(otherVersion));
+	}
+	CHECK(!CookedTexture(cache, hash).IsValid());
+}
+
+BENCHMARK(CookedTexture, CookVsCachedLoad)
+{
+	std::filesystem::path cache = MakeScratchDirectory("CookedTextureBenchmark");
+	const char* textures[] = { "Textures/PBR/wood_albedo.png", "Textures/PBR/wood_normals.png", "Textures/PBR/wood_roughness.png" };
+	for(const char* texture : textures)
+	{
+		std::wstring source = GetTexturePath(texture);
+		TextureCookOptions options = { true, { strstr(texture, "_albedo") != nullptr, strstr(texture, "_normals") != nullptr }, BlockFormat::None };
+
+		double cookMs = MeasureMilliseconds([&]()
+		{
+			TextureData data;
+			LoadTextureData(source.c_str(), "", options, data);
+		}, 3);
+		TextureData warm;
+		LoadTextureData(source.c_str(), cache, options, warm);
+		double cachedMs = MeasureMilliseconds([&]()
+		{
+			TextureData data;
+			LoadTextureData(source.c_str(), cache, options, data);
+		});
+		printf("  %-32s decode + mips %8.3f ms, from cache %8.3f ms (%.0fx)\n", texture, cookMs, cachedMs, cookMs / cachedMs);
+	}
+}
@@ -0,0 +1,177 @@
+#include "TestFramework.h"
+#include "CubemapCooker.h"
+#include "MipGenerator.h"
+#include "PngLoader.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+
+namespace
+{
+	const float Pi = 3.14159265f;
+
+	// Direction through the center of texel (x, y) of a face, in the same cube map
+	// order and orientation CubemapCooker uses
+	void GetTexelDirection(int face, unsigned int x, unsigned int y, unsigned int size, float direction[3])
+	{
+		float u = 2.0f * (x + 0.5f) / size - 1.0f;
+		float v = 2.0f * (y + 0.5f) / size - 1.0f;
+		switch(face)
+		{
+		case 0: direction[0] = 1.0f; direction[1] = -v; direction[2] = -u; break;
+		case 1: direction[0] = -1.0f; direction[1] = -v; direction[2] = u; break;
+		case 2: direction[0] = u; direction[1] = 1.0f; direction[2] = v; break;
+		case 3: direction[0] = u; direction[1] = -1.0f; direction[2] = -v; break;
+		case 4: direction[0] = u; direction[1] = -v; direction[2] = 1.0f; break;
+		default: direction[0] = -u; direction[1] = -v; direction[2] = -1.0f; break;
+		}
+
+		float length = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+		for(int c = 0; c < 3; c++)
+			direction[c] /= length;
+	}
+
+	// Linear (not gamma-encoded) faces whose RGB radiance is color scaled by radiance(direction)
+	std::vector<Image> MakeEnvironment(unsigned int size, const float color[3], const std::function<float(const float*)>& radiance)
+	{
+		std::vector<Image> faces(6);
+		for(int face = 0; face < 6; face++)
+		{
+			faces[face] = { size, size, 4, false, std::vector<uint8_t>((size_t) size * size * 4) };
+			for(unsigned int y = 0; y < size; y++)
+			{
+				for(unsigned int x = 0; x < size; x++)
+				{
+					float direction[3];
+					GetTexelDirection(face, x, y, size, direction);
+					uint8_t* texel = &faces[face].pixels[((size_t) y * size + x) * 4];
+					for(int c = 0; c < 3; c++)
+						texel[c] = (uint8_t) (color[c] * radiance(direction) * 255.0f + 0.5f);
+					texel[3] = 255;
+				}
+			}
+		}
+		return faces;
+	}
+
+	// Checks every coefficient (for every channel) against expected[i] * color[channel]
+	void CheckCoefficients(const float coefficients[9][3], const float expected[9], const float color[3], float tolerance)
+	{
+		for(int i = 0; i < 9; i++)
+		{
+			for(int c = 0; c < 3; c++)
+				CHECK_NEAR(coefficients[i][c], expected[i] * color[c], tolerance);
+		}
+	}
+
+	std::vector<Image> LoadSky(const char* sky)
+	{
+		const char* faceNames[6] = { "right", "left", "up", "down", "front", "back" };
+		std::vector<Image> faces(6);
+		for(int face = 0; face < 6; face++)
+		{
+			std::string path = std::string("Textures/Skies/") + sky + "/" + faceNames[face] + ".png";
+			CHECK(LoadPng(GetAssetPath(path.c_str()).wstring().c_str(), faces[face]));
+		}
+		return faces;
+	}
+}
+
+// Radiance of 1 everywhere only has a band 0 term: 0.282095 * 4pi, times pi from the cosine
+// convolution, which evaluates back to irradiance of pi in every direction
+TEST(CubemapCooker, ConstantEnvironmentSH)
+{
+	const float color[3] = { 1.0f, 0.6f, 0.0f };
+	const float expected[9] = { 0.282095f * 4.0f * Pi * Pi, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+	float coefficients[9][3];
+	ProjectIrradianceSH(MakeEnvironment(64, color, [](const float*) { return 1.0f; }), false, coefficients);
+	CheckCoefficients(coefficients, expected, color, 0.01f);
+
+	const float directions[3][3] = { { 1, 0, 0 }, { 0, -1, 0 }, { 0.6f, 0, 0.8f } };
+	for(const float* direction : directions)
+	{
+		float irradiance[3];
+		EvaluateIrradianceSH(coefficients, direction, irradiance);
+		for(int c = 0; c < 3; c++)
+			CHECK_NEAR(irradiance[c], Pi * color[c], 0.01f);
+	}
+}
+
+// Radiance of max(0, z) (a clamped cosine lobe around +Z) is symmetric around Z, so only the
+// zonal terms (1, z and 3z^2 - 1) are nonzero. Projected, they're 0.282095 * pi, 0.488603 * 2pi/3
+// and 0.315392 * pi/2, then convolved with the cosine lobe's per band scales (pi, 2pi/3, pi/4)
+TEST(CubemapCooker, CosineLobeEnvironmentSH)
+{
+	const float color[3] = { 1.0f, 0.6f, 0.2f };
+	const float expected[9] =
+	{
+		0.282095f * Pi * Pi,
+		0,
+		0.488603f * (2.0f * Pi / 3.0f) * (2.0f * Pi / 3.0f),
+		0, 0, 0,
+		0.315392f * (Pi / 2.0f) * (Pi / 4.0f),
+		0, 0
+	};
+
+	float coefficients[9][3];
+	ProjectIrradianceSH(MakeEnvironment(64, color, [](const float* direction) { return std::max(direction[2], 0.0f); }), false, coefficients);
+	CheckCoefficients(coefficients, expected, color, 0.01f);
+
+	// Gamma-encoded faces are decoded before projecting, so the same lobe stored gamma-encoded
+	// projects the same (up to 8-bit rounding, which is coarser in the dark end)
+	const float white[3] = { 1.0f, 1.0f, 1.0f };
+	std::vector<Image> encoded = MakeEnvironment(64, white, [](const float* direction) { return std::pow(std::max(direction[2], 0.0f), 1.0f / 2.2f); });
+	ProjectIrradianceSH(encoded, true, coefficients);
+	CheckCoefficients(coefficients, expected, white, 0.05f);
+}
+
+TEST(CubemapCooker, PrefiltersConstantSky)
+{
+	const float color[3] = { 0.8f, 0.4f, 0.2f };
+	std::vector<Image> faces = MakeEnvironment(32, color, [](const float*) { return 1.0f; });
+
+	std::vector<Image> mips;
+	CHECK(PrefilterCubemap(faces, true, mips) > 0);
+
+	unsigned int mipCount = GetMipCount(32, 32);
+	CHECK(mips.size() == 6 * mipCount);
+	if(mips.size() != 6 * mipCount)
+		return;
+
+	// Every face's chain halves down to 1x1, and blurring a constant sky leaves it constant
+	int worst = 0;
+	for(int face = 0; face < 6; face++)
+	{
+		CHECK(std::equal(mips[face * mipCount].pixels.begin(), mips[face * mipCount].pixels.end(), faces[face].pixels.begin()));
+		for(unsigned int mip = 0; mip < mipCount; mip++)
+		{
+			const Image& image = mips[face * mipCount + mip];
+			CHECK(image.width == std::max(1u, 32u >> mip) && image.height == image.width && image.channels == 4);
+			for(size_t i = 0; i < image.pixels.size(); i++)
+				worst = std::max(worst, std::abs(image.pixels[i] - faces[face].pixels[i % 4]));
+		}
+	}
+	CHECK(worst <= 1);
+}
+
+BENCHMARK(CubemapCooker, Sky)
+{
+	std::vector<Image> faces = LoadSky("Cold Sunset");
+
+	std::vector<Image> mips;
+	size_t sampleCount = 0;
+	double prefilterMs = MeasureMilliseconds([&]()
+	{
+		mips.clear();
+		sampleCount = PrefilterCubemap(faces, true, mips);
+	}, 1);
+
+	float coefficients[9][3];
+	double irradianceMs = MeasureMilliseconds([&]() { ProjectIrradianceSH(faces, true, coefficients); });
+
+	printf("  Cold Sunset (6 x %ux%u): prefiltered %zu mips in %.3f ms (%.1f M samples/s), irradiance SH in %.3f ms\n",
+		faces[0].width, faces[0].height, mips.size() / 6, prefilterMs, sampleCount / (prefilterMs / 1000.0) / 1000000.0, irradianceMs);
+}
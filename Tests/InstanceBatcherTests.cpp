@@ -0,0 +1,177 @@
+#include "TestFramework.h"
+#include "InstanceBatcher.h"
+#include "RenderQueue.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// Objects over 4 shaders, 16 materials, 32 meshes and 3 levels of detail, with every eighth one
+	// not instanceable; each object's matrices are filled with its own index so they can be traced back to it
+	struct TestObjects
+	{
+		std::vector<uint64_t> keys;
+		std::vector<uint32_t> lods;
+
+		static bool CanInstance(uint32_t object) { return object % 8 != 0; }
+
+		explicit TestObjects(size_t objectCount) : keys(objectCount), lods(objectCount)
+		{
+			uint32_t random = 24680;
+			auto next = [&random]() { random = random * 1664525u + 1013904223u; return random >> 8; };
+			for(size_t i = 0; i < objectCount; i++)
+			{
+				keys[i] = MakeSortKey(0, next() % 4, next() % 16, next() % 32, (next() & 0xFFFF) / 65535.0f);
+				lods[i] = next() % 3;
+			}
+		}
+
+		void AddTo(InstanceBatcher& batcher) const
+		{
+			batcher.Clear();
+			for(size_t i = 0; i < keys.size(); i++)
+				AddObject(batcher, keys[i], lods[i], (uint32_t) i, CanInstance((uint32_t) i));
+		}
+
+		static void AddObject(InstanceBatcher& batcher, uint64_t key, uint32_t lod, uint32_t object, bool canInstance)
+		{
+			XMFLOAT4X4 world, worldInvTranspose;
+			for(int j = 0; j < 16; j++)
+			{
+				(&world.m[0][0])[j] = (float) object;
+				(&worldInvTranspose.m[0][0])[j] = -(float) object;
+			}
+			batcher.Add(key, lod, object, world, worldInvTranspose, canInstance);
+		}
+	};
+}
+
+TEST(InstanceBatcher, GroupsHoldEveryObjectOnce)
+{
+	TestObjects test(10007);
+	InstanceBatcher batcher;
+	test.AddTo(batcher);
+	batcher.Build();
+	CHECK(batcher.GetObjectCount() == test.keys.size());
+
+	const std::vector<InstanceGroup>& groups = batcher.GetGroups();
+	const std::vector<InstanceData>& instances = batcher.GetInstances();
+	const std::vector<uint32_t>& objects = batcher.GetObjects();
+	CHECK(instances.size() == test.keys.size() && objects.size() == test.keys.size());
+	CHECK(groups.size() < test.keys.size());
+
+	std::vector<uint32_t> timesSeen(test.keys.size(), 0);
+	uint32_t instanceCount = 0;
+	for(size_t g = 0; g < groups.size(); g++)
+	{
+		// Groups are packed back to back, and none is empty
+		const InstanceGroup& group = groups[g];
+		CHECK(group.firstInstance == instanceCount && group.instanceCount > 0);
+		instanceCount += group.instanceCount;
+
+		for(uint32_t i = group.firstInstance; i < group.firstInstance + group.instanceCount && i < objects.size(); i++)
+		{
+			// Instance data belongs to the object, and the object belongs in the group
+			uint32_t object = objects[i];
+			timesSeen[object]++;
+			CHECK(instances[i].world.m[3][3] == (float) object && instances[i].worldInvTranspose.m[0][0] == -(float) object);
+			CHECK(GetSortKeyState(test.keys[object]) == GetSortKeyState(group.key) && test.lods[object] == group.lod);
+			CHECK(group.instanceCount == 1 || TestObjects::CanInstance(object));
+		}
+
+		// Two instanceable groups in a row with the same state and level of detail should have been one
+		if(g > 0)
+		{
+			const InstanceGroup& previous = groups[g - 1];
+			bool bothInstanceable = TestObjects::CanInstance(objects[previous.firstInstance]) && TestObjects::CanInstance(objects[group.firstInstance]);
+			CHECK(!bothInstanceable || GetSortKeyState(previous.key) != GetSortKeyState(group.key) || previous.lod != group.lod);
+		}
+	}
+	CHECK(instanceCount == test.keys.size());
+	for(uint32_t seen : timesSeen)
+		CHECK(seen == 1);
+}
+
+TEST(InstanceBatcher, OrdersGroupsAndInstances)
+{
+	TestObjects test(5000);
+	InstanceBatcher batcher;
+	test.AddTo(batcher);
+	batcher.Build();
+
+	// Groups in state order, then level of detail; instances within a group nearest first
+	const std::vector<InstanceGroup>& groups = batcher.GetGroups();
+	const std::vector<uint32_t>& objects = batcher.GetObjects();
+	for(size_t g = 1; g < groups.size(); g++)
+	{
+		uint64_t previousState = GetSortKeyState(groups[g - 1].key), state = GetSortKeyState(groups[g].key);
+		CHECK(previousState < state || (previousState == state && groups[g - 1].lod <= groups[g].lod));
+	}
+	for(const InstanceGroup& group : groups)
+	{
+		CHECK(group.key == test.keys[objects[group.firstInstance]]);
+		for(uint32_t i = group.firstInstance + 1; i < group.firstInstance + group.instanceCount; i++)
+			CHECK(test.keys[objects[i - 1]] <= test.keys[objects[i]]);
+	}
+
+	// Objects at exactly the same key keep the order they were added in
+	batcher.Clear();
+	uint64_t key = MakeSortKey(0, 1, 2, 3, 0.5f);
+	for(uint32_t object = 0; object < 100; object++)
+		TestObjects::AddObject(batcher, key, 0, object, true);
+	batcher.Build();
+	CHECK(batcher.GetGroups().size() == 1);
+	for(uint32_t i = 0; i < 100; i++)
+		CHECK(batcher.GetObjects()[i] == i);
+}
+
+TEST(InstanceBatcher, KeepsUnlikeObjectsApart)
+{
+	// Same state and level of detail at different depths share a group; another level of detail,
+	// another mesh or an object that can't be instanced each need their own
+	InstanceBatcher batcher;
+	TestObjects::AddObject(batcher, MakeSortKey(0, 1, 1, 1, 0.75f), 0, 0, true);
+	TestObjects::AddObject(batcher, MakeSortKey(0, 1, 1, 1, 0.25f), 0, 1, true);
+	TestObjects::AddObject(batcher, MakeSortKey(0, 1, 1, 1, 0.5f), 1, 2, true);
+	TestObjects::AddObject(batcher, MakeSortKey(0, 1, 1, 2, 0.5f), 0, 3, true);
+	TestObjects::AddObject(batcher, MakeSortKey(0, 1, 1, 1, 0.1f), 0, 4, false);
+	TestObjects::AddObject(batcher, MakeSortKey(0, 1, 1, 1, 0.9f), 0, 5, false);
+	batcher.Build();
+
+	const std::vector<InstanceGroup>& groups = batcher.GetGroups();
+	const std::vector<uint32_t>& objects = batcher.GetObjects();
+	CHECK(groups.size() == 5);
+	if(groups.size() == 5)
+	{
+		// The lone object sorts in front of the group it can't join, the nearest object behind it starts
+		// the group, and the other lone object sorts last
+		CHECK(groups[0].instanceCount == 1 && objects[groups[0].firstInstance] == 4);
+		CHECK(groups[1].instanceCount == 2 && objects[groups[1].firstInstance] == 1 && objects[groups[1].firstInstance + 1] == 0);
+		CHECK(groups[2].instanceCount == 1 && objects[groups[2].firstInstance] == 5);
+		CHECK(groups[3].instanceCount == 1 && objects[groups[3].firstInstance] == 2 && groups[3].lod == 1);
+		CHECK(groups[4].instanceCount == 1 && objects[groups[4].firstInstance] == 3);
+	}
+
+	// Rebuilding what's added gives the same groups; clearing leaves nothing
+	std::vector<uint32_t> firstObjects = objects;
+	batcher.Build();
+	CHECK(batcher.GetObjects() == firstObjects);
+	batcher.Clear();
+	batcher.Build();
+	CHECK(batcher.GetObjectCount() == 0 && batcher.GetGroups().empty() && batcher.GetInstances().empty());
+}
+
+BENCHMARK(InstanceBatcher, Build)
+{
+	// Grouping has to keep up with every entity in the scene, every frame
+	printf("  %-10s %10s %12s %10s\n", "objects", "groups", "per draw", "build ms");
+	for(size_t count : { 1000, 10000, 100000, 1000000 })
+	{
+		TestObjects test(count);
+		InstanceBatcher batcher;
+		test.AddTo(batcher);
+		double buildMilliseconds = MeasureMilliseconds([&]() { batcher.Build(); });
+		size_t groupCount = batcher.GetGroups().size();
+		printf("  %-10zu %10zu %12.1f %10.3f\n", count, groupCount, (double) count / groupCount, buildMilliseconds);
+	}
+}
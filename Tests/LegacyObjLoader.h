@@ -0,0 +1,15 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include "Vertex.h"
+
+// --------------------------------------------------------
+// The original getline/sscanf_s .OBJ loop from Mesh's file
+// constructor, kept as the reference ParseObj() is checked
+// and benchmarked against
+// - Every corner becomes its own vertex (no welding), and
+//   only triangles and quads are supported
+// --------------------------------------------------------
+void LegacyLoadObj(const std::filesystem::path& filePath, std::vector<Vertex>& verts, std::vector<unsigned int>& indices);
@@ -0,0 +1,124 @@
+#include "LegacyTransform.h"
+
+using namespace DirectX;
+
+LegacyTransform::LegacyTransform() :
+	location(0, 0, 0),
+	rotation(0, 0, 0),
+	scale(1, 1, 1),
+	isWorldMatrixDirty(false)
+{
+	XMStoreFloat4x4(&worldMatrix, XMMatrixIdentity());
+	XMStoreFloat4x4(&worldInverseMatrix, XMMatrixIdentity());
+	XMStoreFloat4x4(&worldInverseTransposeMatrix, XMMatrixIdentity());
+}
+LegacyTransform::LegacyTransform(XMFLOAT3 location, XMFLOAT3 rotation, XMFLOAT3 scale) :
+	location(location),
+	rotation(rotation),
+	scale(scale),
+	isWorldMatrixDirty(true) // Matrices aren't calculated yet
+{
+	XMStoreFloat4x4(&worldMatrix, XMMatrixIdentity());
+	XMStoreFloat4x4(&worldInverseMatrix, XMMatrixIdentity());
+	XMStoreFloat4x4(&worldInverseTransposeMatrix, XMMatrixIdentity());
+}
+
+void LegacyTransform::MoveAbsolute(float x, float y, float z)
+{
+	SetLocation(XMFLOAT3(location.x + x, location.y + y, location.z + z));
+}
+void LegacyTransform::MoveRelative(float x, float y, float z)
+{
+	MoveRelative(XMFLOAT3(x, y, z));
+}
+void LegacyTransform::MoveRelative(XMFLOAT3 offset)
+{
+	// Get the absolute offset by rotating relative offset by this transform's rotation
+	XMVECTOR relOffset = XMLoadFloat3(&offset);
+	XMVECTOR rot = XMQuaternionRotationRollPitchYaw(rotation.x, rotation.y, rotation.z);
+	XMVECTOR absOffset = XMVector3Rotate(relOffset, rot);
+
+	XMFLOAT3 destination;
+	XMStoreFloat3(&destination, XMLoadFloat3(&location) + absOffset);
+	SetLocation(destination);
+}
+void LegacyTransform::Rotate(float pitch, float yaw, float roll)
+{
+	SetRotation(rotation.x + pitch, rotation.y + yaw, rotation.z + roll);
+}
+
+XMFLOAT3 LegacyTransform::GetLocation() { return location; }
+XMFLOAT3 LegacyTransform::GetPitchYawRoll() { return rotation; }
+XMFLOAT3 LegacyTransform::GetScale() { return scale; }
+XMFLOAT3 LegacyTransform::GetRight()
+{
+	XMFLOAT3 right;
+	XMVECTOR rot = XMQuaternionRotationRollPitchYaw(rotation.x, rotation.y, rotation.z);
+	XMStoreFloat3(&right, XMVector3Rotate(XMVectorSet(1, 0, 0, 0), rot));
+	return right;
+}
+XMFLOAT3 LegacyTransform::GetUp()
+{
+	XMFLOAT3 up;
+	XMVECTOR rot = XMQuaternionRotationRollPitchYaw(rotation.x, rotation.y, rotation.z);
+	XMStoreFloat3(&up, XMVector3Rotate(XMVectorSet(0, 1, 0, 0), rot));
+	return up;
+}
+XMFLOAT3 LegacyTransform::GetForward()
+{
+	XMFLOAT3 forward;
+	XMVECTOR rot = XMQuaternionRotationRollPitchYaw(rotation.x, rotation.y, rotation.z);
+	XMStoreFloat3(&forward, XMVector3Rotate(XMVectorSet(0, 0, 1, 0), rot));
+	return forward;
+}
+XMFLOAT4X4 LegacyTransform::GetWorldMatrix()
+{
+	if(isWorldMatrixDirty)
+	{
+		XMMATRIX translation = XMMatrixTranslationFromVector(XMLoadFloat3(&location));
+		XMMATRIX rotationMatrix = XMMatrixRotationRollPitchYawFromVector(XMLoadFloat3(&rotation));
+		XMMATRIX scaleMatrix = XMMatrixScalingFromVector(XMLoadFloat3(&scale));
+
+		XMMATRIX world = scaleMatrix * rotationMatrix * translation;
+
+		XMStoreFloat4x4(&worldMatrix, world);
+		XMStoreFloat4x4(&worldInverseMatrix, XMMatrixInverse(0, world));
+		XMStoreFloat4x4(&worldInverseTransposeMatrix, XMMatrixInverse(0, XMMatrixTranspose(world)));
+
+		isWorldMatrixDirty = false;
+	}
+
+	return worldMatrix;
+}
+XMFLOAT4X4 LegacyTransform::GetWorldInverseMatrix()
+{
+	if(isWorldMatrixDirty)
+		GetWorldMatrix();
+	return worldInverseMatrix;
+}
+XMFLOAT4X4 LegacyTransform::GetWorldInverseTransposeMatrix()
+{
+	if(isWorldMatrixDirty)
+		GetWorldMatrix();
+	return worldInverseTransposeMatrix;
+}
+
+void LegacyTransform::SetLocation(XMFLOAT3 location)
+{
+	this->location = location;
+	isWorldMatrixDirty = true;
+}
+void LegacyTransform::SetRotation(float pitch, float yaw, float roll)
+{
+	SetRotation(XMFLOAT3(pitch, yaw, roll));
+}
+void LegacyTransform::SetRotation(XMFLOAT3 rotation)
+{
+	this->rotation = rotation;
+	isWorldMatrixDirty = true;
+}
+void LegacyTransform::SetScale(XMFLOAT3 scale)
+{
+	this->scale = scale;
+	isWorldMatrixDirty = true;
+}
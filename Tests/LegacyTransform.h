@@ -0,0 +1,49 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// The original Transform: pitch/yaw/roll storage and its own
+// matrices, rebuilt (with general 4x4 inverses) one object at
+// a time whenever they're asked for after a change
+// - Kept as the reference TransformSystem and the quaternion
+//   Transform are checked and benchmarked against
+// --------------------------------------------------------
+class LegacyTransform
+{
+private:
+	DirectX::XMFLOAT3 location;
+	DirectX::XMFLOAT3 rotation;
+	DirectX::XMFLOAT3 scale;
+
+	DirectX::XMFLOAT4X4 worldMatrix;
+	DirectX::XMFLOAT4X4 worldInverseMatrix;
+	DirectX::XMFLOAT4X4 worldInverseTransposeMatrix;
+
+	// Flag for if the stored world matrix needs to be updated to reflect transformations
+	bool isWorldMatrixDirty;
+
+public:
+	LegacyTransform();
+	LegacyTransform(DirectX::XMFLOAT3 location, DirectX::XMFLOAT3 rotation, DirectX::XMFLOAT3 scale);
+
+	void MoveAbsolute(float x, float y, float z);
+	void MoveRelative(float x, float y, float z);
+	void MoveRelative(DirectX::XMFLOAT3 offset);
+	void Rotate(float pitch, float yaw, float roll);
+
+	DirectX::XMFLOAT3 GetLocation();
+	DirectX::XMFLOAT3 GetPitchYawRoll();
+	DirectX::XMFLOAT3 GetScale();
+	DirectX::XMFLOAT3 GetRight();
+	DirectX::XMFLOAT3 GetUp();
+	DirectX::XMFLOAT3 GetForward();
+	DirectX::XMFLOAT4X4 GetWorldMatrix();
+	DirectX::XMFLOAT4X4 GetWorldInverseMatrix();
+	DirectX::XMFLOAT4X4 GetWorldInverseTransposeMatrix();
+
+	void SetLocation(DirectX::XMFLOAT3 location);
+	void SetRotation(float pitch, float yaw, float roll);
+	void SetRotation(DirectX::XMFLOAT3 rotation);
+	void SetScale(DirectX::XMFLOAT3 scale);
+};
@@ -0,0 +1,301 @@
+#include "TestFramework.h"
+#include "TestMeshes.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <map>
+#include <set>
+#include <tuple>
+
+using namespace DirectX;
+
+namespace
+{
+	typedef std::tuple<float, float, float> PositionKey;
+
+	PositionKey GetPositionKey(const Vertex& vertex)
+	{
+		return { vertex.position.x, vertex.position.y, vertex.position.z };
+	}
+
+	// Edges used by only one triangle, matched by position so uv/normal seams don't count as borders
+	std::set<std::pair<PositionKey, PositionKey>> FindOpenEdges(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+	{
+		std::map<std::pair<PositionKey, PositionKey>, int> edgeUses;
+		for(size_t i = 0; i < indices.size(); i += 3)
+		{
+			for(int e = 0; e < 3; e++)
+			{
+				PositionKey a = GetPositionKey(vertices[indices[i + e]]);
+				PositionKey b = GetPositionKey(vertices[indices[i + (e + 1) % 3]]);
+				edgeUses[{ std::min(a, b), std::max(a, b) }]++;
+			}
+		}
+
+		std::set<std::pair<PositionKey, PositionKey>> openEdges;
+		for(const auto& edge : edgeUses)
+		{
+			if(edge.second == 1)
+				openEdges.insert(edge.first);
+		}
+		return openEdges;
+	}
+
+	// Distance from a point to a triangle (Ericson, "Real-Time Collision Detection" 5.1.5)
+	float PointTriangleDistance(XMVECTOR p, XMVECTOR a, XMVECTOR b, XMVECTOR c)
+	{
+		auto dot = [](XMVECTOR u, XMVECTOR v) { return XMVectorGetX(XMVector3Dot(u, v)); };
+		auto distance = [&](XMVECTOR q) { return XMVectorGetX(XMVector3Length(p - q)); };
+
+		XMVECTOR ab = b - a, ac = c - a, ap = p - a;
+		float d1 = dot(ab, ap), d2 = dot(ac, ap);
+		if(d1 <= 0 && d2 <= 0) return distance(a);
+
+		XMVECTOR bp = p - b;
+		float d3 = dot(ab, bp), d4 = dot(ac, bp);
+		if(d3 >= 0 && d4 <= d3) return distance(b);
+
+		float vc = d1 * d4 - d3 * d2;
+		if(vc <= 0 && d1 >= 0 && d3 <= 0) return distance(a + ab * (d1 / (d1 - d3)));
+
+		XMVECTOR cp = p - c;
+		float d5 = dot(ab, cp), d6 = dot(ac, cp);
+		if(d6 >= 0 && d5 <= d6) return distance(c);
+
+		float vb = d5 * d2 - d1 * d6;
+		if(vb <= 0 && d2 >= 0 && d6 <= 0) return distance(a + ac * (d2 / (d2 - d6)));
+
+		float va = d3 * d6 - d5 * d4;
+		if(va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0) return distance(b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6))));
+
+		float denominator = 1.0f / (va + vb + vc);
+		return distance(a + ab * (vb * denominator) + ac * (vc * denominator));
+	}
+
+	// Largest distance from any original vertex to the simplified surface
+	float MeasureSurfaceDistance(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& simplified)
+	{
+		float worst = 0.0f;
+		for(const Vertex& v : vertices)
+		{
+			XMVECTOR p = XMLoadFloat3(&v.position);
+			float nearest = FLT_MAX;
+			for(size_t i = 0; i < simplified.size(); i += 3)
+			{
+				nearest = std::min(nearest, PointTriangleDistance(p,
+					XMLoadFloat3(&vertices[simplified[i]].position),
+					XMLoadFloat3(&vertices[simplified[i + 1]].position),
+					XMLoadFloat3(&vertices[simplified[i + 2]].position)));
+			}
+			worst = std::max(worst, nearest);
+		}
+		return worst;
+	}
+
+	float BoundingDiagonal(const std::vector<Vertex>& vertices)
+	{
+		XMVECTOR min = XMLoadFloat3(&vertices[0].position);
+		XMVECTOR max = min;
+		for(const Vertex& v : vertices)
+		{
+			min = XMVectorMin(min, XMLoadFloat3(&v.position));
+			max = XMVectorMax(max, XMLoadFloat3(&v.position));
+		}
+		return XMVectorGetX(XMVector3Length(max - min));
+	}
+
+	struct SimplifiedLevel
+	{
+		float ratio;
+		size_t targetIndexCount;
+		std::vector<unsigned int> indices;
+		float error;
+	};
+
+	// Simplifies a model into each of the levels LoadMeshData() builds
+	std::vector<SimplifiedLevel> SimplifyModel(const std::filesystem::path& model, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+	{
+		LoadTestModel(model, vertices, indices);
+		OptimizeVertexCache(indices.data(), indices.size(), vertices.size());
+
+		std::vector<SimplifiedLevel> levels;
+		for(float ratio : MeshLodTriangleRatios)
+		{
+			SimplifiedLevel level = { ratio, (size_t) (indices.size() / 3 * ratio) * 3, {}, 0.0f };
+			level.indices = SimplifyMesh(vertices.data(), vertices.size(), indices.data(), indices.size(), level.targetIndexCount, level.error);
+			levels.push_back(level);
+		}
+		return levels;
+	}
+
+	// Total area of the triangles projected onto the XZ plane (which, for a grid
+	// that doesn't fold over, is the area its border encloses)
+	float ProjectedArea(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+	{
+		float area = 0.0f;
+		for(size_t i = 0; i < indices.size(); i += 3)
+		{
+			const XMFLOAT3& a = vertices[indices[i]].position;
+			const XMFLOAT3& b = vertices[indices[i + 1]].position;
+			const XMFLOAT3& c = vertices[indices[i + 2]].position;
+			area += fabsf((b.x - a.x) * (c.z - a.z) - (c.x - a.x) * (b.z - a.z)) * 0.5f;
+		}
+		return area;
+	}
+}
+
+// Meshes smaller than this are mostly corners (which never move), so they may not simplify at all
+const size_t MinSimplifiableTriangles = 100;
+
+TEST(MeshSimplifier, HitsTriangleTargets)
+{
+	for(const auto& model : GetBundledModels())
+	{
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+		size_t previousCount = SIZE_MAX;
+		for(const SimplifiedLevel& level : SimplifyModel(model, vertices, indices))
+		{
+			CHECK(!level.indices.empty());
+			CHECK(level.indices.size() % 3 == 0);
+			CHECK(level.indices.size() <= indices.size());
+			CHECK(level.indices.size() <= previousCount);
+			previousCount = level.indices.size();
+
+			// Big meshes should get close to each target; some stop a little early once
+			// the only collapses left would fold the surface
+			if(indices.size() / 3 >= MinSimplifiableTriangles)
+				CHECK(level.indices.size() * 4 <= level.targetIndexCount * 5);
+
+			size_t degenerate = 0;
+			for(size_t i = 0; i < level.indices.size(); i += 3)
+			{
+				const unsigned int* t = &level.indices[i];
+				CHECK(t[0] < vertices.size() && t[1] < vertices.size() && t[2] < vertices.size());
+				if(t[0] == t[1] || t[1] == t[2] || t[0] == t[2])
+					degenerate++;
+			}
+			CHECK(degenerate == 0);
+		}
+	}
+
+	// A grid has few corners or seams in the way, so it should land right around each target
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	MakeTestGrid(32, false, vertices, indices);
+	for(float ratio : MeshLodTriangleRatios)
+	{
+		size_t target = (size_t) (indices.size() / 3 * ratio) * 3;
+		float error;
+		std::vector<unsigned int> simplified = SimplifyMesh(vertices.data(), vertices.size(), indices.data(), indices.size(), target, error);
+		CHECK(simplified.size() * 20 <= target * 21);
+		CHECK(simplified.size() * 20 >= target * 19);
+	}
+}
+
+TEST(MeshSimplifier, ErrorBounds)
+{
+	for(const auto& model : GetBundledModels())
+	{
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+		std::vector<SimplifiedLevel> levels = SimplifyModel(model, vertices, indices);
+		float diagonal = BoundingDiagonal(vertices);
+
+		float previousError = 0.0f;
+		for(const SimplifiedLevel& level : levels)
+		{
+			// The reported error is a distance to the planes of the original triangles, which
+			// can undershoot the distance to the triangles themselves, but not by much
+			float measured = MeasureSurfaceDistance(vertices, level.indices);
+			CHECK(level.error >= 0.0f);
+			CHECK(measured <= level.error * 4.0f + diagonal * 1e-5f);
+
+			// Coarser levels never claim to be more accurate
+			CHECK(level.error >= previousError);
+			previousError = level.error;
+
+			// Halving the triangles of a smooth mesh shouldn't visibly change its shape
+			if(level.ratio == MeshLodTriangleRatios[0])
+				CHECK(measured <= diagonal * 0.03f);
+		}
+	}
+}
+
+TEST(MeshSimplifier, PreservesBoundaries)
+{
+	for(const auto& model : GetBundledModels())
+	{
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+		std::vector<SimplifiedLevel> levels = SimplifyModel(model, vertices, indices);
+
+		std::set<PositionKey> borderPositions;
+		for(const auto& edge : FindOpenEdges(vertices, indices))
+		{
+			borderPositions.insert(edge.first);
+			borderPositions.insert(edge.second);
+		}
+
+		for(const SimplifiedLevel& level : levels)
+		{
+			// Closed meshes stay closed, and open ones only have borders where they did before
+			for(const auto& edge : FindOpenEdges(vertices, level.indices))
+			{
+				CHECK(borderPositions.count(edge.first) == 1);
+				CHECK(borderPositions.count(edge.second) == 1);
+			}
+		}
+	}
+
+	// The quads are all corners, so they can't lose any area (cutting a quad along its
+	// diagonal used to pass as a border collapse)
+	for(const char* quad : { "Models/quad.obj", "Models/quad_double_sided.obj" })
+	{
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+		for(const SimplifiedLevel& level : SimplifyModel(GetAssetPath(quad), vertices, indices))
+			CHECK(level.indices.size() == indices.size());
+	}
+
+	// Simplified far past where the interior runs out, a grid still covers its whole square
+	// and keeps every corner
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	MakeTestGrid(32, false, vertices, indices);
+	float error;
+	std::vector<unsigned int> simplified = SimplifyMesh(vertices.data(), vertices.size(), indices.data(), indices.size(), 6, error);
+	CHECK_NEAR(ProjectedArea(vertices, simplified), 4.0f, 1e-4f);
+
+	unsigned int rowLength = 33;
+	for(unsigned int corner : { 0u, rowLength - 1, rowLength * (rowLength - 1), rowLength * rowLength - 1 })
+		CHECK(std::find(simplified.begin(), simplified.end(), corner) != simplified.end());
+}
+
+BENCHMARK(MeshSimplifier, Lods)
+{
+	for(const auto& model : GetBundledModels())
+	{
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+		LoadTestModel(model, vertices, indices);
+		OptimizeVertexCache(indices.data(), indices.size(), vertices.size());
+
+		printf("  %-24s %7zu triangles\n", model.filename().string().c_str(), indices.size() / 3);
+		for(float ratio : MeshLodTriangleRatios)
+		{
+			size_t target = (size_t) (indices.size() / 3 * ratio) * 3;
+			std::vector<unsigned int> simplified;
+			float error = 0.0f;
+			double ms = MeasureMilliseconds([&]()
+			{
+				simplified = SimplifyMesh(vertices.data(), vertices.size(), indices.data(), indices.size(), target, error);
+			});
+			printf("    %5.1f%%: %7zu triangles (target %7zu), error %.4f, %8.3f ms\n",
+				ratio * 100.0f, simplified.size() / 3, target / 3, error, ms);
+		}
+	}
+}
@@ -0,0 +1,157 @@
+#include "TestFramework.h"
+#include "TestMeshes.h"
+#include "MeshTangents.h"
+
+#include <cstring>
+
+namespace
+{
+	struct TestMesh
+	{
+		std::string name;
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+	};
+
+	// Every bundled model, plus a grid big enough to be split into many chunks
+	std::vector<TestMesh> GetTangentTestMeshes()
+	{
+		std::vector<TestMesh> meshes;
+		for(const auto& model : GetBundledModels())
+		{
+			meshes.emplace_back();
+			meshes.back().name = model.filename().string();
+			LoadTestModel(model, meshes.back().vertices, meshes.back().indices);
+		}
+
+		meshes.emplace_back();
+		meshes.back().name = "grid";
+		MakeTestGrid(256, true, meshes.back().vertices, meshes.back().indices);
+		return meshes;
+	}
+
+	// Kernels the CPU can run (they're ordered from slowest to fastest)
+	std::vector<TangentKernel> GetSupportedKernels()
+	{
+		std::vector<TangentKernel> kernels;
+		for(int kernel = 0; kernel <= (int) GetBestTangentKernel(); kernel++)
+			kernels.push_back((TangentKernel) kernel);
+
+		if(GetBestTangentKernel() != TangentKernel::AVX2)
+			printf("  (%s is the best kernel this CPU supports; faster ones are untested)\n", GetTangentKernelName(GetBestTangentKernel()));
+		return kernels;
+	}
+
+	bool SameVertices(const std::vector<Vertex>& a, const std::vector<Vertex>& b)
+	{
+		return a.size() == b.size() && memcmp(a.data(), b.data(), a.size() * sizeof(Vertex)) == 0;
+	}
+}
+
+// The serial and parallel paths, with every kernel, must agree bit for bit
+TEST(MeshTangents, SerialMatchesParallel)
+{
+	// More threads than most test machines have cores, so chunks really do interleave
+	ThreadPool threadPool(8);
+
+	for(const TestMesh& mesh : GetTangentTestMeshes())
+	{
+		std::vector<Vertex> reference = mesh.vertices;
+		CalculateTangentsSerial(reference.data(), reference.size(), mesh.indices.data(), mesh.indices.size(), TangentKernel::Scalar);
+
+		for(TangentKernel kernel : GetSupportedKernels())
+		{
+			std::vector<Vertex> serial = mesh.vertices;
+			CalculateTangentsSerial(serial.data(), serial.size(), mesh.indices.data(), mesh.indices.size(), kernel);
+			CHECK(SameVertices(serial, reference));
+
+			std::vector<Vertex> parallel = mesh.vertices;
+			CalculateTangentsParallel(parallel.data(), parallel.size(), mesh.indices.data(), mesh.indices.size(), threadPool, kernel);
+			CHECK(SameVertices(parallel, reference));
+
+			if(!SameVertices(serial, reference) || !SameVertices(parallel, reference))
+				printf("  mismatch on %s with the %s kernel\n", mesh.name.c_str(), GetTangentKernelName(kernel));
+		}
+	}
+}
+
+// Each kernel on its own, including the leftover triangles that don't fill a SIMD register
+TEST(MeshTangents, KernelsMatchScalar)
+{
+	for(const TestMesh& mesh : GetTangentTestMeshes())
+	{
+		size_t triangleCount = mesh.indices.size() / 3;
+		std::vector<DirectX::XMFLOAT3> reference(triangleCount);
+		CalculateTriangleTangents(mesh.vertices.data(), mesh.indices.data(), 0, triangleCount, reference.data(), TangentKernel::Scalar);
+
+		for(TangentKernel kernel : GetSupportedKernels())
+		{
+			// Start at an odd triangle so both the head and tail are partial
+			size_t begin = triangleCount > 1 ? 1 : 0;
+			std::vector<DirectX::XMFLOAT3> tangents(triangleCount);
+			CalculateTriangleTangents(mesh.vertices.data(), mesh.indices.data(), begin, triangleCount, tangents.data(), kernel);
+			CHECK(memcmp(&tangents[begin], &reference[begin], (triangleCount - begin) * sizeof(DirectX::XMFLOAT3)) == 0);
+		}
+	}
+}
+
+TEST(MeshTangents, TangentsFollowU)
+{
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	MakeTestGrid(16, false, vertices, indices);
+	CalculateTangentsSerial(vertices.data(), vertices.size(), indices.data(), indices.size());
+
+	// U increases along +X, so tangents point that way, perpendicular to the normal
+	for(const Vertex& v : vertices)
+	{
+		CHECK(v.tangent.x > 0.95f);
+		CHECK_NEAR(v.tangent.x * v.tangent.x + v.tangent.y * v.tangent.y + v.tangent.z * v.tangent.z, 1.0, 1e-4);
+		CHECK_NEAR(v.tangent.x * v.normal.x + v.tangent.y * v.normal.y + v.tangent.z * v.normal.z, 0.0, 1e-4);
+	}
+}
+
+BENCHMARK(MeshTangents, SerialVsParallel)
+{
+	printf("  %-12s %10s %12s %12s %8s\n", "triangles", "threads", "serial ms", "parallel ms", "speedup");
+	for(unsigned int cells : { 64u, 128u, 256u, 512u, 1024u })
+	{
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+		MakeTestGrid(cells, true, vertices, indices);
+
+		double serialMilliseconds = MeasureMilliseconds([&]() { CalculateTangentsSerial(vertices.data(), vertices.size(), indices.data(), indices.size()); });
+		double parallelMilliseconds = MeasureMilliseconds([&]()
+			{
+				CalculateTangentsParallel(vertices.data(), vertices.size(), indices.data(), indices.size(), ThreadPool::Global());
+			});
+
+		printf("  %-12zu %10u %12.3f %12.3f %7.2fx\n", indices.size() / 3, ThreadPool::Global().GetThreadCount() + 1,
+			serialMilliseconds, parallelMilliseconds, serialMilliseconds / parallelMilliseconds);
+	}
+}
+
+BENCHMARK(MeshTangents, Kernels)
+{
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	MakeTestGrid(512, true, vertices, indices);
+
+	size_t triangleCount = indices.size() / 3;
+	std::vector<DirectX::XMFLOAT3> tangents(triangleCount);
+
+	printf("  %-8s %12s %16s %8s\n", "kernel", "ms", "Mtriangles/s", "speedup");
+	double scalarMilliseconds = 0.0;
+	for(TangentKernel kernel : GetSupportedKernels())
+	{
+		double milliseconds = MeasureMilliseconds([&]()
+			{
+				CalculateTriangleTangents(vertices.data(), indices.data(), 0, triangleCount, tangents.data(), kernel);
+			}, 10);
+		if(kernel == TangentKernel::Scalar)
+			scalarMilliseconds = milliseconds;
+
+		printf("  %-8s %12.3f %16.1f %7.2fx\n", GetTangentKernelName(kernel), milliseconds,
+			triangleCount / (milliseconds * 1000.0), scalarMilliseconds / milliseconds);
+	}
+}
@@ -0,0 +1,207 @@
+#include "TestFramework.h"
+#include "TestMeshes.h"
+#include "MeshOptimizer.h"
+#include "Meshlets.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	struct MeshletMesh
+	{
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+		std::vector<unsigned int> originalIndices;
+		std::vector<Meshlet> meshlets;
+		XMFLOAT3 center;
+		float radius;
+	};
+
+	// Builds meshlets the way LoadMeshData() does
+	MeshletMesh BuildTestMeshlets(std::vector<Vertex> vertices, std::vector<unsigned int> indices)
+	{
+		MeshletMesh mesh;
+		mesh.vertices = std::move(vertices);
+		mesh.indices = std::move(indices);
+		OptimizeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+		mesh.originalIndices = mesh.indices;
+		mesh.meshlets = BuildMeshlets(mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size());
+
+		// Rough bounding sphere, for placing cameras around it
+		XMVECTOR sum = XMVectorZero();
+		for(const Vertex& v : mesh.vertices)
+			sum += XMLoadFloat3(&v.position);
+		XMVECTOR center = sum / (float) mesh.vertices.size();
+		XMStoreFloat3(&mesh.center, center);
+
+		mesh.radius = 0.0f;
+		for(const Vertex& v : mesh.vertices)
+			mesh.radius = std::max(mesh.radius, XMVectorGetX(XMVector3Length(XMLoadFloat3(&v.position) - center)));
+		return mesh;
+	}
+
+	MeshletMesh BuildTestMeshlets(const std::filesystem::path& model)
+	{
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+		LoadTestModel(model, vertices, indices);
+		return BuildTestMeshlets(vertices, indices);
+	}
+
+	XMVECTOR TriangleNormal(const MeshletMesh& mesh, const unsigned int* triangle)
+	{
+		XMVECTOR a = XMLoadFloat3(&mesh.vertices[triangle[0]].position);
+		XMVECTOR b = XMLoadFloat3(&mesh.vertices[triangle[1]].position);
+		XMVECTOR c = XMLoadFloat3(&mesh.vertices[triangle[2]].position);
+		return XMVector3Cross(b - a, c - a);
+	}
+
+	std::vector<std::array<unsigned int, 3>> SortedTriangles(const std::vector<unsigned int>& indices)
+	{
+		std::vector<std::array<unsigned int, 3>> triangles;
+		for(size_t i = 0; i < indices.size(); i += 3)
+			triangles.push_back({ indices[i], indices[i + 1], indices[i + 2] });
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	// Camera i of count, spread evenly over a sphere around the mesh and looking at its center
+	void GetTestView(const MeshletMesh& mesh, int i, int count, XMFLOAT3& eye, Frustum& frustum)
+	{
+		// Fibonacci sphere
+		float y = 1.0f - 2.0f * (i + 0.5f) / count;
+		float ring = std::sqrt(1.0f - y * y);
+		float angle = i * 2.39996323f;
+		float distance = mesh.radius * 3.0f;
+		eye = XMFLOAT3(
+			mesh.center.x + distance * ring * std::cos(angle),
+			mesh.center.y + distance * y,
+			mesh.center.z + distance * ring * std::sin(angle));
+
+		XMVECTOR eyePosition = XMLoadFloat3(&eye);
+		XMVECTOR up = std::abs(y) > 0.99f ? XMVectorSet(1, 0, 0, 0) : XMVectorSet(0, 1, 0, 0);
+		XMMATRIX view = XMMatrixLookToLH(eyePosition, XMLoadFloat3(&mesh.center) - eyePosition, up);
+		XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 100.0f);
+
+		XMFLOAT4X4 viewProjection;
+		XMStoreFloat4x4(&viewProjection, view * projection);
+		frustum = Frustum::FromMatrix(viewProjection);
+	}
+}
+
+TEST(Meshlets, BuildsValidMeshlets)
+{
+	for(const auto& model : GetBundledModels())
+	{
+		MeshletMesh mesh = BuildTestMeshlets(model);
+		CHECK(!mesh.meshlets.empty());
+
+		// Reordering keeps every triangle (with its winding)
+		CHECK(SortedTriangles(mesh.indices) == SortedTriangles(mesh.originalIndices));
+
+		unsigned int nextIndex = 0;
+		for(const Meshlet& meshlet : mesh.meshlets)
+		{
+			// Meshlets tile the index buffer in order
+			CHECK(meshlet.indexOffset == nextIndex);
+			nextIndex += meshlet.triangleCount * 3;
+
+			CHECK(meshlet.triangleCount > 0 && meshlet.triangleCount <= MaxMeshletTriangles);
+			CHECK(meshlet.vertexCount > 0 && meshlet.vertexCount <= MaxMeshletVertices);
+
+			XMVECTOR center = XMLoadFloat3(&meshlet.center);
+			XMVECTOR axis = XMLoadFloat3(&meshlet.coneAxis);
+			for(unsigned int t = 0; t < meshlet.triangleCount; t++)
+			{
+				const unsigned int* triangle = &mesh.indices[meshlet.indexOffset + t * 3];
+
+				// Bounds hold every vertex...
+				for(int k = 0; k < 3; k++)
+				{
+					float distance = XMVectorGetX(XMVector3Length(XMLoadFloat3(&mesh.vertices[triangle[k]].position) - center));
+					CHECK(distance <= meshlet.radius * 1.0001f + 1e-6f);
+				}
+
+				// ...and the cone holds every (non-degenerate) triangle's facing
+				XMVECTOR normal = TriangleNormal(mesh, triangle);
+				if(meshlet.coneCutoff > 0.0f && XMVectorGetX(XMVector3LengthSq(normal)) > 0.0f)
+					CHECK(XMVectorGetX(XMVector3Dot(XMVector3Normalize(normal), axis)) >= meshlet.coneCutoff - 1e-5f);
+			}
+		}
+		CHECK(nextIndex == mesh.indices.size());
+	}
+}
+
+// Cone culling may only ever drop triangles that really face away
+TEST(Meshlets, ConeCullingIsConservative)
+{
+	for(const auto& model : GetBundledModels())
+	{
+		MeshletMesh mesh = BuildTestMeshlets(model);
+
+		size_t wronglyCulled = 0;
+		for(int view = 0; view < 64; view++)
+		{
+			XMFLOAT3 eye;
+			Frustum frustum;
+			GetTestView(mesh, view, 64, eye, frustum);
+
+			for(const Meshlet& meshlet : mesh.meshlets)
+			{
+				if(IsMeshletFrontFacing(meshlet, eye))
+					continue;
+
+				for(unsigned int t = 0; t < meshlet.triangleCount; t++)
+				{
+					const unsigned int* triangle = &mesh.indices[meshlet.indexOffset + t * 3];
+					XMVECTOR toTriangle = XMLoadFloat3(&mesh.vertices[triangle[0]].position) - XMLoadFloat3(&eye);
+					if(XMVectorGetX(XMVector3Dot(toTriangle, TriangleNormal(mesh, triangle))) < -1e-6f)
+						wronglyCulled++;
+				}
+			}
+		}
+		CHECK(wronglyCulled == 0);
+	}
+}
+
+// Closed meshes viewed from outside have about half their surface facing away,
+// and the normal cones have to catch a good share of that
+// - The denser the mesh, the flatter (and more cullable) each meshlet is, so
+//   the coarse bundled models have lower floors than the generated sphere
+TEST(Meshlets, CulledTriangleRatio)
+{
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	MakeTestSphere(128, 64, vertices, indices);
+
+	struct Case { const char* name; MeshletMesh mesh; float minimumRatio; };
+	Case cases[] =
+	{
+		{ "dense sphere", BuildTestMeshlets(vertices, indices), 0.45f },
+		{ "sphere.obj", BuildTestMeshlets(GetAssetPath("Models/sphere.obj")), 0.15f },
+		{ "helix.obj", BuildTestMeshlets(GetAssetPath("Models/helix.obj")), 0.07f },
+		{ "torus.obj", BuildTestMeshlets(GetAssetPath("Models/torus.obj")), 0.02f },
+	};
+
+	for(const Case& test : cases)
+	{
+		MeshletCullStatistics statistics = {};
+		for(int view = 0; view < 64; view++)
+		{
+			XMFLOAT3 eye;
+			Frustum frustum;
+			GetTestView(test.mesh, view, 64, eye, frustum);
+
+			std::vector<IndexRange> visibleRanges;
+			CullMeshlets(test.mesh.meshlets.data(), test.mesh.meshlets.size(), frustum, eye, visibleRanges, statistics);
+		}
+
+		float culledRatio = (float) statistics.trianglesCulled / (statistics.trianglesCulled + statistics.trianglesVisible);
+		printf("  %s: %zu meshlets, %.1f%% of triangles culled\n", test.name, test.mesh.meshlets.size(), culledRatio * 100.0f);
+		CHECK(culledRatio >= test.minimumRatio);
+	}
+}
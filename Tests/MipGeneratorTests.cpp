@@ -0,0 +1,168 @@
+#include "TestFramework.h"
+#include "TestImages.h"
+#include "MipGenerator.h"
+#include "PngLoader.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+	// The whole chain, with the image itself as mip 0
+	std::vector<Image> MakeMipChain(const Image& image, const MipOptions& options)
+	{
+		std::vector<Image> mips = { image };
+		GenerateMips(image, options, mips);
+		return mips;
+	}
+
+	Image LoadTestTexture(const char* relativePath)
+	{
+		Image image = {};
+		CHECK(LoadPng(GetAssetPath(relativePath).wstring().c_str(), image));
+		return image;
+	}
+
+	Image MakeConstantImage(unsigned int width, unsigned int height, const uint8_t (&color)[4])
+	{
+		Image image = { width, height, 4, false, std::vector<uint8_t>((size_t) width * height * 4) };
+		for(size_t i = 0; i < image.pixels.size(); i++)
+			image.pixels[i] = color[i % 4];
+		return image;
+	}
+
+	// Gradients and a bright square, small and oddly sized, so one golden file covers a whole
+	// chain where neither side halves evenly
+	Image MakeOddSizedImage()
+	{
+		Image image = { 37, 23, 4, true, std::vector<uint8_t>(37 * 23 * 4) };
+		for(unsigned int y = 0; y < image.height; y++)
+		{
+			for(unsigned int x = 0; x < image.width; x++)
+			{
+				uint8_t* pixel = &image.pixels[(y * image.width + x) * 4];
+				bool inSquare = x >= 10 && x < 17 && y >= 5 && y < 12;
+				pixel[0] = (uint8_t) (x * 255 / 36);
+				pixel[1] = (uint8_t) (y * 255 / 22);
+				pixel[2] = inSquare ? 255 : 40;
+				pixel[3] = (uint8_t) ((x + y) % 2 ? 255 : 128);
+			}
+		}
+		return image;
+	}
+}
+
+TEST(MipGenerator, MipCounts)
+{
+	CHECK(GetMipCount(1, 1) == 1);
+	CHECK(GetMipCount(1024, 1024) == 11);
+	CHECK(GetMipCount(1024, 16) == 11);
+	CHECK(GetMipCount(37, 23) == 6);
+
+	// Each level halves (rounding down) until both sides reach 1
+	std::vector<Image> mips = MakeMipChain(MakeOddSizedImage(), { true, false });
+	CHECK(mips.size() == GetMipCount(37, 23));
+	for(size_t i = 1; i < mips.size(); i++)
+	{
+		CHECK(mips[i].width == std::max(1u, mips[i - 1].width / 2));
+		CHECK(mips[i].height == std::max(1u, mips[i - 1].height / 2));
+		CHECK(mips[i].channels == 4);
+		CHECK(mips[i].isSRGB);
+		CHECK(mips[i].pixels.size() == (size_t) mips[i].width * mips[i].height * 4);
+	}
+	CHECK(mips.back().width == 1 && mips.back().height == 1);
+}
+
+// The filter's weights have to sum to 1 at every position, odd sizes and edges included
+TEST(MipGenerator, ConstantImagesStayConstant)
+{
+	const uint8_t color[4] = { 200, 13, 77, 255 };
+	for(auto size : { std::pair{ 64u, 64u }, { 37u, 5u }, { 1u, 9u } })
+	{
+		for(bool isGammaEncoded : { false, true })
+		{
+			int worst = 0;
+			for(const Image& mip : MakeMipChain(MakeConstantImage(size.first, size.second, color), { isGammaEncoded, false }))
+			{
+				for(size_t i = 0; i < mip.pixels.size(); i++)
+					worst = std::max(worst, std::abs(mip.pixels[i] - color[i % 4]));
+			}
+			CHECK(worst <= 1);
+		}
+	}
+}
+
+// A black and white checkerboard averages to half the light, which is mid gray in linear
+// space but pow(0.5, 1 / 2.2) = 186 once gamma encoded
+TEST(MipGenerator, FiltersInLinearSpace)
+{
+	Image checkerboard = { 64, 64, 1, false, std::vector<uint8_t>(64 * 64) };
+	for(unsigned int y = 0; y < 64; y++)
+	{
+		for(unsigned int x = 0; x < 64; x++)
+			checkerboard.pixels[y * 64 + x] = ((x + y) & 1) ? 255 : 0;
+	}
+
+	CHECK_NEAR(MakeMipChain(checkerboard, { false, false }).back().pixels[0], 128, 1);
+	CHECK_NEAR(MakeMipChain(checkerboard, { true, false }).back().pixels[0], 186, 1);
+}
+
+TEST(MipGenerator, NormalsStayUnitLength)
+{
+	std::vector<Image> mips = MakeMipChain(LoadTestTexture("Textures/PBR/wood_normals.png"), { false, true });
+
+	double worst = 0.0;
+	for(size_t i = 1; i < mips.size(); i++)
+	{
+		for(size_t p = 0; p < mips[i].pixels.size(); p += mips[i].channels)
+		{
+			const uint8_t* n = &mips[i].pixels[p];
+			double x = n[0] / 127.5 - 1.0, y = n[1] / 127.5 - 1.0, z = n[2] / 127.5 - 1.0;
+			worst = std::max(worst, std::fabs(std::sqrt(x * x + y * y + z * z) - 1.0));
+		}
+	}
+
+	// Anything past 8-bit rounding (up to half a step per component) means a mip wasn't renormalized
+	CHECK(worst < 0.01);
+}
+
+// The small end of each chain, against reference images (regenerate them with --update-golden
+// after deliberately changing the filter)
+TEST(MipGenerator, GoldenImages)
+{
+	struct GoldenCase
+	{
+		const char* source;
+		MipOptions options;
+		const char* golden;
+	};
+	const GoldenCase cases[] =
+	{
+		{ "Textures/PBR/wood_albedo.png", { true, false }, "mips_wood_albedo.png" },
+		{ "Textures/PBR/wood_normals.png", { false, true }, "mips_wood_normals.png" },
+		{ "Textures/PBR/wood_roughness.png", { false, false }, "mips_wood_roughness.png" },
+	};
+	for(const GoldenCase& test : cases)
+		CHECK(MatchesGoldenImage(test.golden, MakeMipStrip(MakeMipChain(LoadTestTexture(test.source), test.options), 64), 1));
+
+	CHECK(MatchesGoldenImage("mips_odd_size.png", MakeMipStrip(MakeMipChain(MakeOddSizedImage(), { true, false }), 37), 1));
+}
+
+BENCHMARK(MipGenerator, GenerateMips)
+{
+	const char* textures[] = { "Textures/PBR/wood_albedo.png", "Textures/PBR/wood_normals.png", "Textures/PBR/wood_roughness.png" };
+	for(const char* texture : textures)
+	{
+		Image image = LoadTestTexture(texture);
+		MipOptions options = { strstr(texture, "_albedo") != nullptr, strstr(texture, "_normals") != nullptr };
+
+		double ms = MeasureMilliseconds([&]()
+		{
+			std::vector<Image> mips;
+			GenerateMips(image, options, mips);
+		});
+		double megapixels = (double) image.width * image.height / 1000000.0;
+		printf("  %-32s %4ux%-4u x%u: %8.3f ms (%.1f MP/s)\n", texture, image.width, image.height, image.channels, ms, megapixels / (ms / 1000.0));
+	}
+}
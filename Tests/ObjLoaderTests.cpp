@@ -0,0 +1,197 @@
+#include "TestFramework.h"
+#include "LegacyObjLoader.h"
+#include "ObjLoader.h"
+#include "MeshData.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+namespace
+{
+	// ParseFloat() and sscanf may round the last bit differently
+	bool NearlyEqual(float a, float b)
+	{
+		return fabsf(a - b) <= 1e-6f * (1.0f + fabsf(b));
+	}
+
+	bool NearlyEqual(const Vertex& a, const Vertex& b)
+	{
+		return
+			NearlyEqual(a.position.x, b.position.x) && NearlyEqual(a.position.y, b.position.y) && NearlyEqual(a.position.z, b.position.z) &&
+			NearlyEqual(a.normal.x, b.normal.x) && NearlyEqual(a.normal.y, b.normal.y) && NearlyEqual(a.normal.z, b.normal.z) &&
+			NearlyEqual(a.uv.x, b.uv.x) && NearlyEqual(a.uv.y, b.uv.y);
+	}
+
+	void ParseText(const char* text, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+	{
+		ParseObj(text, strlen(text), vertices, indices);
+	}
+}
+
+// Expanding the welded index buffer has to give back exactly the
+// triangles the old loader produced, corner for corner
+TEST(ObjLoader, MatchesLegacyLoader)
+{
+	for(const auto& model : GetBundledModels())
+	{
+		std::vector<Vertex> vertices, legacyVertices;
+		std::vector<unsigned int> indices, legacyIndices;
+		CHECK(LoadObj(model.wstring().c_str(), vertices, indices));
+		LegacyLoadObj(model, legacyVertices, legacyIndices);
+
+		CHECK(!indices.empty());
+		CHECK(indices.size() == legacyIndices.size());
+		if(indices.size() != legacyIndices.size())
+			continue;
+
+		size_t mismatches = 0;
+		for(size_t i = 0; i < indices.size(); i++)
+		{
+			if(indices[i] >= vertices.size() || !NearlyEqual(vertices[indices[i]], legacyVertices[legacyIndices[i]]))
+				mismatches++;
+		}
+		CHECK(mismatches == 0);
+	}
+}
+
+// Corners that share (v, vt, vn) indices become one vertex, so there
+// are exactly as many vertices as distinct corners in the file
+TEST(ObjLoader, WeldsSharedCorners)
+{
+	std::filesystem::path directory = MakeScratchDirectory("ObjLoaderWelds");
+	for(const auto& model : GetBundledModels())
+	{
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+		LoadObj(model.wstring().c_str(), vertices, indices);
+		CHECK(vertices.size() < indices.size());
+
+		std::vector<bool> isUsed(vertices.size(), false);
+		for(unsigned int index : indices)
+			isUsed[index] = true;
+		CHECK(std::find(isUsed.begin(), isUsed.end(), false) == isUsed.end());
+
+		std::set<std::string> corners;
+		std::ifstream file(model);
+		for(std::string line; std::getline(file, line);)
+		{
+			if(line.rfind("f ", 0) != 0)
+				continue;
+
+			std::istringstream face(line.substr(2));
+			for(std::string corner; face >> corner;)
+				corners.insert(corner);
+		}
+		CHECK(corners.size() == vertices.size());
+
+		// Processed meshes keep both counts, from the source and from the cooked file alike (loading
+		// a copy, as meshes are cooked next to their source)
+		std::filesystem::path copy = directory / model.filename();
+		std::filesystem::copy_file(model, copy);
+		for(int load = 0; load < 2; load++)
+		{
+			MeshData data;
+			CHECK(LoadMeshData(copy.wstring().c_str(), data));
+			CHECK(data.sourceVertexCount == indices.size());
+			CHECK(data.vertices.size() == vertices.size());
+		}
+	}
+
+	// Two triangles sharing a diagonal
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	LoadObj(GetAssetPath("Models/quad.obj").wstring().c_str(), vertices, indices);
+	CHECK(vertices.size() == 4);
+	CHECK(indices.size() == 6);
+}
+
+TEST(ObjLoader, ParsesFloats)
+{
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	ParseText(
+		"v -1.25 3 .5\n"
+		"v 1.0e-3 +2.5E2 -0\n"
+		"v 0.1234567890123456789012 100 1e30\n"
+		"f 1 2 3", vertices, indices);
+
+	CHECK(vertices.size() == 3);
+	if(vertices.size() != 3)
+		return;
+
+	// Z is flipped into DirectX's left-handed space
+	CHECK(vertices[0].position.x == -1.25f && vertices[0].position.y == 3.0f && vertices[0].position.z == -0.5f);
+	CHECK(vertices[1].position.x == 1.0e-3f && vertices[1].position.y == 250.0f && vertices[1].position.z == 0.0f);
+	CHECK(NearlyEqual(vertices[2].position.x, 0.12345679f) && vertices[2].position.z == -1e30f);
+}
+
+TEST(ObjLoader, TriangulatesAndWelds)
+{
+	// A pentagon and a triangle sharing an edge, using relative (negative)
+	// indices, no uvs, Windows line endings and no final line break
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	ParseText(
+		"# comment\r\n"
+		"v 0 0 0\r\nv 1 0 0\r\nv 1 1 0\r\nv 0.5 2 0\r\nv 0 1 0\r\nv 2 1 0\r\n"
+		"vn 0 0 1\r\n"
+		"f 1//1 2//1 3//1 4//1 5//1\r\n"
+		"f -5//-1 -1//-1 -4//-1", vertices, indices);
+
+	// 6 unique corners, 3 + 1 triangles
+	CHECK(vertices.size() == 6);
+	CHECK(indices.size() == 12);
+	if(indices.size() != 12)
+		return;
+
+	// Fan from the first corner with the winding flipped: (0, 2, 1), (0, 3, 2), (0, 4, 3)
+	const unsigned int expected[] = { 0, 2, 1, 0, 3, 2, 0, 4, 3, 1, 2, 5 };
+	CHECK(memcmp(indices.data(), expected, sizeof(expected)) == 0);
+
+	// Flipped normal Z and uvs defaulting to (0, 1 - 0)
+	CHECK(vertices[0].normal.z == -1.0f);
+	CHECK(vertices[0].uv.x == 0.0f && vertices[0].uv.y == 1.0f);
+}
+
+TEST(ObjLoader, HandlesLongLines)
+{
+	// The old loader truncated lines at 100 characters
+	std::string text = "v 0.000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000001 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n";
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	ParseObj(text.data(), text.size(), vertices, indices);
+
+	CHECK(vertices.size() == 3);
+	CHECK(indices.size() == 3);
+}
+
+BENCHMARK(ObjLoader, LegacyVsStreaming)
+{
+	printf("  %-20s %10s %12s %12s %8s\n", "model", "KB", "legacy MB/s", "new MB/s", "speedup");
+
+	double totalMegabytes = 0.0;
+	double totalLegacy = 0.0;
+	double totalNew = 0.0;
+	for(const auto& model : GetBundledModels())
+	{
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+		double legacyMilliseconds = MeasureMilliseconds([&]() { LegacyLoadObj(model, vertices, indices); }, 10);
+		double newMilliseconds = MeasureMilliseconds([&]() { LoadObj(model.wstring().c_str(), vertices, indices); }, 10);
+
+		double megabytes = std::filesystem::file_size(model) / (1024.0 * 1024.0);
+		printf("  %-20s %10.1f %12.1f %12.1f %7.1fx\n", model.filename().string().c_str(), megabytes * 1024.0,
+			megabytes / (legacyMilliseconds / 1000.0), megabytes / (newMilliseconds / 1000.0), legacyMilliseconds / newMilliseconds);
+
+		totalMegabytes += megabytes;
+		totalLegacy += legacyMilliseconds;
+		totalNew += newMilliseconds;
+	}
+
+	printf("  %-20s %10.1f %12.1f %12.1f %7.1fx\n", "all", totalMegabytes * 1024.0,
+		totalMegabytes / (totalLegacy / 1000.0), totalMegabytes / (totalNew / 1000.0), totalLegacy / totalNew);
+}
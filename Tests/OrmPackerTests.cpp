@@ -0,0 +1,176 @@
+#include "TestFramework.h"
+#include "OrmPacker.h"
+#include "TextureData.h"
+#include "PngLoader.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace
+{
+	// A map whose red channel holds a distinct pattern per source (and whose other channels,
+	// which the packer should ignore, hold junk)
+	Image MakePatternMap(unsigned int width, unsigned int height, unsigned int channels, int seed)
+	{
+		Image image = { width, height, channels, false, std::vector<uint8_t>((size_t) width * height * channels) };
+		for(size_t p = 0; p < (size_t) width * height; p++)
+		{
+			image.pixels[p * channels] = (uint8_t) (p * (seed * 2 + 1) + seed * 50);
+			for(unsigned int c = 1; c < channels; c++)
+				image.pixels[p * channels + c] = (uint8_t) (17 * c + seed);
+		}
+		return image;
+	}
+
+	Image LoadTestTexture(const char* relativePath)
+	{
+		Image image = {};
+		CHECK(LoadPng(GetAssetPath(relativePath).wstring().c_str(), image));
+		return image;
+	}
+
+	// PSNR of one channel of a decompressed texture against the same channel of the original
+	double ComputeChannelPsnr(const Image& original, const Image& decoded, unsigned int channel)
+	{
+		double squaredError = 0.0;
+		size_t pixelCount = (size_t) original.width * original.height;
+		for(size_t p = 0; p < pixelCount; p++)
+		{
+			double difference = (double) original.pixels[p * original.channels + channel] - decoded.pixels[p * decoded.channels + channel];
+			squaredError += difference * difference;
+		}
+		return squaredError > 0.0 ? 10.0 * std::log10(255.0 * 255.0 * pixelCount / squaredError) : INFINITY;
+	}
+}
+
+TEST(OrmPacker, ChannelPlacement)
+{
+	Image occlusion = MakePatternMap(8, 4, 1, 0);
+	Image roughness = MakePatternMap(8, 4, 4, 1);
+	Image metalness = MakePatternMap(8, 4, 4, 2);
+
+	Image packed;
+	CHECK(PackOrm(&occlusion, &roughness, &metalness, packed));
+	CHECK(packed.width == 8 && packed.height == 4 && packed.channels == 4 && !packed.isSRGB);
+
+	// Only each map's red channel is used, and same-sized maps are copied exactly
+	bool allMatch = true;
+	for(size_t p = 0; p < 32; p++)
+	{
+		const uint8_t* texel = &packed.pixels[p * 4];
+		allMatch &= texel[0] == occlusion.pixels[p];
+		allMatch &= texel[1] == roughness.pixels[p * 4];
+		allMatch &= texel[2] == metalness.pixels[p * 4];
+		allMatch &= texel[3] == 255;
+	}
+	CHECK(allMatch);
+}
+
+TEST(OrmPacker, MissingMapDefaults)
+{
+	Image map = MakePatternMap(4, 4, 1, 3);
+	Image none;
+	CHECK(!PackOrm(nullptr, nullptr, nullptr, none));
+
+	// Every combination of present and missing maps (bit i set = source i present)
+	const uint8_t defaults[3] = { DefaultOcclusion, DefaultRoughness, DefaultMetalness };
+	for(int present = 1; present < 8; present++)
+	{
+		const Image* sources[3];
+		for(int i = 0; i < 3; i++)
+			sources[i] = (present & (1 << i)) ? &map : nullptr;
+
+		Image packed;
+		CHECK(PackOrm(sources[0], sources[1], sources[2], packed));
+		CHECK(packed.width == 4 && packed.height == 4);
+
+		bool allMatch = true;
+		for(size_t p = 0; p < 16; p++)
+		{
+			for(int i = 0; i < 3; i++)
+				allMatch &= packed.pixels[p * 4 + i] == (sources[i] ? map.pixels[p] : defaults[i]);
+			allMatch &= packed.pixels[p * 4 + 3] == 255;
+		}
+		CHECK(allMatch);
+	}
+
+	// Unoccluded, fully rough and not metal
+	CHECK(DefaultOcclusion == 255 && DefaultRoughness == 255 && DefaultMetalness == 0);
+}
+
+// Small maps (like the bundled 128x128 metalness maps) are scaled up to the biggest one
+TEST(OrmPacker, ResizesToLargestMap)
+{
+	Image roughness = MakePatternMap(16, 8, 1, 1);
+	Image metalness = { 2, 2, 4, false, std::vector<uint8_t>(16, 9) };
+
+	Image packed;
+	CHECK(PackOrm(nullptr, &roughness, &metalness, packed));
+	CHECK(packed.width == 16 && packed.height == 8);
+
+	int worst = 0;
+	for(size_t p = 0; p < 128; p++)
+	{
+		CHECK(packed.pixels[p * 4 + 1] == roughness.pixels[p]);
+		worst = std::max(worst, std::abs(packed.pixels[p * 4 + 2] - 9));
+	}
+	CHECK(worst <= 1);
+}
+
+// A bundled material through the whole load path (packing, then mips)
+TEST(OrmPacker, PacksBundledMaterial)
+{
+	std::wstring roughnessPath = GetAssetPath("Textures/PBR/wood_roughness.png").wstring();
+	std::wstring metalnessPath = GetAssetPath("Textures/PBR/wood_metal.png").wstring();
+	Image roughness = LoadTestTexture("Textures/PBR/wood_roughness.png");
+
+	TextureData data;
+	CHECK(LoadOrmTextureData(nullptr, roughnessPath.c_str(), metalnessPath.c_str(), "", { true, { false, false }, BlockFormat::None }, data));
+	CHECK(data.width == roughness.width && data.height == roughness.height && data.channels == 4);
+	CHECK(data.GetMipCount() == GetMipCount(data.width, data.height));
+
+	bool allMatch = true;
+	for(size_t p = 0; p < (size_t) data.width * data.height; p++)
+	{
+		const uint8_t* texel = data.mipPixels[0] + p * 4;
+		allMatch &= texel[0] == DefaultOcclusion && texel[1] == roughness.pixels[p * roughness.channels] && texel[3] == 255;
+	}
+	CHECK(allMatch);
+}
+
+// Separate BC4 roughness and metalness maps against one packed map, per material
+BENCHMARK(OrmPacker, PackedVsSeparate)
+{
+	for(const char* material : { "bronze", "cobblestone", "floor", "paint", "rough", "scratched", "wood" })
+	{
+		std::string base = std::string("Textures/PBR/") + material;
+		std::wstring roughnessPath = GetAssetPath((base + "_roughness.png").c_str()).wstring();
+		std::wstring metalnessPath = GetAssetPath((base + "_metal.png").c_str()).wstring();
+		Image roughness = LoadTestTexture((base + "_roughness.png").c_str());
+		Image metalness = LoadTestTexture((base + "_metal.png").c_str());
+		Image packed;
+		PackOrm(nullptr, &roughness, &metalness, packed);
+
+		TextureData separate[2];
+		LoadTextureData(roughnessPath.c_str(), "", { true, { false, false }, BlockFormat::BC4 }, separate[0]);
+		LoadTextureData(metalnessPath.c_str(), "", { true, { false, false }, BlockFormat::BC4 }, separate[1]);
+		printf("  %-12s separate BC4: %5.2f MB, %5.1f dB roughness\n", material,
+			(separate[0].GetByteSize() + separate[1].GetByteSize()) / (1024.0 * 1024.0),
+			ComputeChannelPsnr(roughness, DecompressImage(separate[0].mipPixels[0], separate[0].width, separate[0].height, BlockFormat::BC4), 0));
+
+		for(BlockFormat format : { BlockFormat::BC1, BlockFormat::BC7 })
+		{
+			TextureData data;
+			double ms = MeasureMilliseconds([&]()
+			{
+				data = TextureData();
+				LoadOrmTextureData(nullptr, roughnessPath.c_str(), metalnessPath.c_str(), "", { true, { false, false }, format }, data);
+			}, 1);
+			Image decoded = DecompressImage(data.mipPixels[0], data.width, data.height, data.format);
+			printf("  %-12s packed %s:   %5.2f MB, %5.1f dB roughness, %5.1f dB metalness, cooked in %8.3f ms\n", material,
+				GetBlockFormatName(data.format), data.GetByteSize() / (1024.0 * 1024.0),
+				ComputeChannelPsnr(packed, decoded, 1), ComputeChannelPsnr(packed, decoded, 2), ms);
+		}
+	}
+}
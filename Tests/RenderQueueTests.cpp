@@ -0,0 +1,180 @@
+#include "TestFramework.h"
+#include "RenderQueue.h"
+
+#include <algorithm>
+
+namespace
+{
+	// --------------------------------------------------------
+	// Stands in for a graphics API: remembers what's bound and
+	// counts draws that happen without their own state bound
+	// --------------------------------------------------------
+	class RecordingBackend : public RenderQueueBackend
+	{
+	public:
+		uint32_t pass = UINT32_MAX, shader = UINT32_MAX, material = UINT32_MAX, mesh = UINT32_MAX;
+		size_t errorCount = 0;
+		std::vector<uint32_t> drawnObjects;
+
+		void BindPass(const RenderItem& item) override
+		{
+			pass = GetSortKeyPass(item.key);
+			shader = material = mesh = UINT32_MAX; // A new pass starts from nothing
+		}
+		void BindShader(const RenderItem& item) override
+		{
+			shader = GetSortKeyShader(item.key);
+			material = UINT32_MAX;
+		}
+		void BindMaterial(const RenderItem& item) override { material = GetSortKeyMaterial(item.key); }
+		void BindMesh(const RenderItem& item) override { mesh = GetSortKeyMesh(item.key); }
+		void Draw(const RenderItem& item) override
+		{
+			if(pass != GetSortKeyPass(item.key) || shader != GetSortKeyShader(item.key) ||
+				material != GetSortKeyMaterial(item.key) || mesh != GetSortKeyMesh(item.key))
+				errorCount++;
+			drawnObjects.push_back(item.object);
+		}
+	};
+
+	// Two passes over the same objects, each with one of 8 shaders, 64 materials and 256 meshes
+	std::vector<RenderItem> MakeRandomItems(size_t itemCount)
+	{
+		uint32_t random = 13579;
+		auto next = [&random]() { random = random * 1664525u + 1013904223u; return random >> 8; };
+		std::vector<RenderItem> items(itemCount);
+		for(size_t i = 0; i < itemCount; i++)
+			items[i] = { MakeSortKey((uint32_t) (i % 2), next() % 8, next() % 64, next() % 256, (next() & 0xFFFF) / 65535.0f), (uint32_t) (i / 2) };
+		return items;
+	}
+
+	void FillQueue(RenderQueue& queue, const std::vector<RenderItem>& items)
+	{
+		queue.Clear();
+		for(const RenderItem& item : items)
+			queue.Add(item.key, item.object);
+	}
+
+	std::vector<RenderItem> StableSorted(std::vector<RenderItem> items)
+	{
+		std::stable_sort(items.begin(), items.end(), [](const RenderItem& a, const RenderItem& b) { return a.key < b.key; });
+		return items;
+	}
+
+	bool SameItems(const std::vector<RenderItem>& a, const std::vector<RenderItem>& b)
+	{
+		return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(),
+			[](const RenderItem& x, const RenderItem& y) { return x.key == y.key && x.object == y.object; });
+	}
+}
+
+TEST(RenderQueue, SortKeyFields)
+{
+	uint64_t key = MakeSortKey(3, 517, 2049, 9001, 0.5f);
+	CHECK(GetSortKeyPass(key) == 3);
+	CHECK(GetSortKeyShader(key) == 517);
+	CHECK(GetSortKeyMaterial(key) == 2049);
+	CHECK(GetSortKeyMesh(key) == 9001);
+	CHECK(GetSortKeyState(key) == GetSortKeyState(MakeSortKey(3, 517, 2049, 9001, 0.9f)));
+	CHECK(GetSortKeyState(key) != GetSortKeyState(MakeSortKey(3, 517, 2049, 9002, 0.5f)));
+
+	// Ids too wide for their field are masked, rather than spilling into the next one
+	uint64_t masked = MakeSortKey(1u << SortKeyPassBits, (1u << SortKeyShaderBits) + 5, 0, 0, 0.0f);
+	CHECK(GetSortKeyPass(masked) == 0);
+	CHECK(GetSortKeyShader(masked) == 5);
+
+	// Depth is clamped, and orders front to back only once everything else is equal
+	CHECK(MakeSortKey(0, 0, 0, 0, -1.0f) == MakeSortKey(0, 0, 0, 0, 0.0f));
+	CHECK(MakeSortKey(0, 0, 0, 0, 2.0f) == MakeSortKey(0, 0, 0, 0, 1.0f));
+	CHECK(MakeSortKey(0, 0, 0, 0, 0.25f) < MakeSortKey(0, 0, 0, 0, 0.75f));
+	CHECK(MakeSortKey(0, 0, 0, 1, 0.0f) > MakeSortKey(0, 0, 0, 0, 1.0f));
+	CHECK(MakeSortKey(0, 1, 0, 0, 0.0f) > MakeSortKey(0, 0, 4095, 16383, 1.0f));
+	CHECK(MakeSortKey(1, 0, 0, 0, 0.0f) > MakeSortKey(0, 1023, 4095, 16383, 1.0f));
+}
+
+TEST(RenderQueue, SortMatchesStableSort)
+{
+	RenderQueue queue;
+	for(size_t count : { 0, 1, 2, 1000, 10007 })
+	{
+		std::vector<RenderItem> items = MakeRandomItems(count);
+		FillQueue(queue, items);
+		queue.Sort();
+		CHECK(SameItems(queue.GetItems(), StableSorted(items)));
+	}
+
+	// Keys differing only in one middle byte (so every other byte is skipped), with plenty of
+	// duplicates whose order has to survive
+	std::vector<RenderItem> items;
+	for(uint32_t i = 0; i < 5000; i++)
+		items.push_back({ MakeSortKey(2, 7, (i * 37) % 16, 3, 0.5f), i });
+	FillQueue(queue, items);
+	queue.Sort();
+	CHECK(SameItems(queue.GetItems(), StableSorted(items)));
+}
+
+TEST(RenderQueue, SubmitBindsOnlyChanges)
+{
+	RenderQueue queue;
+	FillQueue(queue, MakeRandomItems(10000));
+	queue.Sort();
+
+	RecordingBackend backend;
+	RenderQueueStatistics statistics = queue.Submit(backend);
+	CHECK(backend.errorCount == 0);
+	CHECK(statistics.drawCount == 10000);
+	CHECK(backend.drawnObjects.size() == 10000);
+
+	// Sorted, each pass, shader and material is bound once (every combination being contiguous),
+	// and a mesh only when it differs from the last draw's
+	std::vector<uint64_t> materials;
+	size_t meshChanges = 0;
+	for(size_t i = 0; i < queue.GetItems().size(); i++)
+	{
+		uint64_t key = queue.GetItems()[i].key;
+		materials.push_back(MakeSortKey(GetSortKeyPass(key), GetSortKeyShader(key), GetSortKeyMaterial(key), 0, 0.0f));
+		uint64_t previous = i > 0 ? queue.GetItems()[i - 1].key : 0;
+		if(i == 0 || GetSortKeyPass(key) != GetSortKeyPass(previous) || GetSortKeyMesh(key) != GetSortKeyMesh(previous))
+			meshChanges++;
+	}
+	materials.erase(std::unique(materials.begin(), materials.end()), materials.end());
+	CHECK(statistics.passBinds == 2);
+	CHECK(statistics.shaderBinds == 2 * 8);
+	CHECK(statistics.materialBinds == materials.size());
+	CHECK(statistics.materialBinds < statistics.drawCount);
+	CHECK(statistics.meshBinds == meshChanges);
+
+	// Draws with exactly the same state bind nothing new
+	queue.Clear();
+	for(uint32_t i = 0; i < 10; i++)
+		queue.Add(MakeSortKey(0, 1, 2, 3, i / 10.0f), i);
+	RecordingBackend sameStateBackend;
+	statistics = queue.Submit(sameStateBackend);
+	CHECK(sameStateBackend.errorCount == 0);
+	CHECK(statistics.passBinds == 1 && statistics.shaderBinds == 1 && statistics.materialBinds == 1 && statistics.meshBinds == 1);
+	CHECK(statistics.drawCount == 10);
+}
+
+BENCHMARK(RenderQueue, SortAndSubmit)
+{
+	// State changes are compared with binding everything for every draw (the way entities used to
+	// draw themselves)
+	printf("  %-9s %12s %14s %10s %10s %12s %12s %12s\n", "draws", "radix ms", "stable_sort ms", "speedup", "submit ms",
+		"shader binds", "material", "mesh");
+	for(size_t count : { 1000, 10000, 100000, 1000000 })
+	{
+		std::vector<RenderItem> items = MakeRandomItems(count);
+		RenderQueue queue;
+		double radixMilliseconds = MeasureMilliseconds([&]() { FillQueue(queue, items); queue.Sort(); });
+		double stdMilliseconds = MeasureMilliseconds([&]() { StableSorted(items); });
+
+		RenderQueueStatistics statistics = {};
+		double submitMilliseconds = MeasureMilliseconds([&]()
+			{
+				RecordingBackend backend;
+				statistics = queue.Submit(backend);
+			});
+		printf("  %-9zu %12.3f %14.3f %9.2fx %10.3f %12zu %12zu %12zu\n", count, radixMilliseconds, stdMilliseconds,
+			stdMilliseconds / radixMilliseconds, submitMilliseconds, statistics.shaderBinds, statistics.materialBinds, statistics.meshBinds);
+	}
+}
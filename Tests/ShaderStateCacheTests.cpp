@@ -0,0 +1,315 @@
+#include "TestFramework.h"
+#include "ShaderStateCache.h"
+
+#include <cstring>
+#include <memory>
+
+namespace
+{
+	enum class BindKind { Shader, InputLayout, ConstantBuffer, ShaderResource, Sampler, Draw, UnbindPixelResources };
+	struct Bind
+	{
+		BindKind kind;
+		ShaderStage stage = ShaderStage::Vertex;
+		unsigned int slot = 0;
+		uintptr_t object = 0;
+	};
+
+	// --------------------------------------------------------
+	// Stands in for a device context: just records what's bound
+	// and how many calls it took to get there
+	// --------------------------------------------------------
+	struct RecordingContext
+	{
+		uintptr_t shaders[(int) ShaderStage::Count] = {};
+		uintptr_t inputLayout = 0;
+		uintptr_t constantBuffers[(int) ShaderStage::Count][ShaderStateCache::ConstantBufferSlots] = {};
+		uintptr_t shaderResources[(int) ShaderStage::Count][ShaderStateCache::ShaderResourceSlots] = {};
+		uintptr_t samplers[(int) ShaderStage::Count][ShaderStateCache::SamplerSlots] = {};
+		size_t callCount = 0;
+
+		// Makes a bind (or not, when there's a cache that says it's redundant)
+		void Apply(const Bind& bind, ShaderStateCache* cache)
+		{
+			const void* object = reinterpret_cast<const void*>(bind.object);
+			int stage = (int) bind.stage;
+			switch(bind.kind)
+			{
+			case BindKind::Shader:
+				if(!cache || cache->SetShader(bind.stage, object)) { shaders[stage] = bind.object; callCount++; }
+				break;
+			case BindKind::InputLayout:
+				if(!cache || cache->SetInputLayout(object)) { inputLayout = bind.object; callCount++; }
+				break;
+			case BindKind::ConstantBuffer:
+				if(!cache || cache->SetConstantBuffer(bind.stage, bind.slot, object)) { constantBuffers[stage][bind.slot] = bind.object; callCount++; }
+				break;
+			case BindKind::ShaderResource:
+				if(!cache || cache->SetShaderResourceView(bind.stage, bind.slot, object)) { shaderResources[stage][bind.slot] = bind.object; callCount++; }
+				break;
+			case BindKind::Sampler:
+				if(!cache || cache->SetSampler(bind.stage, bind.slot, object)) { samplers[stage][bind.slot] = bind.object; callCount++; }
+				break;
+			case BindKind::UnbindPixelResources:
+			{
+				// Like Game's end of frame cleanup: every slot, narrowed by the cache to what's still bound
+				unsigned int firstSlot = 0, slotCount = ShaderStateCache::ShaderResourceSlots;
+				if(!cache || cache->UnbindShaderResourceViews(ShaderStage::Pixel, firstSlot, slotCount))
+				{
+					memset(&shaderResources[(int) ShaderStage::Pixel][firstSlot], 0, slotCount * sizeof(uintptr_t));
+					callCount++;
+				}
+				break;
+			}
+			case BindKind::Draw:
+				break;
+			}
+		}
+
+		bool Matches(const RecordingContext& other) const
+		{
+			return memcmp(shaders, other.shaders, sizeof(shaders)) == 0 && inputLayout == other.inputLayout &&
+				memcmp(constantBuffers, other.constantBuffers, sizeof(constantBuffers)) == 0 &&
+				memcmp(shaderResources, other.shaderResources, sizeof(shaderResources)) == 0 &&
+				memcmp(samplers, other.samplers, sizeof(samplers)) == 0;
+		}
+	};
+
+	// One frame of the scene as entities bound it one by one: a floor and 7 materials x 5 meshes, all sharing
+	// shaders and the shadow map, each material with its own 4 textures and the same 2 samplers, then the sky
+	// and three post-processing passes
+	std::vector<Bind> MakeSceneFrame()
+	{
+		std::vector<Bind> frame;
+		uintptr_t nextObject = 1;
+		auto newObject = [&nextObject]() { return nextObject++; };
+		uintptr_t layout = newObject(), entityVS = newObject(), entityVSBuffer = newObject(), entityPS = newObject(), entityPSBuffer = newObject();
+		uintptr_t shadowVS = newObject(), shadowVSBuffer = newObject(), shadowMap = newObject(), sampler = newObject(), shadowSampler = newObject();
+		std::vector<uintptr_t> textures(8 * 4);
+		for(uintptr_t& texture : textures)
+			texture = newObject();
+
+		std::vector<int> entityMaterials = { 7 };
+		for(int material = 0; material < 7; material++)
+		{
+			for(int mesh = 0; mesh < 5; mesh++)
+				entityMaterials.push_back(material);
+		}
+
+		// Shadow pass
+		for(size_t i = 0; i < entityMaterials.size(); i++)
+		{
+			frame.push_back({ BindKind::InputLayout, ShaderStage::Vertex, 0, layout });
+			frame.push_back({ BindKind::Shader, ShaderStage::Vertex, 0, shadowVS });
+			frame.push_back({ BindKind::ConstantBuffer, ShaderStage::Vertex, 0, shadowVSBuffer });
+			frame.push_back({ BindKind::Draw });
+		}
+
+		// Main pass
+		for(int material : entityMaterials)
+		{
+			frame.push_back({ BindKind::InputLayout, ShaderStage::Vertex, 0, layout });
+			frame.push_back({ BindKind::Shader, ShaderStage::Vertex, 0, entityVS });
+			frame.push_back({ BindKind::ConstantBuffer, ShaderStage::Vertex, 0, entityVSBuffer });
+			frame.push_back({ BindKind::Shader, ShaderStage::Pixel, 0, entityPS });
+			frame.push_back({ BindKind::ConstantBuffer, ShaderStage::Pixel, 0, entityPSBuffer });
+			for(unsigned int slot = 0; slot < 4; slot++)
+				frame.push_back({ BindKind::ShaderResource, ShaderStage::Pixel, slot, textures[material * 4 + slot] });
+			frame.push_back({ BindKind::ShaderResource, ShaderStage::Pixel, 4, shadowMap });
+			frame.push_back({ BindKind::Sampler, ShaderStage::Pixel, 0, sampler });
+			frame.push_back({ BindKind::Sampler, ShaderStage::Pixel, 1, shadowSampler });
+			frame.push_back({ BindKind::Draw });
+		}
+
+		// Sky, then post-processing passes that each read the last one's output
+		uintptr_t skyVS = newObject(), skyPS = newObject(), skyBuffer = newObject(), skyTexture = newObject();
+		frame.push_back({ BindKind::InputLayout, ShaderStage::Vertex, 0, layout });
+		frame.push_back({ BindKind::Shader, ShaderStage::Vertex, 0, skyVS });
+		frame.push_back({ BindKind::ConstantBuffer, ShaderStage::Vertex, 0, skyBuffer });
+		frame.push_back({ BindKind::Shader, ShaderStage::Pixel, 0, skyPS });
+		frame.push_back({ BindKind::ShaderResource, ShaderStage::Pixel, 0, skyTexture });
+		frame.push_back({ BindKind::Sampler, ShaderStage::Pixel, 0, sampler });
+		frame.push_back({ BindKind::Draw });
+
+		uintptr_t fullscreenVS = newObject();
+		for(int pass = 0; pass < 3; pass++)
+		{
+			frame.push_back({ BindKind::InputLayout, ShaderStage::Vertex, 0, 0 });
+			frame.push_back({ BindKind::Shader, ShaderStage::Vertex, 0, fullscreenVS });
+			frame.push_back({ BindKind::Shader, ShaderStage::Pixel, 0, newObject() });
+			frame.push_back({ BindKind::ConstantBuffer, ShaderStage::Pixel, 0, newObject() });
+			frame.push_back({ BindKind::ShaderResource, ShaderStage::Pixel, 0, newObject() });
+			frame.push_back({ BindKind::Sampler, ShaderStage::Pixel, 0, newObject() });
+			frame.push_back({ BindKind::Draw });
+		}
+		frame.push_back({ BindKind::UnbindPixelResources });
+		return frame;
+	}
+
+	// Replays frames both through a cache and without one; the contexts have to agree at every draw
+	struct ReplayResult
+	{
+		size_t callsPerFrame;			// Without the cache
+		size_t filteredCallsPerFrame;	// With it
+		size_t mismatchCount;
+	};
+	ReplayResult Replay(const std::vector<Bind>& frame, size_t frameCount)
+	{
+		ReplayResult result = {};
+		ShaderStateCache cache;
+		std::unique_ptr<RecordingContext> uncached = std::make_unique<RecordingContext>();
+		std::unique_ptr<RecordingContext> cached = std::make_unique<RecordingContext>();
+		for(size_t f = 0; f < frameCount; f++)
+		{
+			for(const Bind& bind : frame)
+			{
+				uncached->Apply(bind, nullptr);
+				cached->Apply(bind, &cache);
+				if(bind.kind == BindKind::Draw && !uncached->Matches(*cached))
+					result.mismatchCount++;
+			}
+		}
+		if(frameCount > 0)
+		{
+			result.callsPerFrame = uncached->callCount / frameCount;
+			result.filteredCallsPerFrame = cached->callCount / frameCount;
+		}
+		return result;
+	}
+
+	const void* FakeObject(uintptr_t address)
+	{
+		return reinterpret_cast<const void*>(address);
+	}
+}
+
+TEST(ShaderStateCache, SkipsOnlyRedundantBinds)
+{
+	// Nothing is known to start with, not even that slots are empty
+	ShaderStateCache cache;
+	CHECK(cache.SetShader(ShaderStage::Pixel, nullptr));
+	CHECK(cache.SetShaderResourceView(ShaderStage::Pixel, 3, nullptr));
+
+	CHECK(cache.SetShader(ShaderStage::Pixel, FakeObject(16)));
+	CHECK(!cache.SetShader(ShaderStage::Pixel, FakeObject(16)));
+	CHECK(cache.SetShader(ShaderStage::Vertex, FakeObject(16)));
+	CHECK(cache.SetConstantBuffer(ShaderStage::Pixel, 2, FakeObject(32)));
+	CHECK(!cache.SetConstantBuffer(ShaderStage::Pixel, 2, FakeObject(32)));
+	CHECK(cache.SetConstantBuffer(ShaderStage::Pixel, 2, FakeObject(48)));
+	CHECK(cache.SetSampler(ShaderStage::Compute, 0, FakeObject(64)));
+	CHECK(!cache.SetSampler(ShaderStage::Compute, 0, FakeObject(64)));
+	CHECK(cache.GetStatistics().hits == 3 && cache.GetStatistics().misses == 7);
+
+	// Slots past the tracked ones, and append/consume counters, are always set
+	CHECK(cache.SetShaderResourceView(ShaderStage::Pixel, ShaderStateCache::ShaderResourceSlots, FakeObject(80)));
+	CHECK(cache.SetShaderResourceView(ShaderStage::Pixel, ShaderStateCache::ShaderResourceSlots, FakeObject(80)));
+	CHECK(cache.SetUnorderedAccessView(ShaderStage::Compute, 1, FakeObject(96), true));
+	CHECK(cache.SetUnorderedAccessView(ShaderStage::Compute, 1, FakeObject(96), true));
+	CHECK(!cache.SetUnorderedAccessView(ShaderStage::Compute, 1, FakeObject(96), false));
+
+	// Turned off, every bind is made
+	ShaderStateCache::isEnabled = false;
+	bool isMade = cache.SetShader(ShaderStage::Pixel, FakeObject(16));
+	ShaderStateCache::isEnabled = true;
+	CHECK(isMade);
+	CHECK(!cache.SetShader(ShaderStage::Pixel, FakeObject(16)));
+}
+
+TEST(ShaderStateCache, InvalidatesOnlyWhatsAsked)
+{
+	ShaderStateCache cache;
+	cache.SetInputLayout(FakeObject(8));
+	cache.SetShader(ShaderStage::Vertex, FakeObject(16));
+	cache.SetShader(ShaderStage::Pixel, FakeObject(32));
+	cache.SetShaderResourceView(ShaderStage::Pixel, 0, FakeObject(48));
+	cache.SetShader(ShaderStage::Hull, FakeObject(64));
+
+	// Just a shader
+	cache.InvalidateShader(ShaderStage::Hull);
+	CHECK(cache.SetShader(ShaderStage::Hull, FakeObject(64)));
+	CHECK(!cache.SetShader(ShaderStage::Pixel, FakeObject(32)));
+
+	// A whole stage (the vertex stage taking the input layout with it)
+	cache.InvalidateStage(ShaderStage::Vertex);
+	CHECK(cache.SetShader(ShaderStage::Vertex, FakeObject(16)));
+	CHECK(cache.SetInputLayout(FakeObject(8)));
+	CHECK(!cache.SetShaderResourceView(ShaderStage::Pixel, 0, FakeObject(48)));
+
+	// Everything
+	cache.Invalidate();
+	CHECK(cache.SetShader(ShaderStage::Pixel, FakeObject(32)));
+	CHECK(cache.SetShaderResourceView(ShaderStage::Pixel, 0, FakeObject(48)));
+	CHECK(cache.SetInputLayout(FakeObject(8)));
+}
+
+TEST(ShaderStateCache, UnbindNarrowsToBoundSlots)
+{
+	// Unknown slots have to be unbound; after that, only the ones bound since
+	ShaderStateCache cache;
+	unsigned int firstSlot = 0, slotCount = ShaderStateCache::ShaderResourceSlots;
+	CHECK(cache.UnbindShaderResourceViews(ShaderStage::Pixel, firstSlot, slotCount));
+	CHECK(firstSlot == 0 && slotCount == ShaderStateCache::ShaderResourceSlots);
+
+	firstSlot = 0;
+	slotCount = ShaderStateCache::ShaderResourceSlots;
+	CHECK(!cache.UnbindShaderResourceViews(ShaderStage::Pixel, firstSlot, slotCount));
+	CHECK(!cache.SetShaderResourceView(ShaderStage::Pixel, 7, nullptr));
+
+	cache.SetShaderResourceView(ShaderStage::Pixel, 2, FakeObject(16));
+	cache.SetShaderResourceView(ShaderStage::Pixel, 5, FakeObject(32));
+	cache.SetShaderResourceView(ShaderStage::Vertex, 0, FakeObject(48));
+	firstSlot = 0;
+	slotCount = ShaderStateCache::ShaderResourceSlots;
+	CHECK(cache.UnbindShaderResourceViews(ShaderStage::Pixel, firstSlot, slotCount));
+	CHECK(firstSlot == 2 && slotCount == 4);
+	CHECK(cache.SetShaderResourceView(ShaderStage::Pixel, 5, FakeObject(32)));
+	CHECK(!cache.SetShaderResourceView(ShaderStage::Vertex, 0, FakeObject(48)));
+
+	// Ranges running past the tracked slots keep the untracked part
+	cache.SetShaderResourceView(ShaderStage::Pixel, ShaderStateCache::ShaderResourceSlots - 1, FakeObject(16));
+	firstSlot = ShaderStateCache::ShaderResourceSlots - 2;
+	slotCount = 4;
+	CHECK(cache.UnbindShaderResourceViews(ShaderStage::Pixel, firstSlot, slotCount));
+	CHECK(firstSlot == ShaderStateCache::ShaderResourceSlots - 1 && slotCount == 3);
+	firstSlot = ShaderStateCache::ShaderResourceSlots - 2;
+	slotCount = 4;
+	CHECK(cache.UnbindShaderResourceViews(ShaderStage::Pixel, firstSlot, slotCount));
+	CHECK(firstSlot == ShaderStateCache::ShaderResourceSlots && slotCount == 2);
+
+	// UAVs the same way
+	cache.SetUnorderedAccessView(ShaderStage::Compute, 3, FakeObject(64), false);
+	firstSlot = 0;
+	slotCount = ShaderStateCache::UnorderedAccessSlots;
+	CHECK(cache.UnbindUnorderedAccessViews(ShaderStage::Compute, firstSlot, slotCount));
+	firstSlot = 0;
+	slotCount = ShaderStateCache::UnorderedAccessSlots;
+	CHECK(!cache.UnbindUnorderedAccessViews(ShaderStage::Compute, firstSlot, slotCount));
+	CHECK(cache.SetUnorderedAccessView(ShaderStage::Compute, 3, FakeObject(64), false));
+}
+
+TEST(ShaderStateCache, ReplayMatchesUncached)
+{
+	// Filtering saves calls without changing what's bound at any draw, frame after frame
+	std::vector<Bind> frame = MakeSceneFrame();
+	for(size_t frameCount : { 1, 2, 50 })
+	{
+		ReplayResult result = Replay(frame, frameCount);
+		CHECK(result.mismatchCount == 0);
+		CHECK(result.filteredCallsPerFrame < result.callsPerFrame / 2);
+	}
+}
+
+BENCHMARK(ShaderStateCache, Replay)
+{
+	// The API calls the cache saves a frame like the scene's, and what filtering them costs on the CPU
+	std::vector<Bind> frame = MakeSceneFrame();
+	printf("  %-10s %10s %12s %8s %14s\n", "frames", "binds", "with cache", "saved", "ms per frame");
+	for(size_t frameCount : { 1, 100, 10000 })
+	{
+		ReplayResult result = {};
+		double milliseconds = MeasureMilliseconds([&]() { result = Replay(frame, frameCount); });
+		printf("  %-10zu %10zu %12zu %7.1f%% %14.5f%s\n", frameCount, result.callsPerFrame, result.filteredCallsPerFrame,
+			100.0 * (result.callsPerFrame - result.filteredCallsPerFrame) / result.callsPerFrame, milliseconds / frameCount,
+			result.mismatchCount == 0 ? "" : " (MISMATCH)");
+	}
+}
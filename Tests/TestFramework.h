@@ -0,0 +1,94 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// Tiny self-registering test runner for the engine's CPU-side
+// modules (everything that doesn't need a Direct3D device)
+// - TEST() cases run by default; a failed CHECK() reports the
+//   expression and fails the case, but the case keeps going
+// - BENCHMARK() cases only run with --bench, and print their
+//   own timings (they assert nothing)
+// - See TestMain.cpp for the command line
+// --------------------------------------------------------
+typedef void (*TestFunction)();
+
+struct TestCase
+{
+	const char* suite;
+	const char* name;
+	TestFunction function;
+	bool isBenchmark;
+};
+
+std::vector<TestCase>& GetTestCases();
+
+struct TestRegistration
+{
+	TestRegistration(const char* suite, const char* name, TestFunction function, bool isBenchmark)
+	{
+		GetTestCases().push_back({ suite, name, function, isBenchmark });
+	}
+};
+
+// Records a failure in the currently running case
+void ReportFailure(const char* file, int line, const std::string& message);
+
+#define TEST_CASE_(suite, name, isBenchmark) \
+	static void suite##_##name(); \
+	static TestRegistration suite##_##name##_registration(#suite, #name, suite##_##name, isBenchmark); \
+	static void suite##_##name()
+
+#define TEST(suite, name) TEST_CASE_(suite, name, false)
+#define BENCHMARK(suite, name) TEST_CASE_(suite, name, true)
+
+#define CHECK(condition) \
+	do { if(!(condition)) ReportFailure(__FILE__, __LINE__, #condition); } while(false)
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+	do { \
+		double actual_ = (double) (actual), expected_ = (double) (expected); \
+		if(!(actual_ - expected_ <= (tolerance) && expected_ - actual_ <= (tolerance))) \
+			ReportFailure(__FILE__, __LINE__, std::string(#actual " == " #expected " (") + \
+				std::to_string(actual_) + " vs " + std::to_string(expected_) + ")"); \
+	} while(false)
+
+// --------------------------------------------------------
+// Helpers shared by the test files
+// --------------------------------------------------------
+
+// Every .obj in Assets/Models, sorted by name
+std::vector<std::filesystem::path> GetBundledModels();
+
+// Path of a file under Assets/ or Tests/Golden/
+std::filesystem::path GetAssetPath(const char* relativePath);
+std::filesystem::path GetGoldenPath(const char* fileName);
+
+// Empty scratch directory under the system temp directory, for
+// tests that need to write files (such as cooked caches)
+std::filesystem::path MakeScratchDirectory(const char* name);
+
+// True when run with --update-golden, so golden image tests rewrite
+// their reference images instead of comparing against them
+bool IsUpdatingGoldenFiles();
+
+// Best (lowest) time of several runs of a function, in milliseconds,
+// which filters out most scheduling noise in benchmarks
+template<typename Function>
+double MeasureMilliseconds(Function function, int runs = 5)
+{
+	double best = 0.0;
+	for(int i = 0; i < runs; i++)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		function();
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		if(i == 0 || milliseconds < best)
+			best = milliseconds;
+	}
+	return best;
+}
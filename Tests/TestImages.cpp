@@ -0,0 +1,153 @@
+#include "TestImages.h"
+#include "TestFramework.h"
+#include "PngLoader.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+
+namespace
+{
+	uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+	{
+		crc = ~crc;
+		for(size_t i = 0; i < size; i++)
+		{
+			crc ^= data[i];
+			for(int bit = 0; bit < 8; bit++)
+				crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+		}
+		return ~crc;
+	}
+
+	void AppendBigEndian(std::vector<uint8_t>& bytes, uint32_t value)
+	{
+		bytes.insert(bytes.end(), { (uint8_t) (value >> 24), (uint8_t) (value >> 16), (uint8_t) (value >> 8), (uint8_t) value });
+	}
+
+	void AppendChunk(std::vector<uint8_t>& file, const char* type, const std::vector<uint8_t>& data)
+	{
+		AppendBigEndian(file, (uint32_t) data.size());
+		size_t typeStart = file.size();
+		file.insert(file.end(), type, type + 4);
+		file.insert(file.end(), data.begin(), data.end());
+		AppendBigEndian(file, Crc32(&file[typeStart], file.size() - typeStart));
+	}
+}
+
+bool WritePng(const std::filesystem::path& path, const Image& image)
+{
+	if(image.channels != 1 && image.channels != 4)
+		return false;
+
+	// Every row starts with filter type 0 (none)
+	size_t rowSize = (size_t) image.width * image.channels;
+	std::vector<uint8_t> raw;
+	for(unsigned int y = 0; y < image.height; y++)
+	{
+		raw.push_back(0);
+		raw.insert(raw.end(), image.pixels.begin() + y * rowSize, image.pixels.begin() + (y + 1) * rowSize);
+	}
+
+	// zlib stream of stored blocks, followed by the Adler-32 of the raw data
+	std::vector<uint8_t> zlib = { 0x78, 0x01 };
+	for(size_t offset = 0; offset < raw.size();)
+	{
+		size_t length = std::min(raw.size() - offset, (size_t) 65535);
+		bool isLast = offset + length == raw.size();
+		zlib.insert(zlib.end(), { (uint8_t) isLast, (uint8_t) length, (uint8_t) (length >> 8), (uint8_t) ~length, (uint8_t) (~length >> 8) });
+		zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + length);
+		offset += length;
+	}
+	uint32_t a = 1, b = 0;
+	for(uint8_t byte : raw)
+	{
+		a = (a + byte) % 65521;
+		b = (b + a) % 65521;
+	}
+	AppendBigEndian(zlib, (b << 16) | a);
+
+	std::vector<uint8_t> header;
+	AppendBigEndian(header, image.width);
+	AppendBigEndian(header, image.height);
+	header.insert(header.end(), { 8, (uint8_t) (image.channels == 4 ? 6 : 0), 0, 0, 0 });
+
+	std::vector<uint8_t> file = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	AppendChunk(file, "IHDR", header);
+	AppendChunk(file, "IDAT", zlib);
+	AppendChunk(file, "IEND", {});
+
+	std::ofstream output(path, std::ios::binary | std::ios::trunc);
+	output.write((const char*) file.data(), file.size());
+	return output.good();
+}
+
+Image MakeMipStrip(const std::vector<Image>& mips, unsigned int maxWidth)
+{
+	Image strip = { 0, 0, mips[0].channels, mips[0].isSRGB, {} };
+	for(const Image& mip : mips)
+	{
+		if(mip.width <= maxWidth)
+		{
+			strip.width += mip.width;
+			strip.height = std::max(strip.height, mip.height);
+		}
+	}
+	strip.pixels.resize((size_t) strip.width * strip.height * strip.channels);
+
+	unsigned int x = 0;
+	for(const Image& mip : mips)
+	{
+		if(mip.width > maxWidth)
+			continue;
+
+		size_t rowSize = (size_t) mip.width * mip.channels;
+		for(unsigned int y = 0; y < mip.height; y++)
+			std::copy_n(&mip.pixels[y * rowSize], rowSize, &strip.pixels[((size_t) y * strip.width + x) * strip.channels]);
+		x += mip.width;
+	}
+	return strip;
+}
+
+bool MatchesGoldenImage(const char* fileName, const Image& image, int tolerance)
+{
+	std::filesystem::path path = GetGoldenPath(fileName);
+	if(IsUpdatingGoldenFiles())
+	{
+		printf("  Updating %s\n", path.string().c_str());
+		return WritePng(path, image);
+	}
+
+	Image golden;
+	if(!LoadPng(path.wstring().c_str(), golden))
+	{
+		printf("  Can't load %s (run with --update-golden to create it)\n", path.string().c_str());
+		return false;
+	}
+	if(golden.width != image.width || golden.height != image.height || golden.channels != image.channels)
+	{
+		printf("  %s is %ux%ux%u, but the image is %ux%ux%u\n", fileName,
+			golden.width, golden.height, golden.channels, image.width, image.height, image.channels);
+		return false;
+	}
+
+	int worst = 0;
+	size_t worstIndex = 0;
+	for(size_t i = 0; i < image.pixels.size(); i++)
+	{
+		int difference = std::abs(image.pixels[i] - golden.pixels[i]);
+		if(difference > worst)
+		{
+			worst = difference;
+			worstIndex = i;
+		}
+	}
+	if(worst > tolerance)
+	{
+		size_t pixel = worstIndex / image.channels;
+		printf("  %s differs by up to %d at (%zu, %zu) channel %zu\n", fileName, worst,
+			pixel % image.width, pixel / image.width, worstIndex % image.channels);
+		return false;
+	}
+	return true;
+}
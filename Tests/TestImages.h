@@ -0,0 +1,23 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include "Image.h"
+
+// --------------------------------------------------------
+// Images shared by the texture processing tests
+// --------------------------------------------------------
+
+// Writes a 1 or 4 channel image as an uncompressed .PNG (stored deflate blocks), which
+// PngLoader reads back exactly; returns false if the file couldn't be written
+bool WritePng(const std::filesystem::path& path, const Image& image);
+
+// Lays mips out left to right along the top of one image, starting with the first
+// no wider than maxWidth, so a whole (small end of a) chain fits in one golden file
+Image MakeMipStrip(const std::vector<Image>& mips, unsigned int maxWidth);
+
+// Compares an image with Tests/Golden/<fileName>, allowing each channel to be off by up to
+// tolerance (so rounding differences between compilers don't fail it)
+// - With --update-golden it rewrites the golden file instead, and always passes
+bool MatchesGoldenImage(const char* fileName, const Image& image, int tolerance);
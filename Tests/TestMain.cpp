@@ -0,0 +1,123 @@
+#include "TestFramework.h"
+
+#include <algorithm>
+#include <cstring>
+
+// --------------------------------------------------------
+// Usage: EngineTests [--bench] [--list] [--update-golden] [filter]
+// - Runs every test (or with --bench, every benchmark) whose
+//   "Suite" or "Suite.Name" matches the filter, if given
+// - Returns non-zero if any check failed
+// --------------------------------------------------------
+namespace
+{
+	const char* currentCase = nullptr;
+	int currentFailures = 0;
+	bool updateGolden = false;
+
+	bool MatchesFilter(const TestCase& test, const char* filter)
+	{
+		if(!filter)
+			return true;
+
+		std::string fullName = std::string(test.suite) + "." + test.name;
+		return fullName == filter || strcmp(test.suite, filter) == 0;
+	}
+}
+
+std::vector<TestCase>& GetTestCases()
+{
+	static std::vector<TestCase> cases;
+	return cases;
+}
+
+void ReportFailure(const char* file, int line, const std::string& message)
+{
+	printf("  %s(%d): check failed in %s: %s\n", file, line, currentCase, message.c_str());
+	currentFailures++;
+}
+
+std::vector<std::filesystem::path> GetBundledModels()
+{
+	std::vector<std::filesystem::path> models;
+	for(const auto& entry : std::filesystem::directory_iterator(GetAssetPath("Models")))
+	{
+		if(entry.path().extension() == ".obj")
+			models.push_back(entry.path());
+	}
+
+	std::sort(models.begin(), models.end());
+	return models;
+}
+
+std::filesystem::path GetAssetPath(const char* relativePath)
+{
+	return std::filesystem::path(ASSETS_DIR) / relativePath;
+}
+
+std::filesystem::path GetGoldenPath(const char* fileName)
+{
+	return std::filesystem::path(GOLDEN_DIR) / fileName;
+}
+
+std::filesystem::path MakeScratchDirectory(const char* name)
+{
+	std::filesystem::path directory = std::filesystem::temp_directory_path() / "EngineTests" / name;
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory);
+	return directory;
+}
+
+bool IsUpdatingGoldenFiles()
+{
+	return updateGolden;
+}
+
+int main(int argc, char** argv)
+{
+	bool runBenchmarks = false;
+	bool listOnly = false;
+	const char* filter = nullptr;
+	for(int i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "--bench") == 0) runBenchmarks = true;
+		else if(strcmp(argv[i], "--list") == 0) listOnly = true;
+		else if(strcmp(argv[i], "--update-golden") == 0) updateGolden = true;
+		else filter = argv[i];
+	}
+
+	int ran = 0;
+	int failed = 0;
+	for(const TestCase& test : GetTestCases())
+	{
+		if(test.isBenchmark != runBenchmarks || !MatchesFilter(test, filter))
+			continue;
+
+		if(listOnly)
+		{
+			printf("%s.%s\n", test.suite, test.name);
+			continue;
+		}
+
+		std::string fullName = std::string(test.suite) + "." + test.name;
+		currentCase = fullName.c_str();
+		currentFailures = 0;
+
+		printf("[ RUN  ] %s\n", currentCase);
+		fflush(stdout);
+		test.function();
+		printf("[ %s ] %s\n", currentFailures ? "FAIL" : " OK ", currentCase);
+
+		ran++;
+		if(currentFailures)
+			failed++;
+	}
+
+	if(listOnly)
+		return 0;
+
+	printf("%d of %d %s passed\n", ran - failed, ran, runBenchmarks ? "benchmarks" : "tests");
+
+	// A filter that matches nothing is most likely a typo, so don't let it pass quietly
+	return (failed || (filter && ran == 0)) ? 1 : 0;
+}
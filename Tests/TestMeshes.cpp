@@ -0,0 +1,81 @@
+#include "TestMeshes.h"
+#include "ObjLoader.h"
+
+#include <cmath>
+
+void LoadTestModel(const std::filesystem::path& model, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	LoadObj(model.wstring().c_str(), vertices, indices);
+}
+
+void MakeTestGrid(unsigned int cells, bool mirrorU, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	vertices.clear();
+	indices.clear();
+
+	unsigned int rowLength = cells + 1;
+	for(unsigned int z = 0; z < rowLength; z++)
+	{
+		for(unsigned int x = 0; x < rowLength; x++)
+		{
+			float u = (float) x / cells;
+			float v = (float) z / cells;
+
+			// A gentle wave keeps normals (and so tangents) from all being the same
+			float height = 0.05f * sinf(u * 12.0f) * cosf(v * 9.0f);
+
+			Vertex vertex = {};
+			vertex.position = DirectX::XMFLOAT3(u * 2.0f - 1.0f, height, v * 2.0f - 1.0f);
+			vertex.normal = DirectX::XMFLOAT3(0, 1, 0);
+			vertex.uv = DirectX::XMFLOAT2((mirrorU && u > 0.5f) ? 1.0f - u : u, 1.0f - v);
+			vertices.push_back(vertex);
+		}
+	}
+
+	// Clockwise (seen from above) for DirectX
+	for(unsigned int z = 0; z < cells; z++)
+	{
+		for(unsigned int x = 0; x < cells; x++)
+		{
+			unsigned int corner = z * rowLength + x;
+			indices.insert(indices.end(), { corner, corner + rowLength, corner + 1 });
+			indices.insert(indices.end(), { corner + 1, corner + rowLength, corner + rowLength + 1 });
+		}
+	}
+}
+
+void MakeTestSphere(unsigned int segments, unsigned int rings, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	vertices.clear();
+	indices.clear();
+
+	// The seam column is duplicated so its uvs can wrap
+	for(unsigned int ring = 0; ring <= rings; ring++)
+	{
+		float polar = DirectX::XM_PI * ring / rings;
+		for(unsigned int segment = 0; segment <= segments; segment++)
+		{
+			float azimuth = DirectX::XM_2PI * segment / segments;
+
+			Vertex vertex = {};
+			vertex.normal = DirectX::XMFLOAT3(sinf(polar) * cosf(azimuth), cosf(polar), sinf(polar) * sinf(azimuth));
+			vertex.position = vertex.normal;
+			vertex.uv = DirectX::XMFLOAT2((float) segment / segments, (float) ring / rings);
+			vertices.push_back(vertex);
+		}
+	}
+
+	// Clockwise seen from outside
+	unsigned int rowLength = segments + 1;
+	for(unsigned int ring = 0; ring < rings; ring++)
+	{
+		for(unsigned int segment = 0; segment < segments; segment++)
+		{
+			unsigned int corner = ring * rowLength + segment;
+			if(ring > 0)
+				indices.insert(indices.end(), { corner, corner + 1, corner + rowLength });
+			if(ring < rings - 1)
+				indices.insert(indices.end(), { corner + 1, corner + rowLength + 1, corner + rowLength });
+		}
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include "Vertex.h"
+
+// --------------------------------------------------------
+// Meshes shared by the mesh processing tests
+// --------------------------------------------------------
+
+// Parses (and welds) a bundled model, without any further processing
+void LoadTestModel(const std::filesystem::path& model, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+// Flat, wavy grid of (cells + 1)^2 vertices on the XZ plane with uvs across [0, 1]
+// - With mirrorU, the right half's U runs backwards (as on mirrored geometry),
+//   so its tangent frames have the opposite handedness
+void MakeTestGrid(unsigned int cells, bool mirrorU, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+// Unit uv sphere with the given number of segments around it and rings from pole to pole
+// (denser than any bundled model, so it splits into many small meshlets)
+void MakeTestSphere(unsigned int segments, unsigned int rings, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
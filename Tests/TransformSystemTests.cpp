@@ -0,0 +1,420 @@
+#include "TestFramework.h"
+#include "LegacyTransform.h"
+#include "ThreadPool.h"
+#include "TransformSystem.h"
+
+#include <cmath>
+#include <set>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	// Varied enough that no two transforms share a matrix, with translations large enough to matter
+	XMFLOAT3 TestLocation(size_t i) { float f = (float) i; return XMFLOAT3(f * 0.01f, -f * 0.02f, f * 0.03f); }
+	XMFLOAT3 TestRotation(size_t i) { float f = (float) i; return XMFLOAT3(f * 0.1f, f * 0.2f, f * 0.3f); }
+	XMFLOAT3 TestScale(size_t i) { return XMFLOAT3(1.0f + (i % 3), 1.0f + (i % 5) * 0.5f, 0.5f + (i % 7) * 0.25f); }
+
+	std::vector<TransformSystem::Handle> CreateTestTransforms(TransformSystem& system, size_t count)
+	{
+		std::vector<TransformSystem::Handle> handles(count);
+		for(size_t i = 0; i < count; i++)
+			handles[i] = system.Create(TestLocation(i), TestRotation(i), TestScale(i));
+		return handles;
+	}
+
+	// Marks every transform dirty (the way Game::Update spinning every entity does)
+	void DirtyAll(TransformSystem& system, const std::vector<TransformSystem::Handle>& handles)
+	{
+		for(TransformSystem::Handle handle : handles)
+			system.SetRotation(handle, system.GetRotation(handle));
+	}
+
+	// Largest difference between two matrices' elements, relative to the element's size (so
+	// large translations get the same slack as float rounding gives them)
+	float MaxRelativeDifference(const XMFLOAT4X4& actual, const XMFLOAT4X4& expected)
+	{
+		float maxDifference = 0.0f;
+		for(int element = 0; element < 16; element++)
+		{
+			float value = expected.m[element / 4][element % 4];
+			float difference = std::fabs(actual.m[element / 4][element % 4] - value) / (std::fabs(value) > 1.0f ? std::fabs(value) : 1.0f);
+			if(difference > maxDifference)
+				maxDifference = difference;
+		}
+		return maxDifference;
+	}
+
+	struct TransformMatrices
+	{
+		XMFLOAT4X4 world;
+		XMFLOAT4X4 worldInverse;
+		XMFLOAT4X4 worldInverseTranspose;
+	};
+
+	std::vector<TransformMatrices> ReadMatrices(TransformSystem& system, const std::vector<TransformSystem::Handle>& handles)
+	{
+		std::vector<TransformMatrices> matrices;
+		for(TransformSystem::Handle handle : handles)
+			matrices.push_back({ system.GetWorldMatrix(handle), system.GetWorldInverseMatrix(handle), system.GetWorldInverseTransposeMatrix(handle) });
+		return matrices;
+	}
+
+	float MaxRelativeDifference(const TransformMatrices& actual, const TransformMatrices& expected)
+	{
+		return std::fmax(MaxRelativeDifference(actual.world, expected.world),
+			std::fmax(MaxRelativeDifference(actual.worldInverse, expected.worldInverse),
+				MaxRelativeDifference(actual.worldInverseTranspose, expected.worldInverseTranspose)));
+	}
+
+	uint32_t NextRandom(uint32_t& random)
+	{
+		random = random * 1664525u + 1013904223u;
+		return random >> 8;
+	}
+
+	// Every node but the last gets a random parent created after it, so the first update has to
+	// sort them all into depth order
+	std::vector<TransformSystem::Handle> CreateTestHierarchy(TransformSystem& system, size_t nodeCount, uint32_t& random)
+	{
+		std::vector<TransformSystem::Handle> handles(nodeCount);
+		for(size_t i = 0; i < nodeCount; i++)
+		{
+			float f = (float) i;
+			handles[i] = system.Create(XMFLOAT3(std::sin(f), std::cos(f), 1.0f), XMFLOAT3(f * 0.1f, f * 0.2f, f * 0.3f),
+				XMFLOAT3(0.9f + (i % 3) * 0.1f, 0.9f + (i % 5) * 0.05f, 1.0f));
+		}
+		for(size_t i = 0; i + 1 < nodeCount; i++)
+			system.SetParent(handles[i], handles[i + 1 + NextRandom(random) % (nodeCount - i - 1)]);
+		return handles;
+	}
+
+	// The naive way: a world matrix from scratch, multiplying up the chain of parents
+	XMFLOAT4X4 WorldFromScratch(TransformSystem& system, TransformSystem::Handle handle)
+	{
+		XMMATRIX world = XMMatrixIdentity();
+		for(TransformSystem::Handle node = handle; node != TransformSystem::InvalidHandle; node = system.GetParent(node))
+		{
+			XMFLOAT3 location = system.GetLocation(node);
+			XMFLOAT3 rotation = system.GetRotation(node);
+			XMFLOAT3 scale = system.GetScale(node);
+			world = world * XMMatrixScaling(scale.x, scale.y, scale.z) *
+				XMMatrixRotationRollPitchYaw(rotation.x, rotation.y, rotation.z) * XMMatrixTranslation(location.x, location.y, location.z);
+		}
+
+		XMFLOAT4X4 result;
+		XMStoreFloat4x4(&result, world);
+		return result;
+	}
+
+	// Largest element of |matrix * inverse - identity|
+	float MaxInverseError(const XMFLOAT4X4& matrix, const XMFLOAT4X4& inverse)
+	{
+		XMFLOAT4X4 product;
+		XMStoreFloat4x4(&product, XMLoadFloat4x4(&matrix) * XMLoadFloat4x4(&inverse));
+		float maxError = 0.0f;
+		for(int element = 0; element < 16; element++)
+			maxError = std::fmax(maxError, std::fabs(product.m[element / 4][element % 4] - (element % 5 == 0 ? 1.0f : 0.0f)));
+		return maxError;
+	}
+
+	// Random TRS matrices with scales from 0.1 to 10 and translations out to 1000 units, to be
+	// rough on precision
+	struct TrsMatrices
+	{
+		std::vector<XMFLOAT4X4> rotations;
+		std::vector<XMFLOAT3> translations;
+		std::vector<XMFLOAT3> scales;
+		std::vector<XMFLOAT4X4> worlds;
+	};
+
+	TrsMatrices MakeRandomTrsMatrices(size_t matrixCount)
+	{
+		uint32_t random = 54321;
+		auto next = [&random]() { return NextRandom(random) / 16777216.0f; };
+		TrsMatrices matrices;
+		for(size_t i = 0; i < matrixCount; i++)
+		{
+			XMFLOAT3 translation((next() - 0.5f) * 2000.0f, (next() - 0.5f) * 2000.0f, (next() - 0.5f) * 2000.0f);
+			XMFLOAT3 scale(0.1f + next() * 9.9f, 0.1f + next() * 9.9f, 0.1f + next() * 9.9f);
+			XMMATRIX rotation = XMMatrixRotationRollPitchYaw(next() * XM_2PI, next() * XM_2PI, next() * XM_2PI);
+
+			XMFLOAT4X4 rotationMatrix, world;
+			XMStoreFloat4x4(&rotationMatrix, rotation);
+			XMStoreFloat4x4(&world, XMMatrixScaling(scale.x, scale.y, scale.z) * rotation * XMMatrixTranslation(translation.x, translation.y, translation.z));
+			matrices.rotations.push_back(rotationMatrix);
+			matrices.translations.push_back(translation);
+			matrices.scales.push_back(scale);
+			matrices.worlds.push_back(world);
+		}
+		return matrices;
+	}
+
+	XMFLOAT4X4 InvertDirectly(const TrsMatrices& matrices, size_t i)
+	{
+		XMFLOAT4X4 inverse;
+		XMVECTOR scale = XMVectorSetW(XMLoadFloat3(&matrices.scales[i]), 1.0f);
+		XMStoreFloat4x4(&inverse, InverseTRS(XMLoadFloat4x4(&matrices.rotations[i]), XMLoadFloat3(&matrices.translations[i]), scale));
+		return inverse;
+	}
+
+	// Largest element of |matrix * inverse - identity|, worked out in double precision and
+	// relative to the size of the terms summed into it (a big translation cancelling out has
+	// to leave some rounding)
+	double MaxRelativeInverseError(const XMFLOAT4X4& matrix, const XMFLOAT4X4& inverse)
+	{
+		double maxError = 0.0;
+		for(int row = 0; row < 4; row++)
+		{
+			for(int column = 0; column < 4; column++)
+			{
+				double sum = 0.0, magnitude = 0.0;
+				for(int k = 0; k < 4; k++)
+				{
+					sum += (double) matrix.m[row][k] * inverse.m[k][column];
+					magnitude += std::fabs((double) matrix.m[row][k] * inverse.m[k][column]);
+				}
+				double error = std::fabs(sum - (row == column ? 1.0 : 0.0)) / (magnitude > 1.0 ? magnitude : 1.0);
+				maxError = error > maxError ? error : maxError;
+			}
+		}
+		return maxError;
+	}
+}
+
+TEST(TransformSystem, BatchedMatchesPerObject)
+{
+	// Enough groups of four to be split across threads, and not a multiple of four
+	TransformSystem system;
+	std::vector<TransformSystem::Handle> handles = CreateTestTransforms(system, 20001);
+
+	for(TransformSystem::Handle handle : handles)
+		system.UpdateWorldMatrix(handle);
+	std::vector<TransformMatrices> perObject = ReadMatrices(system, handles);
+
+	for(bool parallel : { false, true })
+	{
+		DirtyAll(system, handles);
+		CHECK(system.UpdateWorldMatrices(parallel) == handles.size());
+
+		std::vector<TransformMatrices> batched = ReadMatrices(system, handles);
+		float maxDifference = 0.0f;
+		for(size_t i = 0; i < handles.size(); i++)
+			maxDifference = std::fmax(maxDifference, MaxRelativeDifference(batched[i], perObject[i]));
+		// The two paths sum the inverse translation in different orders, and with translations in
+		// the hundreds that term can cancel down to far less than its parts
+		CHECK(maxDifference < 1e-4f);
+
+		// Nothing's dirty any more, so there's nothing to rebuild
+		CHECK(system.UpdateWorldMatrices(parallel) == 0);
+	}
+}
+
+TEST(TransformSystem, MatchesLegacyTransform)
+{
+	TransformSystem system;
+	std::vector<TransformSystem::Handle> handles = CreateTestTransforms(system, 1000);
+	system.UpdateWorldMatrices(false);
+
+	// The inverses are written down directly rather than through XMMatrixInverse, so they only
+	// agree up to rounding
+	for(size_t i = 0; i < handles.size(); i++)
+	{
+		LegacyTransform legacy(TestLocation(i), TestRotation(i), TestScale(i));
+		TransformMatrices expected = { legacy.GetWorldMatrix(), legacy.GetWorldInverseMatrix(), legacy.GetWorldInverseTransposeMatrix() };
+		TransformMatrices actual = { system.GetWorldMatrix(handles[i]), system.GetWorldInverseMatrix(handles[i]), system.GetWorldInverseTransposeMatrix(handles[i]) };
+		CHECK(MaxRelativeDifference(actual, expected) < 1e-4f);
+	}
+}
+
+TEST(TransformSystem, HandlesSurviveRemoval)
+{
+	// Destroying transforms moves others into their slots, which mustn't change what any handle refers to
+	TransformSystem system;
+	std::vector<TransformSystem::Handle> handles;
+	for(int i = 0; i < 10; i++)
+		handles.push_back(system.Create(XMFLOAT3((float) i, 0, 0), XMFLOAT3(0, 0, 0), XMFLOAT3(1, 1, 1)));
+	system.Destroy(handles[3]);
+	system.Destroy(handles[0]);
+	TransformSystem::Handle added = system.Create(XMFLOAT3(42, 0, 0), XMFLOAT3(0, 0, 0), XMFLOAT3(1, 1, 1));
+	system.UpdateWorldMatrices();
+
+	CHECK(system.GetCount() == 9);
+	for(int i : { 1, 2, 4, 9 })
+		CHECK(system.GetWorldMatrix(handles[i]).m[3][0] == (float) i);
+	CHECK(system.GetWorldMatrix(added).m[3][0] == 42.0f);
+}
+
+TEST(TransformSystem, HierarchyMatchesFromScratch)
+{
+	uint32_t random = 12345;
+	TransformSystem system;
+	std::vector<TransformSystem::Handle> handles = CreateTestHierarchy(system, 2000, random);
+	CHECK(system.UpdateWorldMatrices(false) == handles.size());
+
+	// Move a few nodes; only they and everything under them should be rebuilt
+	std::set<TransformSystem::Handle> moved;
+	for(int i = 0; i < 20; i++)
+	{
+		uint32_t index = NextRandom(random) % handles.size();
+		XMFLOAT3 location = system.GetLocation(handles[index]);
+		system.SetLocation(handles[index], XMFLOAT3(location.x + 0.5f, location.y, location.z));
+		moved.insert(handles[index]);
+	}
+	size_t expectedRebuilt = 0;
+	for(size_t i = 0; i < handles.size(); i++)
+	{
+		for(TransformSystem::Handle node = handles[i]; node != TransformSystem::InvalidHandle; node = system.GetParent(node))
+		{
+			if(moved.count(node) != 0)
+			{
+				expectedRebuilt++;
+				break;
+			}
+		}
+	}
+	CHECK(system.UpdateWorldMatrices(false) == expectedRebuilt);
+
+	for(TransformSystem::Handle handle : handles)
+	{
+		CHECK(MaxRelativeDifference(system.GetWorldMatrix(handle), WorldFromScratch(system, handle)) < 1e-4f);
+		CHECK(MaxInverseError(system.GetWorldMatrix(handle), system.GetWorldInverseMatrix(handle)) < 1e-4f);
+	}
+}
+
+TEST(TransformSystem, StaleReadsRefreshAncestors)
+{
+	// Reading a child's matrix without a batch update in between still sees its parent's change
+	TransformSystem system;
+	TransformSystem::Handle parent = system.Create(XMFLOAT3(1, 0, 0), XMFLOAT3(0, 0, 0), XMFLOAT3(2, 2, 2));
+	TransformSystem::Handle child = system.Create(XMFLOAT3(0, 1, 0), XMFLOAT3(0, 0, 0), XMFLOAT3(1, 1, 1));
+	CHECK(system.SetParent(child, parent));
+	system.UpdateWorldMatrices();
+	CHECK(system.GetWorldMatrix(child).m[3][1] == 2.0f);
+
+	system.SetLocation(parent, XMFLOAT3(5, 0, 0));
+	CHECK(system.GetWorldMatrix(child).m[3][0] == 5.0f);
+	CHECK(system.GetWorldMatrix(child).m[3][1] == 2.0f);
+	CHECK(system.GetWorldInverseMatrix(child).m[3][0] == -2.5f);
+}
+
+TEST(TransformSystem, SetParentRefusesLoops)
+{
+	TransformSystem system;
+	TransformSystem::Handle a = system.Create(XMFLOAT3(0, 0, 0), XMFLOAT3(0, 0, 0), XMFLOAT3(1, 1, 1));
+	TransformSystem::Handle b = system.Create(XMFLOAT3(0, 0, 0), XMFLOAT3(0, 0, 0), XMFLOAT3(1, 1, 1));
+	TransformSystem::Handle c = system.Create(XMFLOAT3(0, 0, 0), XMFLOAT3(0, 0, 0), XMFLOAT3(1, 1, 1));
+	CHECK(system.SetParent(b, a));
+	CHECK(system.SetParent(c, b));
+	CHECK(!system.SetParent(a, c));
+	CHECK(!system.SetParent(a, a));
+	CHECK(system.GetParent(a) == TransformSystem::InvalidHandle);
+	CHECK(system.SetParent(c, TransformSystem::InvalidHandle));
+	CHECK(system.SetParent(a, c));
+}
+
+TEST(TransformSystem, InverseTRSIsPrecise)
+{
+	// Skipping the general inverse shouldn't cost more than float rounding, even at extreme scales
+	TrsMatrices matrices = MakeRandomTrsMatrices(10000);
+	double maxError = 0.0;
+	for(size_t i = 0; i < matrices.worlds.size(); i++)
+		maxError = std::fmax(maxError, MaxRelativeInverseError(matrices.worlds[i], InvertDirectly(matrices, i)));
+	CHECK(maxError < 1e-5);
+}
+
+BENCHMARK(TransformSystem, BatchedVsPerObject)
+{
+	// Every transform changes, then every matrix is rebuilt: the old Transform, one object at a
+	// time, vs the system one object at a time, batched and batched across threads
+	printf("  %-10s %12s %12s %12s %12s %10s\n", "transforms", "legacy ms", "per-obj ms", "batched ms", "parallel ms", "speedup");
+	for(size_t count : { 10000, 100000, 1000000 })
+	{
+		std::vector<LegacyTransform> legacy;
+		legacy.reserve(count);
+		for(size_t i = 0; i < count; i++)
+			legacy.emplace_back(TestLocation(i), TestRotation(i), TestScale(i));
+		double legacyMilliseconds = MeasureMilliseconds([&]()
+			{
+				for(LegacyTransform& transform : legacy)
+				{
+					transform.SetRotation(transform.GetPitchYawRoll());
+					transform.GetWorldMatrix();
+				}
+			});
+		legacy = std::vector<LegacyTransform>();
+
+		TransformSystem system;
+		std::vector<TransformSystem::Handle> handles = CreateTestTransforms(system, count);
+		double perObjectMilliseconds = MeasureMilliseconds([&]()
+			{
+				DirtyAll(system, handles);
+				for(TransformSystem::Handle handle : handles)
+					system.UpdateWorldMatrix(handle);
+			});
+		double batchedMilliseconds = MeasureMilliseconds([&]() { DirtyAll(system, handles); system.UpdateWorldMatrices(false); });
+		double parallelMilliseconds = MeasureMilliseconds([&]() { DirtyAll(system, handles); system.UpdateWorldMatrices(true); });
+
+		printf("  %-10zu %12.3f %12.3f %12.3f %12.3f %9.2fx\n", count, legacyMilliseconds, perObjectMilliseconds,
+			batchedMilliseconds, parallelMilliseconds, legacyMilliseconds / parallelMilliseconds);
+	}
+	printf("  (%u threads)\n", ThreadPool::Global().GetThreadCount() + 1);
+}
+
+BENCHMARK(TransformSystem, Hierarchy)
+{
+	// Updating a hierarchy should only cost as much as the parts of it that moved
+	const size_t nodeCount = 100000;
+	uint32_t random = 12345;
+	TransformSystem system;
+	std::vector<TransformSystem::Handle> handles = CreateTestHierarchy(system, nodeCount, random);
+	double sortMilliseconds = MeasureMilliseconds([&]() { system.UpdateWorldMatrices(false); }, 1);
+	printf("  %zu nodes, first update (with sort) %.3f ms\n", nodeCount, sortMilliseconds);
+
+	printf("  %-10s %10s %12s %12s\n", "changed", "rebuilt", "ms", "ns each");
+	for(size_t changedCount : { 10, 100, 1000, 10000, 100000 })
+	{
+		std::vector<TransformSystem::Handle> changed(changedCount);
+		for(TransformSystem::Handle& handle : changed)
+			handle = handles[NextRandom(random) % nodeCount];
+
+		size_t rebuiltCount = 0;
+		double milliseconds = MeasureMilliseconds([&]()
+			{
+				for(TransformSystem::Handle handle : changed)
+					system.SetLocation(handle, system.GetLocation(handle));
+				rebuiltCount = system.UpdateWorldMatrices(false);
+			});
+		printf("  %-10zu %10zu %12.3f %12.1f\n", changedCount, rebuiltCount, milliseconds, milliseconds * 1000000.0 / rebuiltCount);
+	}
+}
+
+BENCHMARK(TransformSystem, InverseTRS)
+{
+	printf("  %-10s %16s %16s %10s %14s %14s\n", "matrices", "general ms", "TRS ms", "speedup", "general error", "TRS error");
+	for(size_t count : { 10000, 100000, 1000000 })
+	{
+		TrsMatrices matrices = MakeRandomTrsMatrices(count);
+		std::vector<XMFLOAT4X4> generalInverses(count), trsInverses(count);
+		double generalMilliseconds = MeasureMilliseconds([&]()
+			{
+				for(size_t i = 0; i < count; i++)
+					XMStoreFloat4x4(&generalInverses[i], XMMatrixInverse(nullptr, XMLoadFloat4x4(&matrices.worlds[i])));
+			});
+		double trsMilliseconds = MeasureMilliseconds([&]()
+			{
+				for(size_t i = 0; i < count; i++)
+					trsInverses[i] = InvertDirectly(matrices, i);
+			});
+
+		double generalMaxError = 0.0, trsMaxError = 0.0;
+		for(size_t i = 0; i < count; i++)
+		{
+			generalMaxError = std::fmax(generalMaxError, MaxRelativeInverseError(matrices.worlds[i], generalInverses[i]));
+			trsMaxError = std::fmax(trsMaxError, MaxRelativeInverseError(matrices.worlds[i], trsInverses[i]));
+		}
+		printf("  %-10zu %16.3f %16.3f %9.2fx %14.2e %14.2e\n", count, generalMilliseconds, trsMilliseconds,
+			generalMilliseconds / trsMilliseconds, generalMaxError, trsMaxError);
+	}
+}
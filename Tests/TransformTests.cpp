@@ -0,0 +1,168 @@
+#include "TestFramework.h"
+#include "LegacyTransform.h"
+#include "Transform.h"
+
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	float MaxDifference(XMFLOAT3 a, XMFLOAT3 b)
+	{
+		return std::fmax(std::fabs(a.x - b.x), std::fmax(std::fabs(a.y - b.y), std::fabs(a.z - b.z)));
+	}
+
+	// Largest difference between two matrices' elements, relative to the element's size
+	float MaxRelativeDifference(const XMFLOAT4X4& actual, const XMFLOAT4X4& expected)
+	{
+		float maxDifference = 0.0f;
+		for(int element = 0; element < 16; element++)
+		{
+			float value = expected.m[element / 4][element % 4];
+			float difference = std::fabs(actual.m[element / 4][element % 4] - value) / (std::fabs(value) > 1.0f ? std::fabs(value) : 1.0f);
+			if(difference > maxDifference)
+				maxDifference = difference;
+		}
+		return maxDifference;
+	}
+
+	// Flying forward and sideways while looking around, the busiest a frame of Camera::Update gets
+	const float FlightDistance = 0.01f;
+	XMFLOAT2 FlightLook(size_t frame)
+	{
+		return XMFLOAT2(std::sin(frame * 0.01f) * 0.01f, std::cos(frame * 0.013f) * 0.01f);
+	}
+
+	// One frame the way Camera::Update used to: each key's move rebuilds a quaternion from pitch/yaw/roll,
+	// and so does each basis vector the view matrix needs
+	XMFLOAT4X4 FlyLegacy(LegacyTransform& transform, size_t frame)
+	{
+		transform.MoveRelative(0, 0, FlightDistance);
+		transform.MoveRelative(FlightDistance, 0, 0);
+
+		XMFLOAT2 look = FlightLook(frame);
+		transform.Rotate(look.x, look.y, 0);
+		XMFLOAT3 rotation = transform.GetPitchYawRoll();
+		if(rotation.x < -XM_PIDIV2)
+			transform.SetRotation(-XM_PIDIV2, rotation.y, rotation.z);
+		if(rotation.x > XM_PIDIV2)
+			transform.SetRotation(XM_PIDIV2, rotation.y, rotation.z);
+
+		XMFLOAT3 location = transform.GetLocation();
+		XMFLOAT3 forward = transform.GetForward();
+		XMFLOAT3 up = transform.GetUp();
+		XMFLOAT4X4 view;
+		XMStoreFloat4x4(&view, XMMatrixLookToLH(XMLoadFloat3(&location), XMLoadFloat3(&forward), XMLoadFloat3(&up)));
+		return view;
+	}
+
+	// The same frame through Camera::Move (Camera.cpp itself needs Windows for its input)
+	XMFLOAT4X4 Fly(Transform& transform, size_t frame)
+	{
+		transform.MoveRelative(FlightDistance, 0, FlightDistance);
+
+		XMFLOAT2 look = FlightLook(frame);
+		XMFLOAT3 rotation = transform.GetPitchYawRoll();
+		rotation.x += look.x;
+		rotation.y += look.y;
+		if(rotation.x < -XM_PIDIV2)
+			rotation.x = -XM_PIDIV2;
+		if(rotation.x > XM_PIDIV2)
+			rotation.x = XM_PIDIV2;
+		transform.SetRotation(rotation);
+
+		XMFLOAT3 location = transform.GetLocation();
+		XMFLOAT3 forward = transform.GetForward();
+		XMFLOAT3 up = transform.GetUp();
+		XMFLOAT4X4 view;
+		XMStoreFloat4x4(&view, XMMatrixLookToLH(XMLoadFloat3(&location), XMLoadFloat3(&forward), XMLoadFloat3(&up)));
+		return view;
+	}
+}
+
+TEST(Transform, MatchesLegacyTransform)
+{
+	for(int i = 0; i < 100; i++)
+	{
+		float f = (float) i;
+		XMFLOAT3 location(f * 0.5f, -f, 3.0f), rotation(f * 0.1f, f * 0.2f, f * 0.3f), scale(1.0f + (i % 3), 1.0f, 0.5f);
+		Transform transform(location, rotation, scale);
+		LegacyTransform legacy(location, rotation, scale);
+
+		CHECK(MaxDifference(transform.GetRight(), legacy.GetRight()) < 1e-5f);
+		CHECK(MaxDifference(transform.GetUp(), legacy.GetUp()) < 1e-5f);
+		CHECK(MaxDifference(transform.GetForward(), legacy.GetForward()) < 1e-5f);
+		CHECK(MaxRelativeDifference(transform.GetWorldMatrix(), legacy.GetWorldMatrix()) < 1e-5f);
+
+		transform.MoveRelative(1, 2, 3);
+		legacy.MoveRelative(1, 2, 3);
+		CHECK(MaxDifference(transform.GetLocation(), legacy.GetLocation()) < 1e-4f);
+	}
+}
+
+TEST(Transform, CopiesKeepRotation)
+{
+	// Set as a quaternion, the rotation doesn't come from (and can't be rebuilt exactly from) the
+	// angles, so a copy has to take the quaternion itself
+	XMFLOAT4 quaternion;
+	XMStoreFloat4(&quaternion, XMQuaternionRotationAxis(XMVector3Normalize(XMVectorSet(1, 2, 3, 0)), 2.5f));
+	Transform original(XMFLOAT3(1, 2, 3), XMFLOAT3(0, 0, 0), XMFLOAT3(2, 2, 2));
+	original.SetRotation(quaternion);
+	XMFLOAT4 expected = original.GetRotation();
+
+	Transform copied(original);
+	Transform assigned;
+	assigned = original;
+	for(Transform* copy : { &copied, &assigned })
+	{
+		XMFLOAT4 rotation = copy->GetRotation();
+		CHECK(rotation.x == expected.x && rotation.y == expected.y && rotation.z == expected.z && rotation.w == expected.w);
+		CHECK(MaxDifference(copy->GetPitchYawRoll(), original.GetPitchYawRoll()) == 0.0f);
+		CHECK(MaxDifference(copy->GetForward(), original.GetForward()) == 0.0f);
+		CHECK(MaxRelativeDifference(copy->GetWorldMatrix(), original.GetWorldMatrix()) == 0.0f);
+	}
+
+	// Angles outside [-PI, PI] survive a copy as they were typed in, too
+	Transform spun(XMFLOAT3(0, 0, 0), XMFLOAT3(0.5f, 7.0f, -4.0f), XMFLOAT3(1, 1, 1));
+	Transform spunCopy(spun);
+	CHECK(MaxDifference(spunCopy.GetPitchYawRoll(), XMFLOAT3(0.5f, 7.0f, -4.0f)) == 0.0f);
+}
+
+TEST(Transform, CameraFlightMatchesLegacy)
+{
+	LegacyTransform legacy(XMFLOAT3(0, 0, -1), XMFLOAT3(0, 0, 0), XMFLOAT3(1, 1, 1));
+	Transform transform(XMFLOAT3(0, 0, -1), XMFLOAT3(0, 0, 0), XMFLOAT3(1, 1, 1));
+	XMFLOAT4X4 legacyView, view;
+	for(size_t frame = 0; frame < 10000; frame++)
+	{
+		legacyView = FlyLegacy(legacy, frame);
+		view = Fly(transform, frame);
+	}
+
+	// Same flight, so the same view, up to rounding piled up over the frames
+	CHECK(MaxRelativeDifference(view, legacyView) < 1e-3f);
+}
+
+BENCHMARK(Transform, CameraFlight)
+{
+	// Flying around should only work out the camera's rotation when it turns
+	XMFLOAT4X4 legacyView, view;
+	printf("  %-10s %18s %16s %10s\n", "frames", "pitch/yaw/roll ms", "quaternion ms", "speedup");
+	for(size_t frameCount : { 10000, 100000, 1000000 })
+	{
+		double legacyMilliseconds = MeasureMilliseconds([&]()
+			{
+				LegacyTransform legacy(XMFLOAT3(0, 0, -1), XMFLOAT3(0, 0, 0), XMFLOAT3(1, 1, 1));
+				for(size_t frame = 0; frame < frameCount; frame++)
+					legacyView = FlyLegacy(legacy, frame);
+			});
+		double quaternionMilliseconds = MeasureMilliseconds([&]()
+			{
+				Transform transform(XMFLOAT3(0, 0, -1), XMFLOAT3(0, 0, 0), XMFLOAT3(1, 1, 1));
+				for(size_t frame = 0; frame < frameCount; frame++)
+					view = Fly(transform, frame);
+			});
+		printf("  %-10zu %18.3f %16.3f %9.2fx\n", frameCount, legacyMilliseconds, quaternionMilliseconds, legacyMilliseconds / quaternionMilliseconds);
+	}
+}
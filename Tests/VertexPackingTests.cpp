@@ -0,0 +1,149 @@
+#include "TestFramework.h"
+#include "TestMeshes.h"
+#include "MeshTangents.h"
+#include "VertexPacking.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	// Largest difference between a set of vertices and their packed (then unpacked) versions
+	// - Position error is absolute, in the mesh's units
+	// - Uv error is relative to the uv's magnitude (at least 1), since halves are floating point
+	// - Normal and tangent errors are angles, in degrees
+	struct VertexPackingError
+	{
+		float position;
+		float normalDegrees;
+		float tangentDegrees;
+		float uv;
+	};
+
+	// Angle between two directions, in degrees
+	// - Uses atan2 in doubles, since acos can't resolve the tiny angles being measured
+	float AngleBetween(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		double crossX = (double) a.y * b.z - (double) a.z * b.y;
+		double crossY = (double) a.z * b.x - (double) a.x * b.z;
+		double crossZ = (double) a.x * b.y - (double) a.y * b.x;
+		double dot = (double) a.x * b.x + (double) a.y * b.y + (double) a.z * b.z;
+		return (float) (std::atan2(std::sqrt(crossX * crossX + crossY * crossY + crossZ * crossZ), dot) * 180.0 / 3.14159265358979323846);
+	}
+
+	VertexPackingError MeasurePackingError(const std::vector<Vertex>& vertices, const VertexQuantization& quantization)
+	{
+		VertexPackingError error = {};
+		for(const Vertex& original : vertices)
+		{
+			Vertex unpacked = UnpackVertex(PackVertex(original, 1.0f, quantization), quantization);
+
+			error.position = std::max({ error.position,
+				std::abs(unpacked.position.x - original.position.x),
+				std::abs(unpacked.position.y - original.position.y),
+				std::abs(unpacked.position.z - original.position.z) });
+			error.normalDegrees = std::max(error.normalDegrees, AngleBetween(unpacked.normal, original.normal));
+			error.tangentDegrees = std::max(error.tangentDegrees, AngleBetween(unpacked.tangent, original.tangent));
+			error.uv = std::max({ error.uv,
+				std::abs(unpacked.uv.x - original.uv.x) / std::max(std::abs(original.uv.x), 1.0f),
+				std::abs(unpacked.uv.y - original.uv.y) / std::max(std::abs(original.uv.y), 1.0f) });
+		}
+		return error;
+	}
+
+	std::vector<float> CalculateSigns(std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+	{
+		CalculateTangentsSerial(vertices.data(), vertices.size(), indices.data(), indices.size());
+
+		std::vector<float> signs(vertices.size());
+		CalculateBitangentSigns(vertices.data(), vertices.size(), indices.data(), indices.size(), signs.data());
+		return signs;
+	}
+}
+
+// What the packed format loses on the bundled models stays under what's visible
+TEST(VertexPacking, ErrorBounds)
+{
+	for(const auto& model : GetBundledModels())
+	{
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+		LoadTestModel(model, vertices, indices);
+		CalculateTangentsSerial(vertices.data(), vertices.size(), indices.data(), indices.size());
+
+		VertexQuantization quantization = CalculateVertexQuantization(vertices.data(), vertices.size());
+		VertexPackingError error = MeasurePackingError(vertices, quantization);
+
+		// Half a 16-bit step of the largest axis (plus float rounding)
+		float largestScale = std::max({ quantization.positionScale.x, quantization.positionScale.y, quantization.positionScale.z });
+		CHECK(error.position <= largestScale * (0.5f / 65535.0f) * 1.01f);
+
+		// 16-bit octahedral vectors are good to a few thousandths of a degree
+		CHECK(error.normalDegrees < 0.01f);
+		CHECK(error.tangentDegrees < 0.01f);
+
+		// Half floats have 11 significant bits, so round to within 2^-11 of the value
+		CHECK(error.uv <= 1.0f / 2048.0f);
+	}
+}
+
+TEST(VertexPacking, OctahedralRoundTrip)
+{
+	// Axes and the octahedron's folds are the edge cases
+	std::vector<XMFLOAT3> directions = {
+		{ 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+		{ 0.577350f, 0.577350f, -0.577350f }, { -0.707107f, 0, -0.707107f } };
+
+	std::mt19937 random(1234);
+	std::normal_distribution<float> gaussian;
+	for(int i = 0; i < 10000; i++)
+	{
+		XMFLOAT3 direction(gaussian(random), gaussian(random), gaussian(random));
+		XMStoreFloat3(&direction, XMVector3Normalize(XMLoadFloat3(&direction)));
+		directions.push_back(direction);
+	}
+
+	float worstDegrees = 0.0f;
+	for(const XMFLOAT3& direction : directions)
+		worstDegrees = std::max(worstDegrees, AngleBetween(DecodeOctahedral(EncodeOctahedral(direction)), direction));
+	CHECK(worstDegrees < 1e-3f);
+}
+
+TEST(VertexPacking, BitangentSigns)
+{
+	// Left half of the grid is laid out normally, the right half has its U mirrored
+	const unsigned int cells = 16;
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	MakeTestGrid(cells, true, vertices, indices);
+	std::vector<float> signs = CalculateSigns(vertices, indices);
+
+	VertexQuantization quantization = CalculateVertexQuantization(vertices.data(), vertices.size());
+	for(size_t i = 0; i < vertices.size(); i++)
+	{
+		// The seam's vertices are shared by both halves
+		unsigned int column = i % (cells + 1);
+		if(column == cells / 2)
+			continue;
+
+		float expected = column < cells / 2 ? 1.0f : -1.0f;
+		CHECK(signs[i] == expected);
+		CHECK(UnpackBitangentSign(PackVertex(vertices[i], signs[i], quantization)) == expected);
+	}
+
+	// Real meshes: no mirroring except the cylinder's caps
+	for(const auto& model : GetBundledModels())
+	{
+		LoadTestModel(model, vertices, indices);
+		signs = CalculateSigns(vertices, indices);
+
+		size_t mirrored = std::count(signs.begin(), signs.end(), -1.0f);
+		if(model.stem() == "cylinder")
+			CHECK(mirrored > 0 && mirrored < vertices.size());
+		else
+			CHECK(mirrored == 0);
+	}
+}
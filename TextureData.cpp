@@ -0,0 +1,285 @@
+#include "TextureData.h"
+#include "MappedFile.h"
+#include "PngLoader.h"
+#include "OrmPacker.h"
+#include "CubemapCooker.h"
+#include "ThreadPool.h"
+
+#include <cstdio>
+#include <cstring>
+
+void TextureData::SetMips(std::vector<Image>&& mips, unsigned int mipFaceCount)
+{
+	ownedMips = std::move(mips);
+	ownedBlocks.clear();
+	cooked.reset();
+	faceCount = mipFaceCount;
+
+	width = ownedMips.empty() ? 0 : ownedMips[0].width;
+	height = ownedMips.empty() ? 0 : ownedMips[0].height;
+	channels = ownedMips.empty() ? 0 : ownedMips[0].channels;
+	isSRGB = !ownedMips.empty() && ownedMips[0].isSRGB;
+	format = BlockFormat::None;
+
+	mipPixels.clear();
+	for(const Image& mip : ownedMips)
+		mipPixels.push_back(mip.pixels.data());
+}
+
+void TextureData::SetCompressedMips(const std::vector<Image>& sourceMips, BlockFormat blockFormat, std::vector<std::vector<uint8_t>>&& blocks)
+{
+	ownedBlocks = std::move(blocks);
+	ownedMips.clear();
+	cooked.reset();
+	faceCount = 1;
+
+	width = sourceMips.empty() ? 0 : sourceMips[0].width;
+	height = sourceMips.empty() ? 0 : sourceMips[0].height;
+	channels = sourceMips.empty() ? 0 : sourceMips[0].channels;
+	isSRGB = !sourceMips.empty() && sourceMips[0].isSRGB;
+	format = blockFormat;
+
+	mipPixels.clear();
+	for(const std::vector<uint8_t>& mip : ownedBlocks)
+		mipPixels.push_back(mip.data());
+}
+
+unsigned int TextureData::GetRowPitch(unsigned int mip) const
+{
+	unsigned int mipWidth = width >> mip;
+	return ::GetRowPitch(format, channels, mipWidth > 0 ? mipWidth : 1);
+}
+
+size_t TextureData::GetMipSize(unsigned int mip) const
+{
+	unsigned int mipWidth = width >> mip;
+	unsigned int mipHeight = height >> mip;
+	return GetSurfaceSize(format, channels, mipWidth > 0 ? mipWidth : 1, mipHeight > 0 ? mipHeight : 1);
+}
+
+size_t TextureData::GetByteSize() const
+{
+	return (size_t) CookedTexture::GetMipChainSize(format, width, height, channels, GetMipCount()) * faceCount;
+}
+
+size_t TextureData::GetUncompressedByteSize() const
+{
+	return (size_t) CookedTexture::GetMipChainSize(BlockFormat::None, width, height, channels, GetMipCount()) * faceCount;
+}
+
+namespace
+{
+	// Points data at a cached texture, if there is one for this hash
+	bool LoadCachedTexture(const std::filesystem::path& cacheDirectory, uint64_t hash, TextureData& data)
+	{
+		if(cacheDirectory.empty())
+			return false;
+
+		std::unique_ptr<CookedTexture> cooked = std::make_unique<CookedTexture>(cacheDirectory, hash);
+		if(!cooked->IsValid())
+			return false;
+
+		const CookedTextureHeader* header = cooked->GetHeader();
+		data.width = header->width;
+		data.height = header->height;
+		data.channels = header->channels;
+		data.isSRGB = header->isSRGB != 0;
+		data.format = (BlockFormat) header->format;
+		data.faceCount = header->faceCount;
+		memcpy(data.irradianceSH, header->irradianceSH, sizeof(data.irradianceSH));
+		data.mipPixels.clear();
+		for(unsigned int face = 0; face < header->faceCount; face++)
+		{
+			for(unsigned int mip = 0; mip < header->mipCount; mip++)
+				data.mipPixels.push_back(cooked->GetMipPixels(mip, face));
+		}
+		data.ownedMips.clear();
+		data.ownedBlocks.clear();
+		data.cooked = std::move(cooked);
+		return true;
+	}
+
+	// Writes data (whose mips are all in place) to the cache, filling in the rest of the header from it
+	void WriteCookedTexture(const std::filesystem::path& cacheDirectory, CookedTextureHeader header, const TextureData& data)
+	{
+		if(cacheDirectory.empty())
+			return;
+
+		header.width = data.width;
+		header.height = data.height;
+		header.channels = data.channels;
+		header.mipCount = data.GetMipCount();
+		header.isSRGB = data.isSRGB ? 1 : 0;
+		header.faceCount = data.faceCount;
+		CookedTexture::Write(cacheDirectory, header, data.mipPixels);
+	}
+
+	// Generates mips for (and compresses) a decoded image, hands them to data and writes them to the cache
+	void CookTexture(std::vector<Image>& mips, const std::filesystem::path& cacheDirectory, uint64_t hash, const TextureCookOptions& options, TextureData& data)
+	{
+		if(options.generateMips)
+			GenerateMips(mips[0], options.mipOptions, mips);
+
+		// Pick the format this particular texture can actually use
+		BlockFormat format = options.format;
+		if(format != BlockFormat::None && !CanBlockCompress(mips[0].width, mips[0].height))
+			format = BlockFormat::None;
+		if(format == BlockFormat::BC1 && mips[0].channels == 4)
+		{
+			for(size_t i = 3; i < mips[0].pixels.size(); i += 4)
+			{
+				if(mips[0].pixels[i] != 255)
+				{
+					format = BlockFormat::BC3;
+					break;
+				}
+			}
+		}
+
+		CookedTextureHeader header = {};
+		header.contentHash = hash;
+		header.format = (uint32_t) format;
+
+		if(format == BlockFormat::None)
+			data.SetMips(std::move(mips));
+		else
+		{
+			std::vector<std::vector<uint8_t>> blocks(mips.size());
+			for(size_t mip = 0; mip < mips.size(); mip++)
+				CompressImage(mips[mip], format, blocks[mip]);
+
+			// Quality of the top mip, which is what's seen up close
+			Image decompressed = DecompressImage(blocks[0].data(), mips[0].width, mips[0].height, format);
+			header.psnr = (float) ComputePsnr(mips[0], decompressed, GetBlockFormatChannels(format));
+
+			data.SetCompressedMips(mips, format, std::move(blocks));
+		}
+
+		// Cook it so later runs can skip all of the above
+		WriteCookedTexture(cacheDirectory, header, data);
+	}
+
+	// Key on everything that changes what gets cooked
+	uint64_t HashCookOptions(const TextureCookOptions& options, uint64_t hash)
+	{
+		uint8_t settings[4] = { options.generateMips, options.mipOptions.isGammaEncoded, options.mipOptions.isNormalMap, (uint8_t) options.format };
+		return HashBytes(settings, sizeof(settings), hash);
+	}
+}
+
+bool LoadTextureData(const wchar_t* filePath, const std::filesystem::path& cacheDirectory, const TextureCookOptions& options, TextureData& data)
+{
+	MappedFile source(filePath);
+	if(!source.IsOpen())
+		return false;
+
+	uint64_t hash = HashBytes(source.GetData(), source.GetSize(), CookedTexture::Version);
+	hash = HashCookOptions(options, hash);
+
+	// Cache hit: upload straight out of the mapped file
+	if(LoadCachedTexture(cacheDirectory, hash, data))
+		return true;
+
+	std::vector<Image> mips(1);
+	if(!DecodePng((const uint8_t*) source.GetData(), source.GetSize(), mips[0]))
+		return false;
+
+	CookTexture(mips, cacheDirectory, hash, options, data);
+	return true;
+}
+
+bool LoadOrmTextureData(const wchar_t* occlusionPath, const wchar_t* roughnessPath, const wchar_t* metalnessPath,
+	const std::filesystem::path& cacheDirectory, const TextureCookOptions& options, TextureData& data)
+{
+	// Every source (and which slot it's in) goes into the hash
+	const wchar_t* paths[3] = { occlusionPath, roughnessPath, metalnessPath };
+	std::unique_ptr<MappedFile> sources[3];
+	uint64_t hash = CookedTexture::Version;
+	for(int i = 0; i < 3; i++)
+	{
+		uint8_t slot = (uint8_t) i;
+		hash = HashBytes(&slot, 1, hash);
+		if(!paths[i])
+			continue;
+
+		sources[i] = std::make_unique<MappedFile>(paths[i]);
+		if(!sources[i]->IsOpen())
+			return false;
+		hash = HashBytes(sources[i]->GetData(), sources[i]->GetSize(), hash);
+	}
+	hash = HashCookOptions(options, hash);
+
+	if(LoadCachedTexture(cacheDirectory, hash, data))
+		return true;
+
+	Image decoded[3];
+	for(int i = 0; i < 3; i++)
+	{
+		if(sources[i] && !DecodePng((const uint8_t*) sources[i]->GetData(), sources[i]->GetSize(), decoded[i]))
+			return false;
+	}
+
+	std::vector<Image> mips(1);
+	if(!PackOrm(sources[0] ? &decoded[0] : nullptr, sources[1] ? &decoded[1] : nullptr, sources[2] ? &decoded[2] : nullptr, mips[0]))
+		return false;
+
+	CookTexture(mips, cacheDirectory, hash, options, data);
+	return true;
+}
+
+bool LoadCubemapData(const std::vector<std::wstring>& facePaths, const std::filesystem::path& cacheDirectory, TextureData& data)
+{
+	if(facePaths.size() != 6)
+		return false;
+
+	std::string name = std::filesystem::path(facePaths[0]).parent_path().filename().string();
+
+	// Every face (in order) goes into the hash
+	std::unique_ptr<MappedFile> sources[6];
+	uint64_t hash = HashBytes("cube", 4, CookedTexture::Version);
+	for(int face = 0; face < 6; face++)
+	{
+		sources[face] = std::make_unique<MappedFile>(facePaths[face].c_str());
+		if(!sources[face]->IsOpen())
+			return false;
+		hash = HashBytes(sources[face]->GetData(), sources[face]->GetSize(), hash);
+	}
+
+	if(LoadCachedTexture(cacheDirectory, hash, data))
+		return true;
+
+	// Decode the faces in parallel, and make sure they can actually form a cube
+	std::vector<Image> faces(6);
+	bool decoded[6] = {};
+	ThreadPool::Global().ParallelFor(6, 1, [&](size_t begin, size_t end)
+	{
+		for(size_t face = begin; face < end; face++)
+			decoded[face] = DecodePng((const uint8_t*) sources[face]->GetData(), sources[face]->GetSize(), faces[face]);
+	});
+	for(int face = 0; face < 6; face++)
+	{
+		if(!decoded[face] || faces[face].width != faces[face].height ||
+			faces[face].width != faces[0].width || faces[face].channels != faces[0].channels)
+		{
+			printf("Can't make a cube map out of %s: faces must decode to squares of the same size\n", name.c_str());
+			return false;
+		}
+	}
+
+	// Sky faces are color, so gamma encoded like any other color texture
+	std::vector<Image> mips;
+	PrefilterCubemap(faces, true, mips);
+
+	float irradianceSH[9][3];
+	ProjectIrradianceSH(faces, true, irradianceSH);
+
+	data.SetMips(std::move(mips), 6);
+	memcpy(data.irradianceSH, irradianceSH, sizeof(irradianceSH));
+
+	CookedTextureHeader header = {};
+	header.contentHash = hash;
+	header.format = (uint32_t) BlockFormat::None;
+	memcpy(header.irradianceSH, irradianceSH, sizeof(irradianceSH));
+	WriteCookedTexture(cacheDirectory, header, data);
+	return true;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Image.h"
+#include "MipGenerator.h"
+#include "BlockCompression.h"
+#include "CookedTexture.h"
+
+// --------------------------------------------------------
+// A texture's mip chain in CPU memory, ready to upload
+// - The pixels either point into a memory mapped cache file
+//   or into mips this object owns
+// - Mip i is max(1, width >> i) x max(1, height >> i), with
+//   rows packed tightly (see GetRowPitch)
+// - Cube maps have 6 faces, each with its own mip chain, in
+//   mipPixels face-major (mipPixels[face * mipCount + mip])
+// --------------------------------------------------------
+struct TextureData
+{
+	unsigned int width;
+	unsigned int height;
+	unsigned int channels;	// Of the source image (1 or 4), even when compressed
+	bool isSRGB;
+	BlockFormat format;		// None for plain 8-bit texels
+	unsigned int faceCount;	// 1, or 6 for a cube map
+	std::vector<const uint8_t*> mipPixels;
+	float irradianceSH[9][3];	// Cube maps only: diffuse irradiance (see CubemapCooker)
+
+	std::vector<Image> ownedMips;					// Backing for mipPixels when they were made in memory
+	std::vector<std::vector<uint8_t>> ownedBlocks;	// Same, for compressed mips
+	std::unique_ptr<CookedTexture> cooked;			// Backing for mipPixels when they were mapped from the cache
+
+	// Takes ownership of a mip chain (mips[0] being the full image), or faceCount of them face-major
+	void SetMips(std::vector<Image>&& mips, unsigned int faceCount = 1);
+	// Takes ownership of a compressed mip chain, made from (and the same size as) the given mips
+	void SetCompressedMips(const std::vector<Image>& sourceMips, BlockFormat blockFormat, std::vector<std::vector<uint8_t>>&& blocks);
+
+	unsigned int GetMipCount() const { return (unsigned int) mipPixels.size() / faceCount; };
+	unsigned int GetRowPitch(unsigned int mip) const;
+	size_t GetMipSize(unsigned int mip) const;
+
+	// Bytes for the whole mip chain (of every face) as stored, and as it would be with plain 8-bit texels
+	size_t GetByteSize() const;
+	size_t GetUncompressedByteSize() const;
+};
+
+// How a texture should be cooked
+// - Block compression is skipped (falling back to plain texels) when the texture isn't a whole
+//   number of blocks, and BC1 becomes BC3 when the texture has any transparency
+struct TextureCookOptions
+{
+	bool generateMips;
+	MipOptions mipOptions;
+	BlockFormat format;
+};
+
+// Loads a .PNG and (optionally) its full mip chain, going through the texture cache
+// - The cache is keyed by a hash of the file's contents and the options, so a hit only
+//   costs reading the source once to hash it; a miss decodes it, generates its mips,
+//   compresses them and writes them to the cache for next time
+// - An empty cacheDirectory skips the cache entirely
+// - Touches no graphics API state, so it's safe to call from any thread
+bool LoadTextureData(const wchar_t* filePath, const std::filesystem::path& cacheDirectory, const TextureCookOptions& options, TextureData& data);
+
+// Loads separate occlusion, roughness and metalness maps (any of which can be null) packed into one
+// texture (see OrmPacker), going through the texture cache like LoadTextureData
+bool LoadOrmTextureData(const wchar_t* occlusionPath, const wchar_t* roughnessPath, const wchar_t* metalnessPath,
+	const std::filesystem::path& cacheDirectory, const TextureCookOptions& options, TextureData& data);
+
+// Loads six sky faces (+X, -X, +Y, -Y, +Z, -Z) as a cube map ready for image based lighting, going
+// through the texture cache like LoadTextureData
+// - Lower mips are prefiltered for specular reflections and irradianceSH is filled in for diffuse
+//   lighting (see CubemapCooker); both are slow to make, so caching them matters far more here
+bool LoadCubemapData(const std::vector<std::wstring>& facePaths, const std::filesystem::path& cacheDirectory, TextureData& data);
@@ -0,0 +1,128 @@
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(unsigned int threadCount) :
+	isShuttingDown(false)
+{
+	for(unsigned int i = 0; i < threadCount; i++)
+		workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+ThreadPool::~ThreadPool()
+{
+	// Let the workers finish whatever is already queued, then join them
+	{
+		std::lock_guard<std::mutex> lock(taskMutex);
+		isShuttingDown = true;
+	}
+	taskAvailable.notify_all();
+
+	for(std::thread& worker : workers)
+		worker.join();
+}
+
+ThreadPool& ThreadPool::Global()
+{
+	static ThreadPool pool(std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 1);
+	return pool;
+}
+
+void ThreadPool::WorkerLoop()
+{
+	while(true)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(taskMutex);
+			taskAvailable.wait(lock, [this] { return isShuttingDown || !tasks.empty(); });
+
+			if(tasks.empty())
+				return; // Shutting down with nothing left to do
+
+			task = std::move(tasks.front());
+			tasks.pop();
+		}
+
+		task();
+	}
+}
+
+std::future<void> ThreadPool::Submit(std::function<void()> task)
+{
+	// Packaged tasks are move-only, so share ownership to fit in a std::function
+	auto packagedTask = std::make_shared<std::packaged_task<void()>>(std::move(task));
+	std::future<void> result = packagedTask->get_future();
+	{
+		std::lock_guard<std::mutex> lock(taskMutex);
+		tasks.push([packagedTask] { (*packagedTask)(); });
+	}
+	taskAvailable.notify_one();
+
+	return result;
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t minChunkSize, const std::function<void(size_t begin, size_t end)>& body)
+{
+	if(count == 0)
+		return;
+
+	// A few chunks per thread keeps everyone busy even if some chunks are slower than others
+	size_t threadCount = workers.size() + 1;
+	size_t chunkSize = (count + threadCount * 4 - 1) / (threadCount * 4);
+	if(chunkSize < minChunkSize)
+		chunkSize = minChunkSize;
+	size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+
+	// Not worth handing out to other threads
+	if(chunkCount == 1)
+	{
+		body(0, count);
+		return;
+	}
+
+	// Shared between every participating thread; helpers that start after all
+	// the work is claimed still touch it, so it has to outlive this call
+	struct ParallelForState
+	{
+		std::atomic<size_t> nextChunk = 0;
+		std::atomic<size_t> chunksDone = 0;
+		std::mutex doneMutex;
+		std::condition_variable allDone;
+	};
+	auto state = std::make_shared<ParallelForState>();
+
+	// Claims and runs chunks until there are none left
+	auto runChunks = [state, count, chunkSize, chunkCount, &body]
+	{
+		size_t chunk;
+		while((chunk = state->nextChunk.fetch_add(1)) < chunkCount)
+		{
+			size_t begin = chunk * chunkSize;
+			size_t end = begin + chunkSize < count ? begin + chunkSize : count;
+			body(begin, end);
+
+			if(state->chunksDone.fetch_add(1) + 1 == chunkCount)
+			{
+				std::lock_guard<std::mutex> lock(state->doneMutex);
+				state->allDone.notify_all();
+			}
+		}
+	};
+
+	// Helpers only ever reference "body" while claiming a chunk, which
+	// can't happen after the last chunk is done (and this call returns)
+	size_t helperCount = chunkCount - 1 < workers.size() ? chunkCount - 1 : workers.size();
+	{
+		std::lock_guard<std::mutex> lock(taskMutex);
+		for(size_t i = 0; i < helperCount; i++)
+			tasks.push(runChunks);
+	}
+	taskAvailable.notify_all();
+
+	// Pitch in on this thread, then wait for any chunks still running elsewhere
+	runChunks();
+
+	std::unique_lock<std::mutex> lock(state->doneMutex);
+	state->allDone.wait(lock, [&state, chunkCount] { return state->chunksDone.load() == chunkCount; });
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// --------------------------------------------------------
+// Fixed set of worker threads that run queued tasks
+// - Submit() queues a single task and returns a future for it
+// - ParallelFor() splits a range into chunks that the workers
+//   AND the calling thread chew through, blocking until done
+//   (safe to call from inside a task, since the caller never
+//   just sits waiting on work nobody has picked up)
+// --------------------------------------------------------
+class ThreadPool
+{
+private:
+	std::vector<std::thread> workers;
+	std::queue<std::function<void()>> tasks;
+	std::mutex taskMutex;
+	std::condition_variable taskAvailable;
+	bool isShuttingDown;
+
+	void WorkerLoop();
+
+public:
+	ThreadPool(unsigned int threadCount);
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete; // Remove copy constructor
+	ThreadPool& operator=(const ThreadPool&) = delete; // Remove copy-assignment operator
+
+	// Shared pool with one worker per hardware thread (minus the calling thread)
+	static ThreadPool& Global();
+
+	std::future<void> Submit(std::function<void()> task);
+
+	// Calls body(begin, end) over [0, count) in chunks of at least minChunkSize
+	void ParallelFor(size_t count, size_t minChunkSize, const std::function<void(size_t begin, size_t end)>& body);
+
+	unsigned int GetThreadCount() const { return (unsigned int) workers.size(); };
+};
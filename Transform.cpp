@@ -2,28 +2,38 @@
 
 using namespace DirectX;
 
-Transform::Transform() : 
-	location(0, 0, 0),
-	rotation(0, 0, 0),
-	scale(1, 1, 1),
-	isWorldMatrixDirty(false)
+Transform::Transform() :
+	handle(TransformSystem::Global().Create(XMFLOAT3(0, 0, 0), XMFLOAT3(0, 0, 0), XMFLOAT3(1, 1, 1)))
 {
-	XMStoreFloat4x4(&worldMatrix, XMMatrixIdentity());
-	XMStoreFloat4x4(&worldInverseTransposeMatrix, XMMatrixIdentity());
 }
 Transform::Transform(XMFLOAT3 location, XMFLOAT3 rotation, XMFLOAT3 scale) : 
-	location(location), 
-	rotation(rotation), 
-	scale(scale),
-	isWorldMatrixDirty(true) // Matrices aren't calculated yet
+	handle(TransformSystem::Global().Create(location, rotation, scale)) // Matrices are calculated by the next batch or when first asked for
 {
-	// Default matrices; will be calculated the first time GetWorldMatrix() or GetWorldInverseTransposeMatrix() are called
-	XMStoreFloat4x4(&worldMatrix, XMMatrixIdentity());
-	XMStoreFloat4x4(&worldInverseTransposeMatrix, XMMatrixIdentity());
+}
+Transform::Transform(const Transform& other)
+{
+	TransformSystem& system = TransformSystem::Global();
+	handle = system.Create(system.GetLocation(other.handle), XMFLOAT3(0, 0, 0), system.GetScale(other.handle));
+	system.CopyRotation(handle, other.handle);
+	system.SetParent(handle, system.GetParent(other.handle));
+}
+Transform& Transform::operator=(const Transform& other)
+{
+	TransformSystem& system = TransformSystem::Global();
+	system.SetLocation(handle, system.GetLocation(other.handle));
+	system.CopyRotation(handle, other.handle);
+	system.SetScale(handle, system.GetScale(other.handle));
+	system.SetParent(handle, system.GetParent(other.handle));
+	return *this;
+}
+Transform::~Transform()
+{
+	TransformSystem::Global().Destroy(handle);
 }
 
 void Transform::MoveAbsolute(float x, float y, float z)
 {
+	XMFLOAT3 location = GetLocation();
 	SetLocation(location.x + x, location.y + y, location.z + z);
 }
 void Transform::MoveAbsolute(DirectX::XMFLOAT3 offset)
@@ -38,11 +48,14 @@ void Transform::MoveRelative(float x, float y, float z)
 }
 void Transform::MoveRelative(DirectX::XMFLOAT3 offset)
 {
-	// Get the absolute offset by rotating relative offset by this transform's rotation
-	XMVECTOR relOffset = XMLoadFloat3(&offset);
-	XMVECTOR rot = XMQuaternionRotationRollPitchYaw(rotation.x, rotation.y, rotation.z);
-	XMVECTOR absOffset = XMVector3Rotate(relOffset, rot);
+	// Get the absolute offset by rotating relative offset by this transform's rotation (i.e. along its axes)
+	TransformSystem& system = TransformSystem::Global();
+	XMFLOAT3 right = system.GetRight(handle);
+	XMFLOAT3 up = system.GetUp(handle);
+	XMFLOAT3 forward = system.GetForward(handle);
+	XMVECTOR absOffset = XMLoadFloat3(&right) * offset.x + XMLoadFloat3(&up) * offset.y + XMLoadFloat3(&forward) * offset.z;
 
+	XMFLOAT3 location = GetLocation();
 	XMVECTOR currentLocation = XMLoadFloat3(&location);
 
 	// Add absolute offset to current location
@@ -52,6 +65,7 @@ void Transform::MoveRelative(DirectX::XMFLOAT3 offset)
 }
 void Transform::Rotate(float pitch, float yaw, float roll)
 {
+	XMFLOAT3 rotation = GetPitchYawRoll();
 	SetRotation(rotation.x + pitch, rotation.y + yaw, rotation.z + roll);
 }
 void Transform::Rotate(DirectX::XMFLOAT3 pitchYawRoll)
@@ -60,6 +74,7 @@ void Transform::Rotate(DirectX::XMFLOAT3 pitchYawRoll)
 }
 void Transform::Scale(float x, float y, float z)
 {
+	XMFLOAT3 scale = GetScale();
 	SetScale(scale.x * x, scale.y * y, scale.z * z);
 }
 void Transform::Scale(DirectX::XMFLOAT3 scale)
@@ -68,103 +83,38 @@ void Transform::Scale(DirectX::XMFLOAT3 scale)
 }
 
 #pragma region Getters
-XMFLOAT3 Transform::GetLocation() { return location; }
-XMFLOAT3 Transform::GetPitchYawRoll() { return rotation; }
-XMFLOAT3 Transform::GetScale() { return scale; }
-XMFLOAT3 Transform::GetRight()
-{
-	// Rotate the world right vector by this transform's rotation
-	XMFLOAT3 worldRight = XMFLOAT3(1, 0, 0);
-
-	XMFLOAT3 right;
-	XMVECTOR rot = XMQuaternionRotationRollPitchYaw(rotation.x, rotation.y, rotation.z);
-
-	XMStoreFloat3(&right, XMVector3Rotate(XMLoadFloat3(&worldRight), rot));
-	return right;
-}
-XMFLOAT3 Transform::GetUp()
-{
-	// Rotate the world up vector by this transform's rotation
-	XMFLOAT3 worldUp = XMFLOAT3(0, 1, 0);
-
-	XMFLOAT3 up;
-	XMVECTOR rot = XMQuaternionRotationRollPitchYaw(rotation.x, rotation.y, rotation.z);
-
-	XMStoreFloat3(&up, XMVector3Rotate(XMLoadFloat3(&worldUp), rot));
-	return up;
-}
-XMFLOAT3 Transform::GetForward()
-{
-	// Rotate the world forward vector by this transform's rotation
-	XMFLOAT3 worldForward = XMFLOAT3(0, 0, 1);
-
-	XMFLOAT3 forward;
-	XMVECTOR rot = XMQuaternionRotationRollPitchYaw(rotation.x, rotation.y, rotation.z);
-
-	XMStoreFloat3(&forward, XMVector3Rotate(XMLoadFloat3(&worldForward), rot));
-	return forward;
-}
-XMFLOAT4X4 Transform::GetWorldMatrix()
-{
-	if(isWorldMatrixDirty)
-	{
-		XMVECTOR translationVector = XMLoadFloat3(&location);
-		XMVECTOR rotationVector = XMLoadFloat3(&rotation);
-		XMVECTOR scaleVector = XMLoadFloat3(&scale);
-
-		XMMATRIX translation = XMMatrixTranslationFromVector(translationVector);
-		XMMATRIX rotation = XMMatrixRotationRollPitchYawFromVector(rotationVector);
-		XMMATRIX scale = XMMatrixScalingFromVector(scaleVector);
-
-		XMMATRIX world = scale * rotation * translation;
-
-		XMStoreFloat4x4(&worldMatrix, world);
-		XMStoreFloat4x4(&worldInverseMatrix, XMMatrixInverse(0, world));
-		XMStoreFloat4x4(&worldInverseTransposeMatrix, XMMatrixInverse(0, XMMatrixTranspose(world)));
-
-		isWorldMatrixDirty = false;
-	}
-
-	return worldMatrix;
-}
-XMFLOAT4X4 Transform::GetWorldInverseMatrix()
-{
-	// Make sure the matrices are up-to-date
-	if(isWorldMatrixDirty)
-		GetWorldMatrix();
-
-	return worldInverseMatrix;
-}
-XMFLOAT4X4 Transform::GetWorldInverseTransposeMatrix()
-{
-	// Make sure the matrices are up-to-date
-	if(isWorldMatrixDirty)
-		GetWorldMatrix();
-
-	return worldInverseTransposeMatrix;
-}
+XMFLOAT3 Transform::GetLocation() { return TransformSystem::Global().GetLocation(handle); }
+XMFLOAT3 Transform::GetPitchYawRoll() { return TransformSystem::Global().GetRotation(handle); }
+XMFLOAT4 Transform::GetRotation() { return TransformSystem::Global().GetRotationQuaternion(handle); }
+XMFLOAT3 Transform::GetScale() { return TransformSystem::Global().GetScale(handle); }
+// The world axes turned by this transform's rotation (worked out whenever it changes)
+XMFLOAT3 Transform::GetRight() { return TransformSystem::Global().GetRight(handle); }
+XMFLOAT3 Transform::GetUp() { return TransformSystem::Global().GetUp(handle); }
+XMFLOAT3 Transform::GetForward() { return TransformSystem::Global().GetForward(handle); }
+XMFLOAT4X4 Transform::GetWorldMatrix() { return TransformSystem::Global().GetWorldMatrix(handle); }
+XMFLOAT4X4 Transform::GetWorldInverseMatrix() { return TransformSystem::Global().GetWorldInverseMatrix(handle); }
+XMFLOAT4X4 Transform::GetWorldInverseTransposeMatrix() { return TransformSystem::Global().GetWorldInverseTransposeMatrix(handle); }
+XMFLOAT3 Transform::GetWorldLocation()
+{
+	// The world matrix's translation row
+	const XMFLOAT4X4& world = TransformSystem::Global().GetWorldMatrix(handle);
+	return XMFLOAT3(world.m[3][0], world.m[3][1], world.m[3][2]);
+}
+bool Transform::HasParent() { return TransformSystem::Global().GetParent(handle) != TransformSystem::InvalidHandle; }
 #pragma endregion
 
 #pragma region Setters
 void Transform::SetLocation(float x, float y, float z) { SetLocation(XMFLOAT3(x, y, z)); }
-void Transform::SetLocation(XMFLOAT3 location)
-{
-	this->location = location;
-
-	isWorldMatrixDirty = true;
-}
+void Transform::SetLocation(XMFLOAT3 location) { TransformSystem::Global().SetLocation(handle, location); }
 void Transform::SetRotation(float pitch, float yaw, float roll) { SetRotation(XMFLOAT3(pitch, yaw, roll)); }
-void Transform::SetRotation(XMFLOAT3 rotation)
-{
-	this->rotation = rotation;
-
-	isWorldMatrixDirty = true;
-}
+void Transform::SetRotation(XMFLOAT3 rotation) { TransformSystem::Global().SetRotation(handle, rotation); }
+void Transform::SetRotation(XMFLOAT4 quaternion) { TransformSystem::Global().SetRotationQuaternion(handle, quaternion); }
 void Transform::SetScale(float x, float y, float z) { SetScale(XMFLOAT3(x, y, z)); }
-void Transform::SetScale(XMFLOAT3 scale)
+void Transform::SetScale(XMFLOAT3 scale) { TransformSystem::Global().SetScale(handle, scale); }
+bool Transform::SetParent(Transform* parent)
 {
-	this->scale = scale;
-
-	isWorldMatrixDirty = true;
+	if(parent == this)
+		return false;
+	return TransformSystem::Global().SetParent(handle, parent ? parent->handle : TransformSystem::InvalidHandle);
 }
 #pragma endregion
\ No newline at end of file
@@ -2,23 +2,34 @@
 
 #include <DirectXMath.h>
 
+#include "TransformSystem.h"
+
+// --------------------------------------------------------
+// A location, rotation and scale, and the world matrices
+// they make
+// - The data itself lives in the global TransformSystem, so
+//   every transform's matrices can be rebuilt in one batch;
+//   this is a handle to it that still behaves like a value
+//   (copies get their own data)
+// - Matrices of a transform changed since the last batch are
+//   rebuilt on their own when asked for
+// - With a parent, location, rotation and scale are relative
+//   to it, and the world matrices include the parent's
+// - Rotation is a quaternion; pitch/yaw/roll are there for
+//   editing, and turning them into the quaternion (and the
+//   right/up/forward vectors) happens once per change
+// --------------------------------------------------------
 class Transform
 {
 private:
-	DirectX::XMFLOAT3 location;
-	DirectX::XMFLOAT3 rotation;
-	DirectX::XMFLOAT3 scale;
-
-	DirectX::XMFLOAT4X4 worldMatrix;
-	DirectX::XMFLOAT4X4 worldInverseMatrix;
-	DirectX::XMFLOAT4X4 worldInverseTransposeMatrix;
-
-	// Flag for if the stored world matrix needs to be updated to reflect transformations
-	bool isWorldMatrixDirty;
+	TransformSystem::Handle handle;
 
 public:
 	Transform();
 	Transform(DirectX::XMFLOAT3 location, DirectX::XMFLOAT3 rotation, DirectX::XMFLOAT3 scale);
+	Transform(const Transform& other);
+	Transform& operator=(const Transform& other);
+	~Transform();
 
 	void MoveAbsolute(float x, float y, float z);
 	void MoveAbsolute(DirectX::XMFLOAT3 offset);
@@ -31,6 +42,7 @@ public:
 
 	DirectX::XMFLOAT3 GetLocation();
 	DirectX::XMFLOAT3 GetPitchYawRoll();
+	DirectX::XMFLOAT4 GetRotation();
 	DirectX::XMFLOAT3 GetScale();
 	DirectX::XMFLOAT3 GetRight();
 	DirectX::XMFLOAT3 GetUp();
@@ -38,11 +50,16 @@ public:
 	DirectX::XMFLOAT4X4 GetWorldMatrix();
 	DirectX::XMFLOAT4X4 GetWorldInverseMatrix();
 	DirectX::XMFLOAT4X4 GetWorldInverseTransposeMatrix();
+	DirectX::XMFLOAT3 GetWorldLocation();
+	bool HasParent();
 
 	void SetLocation(float x, float y, float z);
 	void SetLocation(DirectX::XMFLOAT3 location);
 	void SetRotation(float pitch, float yaw, float roll);
 	void SetRotation(DirectX::XMFLOAT3 rotation);
+	void SetRotation(DirectX::XMFLOAT4 quaternion);
 	void SetScale(float x, float y, float z);
 	void SetScale(DirectX::XMFLOAT3 scale);
+	// Null detaches it; returns false (changing nothing) if parent is this or one of its children
+	bool SetParent(Transform* parent);
 };
\ No newline at end of file
@@ -0,0 +1,583 @@
+#include "TransformSystem.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+	const uint32_t InvalidSlot = UINT32_MAX;
+	const size_t ParallelGroupChunk = 1024; // Groups of four per task; small batches aren't worth splitting
+
+	uint32_t RoundUpToGroup(uint32_t count)
+	{
+		return (count + 3) & ~3u;
+	}
+
+	// --------------------------------------------------------
+	// Pitch, yaw and roll that XMQuaternionRotationRollPitchYaw
+	// would turn back into the given rotation matrix (roll,
+	// then pitch, then yaw); looking straight up or down, all
+	// of the turn about the up axis is put in yaw
+	// --------------------------------------------------------
+	XMFLOAT3 PitchYawRollFromMatrix(const XMFLOAT4X4& rotation)
+	{
+		float sinPitch = -rotation.m[2][1];
+		sinPitch = sinPitch > 1.0f ? 1.0f : (sinPitch < -1.0f ? -1.0f : sinPitch);
+		float pitch = std::asin(sinPitch);
+		if(std::fabs(sinPitch) > 0.99999f)
+			return XMFLOAT3(pitch, std::atan2(-rotation.m[0][2], rotation.m[0][0]), 0.0f);
+		return XMFLOAT3(pitch, std::atan2(rotation.m[2][0], rotation.m[2][2]), std::atan2(rotation.m[0][1], rotation.m[1][1]));
+	}
+
+	// Writes one row of four matrices, given that row's four columns across the four lanes
+	void StoreRows(XMFLOAT4X4* matrices, int row, FXMVECTOR c0, FXMVECTOR c1, FXMVECTOR c2, GXMVECTOR c3)
+	{
+		XMMATRIX lanes = XMMatrixTranspose(XMMATRIX(c0, c1, c2, c3));
+		for(int lane = 0; lane < 4; lane++)
+			XMStoreFloat4((XMFLOAT4*) matrices[lane].m[row], lanes.r[lane]);
+	}
+}
+
+XMMATRIX InverseTRS(FXMMATRIX rotation, FXMVECTOR translation, FXMVECTOR scale)
+{
+	XMMATRIX inverse = XMMatrixTranspose(rotation);
+	XMVECTOR inverseScale = XMVectorReciprocal(scale);
+	for(int row = 0; row < 3; row++)
+		inverse.r[row] = XMVectorSetW(inverse.r[row] * inverseScale, 0.0f);
+	inverse.r[3] = XMVectorSetW(-XMVector3TransformNormal(translation, inverse), 1.0f);
+	return inverse;
+}
+
+TransformSystem::TransformSystem() :
+	count(0), isOrderDirty(false)
+{
+}
+
+TransformSystem& TransformSystem::Global()
+{
+	static TransformSystem system;
+	return system;
+}
+
+void TransformSystem::ResizeSlots(uint32_t newCount)
+{
+	uint32_t oldSize = (uint32_t) isDirty.size();
+	uint32_t newSize = RoundUpToGroup(newCount);
+	count = newCount;
+	if(newSize == oldSize)
+		return;
+
+	for(std::vector<float>* component : { &locationX, &locationY, &locationZ, &rotationX, &rotationY, &rotationZ, &pitch, &yaw, &roll })
+		component->resize(newSize, 0.0f);
+	for(std::vector<float>* component : { &rotationW, &scaleX, &scaleY, &scaleZ })
+		component->resize(newSize, 1.0f);
+	rights.resize(newSize, XMFLOAT3(1, 0, 0));
+	ups.resize(newSize, XMFLOAT3(0, 1, 0));
+	forwards.resize(newSize, XMFLOAT3(0, 0, 1));
+	parentHandles.resize(newSize, InvalidHandle);
+
+	XMFLOAT4X4 identity;
+	XMStoreFloat4x4(&identity, XMMatrixIdentity());
+	for(std::vector<XMFLOAT4X4>* matrices : { &localMatrices, &localInverseMatrices, &worldMatrices, &worldInverseMatrices, &worldInverseTransposeMatrices })
+		matrices->resize(newSize, identity);
+	isDirty.resize(newSize, 0);
+	isInverseTransposeStale.resize(newSize, 0);
+	worldVersions.resize(newSize, 0);
+	parentVersions.resize(newSize, 0);
+	slotHandles.resize(newSize, 0);
+}
+
+void TransformSystem::ResetSlot(uint32_t slot)
+{
+	// Padding is an identity that never needs rebuilding
+	locationX[slot] = locationY[slot] = locationZ[slot] = 0.0f;
+	rotationX[slot] = rotationY[slot] = rotationZ[slot] = 0.0f;
+	rotationW[slot] = 1.0f;
+	pitch[slot] = yaw[slot] = roll[slot] = 0.0f;
+	scaleX[slot] = scaleY[slot] = scaleZ[slot] = 1.0f;
+	parentHandles[slot] = InvalidHandle;
+	isDirty[slot] = 0;
+}
+
+void TransformSystem::MoveSlot(uint32_t from, uint32_t to)
+{
+	locationX[to] = locationX[from];
+	locationY[to] = locationY[from];
+	locationZ[to] = locationZ[from];
+	rotationX[to] = rotationX[from];
+	rotationY[to] = rotationY[from];
+	rotationZ[to] = rotationZ[from];
+	rotationW[to] = rotationW[from];
+	pitch[to] = pitch[from];
+	yaw[to] = yaw[from];
+	roll[to] = roll[from];
+	rights[to] = rights[from];
+	ups[to] = ups[from];
+	forwards[to] = forwards[from];
+	scaleX[to] = scaleX[from];
+	scaleY[to] = scaleY[from];
+	scaleZ[to] = scaleZ[from];
+	parentHandles[to] = parentHandles[from];
+	localMatrices[to] = localMatrices[from];
+	localInverseMatrices[to] = localInverseMatrices[from];
+	worldMatrices[to] = worldMatrices[from];
+	worldInverseMatrices[to] = worldInverseMatrices[from];
+	worldInverseTransposeMatrices[to] = worldInverseTransposeMatrices[from];
+	isDirty[to] = isDirty[from];
+	isInverseTransposeStale[to] = isInverseTransposeStale[from];
+	worldVersions[to] = worldVersions[from];
+	parentVersions[to] = parentVersions[from];
+	slotHandles[to] = slotHandles[from];
+	handleSlots[slotHandles[to]] = to;
+}
+
+// --------------------------------------------------------
+// Reorders the slots by depth in the hierarchy (roots first,
+// otherwise keeping their order), so parents come before
+// their children again
+// --------------------------------------------------------
+void TransformSystem::SortByDepth()
+{
+	// Work out each slot's depth, walking up only as far as the first ancestor already known
+	std::vector<uint32_t> depths(count, UINT32_MAX);
+	std::vector<uint32_t> chain;
+	for(uint32_t slot = 0; slot < count; slot++)
+	{
+		uint32_t current = slot;
+		while(current != InvalidSlot && depths[current] == UINT32_MAX)
+		{
+			chain.push_back(current);
+			current = GetParentSlot(current);
+		}
+
+		uint32_t depth = current == InvalidSlot ? 0 : depths[current] + 1;
+		for(size_t i = chain.size(); i-- > 0; depth++)
+			depths[chain[i]] = depth;
+		chain.clear();
+	}
+
+	// Counting sort, since depths are small
+	uint32_t maxDepth = 0;
+	for(uint32_t depth : depths)
+		maxDepth = depth > maxDepth ? depth : maxDepth;
+	std::vector<uint32_t> depthStarts(maxDepth + 2, 0);
+	for(uint32_t depth : depths)
+		depthStarts[depth + 1]++;
+	for(size_t depth = 1; depth < depthStarts.size(); depth++)
+		depthStarts[depth] += depthStarts[depth - 1];
+	std::vector<uint32_t> order(count);
+	for(uint32_t slot = 0; slot < count; slot++)
+		order[depthStarts[depths[slot]]++] = slot;
+
+	// Gather every array into its new order (padding stays where it is)
+	auto permute = [&](auto& values)
+	{
+		auto sorted = values;
+		for(uint32_t slot = 0; slot < count; slot++)
+			sorted[slot] = values[order[slot]];
+		values.swap(sorted);
+	};
+	for(std::vector<float>* component : { &locationX, &locationY, &locationZ, &rotationX, &rotationY, &rotationZ, &rotationW,
+		&pitch, &yaw, &roll, &scaleX, &scaleY, &scaleZ })
+		permute(*component);
+	for(std::vector<XMFLOAT3>* vectors : { &rights, &ups, &forwards })
+		permute(*vectors);
+	for(std::vector<XMFLOAT4X4>* matrices : { &localMatrices, &localInverseMatrices, &worldMatrices, &worldInverseMatrices, &worldInverseTransposeMatrices })
+		permute(*matrices);
+	permute(parentHandles);
+	permute(isDirty);
+	permute(isInverseTransposeStale);
+	permute(worldVersions);
+	permute(parentVersions);
+	permute(slotHandles);
+	for(uint32_t slot = 0; slot < count; slot++)
+		handleSlots[slotHandles[slot]] = slot;
+
+	isOrderDirty = false;
+}
+
+uint32_t TransformSystem::GetParentSlot(uint32_t slot)
+{
+	Handle parent = parentHandles[slot];
+	return parent == InvalidHandle ? InvalidSlot : handleSlots[parent];
+}
+
+bool TransformSystem::IsStale(uint32_t slot)
+{
+	uint32_t parentSlot = GetParentSlot(slot);
+	return isDirty[slot] || (parentSlot != InvalidSlot && parentVersions[slot] != worldVersions[parentSlot]);
+}
+
+// Sets a slot's (normalized) rotation, and the directions it turns right, up and forward into
+void TransformSystem::StoreRotation(uint32_t slot, FXMVECTOR quaternion)
+{
+	XMFLOAT4 rotation;
+	XMStoreFloat4(&rotation, quaternion);
+	rotationX[slot] = rotation.x;
+	rotationY[slot] = rotation.y;
+	rotationZ[slot] = rotation.z;
+	rotationW[slot] = rotation.w;
+
+	// The rows of the rotation matrix are where each axis ends up
+	XMMATRIX matrix = XMMatrixRotationQuaternion(quaternion);
+	XMStoreFloat3(&rights[slot], matrix.r[0]);
+	XMStoreFloat3(&ups[slot], matrix.r[1]);
+	XMStoreFloat3(&forwards[slot], matrix.r[2]);
+	isDirty[slot] = 1;
+}
+
+TransformSystem::Handle TransformSystem::Create(XMFLOAT3 location, XMFLOAT3 rotation, XMFLOAT3 scale)
+{
+	Handle handle;
+	if(!freeHandles.empty())
+	{
+		handle = freeHandles.back();
+		freeHandles.pop_back();
+	}
+	else
+	{
+		handle = (Handle) handleSlots.size();
+		handleSlots.push_back(InvalidSlot);
+		childCounts.push_back(0);
+	}
+
+	uint32_t slot = count;
+	ResizeSlots(count + 1);
+	handleSlots[handle] = slot;
+	slotHandles[slot] = handle;
+
+	locationX[slot] = location.x;
+	locationY[slot] = location.y;
+	locationZ[slot] = location.z;
+	pitch[slot] = rotation.x;
+	yaw[slot] = rotation.y;
+	roll[slot] = rotation.z;
+	StoreRotation(slot, XMQuaternionRotationRollPitchYaw(rotation.x, rotation.y, rotation.z));
+	scaleX[slot] = scale.x;
+	scaleY[slot] = scale.y;
+	scaleZ[slot] = scale.z;
+	parentHandles[slot] = InvalidHandle;
+	isDirty[slot] = 1; // Matrices aren't calculated yet
+	return handle;
+}
+
+void TransformSystem::Destroy(Handle handle)
+{
+	uint32_t slot = handleSlots[handle];
+	uint32_t last = count - 1;
+
+	// Children are left where they are, relative to the world instead
+	if(childCounts[handle] > 0)
+	{
+		for(uint32_t child = 0; child < count; child++)
+		{
+			if(parentHandles[child] == handle)
+			{
+				parentHandles[child] = InvalidHandle;
+				isDirty[child] = 1;
+			}
+		}
+		childCounts[handle] = 0;
+	}
+	if(parentHandles[slot] != InvalidHandle)
+		childCounts[parentHandles[slot]]--;
+
+	// Keep the slots packed by moving the last one into the gap
+	if(slot != last)
+	{
+		MoveSlot(last, slot);
+		uint32_t parentSlot = GetParentSlot(slot);
+		if(parentSlot != InvalidSlot && parentSlot > slot)
+			isOrderDirty = true;
+	}
+	ResetSlot(last);
+
+	handleSlots[handle] = InvalidSlot;
+	freeHandles.push_back(handle);
+	ResizeSlots(last);
+}
+
+bool TransformSystem::SetParent(Handle handle, Handle parent)
+{
+	// Refuse to make a loop
+	for(Handle ancestor = parent; ancestor != InvalidHandle; ancestor = GetParent(ancestor))
+	{
+		if(ancestor == handle)
+			return false;
+	}
+
+	uint32_t slot = handleSlots[handle];
+	if(parentHandles[slot] != InvalidHandle)
+		childCounts[parentHandles[slot]]--;
+	parentHandles[slot] = parent;
+	isDirty[slot] = 1;
+	if(parent == InvalidHandle)
+		return true;
+
+	childCounts[parent]++;
+	if(handleSlots[parent] > slot)
+		isOrderDirty = true;
+	return true;
+}
+
+// --------------------------------------------------------
+// Builds the local matrices of the four slots starting at
+// firstSlot, one SIMD lane per transform
+// - Same result as XMMatrixScaling * XMMatrixRotationQuaternion
+//   * XMMatrixTranslation, with the inverse written down
+//   directly (a TRS matrix inverts to S^-1 * R^T * T^-1)
+//   rather than going through a general 4x4 inverse
+// --------------------------------------------------------
+void TransformSystem::UpdateGroup(uint32_t firstSlot)
+{
+	XMVECTOR qx = XMLoadFloat4((const XMFLOAT4*) &rotationX[firstSlot]);
+	XMVECTOR qy = XMLoadFloat4((const XMFLOAT4*) &rotationY[firstSlot]);
+	XMVECTOR qz = XMLoadFloat4((const XMFLOAT4*) &rotationZ[firstSlot]);
+	XMVECTOR qw = XMLoadFloat4((const XMFLOAT4*) &rotationW[firstSlot]);
+
+	// Rotation from the (unit) quaternion, one element per vector - no trig needed
+	XMVECTOR two = XMVectorReplicate(2.0f);
+	XMVECTOR xx = qx * qx * two, yy = qy * qy * two, zz = qz * qz * two;
+	XMVECTOR xy = qx * qy * two, xz = qx * qz * two, yz = qy * qz * two;
+	XMVECTOR wx = qw * qx * two, wy = qw * qy * two, wz = qw * qz * two;
+	XMVECTOR r00 = XMVectorSplatOne() - yy - zz;
+	XMVECTOR r01 = xy + wz;
+	XMVECTOR r02 = xz - wy;
+	XMVECTOR r10 = xy - wz;
+	XMVECTOR r11 = XMVectorSplatOne() - xx - zz;
+	XMVECTOR r12 = yz + wx;
+	XMVECTOR r20 = xz + wy;
+	XMVECTOR r21 = yz - wx;
+	XMVECTOR r22 = XMVectorSplatOne() - xx - yy;
+
+	XMVECTOR sx = XMLoadFloat4((const XMFLOAT4*) &scaleX[firstSlot]);
+	XMVECTOR sy = XMLoadFloat4((const XMFLOAT4*) &scaleY[firstSlot]);
+	XMVECTOR sz = XMLoadFloat4((const XMFLOAT4*) &scaleZ[firstSlot]);
+	XMVECTOR tx = XMLoadFloat4((const XMFLOAT4*) &locationX[firstSlot]);
+	XMVECTOR ty = XMLoadFloat4((const XMFLOAT4*) &locationY[firstSlot]);
+	XMVECTOR tz = XMLoadFloat4((const XMFLOAT4*) &locationZ[firstSlot]);
+	XMVECTOR zero = XMVectorZero();
+	XMVECTOR one = XMVectorSplatOne();
+
+	// Local: each rotation row scaled, then the translation
+	XMFLOAT4X4* local = &localMatrices[firstSlot];
+	StoreRows(local, 0, r00 * sx, r01 * sx, r02 * sx, zero);
+	StoreRows(local, 1, r10 * sy, r11 * sy, r12 * sy, zero);
+	StoreRows(local, 2, r20 * sz, r21 * sz, r22 * sz, zero);
+	StoreRows(local, 3, tx, ty, tz, one);
+
+	// Inverse: transposed rotation with each column divided by its scale, and the translation
+	// taken back through both
+	XMVECTOR inverseSx = XMVectorReciprocal(sx);
+	XMVECTOR inverseSy = XMVectorReciprocal(sy);
+	XMVECTOR inverseSz = XMVectorReciprocal(sz);
+	XMVECTOR d0 = -(tx * r00 + ty * r01 + tz * r02) * inverseSx;
+	XMVECTOR d1 = -(tx * r10 + ty * r11 + tz * r12) * inverseSy;
+	XMVECTOR d2 = -(tx * r20 + ty * r21 + tz * r22) * inverseSz;
+
+	XMFLOAT4X4* inverse = &localInverseMatrices[firstSlot];
+	StoreRows(inverse, 0, r00 * inverseSx, r10 * inverseSy, r20 * inverseSz, zero);
+	StoreRows(inverse, 1, r01 * inverseSx, r11 * inverseSy, r21 * inverseSz, zero);
+	StoreRows(inverse, 2, r02 * inverseSx, r12 * inverseSy, r22 * inverseSz, zero);
+	StoreRows(inverse, 3, d0, d1, d2, one);
+}
+
+// One transform's local matrices, the way every Transform used to build them (but inverted directly)
+void TransformSystem::UpdateLocal(uint32_t slot)
+{
+	XMVECTOR translationVector = XMVectorSet(locationX[slot], locationY[slot], locationZ[slot], 0.0f);
+	XMVECTOR scaleVector = XMVectorSet(scaleX[slot], scaleY[slot], scaleZ[slot], 1.0f);
+
+	XMMATRIX translation = XMMatrixTranslationFromVector(translationVector);
+	XMMATRIX rotation = XMMatrixRotationQuaternion(XMVectorSet(rotationX[slot], rotationY[slot], rotationZ[slot], rotationW[slot]));
+	XMMATRIX scale = XMMatrixScalingFromVector(scaleVector);
+
+	XMMATRIX local = scale * rotation * translation;
+
+	XMStoreFloat4x4(&localMatrices[slot], local);
+	XMStoreFloat4x4(&localInverseMatrices[slot], InverseTRS(rotation, translationVector, scaleVector));
+}
+
+// World matrices from the (up to date) local matrices and parent's world matrices
+void TransformSystem::UpdateWorld(uint32_t slot)
+{
+	uint32_t parentSlot = GetParentSlot(slot);
+	if(parentSlot == InvalidSlot)
+	{
+		worldMatrices[slot] = localMatrices[slot];
+		worldInverseMatrices[slot] = localInverseMatrices[slot];
+	}
+	else
+	{
+		// (local * parent)^-1 = parent^-1 * local^-1
+		XMStoreFloat4x4(&worldMatrices[slot], XMLoadFloat4x4(&localMatrices[slot]) * XMLoadFloat4x4(&worldMatrices[parentSlot]));
+		XMStoreFloat4x4(&worldInverseMatrices[slot], XMLoadFloat4x4(&worldInverseMatrices[parentSlot]) * XMLoadFloat4x4(&localInverseMatrices[slot]));
+		parentVersions[slot] = worldVersions[parentSlot];
+	}
+
+	// Only the shaders that light things need the inverse transpose, so it waits until asked for
+	isInverseTransposeStale[slot] = 1;
+	isDirty[slot] = 0;
+	worldVersions[slot]++;
+}
+
+// Brings one slot up to date, ancestors first
+void TransformSystem::Refresh(uint32_t slot)
+{
+	refreshChain.clear();
+	for(uint32_t current = slot; current != InvalidSlot; current = GetParentSlot(current))
+		refreshChain.push_back(current);
+
+	for(size_t i = refreshChain.size(); i-- > 0;)
+	{
+		uint32_t current = refreshChain[i];
+		if(!IsStale(current))
+			continue;
+		if(isDirty[current])
+			UpdateLocal(current);
+		UpdateWorld(current);
+	}
+}
+
+size_t TransformSystem::UpdateWorldMatrices(bool parallel)
+{
+	if(isOrderDirty)
+		SortByDepth();
+
+	// Local matrices only depend on each transform's own values, so they can go in any order
+	size_t groupCount = RoundUpToGroup(count) / 4;
+	auto updateGroups = [&](size_t begin, size_t end)
+	{
+		for(size_t group = begin; group < end; group++)
+		{
+			// Skip the whole group if none of its four are dirty
+			uint32_t flags;
+			memcpy(&flags, &isDirty[group * 4], 4);
+			if(flags != 0)
+				UpdateGroup((uint32_t) group * 4);
+		}
+	};
+	if(parallel && groupCount > ParallelGroupChunk)
+		ThreadPool::Global().ParallelFor(groupCount, ParallelGroupChunk, updateGroups);
+	else
+		updateGroups(0, groupCount);
+
+	// World matrices front to back, so every parent is done before its children look at it
+	size_t rebuiltCount = 0;
+	for(uint32_t slot = 0; slot < count; slot++)
+	{
+		if(IsStale(slot))
+		{
+			UpdateWorld(slot);
+			rebuiltCount++;
+		}
+	}
+	return rebuiltCount;
+}
+
+void TransformSystem::UpdateWorldMatrix(Handle handle)
+{
+	Refresh(handleSlots[handle]);
+}
+
+#pragma region Getters
+XMFLOAT3 TransformSystem::GetLocation(Handle handle)
+{
+	uint32_t slot = handleSlots[handle];
+	return XMFLOAT3(locationX[slot], locationY[slot], locationZ[slot]);
+}
+XMFLOAT3 TransformSystem::GetRotation(Handle handle)
+{
+	uint32_t slot = handleSlots[handle];
+	return XMFLOAT3(pitch[slot], yaw[slot], roll[slot]);
+}
+XMFLOAT4 TransformSystem::GetRotationQuaternion(Handle handle)
+{
+	uint32_t slot = handleSlots[handle];
+	return XMFLOAT4(rotationX[slot], rotationY[slot], rotationZ[slot], rotationW[slot]);
+}
+XMFLOAT3 TransformSystem::GetScale(Handle handle)
+{
+	uint32_t slot = handleSlots[handle];
+	return XMFLOAT3(scaleX[slot], scaleY[slot], scaleZ[slot]);
+}
+XMFLOAT3 TransformSystem::GetRight(Handle handle) { return rights[handleSlots[handle]]; }
+XMFLOAT3 TransformSystem::GetUp(Handle handle) { return ups[handleSlots[handle]]; }
+XMFLOAT3 TransformSystem::GetForward(Handle handle) { return forwards[handleSlots[handle]]; }
+const XMFLOAT4X4& TransformSystem::GetWorldMatrix(Handle handle)
+{
+	UpdateWorldMatrix(handle);
+	return worldMatrices[handleSlots[handle]];
+}
+const XMFLOAT4X4& TransformSystem::GetWorldInverseMatrix(Handle handle)
+{
+	UpdateWorldMatrix(handle);
+	return worldInverseMatrices[handleSlots[handle]];
+}
+const XMFLOAT4X4& TransformSystem::GetWorldInverseTransposeMatrix(Handle handle)
+{
+	UpdateWorldMatrix(handle);
+	uint32_t slot = handleSlots[handle];
+	if(isInverseTransposeStale[slot])
+	{
+		XMStoreFloat4x4(&worldInverseTransposeMatrices[slot], XMMatrixTranspose(XMLoadFloat4x4(&worldInverseMatrices[slot])));
+		isInverseTransposeStale[slot] = 0;
+	}
+	return worldInverseTransposeMatrices[slot];
+}
+#pragma endregion
+
+#pragma region Setters
+void TransformSystem::SetLocation(Handle handle, XMFLOAT3 location)
+{
+	uint32_t slot = handleSlots[handle];
+	locationX[slot] = location.x;
+	locationY[slot] = location.y;
+	locationZ[slot] = location.z;
+	isDirty[slot] = 1;
+}
+void TransformSystem::SetRotation(Handle handle, XMFLOAT3 rotation)
+{
+	uint32_t slot = handleSlots[handle];
+	pitch[slot] = rotation.x;
+	yaw[slot] = rotation.y;
+	roll[slot] = rotation.z;
+	StoreRotation(slot, XMQuaternionRotationRollPitchYaw(rotation.x, rotation.y, rotation.z));
+}
+void TransformSystem::SetRotationQuaternion(Handle handle, XMFLOAT4 quaternion)
+{
+	uint32_t slot = handleSlots[handle];
+	XMVECTOR normalized = XMQuaternionNormalize(XMLoadFloat4(&quaternion));
+	StoreRotation(slot, normalized);
+
+	// Keep the angles in step, for anything editing them
+	XMFLOAT4X4 matrix;
+	XMStoreFloat4x4(&matrix, XMMatrixRotationQuaternion(normalized));
+	XMFLOAT3 rotation = PitchYawRollFromMatrix(matrix);
+	pitch[slot] = rotation.x;
+	yaw[slot] = rotation.y;
+	roll[slot] = rotation.z;
+}
+void TransformSystem::CopyRotation(Handle handle, Handle source)
+{
+	// Going through either setter would rebuild one from the other, which doesn't round trip
+	uint32_t slot = handleSlots[handle];
+	uint32_t sourceSlot = handleSlots[source];
+	pitch[slot] = pitch[sourceSlot];
+	yaw[slot] = yaw[sourceSlot];
+	roll[slot] = roll[sourceSlot];
+	StoreRotation(slot, XMVectorSet(rotationX[sourceSlot], rotationY[sourceSlot], rotationZ[sourceSlot], rotationW[sourceSlot]));
+}
+void TransformSystem::SetScale(Handle handle, XMFLOAT3 scale)
+{
+	uint32_t slot = handleSlots[handle];
+	scaleX[slot] = scale.x;
+	scaleY[slot] = scale.y;
+	scaleZ[slot] = scale.z;
+	isDirty[slot] = 1;
+}
+#pragma endregion
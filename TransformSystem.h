@@ -0,0 +1,129 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// --------------------------------------------------------
+// Every transform's data in one place, as structure-of-arrays
+// - Locations, rotations and scales are kept one float array
+//   per component, so UpdateWorldMatrices() can build the
+//   matrices of four transforms at once with SIMD
+// - Rotations are normalized quaternions; pitch/yaw/roll are
+//   kept beside them only for editing, and the right, up and
+//   forward vectors are worked out once whenever the rotation
+//   changes rather than every time they're asked for
+// - Transforms are referred to by handle; their data stays
+//   densely packed (removing one moves the last into its
+//   place), padded to a multiple of four with identities
+// - Transforms can have a parent, making their location,
+//   rotation and scale relative to it (world = local * parent
+//   world); parents are always kept in earlier slots than
+//   their children (sorted by depth whenever that breaks), so
+//   one pass front to back sees every parent before its
+//   children
+// - Only transforms marked dirty, and those under them, have
+//   their matrices rebuilt; reading a stale transform's
+//   matrices rebuilds just it (and its stale ancestors), so
+//   batching is purely an optimization
+// --------------------------------------------------------
+class TransformSystem
+{
+public:
+	using Handle = uint32_t;
+	static constexpr Handle InvalidHandle = UINT32_MAX;
+
+private:
+	// Per slot (i.e. densely packed, in no particular order)
+	std::vector<float> locationX, locationY, locationZ;
+	std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+	std::vector<float> pitch, yaw, roll;	// What the rotation was set from (or, if set as a quaternion, works out to)
+	std::vector<DirectX::XMFLOAT3> rights, ups, forwards;
+	std::vector<float> scaleX, scaleY, scaleZ;
+	std::vector<Handle> parentHandles;
+	std::vector<DirectX::XMFLOAT4X4> localMatrices;
+	std::vector<DirectX::XMFLOAT4X4> localInverseMatrices;
+	std::vector<DirectX::XMFLOAT4X4> worldMatrices;
+	std::vector<DirectX::XMFLOAT4X4> worldInverseMatrices;
+	std::vector<DirectX::XMFLOAT4X4> worldInverseTransposeMatrices;
+	std::vector<uint8_t> isDirty;			// Location, rotation or scale changed since the local matrices were built
+	std::vector<uint8_t> isInverseTransposeStale; // Built on demand, since only some shaders use it
+	std::vector<uint32_t> worldVersions;	// Bumped every time the world matrices are rebuilt
+	std::vector<uint32_t> parentVersions;	// The parent's world version this slot was last built against
+	std::vector<Handle> slotHandles;
+
+	// Per handle
+	std::vector<uint32_t> handleSlots;
+	std::vector<uint32_t> childCounts;
+	std::vector<Handle> freeHandles;
+
+	uint32_t count;
+	bool isOrderDirty; // Some child comes before its parent
+	std::vector<uint32_t> refreshChain; // Scratch space for Refresh()
+
+	void ResizeSlots(uint32_t newCount);
+	void ResetSlot(uint32_t slot);
+	void MoveSlot(uint32_t from, uint32_t to);
+	void SortByDepth();
+	uint32_t GetParentSlot(uint32_t slot);
+	bool IsStale(uint32_t slot);
+	void StoreRotation(uint32_t slot, DirectX::FXMVECTOR quaternion);
+	void UpdateGroup(uint32_t firstSlot);
+	void UpdateLocal(uint32_t slot);
+	void UpdateWorld(uint32_t slot);
+	void Refresh(uint32_t slot);
+
+public:
+	TransformSystem();
+	TransformSystem(const TransformSystem&) = delete; // Remove copy constructor
+	TransformSystem& operator=(const TransformSystem&) = delete; // Remove copy-assignment operator
+
+	// Where every Transform keeps its data
+	static TransformSystem& Global();
+
+	Handle Create(DirectX::XMFLOAT3 location, DirectX::XMFLOAT3 rotation, DirectX::XMFLOAT3 scale);
+	void Destroy(Handle handle);
+
+	// Rebuilds the local matrices of every dirty transform, four at a time (optionally split across
+	// the global thread pool), then the world matrices of those and everything under them, parents
+	// first; returns how many world matrices were rebuilt
+	size_t UpdateWorldMatrices(bool parallel = true);
+	// Rebuilds one transform's matrices (and any of its ancestors'), if they're out of date
+	void UpdateWorldMatrix(Handle handle);
+
+	// Makes the transform relative to parent (InvalidHandle for none), keeping its local values
+	// - Returns false, changing nothing, if parent is the transform itself or one of its descendants
+	bool SetParent(Handle handle, Handle parent);
+	Handle GetParent(Handle handle) { return parentHandles[handleSlots[handle]]; };
+
+	DirectX::XMFLOAT3 GetLocation(Handle handle);
+	DirectX::XMFLOAT3 GetRotation(Handle handle); // Pitch, yaw and roll
+	DirectX::XMFLOAT4 GetRotationQuaternion(Handle handle);
+	DirectX::XMFLOAT3 GetScale(Handle handle);
+	DirectX::XMFLOAT3 GetRight(Handle handle);
+	DirectX::XMFLOAT3 GetUp(Handle handle);
+	DirectX::XMFLOAT3 GetForward(Handle handle);
+	const DirectX::XMFLOAT4X4& GetWorldMatrix(Handle handle);
+	const DirectX::XMFLOAT4X4& GetWorldInverseMatrix(Handle handle);
+	const DirectX::XMFLOAT4X4& GetWorldInverseTransposeMatrix(Handle handle);
+
+	void SetLocation(Handle handle, DirectX::XMFLOAT3 location);
+	void SetRotation(Handle handle, DirectX::XMFLOAT3 rotation);
+	void SetRotationQuaternion(Handle handle, DirectX::XMFLOAT4 quaternion); // Normalized here
+	void CopyRotation(Handle handle, Handle source); // Quaternion and angles both, exactly
+	void SetScale(Handle handle, DirectX::XMFLOAT3 scale);
+
+	size_t GetCount() { return count; };
+	bool IsDirty(Handle handle) { return isDirty[handleSlots[handle]] != 0; };
+};
+
+// --------------------------------------------------------
+// Inverse of scale * rotation * translation, written down
+// directly instead of through a general 4x4 inverse:
+// translation^-1 * rotation^T * scale^-1, i.e. the
+// transposed rotation with each column divided by its
+// scale, and the negated translation taken through that
+// - scale's w must be non-zero (it's ignored otherwise)
+// --------------------------------------------------------
+DirectX::XMMATRIX InverseTRS(DirectX::FXMMATRIX rotation, DirectX::FXMVECTOR translation, DirectX::FXMVECTOR scale);
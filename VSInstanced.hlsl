@@ -0,0 +1,38 @@
+#include "ShaderStructs.hlsli"
+#include "FrameData.hlsli"
+
+cbuffer DataFromCPU : register(b0) // Take the data from memory register b0 ("buffer 0")
+{
+    uint firstInstance; // Where this draw's instances start in Instances
+}
+
+StructuredBuffer<InstanceData> Instances : register(t0);
+
+// --------------------------------------------------------
+// Same as VertexShader.hlsl, but drawing many instances of
+// a mesh at once, each with its own matrices
+// --------------------------------------------------------
+VertexToPixel main( VertexShaderInput input, uint instanceID : SV_InstanceID )
+{
+    InstanceData instance = Instances[firstInstance + instanceID];
+
+	// Set up output struct
+	VertexToPixel output;
+	
+	matrix wvp = mul(projMatrix, mul(viewMatrix, instance.worldMatrix));
+    output.screenPosition = mul(wvp, float4(input.localPosition, 1.0f));
+	
+	// Rotate normal and tangent to match object's world transform
+    output.normal = mul((float3x3) instance.worldInvTranspose, input.normal);
+	output.tangent = mul((float3x3) instance.worldMatrix, input.tangent);
+	output.bitangentSign = 1.0f; // The full vertex format has no handedness, so assumes unmirrored uvs
+	
+    output.uv = input.uv;
+
+	output.worldPosition = mul(instance.worldMatrix, float4(input.localPosition, 1)).xyz;
+
+    matrix shadowWVP = mul(lightProj, mul(lightView, instance.worldMatrix));
+    output.shadowMapPosition = mul(shadowWVP, float4(input.localPosition, 1.0f));
+
+	return output;
+}
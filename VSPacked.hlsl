@@ -0,0 +1,40 @@
+#include "ShaderStructs.hlsli"
+#include "FrameData.hlsli"
+
+cbuffer DataFromCPU : register(b0) // Take the data from memory register b0 ("buffer 0")
+{
+	matrix worldMatrix;
+	matrix worldInvTranspose;
+
+    float3 positionOffset;
+    float3 positionScale;
+}
+
+// --------------------------------------------------------
+// Same as VertexShader.hlsl, but for meshes with packed
+// vertices (see PackedVertex)
+// --------------------------------------------------------
+VertexToPixel main( PackedVertexShaderInput packedInput )
+{
+    VertexShaderInput input = UnpackVertex(packedInput, positionOffset, positionScale);
+
+	// Set up output struct
+	VertexToPixel output;
+	
+	matrix wvp = mul(projMatrix, mul(viewMatrix, worldMatrix));
+    output.screenPosition = mul(wvp, float4(input.localPosition, 1.0f));
+	
+	// Rotate normal and tangent to match object's world transform
+    output.normal = mul((float3x3) worldInvTranspose, input.normal);
+	output.tangent = mul((float3x3) worldMatrix, input.tangent);
+	output.bitangentSign = UnpackBitangentSign(packedInput);
+	
+    output.uv = input.uv;
+
+	output.worldPosition = mul(worldMatrix, float4(input.localPosition, 1)).xyz;
+
+    matrix shadowWVP = mul(lightProj, mul(lightView, worldMatrix));
+    output.shadowMapPosition = mul(shadowWVP, float4(input.localPosition, 1.0f));
+
+	return output;
+}
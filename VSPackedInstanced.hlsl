@@ -0,0 +1,42 @@
+#include "ShaderStructs.hlsli"
+#include "FrameData.hlsli"
+
+cbuffer DataFromCPU : register(b0) // Take the data from memory register b0 ("buffer 0")
+{
+    float3 positionOffset;
+    float3 positionScale;
+
+    uint firstInstance; // Where this draw's instances start in Instances
+}
+
+StructuredBuffer<InstanceData> Instances : register(t0);
+
+// --------------------------------------------------------
+// Same as VSInstanced.hlsl, but for meshes with packed
+// vertices (see PackedVertex)
+// --------------------------------------------------------
+VertexToPixel main( PackedVertexShaderInput packedInput, uint instanceID : SV_InstanceID )
+{
+    VertexShaderInput input = UnpackVertex(packedInput, positionOffset, positionScale);
+    InstanceData instance = Instances[firstInstance + instanceID];
+
+	// Set up output struct
+	VertexToPixel output;
+	
+	matrix wvp = mul(projMatrix, mul(viewMatrix, instance.worldMatrix));
+    output.screenPosition = mul(wvp, float4(input.localPosition, 1.0f));
+	
+	// Rotate normal and tangent to match object's world transform
+    output.normal = mul((float3x3) instance.worldInvTranspose, input.normal);
+	output.tangent = mul((float3x3) instance.worldMatrix, input.tangent);
+	output.bitangentSign = UnpackBitangentSign(packedInput);
+	
+    output.uv = input.uv;
+
+	output.worldPosition = mul(instance.worldMatrix, float4(input.localPosition, 1)).xyz;
+
+    matrix shadowWVP = mul(lightProj, mul(lightView, instance.worldMatrix));
+    output.shadowMapPosition = mul(shadowWVP, float4(input.localPosition, 1.0f));
+
+	return output;
+}
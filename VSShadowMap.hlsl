@@ -1,11 +1,10 @@
 #include "ShaderStructs.hlsli"
+#include "FrameData.hlsli"
 
 // Constant Buffer for external (C++) data
 cbuffer externalData : register(b0)
 {
     matrix world;
-    matrix view;
-    matrix projection;
 };
 
 // --------------------------------------------------------
@@ -13,6 +12,6 @@ cbuffer externalData : register(b0)
 // --------------------------------------------------------
 float4 main(VertexShaderInput input) : SV_POSITION
 {
-    matrix wvp = mul(projection, mul(view, world));
+    matrix wvp = mul(lightProj, mul(lightView, world));
     return mul(wvp, float4(input.localPosition, 1.0f));
 }
\ No newline at end of file
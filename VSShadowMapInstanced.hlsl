@@ -0,0 +1,20 @@
+#include "ShaderStructs.hlsli"
+#include "FrameData.hlsli"
+
+// Constant Buffer for external (C++) data
+cbuffer externalData : register(b0)
+{
+    uint firstInstance; // Where this draw's instances start in Instances
+};
+
+StructuredBuffer<InstanceData> Instances : register(t0);
+
+// --------------------------------------------------------
+// Same as VSShadowMap.hlsl, but drawing many instances of a
+// mesh at once, each with its own world matrix
+// --------------------------------------------------------
+float4 main(VertexShaderInput input, uint instanceID : SV_InstanceID) : SV_POSITION
+{
+    matrix wvp = mul(lightProj, mul(lightView, Instances[firstInstance + instanceID].worldMatrix));
+    return mul(wvp, float4(input.localPosition, 1.0f));
+}
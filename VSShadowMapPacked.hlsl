@@ -0,0 +1,23 @@
+#include "ShaderStructs.hlsli"
+#include "FrameData.hlsli"
+
+// Constant Buffer for external (C++) data
+cbuffer externalData : register(b0)
+{
+    matrix world;
+
+    float3 positionOffset;
+    float3 positionScale;
+};
+
+// --------------------------------------------------------
+// Same as VSShadowMap.hlsl, but for meshes with packed
+// vertices (see PackedVertex)
+// --------------------------------------------------------
+float4 main(PackedVertexShaderInput packedInput) : SV_POSITION
+{
+    float3 localPosition = positionOffset + packedInput.localPosition.xyz * positionScale;
+
+    matrix wvp = mul(lightProj, mul(lightView, world));
+    return mul(wvp, float4(localPosition, 1.0f));
+}
@@ -0,0 +1,25 @@
+#include "ShaderStructs.hlsli"
+#include "FrameData.hlsli"
+
+// Constant Buffer for external (C++) data
+cbuffer externalData : register(b0)
+{
+    float3 positionOffset;
+    float3 positionScale;
+
+    uint firstInstance; // Where this draw's instances start in Instances
+};
+
+StructuredBuffer<InstanceData> Instances : register(t0);
+
+// --------------------------------------------------------
+// Same as VSShadowMapInstanced.hlsl, but for meshes with
+// packed vertices (see PackedVertex)
+// --------------------------------------------------------
+float4 main(PackedVertexShaderInput packedInput, uint instanceID : SV_InstanceID) : SV_POSITION
+{
+    float3 localPosition = positionOffset + packedInput.localPosition.xyz * positionScale;
+
+    matrix wvp = mul(lightProj, mul(lightView, Instances[firstInstance + instanceID].worldMatrix));
+    return mul(wvp, float4(localPosition, 1.0f));
+}
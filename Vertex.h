@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <DirectXMath.h>
 
 // --------------------------------------------------------
@@ -13,4 +14,29 @@ struct Vertex
 	DirectX::XMFLOAT3 normal;
 	DirectX::XMFLOAT3 tangent;
 	DirectX::XMFLOAT2 uv;
-};
\ No newline at end of file
+};
+
+// --------------------------------------------------------
+// A compressed alternative to Vertex (20 bytes instead of 44)
+// - Position is 16-bit UNORM within the mesh's bounds (see
+//   VertexQuantization), with the bitangent sign in w
+// - Normal and tangent are octahedral-encoded 16-bit SNORM pairs
+// - UV is a pair of half floats
+//
+// - Must match PackedVertexShaderInput and the input layout
+//   created in Game::LoadShaders()
+// --------------------------------------------------------
+struct PackedVertex
+{
+	uint16_t position[4];
+	int16_t normal[2];
+	int16_t tangent[2];
+	uint16_t uv[2];
+};
+
+// Which of the vertex structs a mesh's vertex buffer holds
+enum class VertexFormat
+{
+	Full,
+	Packed
+};
@@ -0,0 +1,148 @@
+#include "VertexPacking.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <DirectXPackedVector.h>
+
+using namespace DirectX;
+
+namespace
+{
+	const float UNormMax = 65535.0f;
+	const float SNormMax = 32767.0f;
+
+	uint16_t FloatToUNorm16(float value)
+	{
+		return (uint16_t) std::lround(std::clamp(value, 0.0f, 1.0f) * UNormMax);
+	}
+	float UNorm16ToFloat(uint16_t value)
+	{
+		return value / UNormMax;
+	}
+
+	int16_t FloatToSNorm16(float value)
+	{
+		return (int16_t) std::lround(std::clamp(value, -1.0f, 1.0f) * SNormMax);
+	}
+	float SNorm16ToFloat(int16_t value)
+	{
+		// Matches the GPU's conversion, where both -32768 and -32767 become -1
+		return std::max(value / SNormMax, -1.0f);
+	}
+
+	// Sign that treats 0 as positive (so folded vectors land on the correct side)
+	float SignNotZero(float value)
+	{
+		return value >= 0.0f ? 1.0f : -1.0f;
+	}
+}
+
+VertexQuantization CalculateVertexQuantization(const Vertex* vertices, size_t vertexCount)
+{
+	VertexQuantization quantization = {};
+	if(vertexCount == 0)
+		return quantization;
+
+	XMFLOAT3 min = vertices[0].position;
+	XMFLOAT3 max = vertices[0].position;
+	for(size_t i = 1; i < vertexCount; i++)
+	{
+		const XMFLOAT3& p = vertices[i].position;
+		min = XMFLOAT3(std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z));
+		max = XMFLOAT3(std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z));
+	}
+
+	quantization.positionOffset = min;
+	quantization.positionScale = XMFLOAT3(max.x - min.x, max.y - min.y, max.z - min.z);
+	return quantization;
+}
+
+// --------------------------------------------------------
+// Octahedral unit vector encoding
+// - Projects the vector onto an octahedron, then unfolds the
+//   lower half over the upper half's corners so the whole
+//   sphere fits in a square with fairly even precision
+// - See "A Survey of Efficient Representations for Independent
+//   Unit Vectors" (Cigolle et al. 2014)
+// --------------------------------------------------------
+XMFLOAT2 EncodeOctahedral(XMFLOAT3 direction)
+{
+	float l1Norm = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+	if(l1Norm == 0.0f)
+		return XMFLOAT2(0, 0);
+
+	float x = direction.x / l1Norm;
+	float y = direction.y / l1Norm;
+	if(direction.z < 0.0f)
+	{
+		float foldedX = (1.0f - std::abs(y)) * SignNotZero(x);
+		float foldedY = (1.0f - std::abs(x)) * SignNotZero(y);
+		x = foldedX;
+		y = foldedY;
+	}
+	return XMFLOAT2(x, y);
+}
+
+XMFLOAT3 DecodeOctahedral(XMFLOAT2 encoded)
+{
+	XMFLOAT3 direction(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+
+	// Unfold the lower half (mirrors DecodeOctahedral() in ShaderStructs.hlsli)
+	float fold = std::max(-direction.z, 0.0f);
+	direction.x += direction.x >= 0.0f ? -fold : fold;
+	direction.y += direction.y >= 0.0f ? -fold : fold;
+
+	XMStoreFloat3(&direction, XMVector3Normalize(XMLoadFloat3(&direction)));
+	return direction;
+}
+
+PackedVertex PackVertex(const Vertex& vertex, float bitangentSign, const VertexQuantization& quantization)
+{
+	PackedVertex packed = {};
+
+	// Position relative to the bounds (flat axes have no scale, and always store 0)
+	const float* position = &vertex.position.x;
+	const float* offset = &quantization.positionOffset.x;
+	const float* scale = &quantization.positionScale.x;
+	for(int i = 0; i < 3; i++)
+		packed.position[i] = scale[i] > 0.0f ? FloatToUNorm16((position[i] - offset[i]) / scale[i]) : 0;
+
+	// Bitangent sign, as 0 (-1) or 65535 (+1)
+	packed.position[3] = FloatToUNorm16(bitangentSign * 0.5f + 0.5f);
+
+	XMFLOAT2 normal = EncodeOctahedral(vertex.normal);
+	packed.normal[0] = FloatToSNorm16(normal.x);
+	packed.normal[1] = FloatToSNorm16(normal.y);
+
+	XMFLOAT2 tangent = EncodeOctahedral(vertex.tangent);
+	packed.tangent[0] = FloatToSNorm16(tangent.x);
+	packed.tangent[1] = FloatToSNorm16(tangent.y);
+
+	packed.uv[0] = PackedVector::XMConvertFloatToHalf(vertex.uv.x);
+	packed.uv[1] = PackedVector::XMConvertFloatToHalf(vertex.uv.y);
+
+	return packed;
+}
+
+Vertex UnpackVertex(const PackedVertex& packed, const VertexQuantization& quantization)
+{
+	Vertex vertex = {};
+
+	vertex.position = XMFLOAT3(
+		quantization.positionOffset.x + UNorm16ToFloat(packed.position[0]) * quantization.positionScale.x,
+		quantization.positionOffset.y + UNorm16ToFloat(packed.position[1]) * quantization.positionScale.y,
+		quantization.positionOffset.z + UNorm16ToFloat(packed.position[2]) * quantization.positionScale.z);
+	vertex.normal = DecodeOctahedral(XMFLOAT2(SNorm16ToFloat(packed.normal[0]), SNorm16ToFloat(packed.normal[1])));
+	vertex.tangent = DecodeOctahedral(XMFLOAT2(SNorm16ToFloat(packed.tangent[0]), SNorm16ToFloat(packed.tangent[1])));
+	vertex.uv = XMFLOAT2(
+		PackedVector::XMConvertHalfToFloat(packed.uv[0]),
+		PackedVector::XMConvertHalfToFloat(packed.uv[1]));
+
+	return vertex;
+}
+
+float UnpackBitangentSign(const PackedVertex& packed)
+{
+	return UNorm16ToFloat(packed.position[3]) * 2.0f - 1.0f;
+}
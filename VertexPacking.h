@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+
+#include <DirectXMath.h>
+
+#include "Vertex.h"
+
+// --------------------------------------------------------
+// Maps a mesh's 16-bit quantized positions back to its
+// local space: position = positionOffset + unorm * positionScale
+// (where unorm is the stored value as a 0-1 float)
+// --------------------------------------------------------
+struct VertexQuantization
+{
+	DirectX::XMFLOAT3 positionOffset;
+	DirectX::XMFLOAT3 positionScale;
+};
+
+// Quantization that spans the bounding box of the given vertices
+VertexQuantization CalculateVertexQuantization(const Vertex* vertices, size_t vertexCount);
+
+// Octahedral encoding of a unit vector into [-1, 1]^2, and back
+DirectX::XMFLOAT2 EncodeOctahedral(DirectX::XMFLOAT3 direction);
+DirectX::XMFLOAT3 DecodeOctahedral(DirectX::XMFLOAT2 encoded);
+
+// The bitangent sign (+1 or -1, see CalculateBitangentSigns()) is stored in position[3]
+PackedVertex PackVertex(const Vertex& vertex, float bitangentSign, const VertexQuantization& quantization);
+Vertex UnpackVertex(const PackedVertex& packed, const VertexQuantization& quantization);
+float UnpackBitangentSign(const PackedVertex& packed);
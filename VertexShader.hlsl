@@ -1,14 +1,10 @@
 #include "ShaderStructs.hlsli"
+#include "FrameData.hlsli"
 
 cbuffer DataFromCPU : register(b0) // Take the data from memory register b0 ("buffer 0")
 {
 	matrix worldMatrix;
 	matrix worldInvTranspose;
-	matrix viewMatrix;
-	matrix projMatrix;
-	
-    matrix lightView;
-    matrix lightProj;
 }
 
 // --------------------------------------------------------
@@ -29,6 +25,7 @@ VertexToPixel main( VertexShaderInput input )
 	// Rotate normal and tangent to match object's world transform
     output.normal = mul((float3x3) worldInvTranspose, input.normal);
 	output.tangent = mul((float3x3) worldMatrix, input.tangent);
+	output.bitangentSign = 1.0f; // The full vertex format has no handedness, so assumes unmirrored uvs
 	
     output.uv = input.uv;
 